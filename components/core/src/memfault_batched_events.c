@@ -8,6 +8,7 @@
 
 #include "memfault/core/batched_events.h"
 #include "memfault/core/sdk_assert.h"
+#include "memfault/core/serializer_helper.h"
 #include "memfault/util/cbor.h"
 
 void memfault_batched_events_build_header(size_t num_events,
@@ -26,3 +27,41 @@ void memfault_batched_events_build_header(size_t num_events,
   memfault_cbor_encode_array_begin(&encoder, num_events);
   header_out->length = memfault_cbor_encoder_deinit(&encoder);
 }
+
+#if MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_ENABLED
+
+bool memfault_batched_events_capture_metadata(sMemfaultBatchedEventsMetadata *metadata_out) {
+  MEMFAULT_SDK_ASSERT(metadata_out != NULL);
+
+  sMemfaultCborEncoder encoder;
+  memfault_cbor_encoder_init(&encoder, memfault_cbor_encoder_memcpy_write, metadata_out->data,
+                             sizeof(metadata_out->data));
+  const bool success = memfault_serializer_helper_encode_batch_metadata(&encoder);
+  const size_t length = memfault_cbor_encoder_deinit(&encoder);
+  metadata_out->length = success ? length : 0;
+  return success;
+}
+
+void memfault_batched_events_build_compact_header(size_t num_events,
+                                                  const sMemfaultBatchedEventsMetadata *metadata,
+                                                  sMemfaultBatchedEventsHeader *header_out) {
+  MEMFAULT_SDK_ASSERT((metadata != NULL) && (header_out != NULL));
+
+  if (num_events == 0) {
+    header_out->length = 0;
+    return;
+  }
+
+  // The stored events only hold their type, timestamp and event info. The metadata they share is
+  // sent once, ahead of the array holding the events. The header has room for the largest
+  // metadata that can be captured, so this can't run out of space.
+  sMemfaultCborEncoder encoder;
+  memfault_cbor_encoder_init(&encoder, memfault_cbor_encoder_memcpy_write, header_out->data,
+                             sizeof(header_out->data));
+  memfault_cbor_encode_array_begin(&encoder, 2);
+  memfault_cbor_join(&encoder, metadata->data, metadata->length);
+  memfault_cbor_encode_array_begin(&encoder, num_events);
+  header_out->length = memfault_cbor_encoder_deinit(&encoder);
+}
+
+#endif /* MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_ENABLED */
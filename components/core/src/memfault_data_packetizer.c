@@ -6,6 +6,7 @@
 #include <inttypes.h>
 #include <string.h>
 
+#include "memfault/config.h"
 #include "memfault/core/compiler.h"
 #include "memfault/core/data_packetizer.h"
 #include "memfault/core/data_packetizer_source.h"
@@ -76,9 +77,18 @@ typedef enum {
   kMfltMessageType_Event = 2,
   kMfltMessageType_Log = 3,
   kMfltMessageType_Cdr = 4,
+  //! Batch of events read from event storage with their shared metadata hoisted into the header
+  //! (MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_ENABLED)
+  kMfltMessageType_CompactEvents = 5,
   kMfltMessageType_NumTypes
 } eMfltMessageType;
 
+#if MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_ENABLED
+  #define MEMFAULT_PACKETIZER_EVENT_MESSAGE_TYPE kMfltMessageType_CompactEvents
+#else
+  #define MEMFAULT_PACKETIZER_EVENT_MESSAGE_TYPE kMfltMessageType_Event
+#endif
+
 //! Make sure our externally facing types match the internal ones
 MEMFAULT_STATIC_ASSERT((1 << kMfltMessageType_Coredump) == kMfltDataSourceMask_Coredump,
                        "kMfltDataSourceMask_Coredump is incorrectly defined");
@@ -88,7 +98,7 @@ MEMFAULT_STATIC_ASSERT((1 << kMfltMessageType_Log) == kMfltDataSourceMask_Log,
                        "kMfltDataSourceMask_Log is incorrectly defined");
 MEMFAULT_STATIC_ASSERT((1 << kMfltMessageType_Cdr) == kMfltDataSourceMask_Cdr,
                        "kMfltDataSourceMask_Cdr is incorrectly defined");
-MEMFAULT_STATIC_ASSERT(kMfltMessageType_NumTypes == 5, "eMfltMessageType needs to be updated");
+MEMFAULT_STATIC_ASSERT(kMfltMessageType_NumTypes == 6, "eMfltMessageType needs to be updated");
 
 typedef struct MemfaultDataSource {
   eMfltMessageType type;
@@ -103,7 +113,7 @@ static const sMemfaultDataSource s_memfault_data_source[] = {
     .impl = &g_memfault_coredump_data_source,
   },
   {
-    .type = kMfltMessageType_Event,
+    .type = MEMFAULT_PACKETIZER_EVENT_MESSAGE_TYPE,
     .use_rle = false,
     .impl = &g_memfault_event_data_source,
   },
@@ -122,6 +132,20 @@ static const sMemfaultDataSource s_memfault_data_source[] = {
   }
 };
 
+#if MEMFAULT_PACKETIZER_PRIORITY_CHANNELS_ENABLED
+//! The order data sources are checked for a new message to send in. Small, time-sensitive
+//! messages are sent first rather than queueing up behind a long running coredump upload.
+static const eMfltMessageType s_source_priority_order[] = {
+  MEMFAULT_PACKETIZER_EVENT_MESSAGE_TYPE,
+  kMfltMessageType_Log,
+  kMfltMessageType_Cdr,
+  kMfltMessageType_Coredump,
+};
+MEMFAULT_STATIC_ASSERT(MEMFAULT_ARRAY_SIZE(s_source_priority_order) ==
+                         MEMFAULT_ARRAY_SIZE(s_memfault_data_source),
+                       "Every data source must be assigned a priority");
+#endif
+
 typedef struct {
   size_t total_size;
   sMemfaultDataSource source;
@@ -231,11 +255,37 @@ static void prv_data_source_chunk_transport_msg_reader(uint32_t offset, void *bu
   }
 }
 
+static uint32_t prv_message_type_to_source_mask(eMfltMessageType type) {
+  // compact events are just another encoding of the event data source
+  if (type == kMfltMessageType_CompactEvents) {
+    return kMfltDataSourceMask_Event;
+  }
+  return (uint32_t)(1 << type);
+}
+
+//! @return the data source checked i-th for a new message to send
+static const sMemfaultDataSource *prv_get_data_source(size_t i) {
+#if MEMFAULT_PACKETIZER_PRIORITY_CHANNELS_ENABLED
+  for (size_t j = 0; j < MEMFAULT_ARRAY_SIZE(s_memfault_data_source); j++) {
+    if (s_memfault_data_source[j].type == s_source_priority_order[i]) {
+      return &s_memfault_data_source[j];
+    }
+  }
+  return NULL;
+#else
+  return &s_memfault_data_source[i];
+#endif
+}
+
 static bool prv_get_source_with_data(size_t *total_size, sMemfaultDataSource *active_source) {
   for (size_t i = 0; i < MEMFAULT_ARRAY_SIZE(s_memfault_data_source); i++) {
-    const sMemfaultDataSource *data_source = &s_memfault_data_source[i];
+    const sMemfaultDataSource *data_source = prv_get_data_source(i);
+    if (data_source == NULL) {
+      continue;
+    }
 
-    const bool disabled_source = (((1 << data_source->type) & s_active_data_sources) == 0);
+    const bool disabled_source =
+      ((prv_message_type_to_source_mask(data_source->type) & s_active_data_sources) == 0);
     if (disabled_source) {
       // sdk user has disabled extraction of data for specified source
       continue;
@@ -400,3 +450,30 @@ bool memfault_packetizer_get_chunk(void *buf, size_t *buf_len) {
 
   return true;
 }
+
+bool memfault_packetizer_get_chunks_bulk(void *buf, size_t *buf_len, size_t *chunk_lens,
+                                         size_t *num_chunks) {
+  if ((buf == NULL) || (buf_len == NULL) || (chunk_lens == NULL) || (num_chunks == NULL)) {
+    return false;
+  }
+
+  uint8_t *bufp = (uint8_t *)buf;
+  size_t bytes_packed = 0;
+  size_t chunks_packed = 0;
+
+  while ((chunks_packed < *num_chunks) &&
+         ((*buf_len - bytes_packed) >= MEMFAULT_PACKETIZER_MIN_BUF_LEN)) {
+    size_t chunk_len = *buf_len - bytes_packed;
+    if (!memfault_packetizer_get_chunk(&bufp[bytes_packed], &chunk_len)) {
+      break;
+    }
+
+    chunk_lens[chunks_packed] = chunk_len;
+    chunks_packed++;
+    bytes_packed += chunk_len;
+  }
+
+  *buf_len = bytes_packed;
+  *num_chunks = chunks_packed;
+  return (chunks_packed != 0);
+}
@@ -55,7 +55,11 @@ typedef enum {
 
 typedef struct {
   eMemfaultDataSourceRleState state;
-  uint8_t temp_buf[128];
+  // Window of the backing data source last read into temp_buf. Cached so that consecutive RLE
+  // sequences found within the same window do not result in additional backing reads
+  uint32_t window_offset;
+  uint32_t window_len;
+  uint8_t temp_buf[MEMFAULT_DATA_SOURCE_RLE_READ_BUF_SIZE];
   // The number of bytes written within the current RLE sequence
   uint32_t write_offset;
   // The total number of bytes that have been processed from the backing data source
@@ -123,6 +127,54 @@ static uint32_t prv_data_source_rle_get_backing_read_offset(void) {
   return write_info->write_start_offset + data_bytes_written;
 }
 
+//! Reads backing data, serving whatever portion of the request overlaps the cached window from
+//! temp_buf rather than the backing data source
+static void prv_data_source_rle_backing_read(uint32_t offset, uint8_t *buf, size_t buf_len) {
+  const sMemfaultDataSourceRleEncodeCtx *encode_ctx = &s_ds_rle_state.encode_ctx;
+  const uint32_t window_start = encode_ctx->window_offset;
+  const uint32_t window_end = window_start + encode_ctx->window_len;
+  const uint32_t end_offset = offset + buf_len;
+
+  if (end_offset <= window_start || offset >= window_end) {
+    s_active_data_source->read_msg_cb(offset, buf, buf_len);
+    return;
+  }
+
+  if (offset < window_start) {
+    const size_t prefix_len = window_start - offset;
+    s_active_data_source->read_msg_cb(offset, buf, prefix_len);
+    buf += prefix_len;
+    offset = window_start;
+  }
+
+  const size_t cached_len = MEMFAULT_MIN(end_offset, window_end) - offset;
+  memcpy(buf, &encode_ctx->temp_buf[offset - window_start], cached_len);
+
+  if (end_offset > window_end) {
+    s_active_data_source->read_msg_cb(window_end, buf + cached_len, end_offset - window_end);
+  }
+}
+
+//! Makes sure the window holds the backing data starting at offset, only reading from the backing
+//! data source when the cached window has been consumed
+//!
+//! @return A pointer to the data at offset and, via data_len, the number of bytes available
+static const uint8_t *prv_data_source_rle_window_get(uint32_t offset, size_t *data_len) {
+  sMemfaultDataSourceRleEncodeCtx *encode_ctx = &s_ds_rle_state.encode_ctx;
+  const uint32_t window_end = encode_ctx->window_offset + encode_ctx->window_len;
+
+  if (offset < encode_ctx->window_offset || offset >= window_end) {
+    const size_t bytes_remaining = s_ds_rle_state.original_size - offset;
+    encode_ctx->window_offset = offset;
+    encode_ctx->window_len = MEMFAULT_MIN(bytes_remaining, sizeof(encode_ctx->temp_buf));
+    s_active_data_source->read_msg_cb(offset, encode_ctx->temp_buf, encode_ctx->window_len);
+  }
+
+  const uint32_t window_start_idx = offset - encode_ctx->window_offset;
+  *data_len = encode_ctx->window_len - window_start_idx;
+  return &encode_ctx->temp_buf[window_start_idx];
+}
+
 static bool prv_data_source_rle_read_msg_prepare(const void *data, size_t data_len) {
   sMemfaultRleCtx *rle_ctx = &s_ds_rle_state.rle_ctx;
   sMemfaultDataSourceRleEncodeCtx *encode_ctx = &s_ds_rle_state.encode_ctx;
@@ -165,7 +217,7 @@ static uint32_t prv_data_source_rle_build_msg_incremental(uint8_t *buf, size_t b
   size_t data_to_write = MEMFAULT_MIN(buf_len, total_write_len - encode_ctx->write_offset);
 
   const uint32_t start_offset = prv_data_source_rle_get_backing_read_offset();
-  s_active_data_source->read_msg_cb(start_offset, &buf[header_bytes_to_write], data_to_write);
+  prv_data_source_rle_backing_read(start_offset, &buf[header_bytes_to_write], data_to_write);
   encode_ctx->write_offset += data_to_write;
 
   const size_t bytes_written = header_bytes_to_write + data_to_write;
@@ -199,15 +251,10 @@ static bool prv_data_source_rle_read(uint32_t offset, void *buf, size_t buf_len)
   }
 
   while (encode_ctx->bytes_processed != s_ds_rle_state.original_size) {
-    uint8_t *working_buf = &encode_ctx->temp_buf[0];
-    const size_t working_buf_size = sizeof(encode_ctx->temp_buf);
-
-    const size_t bytes_remaining = s_ds_rle_state.original_size - encode_ctx->bytes_processed;
-    const size_t bytes_read = MEMFAULT_MIN(bytes_remaining, working_buf_size);
-
-    const size_t read_offset = prv_data_source_rle_get_backing_read_offset();
-    s_active_data_source->read_msg_cb(read_offset, working_buf, bytes_read);
-    prv_data_source_rle_read_msg_prepare(working_buf, bytes_read);
+    size_t bytes_available;
+    const uint8_t *data =
+      prv_data_source_rle_window_get(encode_ctx->bytes_processed, &bytes_available);
+    prv_data_source_rle_read_msg_prepare(data, bytes_available);
 
     // do we know what to write for the next block yet?
     buf_full = prv_data_source_rle_fill_msg(&bufp, &buf_len);
@@ -242,9 +289,24 @@ static size_t prv_compute_rle_size(void) {
   s_ds_rle_state.total_rle_size = rle_ctx->total_rle_size;
 
   *rle_ctx = (sMemfaultRleCtx){ 0 };
+  // temp_buf was used as a scratch buffer, it no longer holds a valid window
+  s_ds_rle_state.encode_ctx.window_len = 0;
   return s_ds_rle_state.total_rle_size;
 }
 
+//! Use the RLE size of the message if the backing data source already knows it
+static bool prv_lookup_rle_size(void) {
+  MemfaultDataSourceGetRleSizeCallback *get_rle_size_cb = s_active_data_source->get_rle_size_cb;
+  size_t rle_size = 0;
+  if ((get_rle_size_cb == NULL) || !get_rle_size_cb(&rle_size) || (rle_size == 0)) {
+    return false;
+  }
+
+  s_ds_rle_state.total_rle_size = rle_size;
+  s_ds_rle_state.encode_ctx.state = kMemfaultDataSourceRleState_FindingSeqLength;
+  return true;
+}
+
 MEMFAULT_WEAK bool memfault_data_source_rle_read_msg(uint32_t offset, void *buf, size_t buf_len) {
   return prv_data_source_rle_read(offset, buf, buf_len);
 }
@@ -263,6 +325,11 @@ bool memfault_data_source_rle_has_more_msgs(size_t *total_size_out) {
     return true;
   }
 
+  if (prv_lookup_rle_size()) {
+    *total_size_out = s_ds_rle_state.total_rle_size;
+    return true;
+  }
+
   *total_size_out = prv_compute_rle_size();
   return true;
 }
@@ -26,6 +26,15 @@
 #include "memfault/core/sdk_assert.h"
 #include "memfault/util/circular_buffer.h"
 
+#if MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_ENABLED
+  #if !MEMFAULT_EVENT_STORAGE_READ_BATCHING_ENABLED
+    #error "Compact event batches require MEMFAULT_EVENT_STORAGE_READ_BATCHING_ENABLED"
+  #endif
+  #if MEMFAULT_EVENT_STORAGE_RESTORE_STATE
+    #error "Compact event batches can not be used with MEMFAULT_EVENT_STORAGE_RESTORE_STATE"
+  #endif
+#endif
+
 //
 // Routines which can optionally be implemented.
 // For more details see:
@@ -71,6 +80,14 @@ typedef struct {
 
 #define MEMFAULT_EVENT_STORAGE_WRITE_IN_PROGRESS 0xffff
 
+#if MEMFAULT_EVENT_STORAGE_RESERVED_WRITES_ENABLED
+//! Set in the header of a reserved event which was rolled back but could not be removed from
+//! storage because other events had been reserved after it. The reader skips over these.
+  #define MEMFAULT_EVENT_STORAGE_DISCARDED_FLAG 0x8000
+//! Largest event, including its header, that can be stored alongside the discarded flag
+  #define MEMFAULT_EVENT_STORAGE_MAX_EVENT_SIZE (MEMFAULT_EVENT_STORAGE_DISCARDED_FLAG - 1)
+#endif
+
 typedef MEMFAULT_PACKED_STRUCT {
   uint16_t total_size;
 }
@@ -83,6 +100,153 @@ typedef struct {
 } sMfltEventStorageContext;
 static sMfltEventStorageContext s_event_storage;
 
+//! Position of the most recently read event within the active read, so sequential reads of a
+//! batch can resume there instead of walking every event header from the start of the buffer.
+//! Kept outside of s_event_storage so the saved/restored state layout is unaffected. A zeroed
+//! cursor refers to the first event.
+typedef struct {
+  //! Offset of the event's data within the event payload (excluding any batch header)
+  uint32_t payload_offset;
+  //! Offset of the event's sMemfaultEventStorageHeader within the circular buffer
+  uint32_t storage_offset;
+} sMemfaultEventStorageReadCursor;
+static sMemfaultEventStorageReadCursor s_read_cursor;
+
+#if MEMFAULT_EVENT_STORAGE_RESERVED_WRITES_ENABLED
+//! Number of reserved events which have not been committed yet. Like the read cursor, these are
+//! kept outside of s_event_storage.
+static size_t s_num_reservations_outstanding;
+//! Storage position just past the most recently reserved event
+static size_t s_reservations_end_idx;
+#endif
+
+#if MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_ENABLED
+//! The metadata shared by the events of a compact batch is captured when the events are written,
+//! so a change (i.e a device serial provisioned after boot) only applies to the events written
+//! after it. A batch never spans events written before and after a change. Like the read cursor,
+//! this is kept outside of s_event_storage.
+typedef struct {
+  sMemfaultBatchedEventsMetadata metadata;
+  //! Number of bytes from the front of storage to the end of the events using this metadata. Not
+  //! used for the newest generation, whose events extend to the end of storage.
+  size_t end_offset;
+} sMemfaultEventStorageMetadataGeneration;
+
+typedef struct {
+  //! Oldest first, the first generation applies to the events at the front of storage
+  sMemfaultEventStorageMetadataGeneration
+    generations[MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_MAX_GENERATIONS];
+  size_t num_generations;
+} sMemfaultEventStorageBatchMetadata;
+MEMFAULT_STATIC_ASSERT(MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_MAX_GENERATIONS >= 1,
+                       "At least one generation of event metadata must be tracked");
+static sMemfaultEventStorageBatchMetadata s_batch_metadata;
+//! Metadata of the event being written. Only accessed with memfault_lock() held.
+static sMemfaultBatchedEventsMetadata s_write_metadata;
+//! Number of events not stored because their metadata could not be tracked
+static uint32_t s_metadata_drop_count;
+
+static bool prv_batch_metadata_equal(const sMemfaultBatchedEventsMetadata *a,
+                                     const sMemfaultBatchedEventsMetadata *b) {
+  return (a->length == b->length) && (memcmp(a->data, b->data, a->length) == 0);
+}
+
+//! Drops the newest generations which no longer have any events, i.e because the writes using
+//! them were rolled back. The caller must hold memfault_lock().
+static void prv_drop_empty_metadata_generations(size_t bytes_used) {
+  sMemfaultEventStorageBatchMetadata *metadata = &s_batch_metadata;
+  while ((metadata->num_generations > 1) &&
+         (metadata->generations[metadata->num_generations - 2].end_offset >= bytes_used)) {
+    metadata->num_generations--;
+  }
+}
+
+//! Records the metadata for an event about to be written. The caller must hold memfault_lock().
+//!
+//! @return false if the event can't be stored because its metadata can't be tracked
+static bool prv_capture_write_metadata(void) {
+  if (!memfault_batched_events_capture_metadata(&s_write_metadata)) {
+    MEMFAULT_LOG_ERROR("Event metadata exceeds compact batch header size");
+    s_metadata_drop_count++;
+    return false;
+  }
+
+  sMemfaultEventStorageBatchMetadata *metadata = &s_batch_metadata;
+  const size_t bytes_used = memfault_circular_buffer_get_read_size(&s_event_storage.buffer);
+  if ((bytes_used == 0) || (metadata->num_generations == 0)) {
+    metadata->generations[0].metadata = s_write_metadata;
+    metadata->num_generations = 1;
+    return true;
+  }
+
+  prv_drop_empty_metadata_generations(bytes_used);
+  sMemfaultEventStorageMetadataGeneration *latest =
+    &metadata->generations[metadata->num_generations - 1];
+  if (prv_batch_metadata_equal(&latest->metadata, &s_write_metadata)) {
+    return true;
+  }
+
+  if (metadata->num_generations == MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_MAX_GENERATIONS) {
+    MEMFAULT_LOG_ERROR("Event metadata changed %d times before older events were read",
+                       (int)metadata->num_generations);
+    s_metadata_drop_count++;
+    return false;
+  }
+
+  latest->end_offset = bytes_used;
+  metadata->generations[metadata->num_generations].metadata = s_write_metadata;
+  metadata->num_generations++;
+  return true;
+}
+
+//! @return the number of bytes at the front of storage which can be read in a single batch
+static size_t prv_batch_metadata_readable_size(void) {
+  return (s_batch_metadata.num_generations > 1) ? s_batch_metadata.generations[0].end_offset :
+                                                  SIZE_MAX;
+}
+
+uint32_t memfault_event_storage_read_metadata_drop_count(void) {
+  uint32_t drop_count;
+  memfault_lock();
+  {
+    drop_count = s_metadata_drop_count;
+    s_metadata_drop_count = 0;
+  }
+  memfault_unlock();
+  return drop_count;
+}
+#endif /* MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_ENABLED */
+
+static void prv_reset_read_state(void) {
+  s_event_storage.read_state = (sMemfaultEventStorageReadState){ 0 };
+  s_read_cursor = (sMemfaultEventStorageReadCursor){ 0 };
+}
+
+//! Removes events from the front of storage. The caller must hold memfault_lock().
+static void prv_consume(size_t num_bytes) {
+  memfault_circular_buffer_consume(&s_event_storage.buffer, num_bytes);
+
+#if MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_ENABLED
+  // batches end where the metadata changed, so this never goes past the end of a generation
+  sMemfaultEventStorageBatchMetadata *metadata = &s_batch_metadata;
+  for (size_t i = 0; (i + 1) < metadata->num_generations; i++) {
+    size_t *end_offset = &metadata->generations[i].end_offset;
+    *end_offset -= MEMFAULT_MIN(num_bytes, *end_offset);
+  }
+  while ((metadata->num_generations > 1) && (metadata->generations[0].end_offset == 0)) {
+    memmove(&metadata->generations[0], &metadata->generations[1],
+            (metadata->num_generations - 1) * sizeof(metadata->generations[0]));
+    metadata->num_generations--;
+  }
+#endif
+}
+
+static void prv_reset_batch_metadata(void) {
+#if MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_ENABLED
+  s_batch_metadata = (sMemfaultEventStorageBatchMetadata){ 0 };
+#endif
+}
+
 #if MEMFAULT_EVENT_STORAGE_RESTORE_STATE
 MEMFAULT_STATIC_ASSERT(sizeof(s_event_storage) == MEMFAULT_EVENT_STORAGE_STATE_SIZE_BYTES,
                        "Update MEMFAULT_EVENT_STORAGE_STATE_SIZE_BYTES to match s_event_storage.");
@@ -137,6 +301,25 @@ static void prv_compute_read_state(sMemfaultEventStorageReadState *state) {
       break;
     }
 
+#if MEMFAULT_EVENT_STORAGE_RESERVED_WRITES_ENABLED
+    if ((hdr.total_size & MEMFAULT_EVENT_STORAGE_DISCARDED_FLAG) != 0) {
+      if (state->num_events != 0) {
+        // hand out the events preceding the discarded one first
+        break;
+      }
+      // discarded event at the front of storage, drop it and keep looking
+      prv_consume(hdr.total_size & ~MEMFAULT_EVENT_STORAGE_DISCARDED_FLAG);
+      continue;
+    }
+#endif
+
+#if MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_ENABLED
+    if ((state->active_event_read_size + hdr.total_size) > prv_batch_metadata_readable_size()) {
+      // the events written after the metadata changed are sent in the next batch
+      break;
+    }
+#endif
+
     state->num_events++;
     state->active_event_read_size += hdr.total_size;
 
@@ -154,7 +337,11 @@ static void prv_compute_read_state(sMemfaultEventStorageReadState *state) {
 #endif /* MEMFAULT_EVENT_STORAGE_READ_BATCHING_ENABLED */
   }
 
-#if (MEMFAULT_EVENT_STORAGE_READ_BATCHING_ENABLED != 0)
+#if MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_ENABLED
+  memfault_batched_events_build_compact_header(state->num_events,
+                                               &s_batch_metadata.generations[0].metadata,
+                                               &state->event_header);
+#elif (MEMFAULT_EVENT_STORAGE_READ_BATCHING_ENABLED != 0)
   memfault_batched_events_build_header(state->num_events, &state->event_header);
 #endif
 }
@@ -177,6 +364,7 @@ static bool prv_has_data_ram(size_t *total_size) {
   {
     prv_compute_read_state(&read_state);
     s_event_storage.read_state = read_state;
+    s_read_cursor = (sMemfaultEventStorageReadCursor){ 0 };
   }
   memfault_unlock();
 
@@ -208,6 +396,12 @@ static bool prv_event_storage_read_ram(uint32_t offset, void *buf, size_t buf_le
   uint32_t curr_offset = 0;
   uint32_t read_offset = 0;
 
+  // resume from the last event read if the requested data is at or after it
+  if (offset >= s_read_cursor.payload_offset) {
+    curr_offset = s_read_cursor.payload_offset;
+    read_offset = s_read_cursor.storage_offset;
+  }
+
   while (buf_len > 0) {
     sMemfaultEventStorageHeader hdr = { 0 };
     const bool success =
@@ -227,6 +421,11 @@ static bool prv_event_storage_read_ram(uint32_t offset, void *buf, size_t buf_le
       continue;
     }
 
+    s_read_cursor = (sMemfaultEventStorageReadCursor){
+      .payload_offset = curr_offset,
+      .storage_offset = read_offset - sizeof(hdr),
+    };
+
     // offset within the event to start reading at
     const size_t evt_start_offset = offset - curr_offset;
 
@@ -255,9 +454,8 @@ static void prv_event_storage_mark_event_read_ram(void) {
 
   memfault_lock();
   {
-    memfault_circular_buffer_consume(&s_event_storage.buffer,
-                                     s_event_storage.read_state.active_event_read_size);
-    s_event_storage.read_state = (sMemfaultEventStorageReadState){ 0 };
+    prv_consume(s_event_storage.read_state.active_event_read_size);
+    prv_reset_read_state();
   }
   memfault_unlock();
 }
@@ -273,7 +471,18 @@ static size_t prv_event_storage_storage_begin_write(void) {
   };
   bool success;
   memfault_lock();
-  { success = memfault_circular_buffer_write(&s_event_storage.buffer, &hdr, sizeof(hdr)); }
+  {
+#if MEMFAULT_EVENT_STORAGE_RESERVED_WRITES_ENABLED
+    // appends go to the end of storage so can't be interleaved with outstanding reservations
+    success = (s_num_reservations_outstanding == 0);
+#else
+    success = true;
+#endif
+#if MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_ENABLED
+    success = success && prv_capture_write_metadata();
+#endif
+    success = success && memfault_circular_buffer_write(&s_event_storage.buffer, &hdr, sizeof(hdr));
+  }
   memfault_unlock();
   if (!success) {
     return 0;
@@ -284,7 +493,12 @@ static size_t prv_event_storage_storage_begin_write(void) {
     .bytes_written = sizeof(hdr),
   };
 
+#if MEMFAULT_EVENT_STORAGE_RESERVED_WRITES_ENABLED
+  return MEMFAULT_MIN(memfault_circular_buffer_get_write_size(&s_event_storage.buffer),
+                      MEMFAULT_EVENT_STORAGE_MAX_EVENT_SIZE - sizeof(hdr));
+#else
   return memfault_circular_buffer_get_write_size(&s_event_storage.buffer);
+#endif
 }
 
 static bool prv_event_storage_storage_append_data(const void *bytes, size_t num_bytes) {
@@ -328,6 +542,153 @@ static void prv_event_storage_storage_finish_write(bool rollback) {
 #endif
 }
 
+#if MEMFAULT_EVENT_STORAGE_RESERVED_WRITES_ENABLED
+static bool prv_event_storage_reserve(size_t num_bytes,
+                                      sMemfaultEventStorageReservation *reservation) {
+  const sMemfaultEventStorageHeader hdr = {
+    .total_size = MEMFAULT_EVENT_STORAGE_WRITE_IN_PROGRESS,
+  };
+  bool success;
+  memfault_lock();
+  {
+    // reserve as much of the requested space as is free, the unused part is released on commit
+    const size_t space_available = memfault_circular_buffer_get_write_size(&s_event_storage.buffer);
+    const size_t total_size =
+      MEMFAULT_MIN(MEMFAULT_MIN(num_bytes + sizeof(hdr), space_available),
+                   MEMFAULT_EVENT_STORAGE_MAX_EVENT_SIZE);
+    size_t storage_idx = 0;
+    success = !s_event_storage.write_state.write_in_progress && (num_bytes != 0) &&
+              (total_size > sizeof(hdr));
+  #if MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_ENABLED
+    success = success && prv_capture_write_metadata();
+  #endif
+    success = success &&
+              memfault_circular_buffer_reserve(&s_event_storage.buffer, total_size, &storage_idx);
+    if (success) {
+      // the reader stops at the first in-progress event it finds, so nothing past this point
+      // becomes visible until the reservation is committed
+      memfault_circular_buffer_write_reserved(&s_event_storage.buffer, storage_idx, 0, &hdr,
+                                              sizeof(hdr));
+      s_num_reservations_outstanding++;
+      s_reservations_end_idx = (storage_idx + total_size) % s_event_storage.buffer.total_space;
+      *reservation = (sMemfaultEventStorageReservation){
+        .storage_idx = storage_idx,
+        .size = total_size - sizeof(hdr),
+      };
+    }
+  }
+  memfault_unlock();
+
+  return success;
+}
+
+static bool prv_event_storage_write_reserved(sMemfaultEventStorageReservation *reservation,
+                                             const void *bytes, size_t num_bytes) {
+  if ((reservation->bytes_written + num_bytes) > reservation->size) {
+    return false;
+  }
+
+  // The region is owned by this producer until it is committed, so no lock is needed
+  const bool success = memfault_circular_buffer_write_reserved(
+    &s_event_storage.buffer, reservation->storage_idx,
+    sizeof(sMemfaultEventStorageHeader) + reservation->bytes_written, bytes, num_bytes);
+  if (success) {
+    reservation->bytes_written += num_bytes;
+  }
+  return success;
+}
+
+static void prv_write_reserved_header(size_t storage_idx, size_t offset, size_t total_size) {
+  const sMemfaultEventStorageHeader hdr = { .total_size = (uint16_t)total_size };
+  memfault_circular_buffer_write_reserved(&s_event_storage.buffer, storage_idx, offset, &hdr,
+                                          sizeof(hdr));
+}
+
+//! Copies a reserved event into a new reservation at the end of storage, for the rare case
+//! where the unused tail of its original reservation is too small to hold a discarded event
+//! header. The caller must hold memfault_lock().
+//!
+//! @return true if the event was moved, false if there was no space for the copy
+static bool prv_move_reserved_event_locked(const sMemfaultEventStorageReservation *reservation) {
+  const size_t total_size = reservation->bytes_written + sizeof(sMemfaultEventStorageHeader);
+  size_t storage_idx = 0;
+  if (!memfault_circular_buffer_reserve(&s_event_storage.buffer, total_size, &storage_idx)) {
+    return false;
+  }
+
+  // offset of the original event data relative to the oldest byte in storage
+  const size_t total_space = s_event_storage.buffer.total_space;
+  const size_t read_offset =
+    ((reservation->storage_idx + total_space - s_event_storage.buffer.read_offset) %
+     total_space) +
+    sizeof(sMemfaultEventStorageHeader);
+  for (size_t offset = 0; offset < reservation->bytes_written;) {
+    uint8_t buf[16];
+    const size_t chunk_len = MEMFAULT_MIN(sizeof(buf), reservation->bytes_written - offset);
+    memfault_circular_buffer_read(&s_event_storage.buffer, read_offset + offset, buf, chunk_len);
+    memfault_circular_buffer_write_reserved(&s_event_storage.buffer, storage_idx,
+                                            sizeof(sMemfaultEventStorageHeader) + offset, buf,
+                                            chunk_len);
+    offset += chunk_len;
+  }
+
+  prv_write_reserved_header(storage_idx, 0, total_size);
+  s_reservations_end_idx = (storage_idx + total_size) % total_space;
+  return true;
+}
+
+static bool prv_event_storage_commit_reserved(sMemfaultEventStorageReservation *reservation,
+                                              bool rollback) {
+  bool publish = !rollback && (reservation->bytes_written != 0);
+  const size_t total_size = reservation->size + sizeof(sMemfaultEventStorageHeader);
+  const size_t event_size = reservation->bytes_written + sizeof(sMemfaultEventStorageHeader);
+  const size_t unused_size = publish ? (total_size - event_size) : total_size;
+
+  memfault_lock();
+  {
+    const size_t total_space = s_event_storage.buffer.total_space;
+    const size_t end_idx = (reservation->storage_idx + total_size) % total_space;
+    // trailing bytes of the reservation left in place as a discarded event the reader skips
+    size_t discarded_size = 0;
+    if (end_idx == s_reservations_end_idx) {
+      // most recent reservation, so any unused space can be released outright
+      memfault_circular_buffer_consume_from_end(&s_event_storage.buffer, unused_size);
+      s_reservations_end_idx = (reservation->storage_idx + total_size - unused_size) % total_space;
+  #if MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_ENABLED
+      // events written after a metadata change may have been rolled back, moving the end of
+      // storage before the point the change applied from
+      prv_drop_empty_metadata_generations(
+        memfault_circular_buffer_get_read_size(&s_event_storage.buffer));
+  #endif
+    } else if ((unused_size == 0) || (unused_size >= sizeof(sMemfaultEventStorageHeader))) {
+      discarded_size = unused_size;
+    } else {
+      publish = prv_move_reserved_event_locked(reservation);
+      discarded_size = total_size;
+    }
+
+    if (discarded_size != 0) {
+      prv_write_reserved_header(reservation->storage_idx, total_size - discarded_size,
+                                discarded_size | MEMFAULT_EVENT_STORAGE_DISCARDED_FLAG);
+    }
+    if (publish && (discarded_size != total_size)) {
+      // publishing the header is what makes the event (and everything committed after it)
+      // visible to the reader
+      prv_write_reserved_header(reservation->storage_idx, 0, event_size);
+    }
+    s_num_reservations_outstanding--;
+  }
+  memfault_unlock();
+
+  #if MEMFAULT_EVENT_STORAGE_NV_SUPPORT_ENABLED
+  if (publish) {
+    prv_invoke_request_persist_callback();
+  }
+  #endif
+  return publish;
+}
+#endif /* MEMFAULT_EVENT_STORAGE_RESERVED_WRITES_ENABLED */
+
 static size_t prv_get_size_cb(void) {
   return memfault_circular_buffer_get_read_size(&s_event_storage.buffer) +
          memfault_circular_buffer_get_write_size(&s_event_storage.buffer);
@@ -359,7 +720,12 @@ const sMemfaultEventStorageImpl *memfault_events_storage_boot(void *buf, size_t
     memfault_circular_buffer_init(&s_event_storage.buffer, buf, buf_len);
 
     s_event_storage.write_state = (sMemfaultEventStorageWriteState){ 0 };
-    s_event_storage.read_state = (sMemfaultEventStorageReadState){ 0 };
+    prv_reset_read_state();
+#if MEMFAULT_EVENT_STORAGE_RESERVED_WRITES_ENABLED
+    s_num_reservations_outstanding = 0;
+    s_reservations_end_idx = 0;
+#endif
+    prv_reset_batch_metadata();
   }
 
   static const sMemfaultEventStorageImpl s_event_storage_impl = {
@@ -367,6 +733,11 @@ const sMemfaultEventStorageImpl *memfault_events_storage_boot(void *buf, size_t
     .append_data_cb = &prv_event_storage_storage_append_data,
     .finish_write_cb = &prv_event_storage_storage_finish_write,
     .get_storage_size_cb = &prv_get_size_cb,
+#if MEMFAULT_EVENT_STORAGE_RESERVED_WRITES_ENABLED
+    .reserve_cb = &prv_event_storage_reserve,
+    .write_reserved_cb = &prv_event_storage_write_reserved,
+    .commit_reserved_cb = &prv_event_storage_commit_reserved,
+#endif
   };
   return &s_event_storage_impl;
 }
@@ -396,7 +767,7 @@ static bool prv_nv_event_storage_enabled(void) {
   if (s_nv_event_storage_enabled && !enabled) {
     // This shouldn't happen and is indicative of a failure in nv storage. Let's reset the read
     // state in case we were in the middle of a read() trying to copy data into nv storage.
-    s_event_storage.read_state = (sMemfaultEventStorageReadState){ 0 };
+    prv_reset_read_state();
   }
   if (enabled) {
     // if nonvolatile storage is enabled, it is a configuration error if all the
@@ -519,5 +890,10 @@ void memfault_event_storage_reset(void) {
   // NB: storage implementation is const so cannot be reset
   memset(&s_event_storage.buffer, 0, sizeof(s_event_storage.buffer));
   s_event_storage.write_state = (sMemfaultEventStorageWriteState){ 0 };
-  s_event_storage.read_state = (sMemfaultEventStorageReadState){ 0 };
+  prv_reset_read_state();
+#if MEMFAULT_EVENT_STORAGE_RESERVED_WRITES_ENABLED
+  s_num_reservations_outstanding = 0;
+  s_reservations_end_idx = 0;
+#endif
+  prv_reset_batch_metadata();
 }
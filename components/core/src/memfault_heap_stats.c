@@ -39,6 +39,37 @@ sMfltHeapStats g_memfault_heap_stats = {
 };
 sMfltHeapStatEntry g_memfault_heap_stats_pool[MEMFAULT_HEAP_STATS_MAX_COUNT];
 
+//! Number of slots in the pointer -> entry index hash table. Kept at a load factor of at most 0.5
+//! so probe sequences stay short.
+#define MEMFAULT_HEAP_STATS_HASH_SLOTS MEMFAULT_ROUND_UP_POW2(2 * MEMFAULT_HEAP_STATS_MAX_COUNT)
+
+MEMFAULT_STATIC_ASSERT(MEMFAULT_HEAP_STATS_HASH_SLOTS >= 2 * MEMFAULT_HEAP_STATS_MAX_COUNT,
+                       "Heap stats hash table too small");
+MEMFAULT_STATIC_ASSERT((MEMFAULT_HEAP_STATS_HASH_SLOTS & (MEMFAULT_HEAP_STATS_HASH_SLOTS - 1)) == 0,
+                       "Heap stats hash table size must be a power of 2");
+
+// The bookkeeping below is not part of the coredump-visible state; it only exists so that the
+// malloc & free hooks never have to scan g_memfault_heap_stats_pool.
+
+//! Open-addressing (linear probing) table mapping in-use allocation pointers to their entry in
+//! g_memfault_heap_stats_pool. Slots hold the entry index + 1 so a zeroed table is empty.
+static uint16_t s_heap_stats_hash[MEMFAULT_HEAP_STATS_HASH_SLOTS];
+
+//! For entries in the in-use list, the index of the next newer entry (the reverse of
+//! info.next_entry_index). For freed entries, the index of the next entry in the free queue.
+static uint16_t s_heap_stats_links[MEMFAULT_HEAP_STATS_MAX_COUNT];
+
+//! Oldest entry in the in-use list, evicted when there are no entries left to reuse
+static uint16_t s_heap_stats_tail = MEMFAULT_HEAP_STATS_LIST_END;
+
+//! Queue of freed entries, oldest first
+static uint16_t s_heap_stats_free_head = MEMFAULT_HEAP_STATS_LIST_END;
+static uint16_t s_heap_stats_free_tail = MEMFAULT_HEAP_STATS_LIST_END;
+
+//! Entries are handed out in index order, so [s_heap_stats_never_used, MAX_COUNT) have never
+//! been used
+static uint16_t s_heap_stats_never_used;
+
 static void prv_heap_stats_lock(void) {
 #if MEMFAULT_COREDUMP_HEAP_STATS_LOCK_ENABLE
   memfault_lock();
@@ -58,6 +89,11 @@ void memfault_heap_stats_reset(void) {
     .stats_pool_head = MEMFAULT_HEAP_STATS_LIST_END,
   };
   memset(g_memfault_heap_stats_pool, 0, sizeof(g_memfault_heap_stats_pool));
+  memset(s_heap_stats_hash, 0, sizeof(s_heap_stats_hash));
+  s_heap_stats_tail = MEMFAULT_HEAP_STATS_LIST_END;
+  s_heap_stats_free_head = MEMFAULT_HEAP_STATS_LIST_END;
+  s_heap_stats_free_tail = MEMFAULT_HEAP_STATS_LIST_END;
+  s_heap_stats_never_used = 0;
   prv_heap_stats_unlock();
 }
 
@@ -67,54 +103,148 @@ bool memfault_heap_stats_empty(void) {
   return g_memfault_heap_stats_pool[0].info.size == 0;
 }
 
-//! Get the previous entry index of the entry index to be found
+static size_t prv_hash_slot(const void *ptr) {
+  // allocations are typically at least 4-byte aligned, so mix the upper bits down before masking
+  uint32_t hash = (uint32_t)((uintptr_t)ptr >> 2);
+  hash ^= hash >> 16;
+  hash *= 0x45d9f3bu;
+  hash ^= hash >> 16;
+  return hash & (MEMFAULT_HEAP_STATS_HASH_SLOTS - 1);
+}
+
+static void prv_hash_insert(uint16_t entry_index) {
+  size_t slot = prv_hash_slot(g_memfault_heap_stats_pool[entry_index].ptr);
+  while (s_heap_stats_hash[slot] != 0) {
+    slot = (slot + 1) & (MEMFAULT_HEAP_STATS_HASH_SLOTS - 1);
+  }
+  s_heap_stats_hash[slot] = (uint16_t)(entry_index + 1);
+}
+
+//! Find the hash slot tracking the in-use entry for ptr
+//!
+//! @return the slot or MEMFAULT_HEAP_STATS_HASH_SLOTS if ptr is not tracked
+static size_t prv_hash_find(const void *ptr) {
+  size_t slot = prv_hash_slot(ptr);
+  while (s_heap_stats_hash[slot] != 0) {
+    if (g_memfault_heap_stats_pool[s_heap_stats_hash[slot] - 1].ptr == ptr) {
+      return slot;
+    }
+    slot = (slot + 1) & (MEMFAULT_HEAP_STATS_HASH_SLOTS - 1);
+  }
+  return MEMFAULT_HEAP_STATS_HASH_SLOTS;
+}
+
+//! Remove a slot from the hash table
 //!
-//! Iterates through the entry array checking if entry is in use and if the
-//! next entry index matches the search index. If the previous entry cannot be found,
-//! MEMFAULT_HEAP_STATS_LIST_END is returned
-static uint16_t prv_get_previous_entry(uint16_t search_entry_index) {
-  uint16_t index = MEMFAULT_HEAP_STATS_LIST_END;
-
-  for (size_t i = 0; i < MEMFAULT_ARRAY_SIZE(g_memfault_heap_stats_pool); i++) {
-    sMfltHeapStatEntry *entry = &g_memfault_heap_stats_pool[i];
-    if (entry->info.in_use && entry->info.next_entry_index == search_entry_index) {
-      index = (uint16_t)i;
+//! Uses backward-shift deletion so no tombstones are needed: subsequent entries of the probe
+//! sequence are moved up into the hole unless their home slot lies (cyclically) after it.
+static void prv_hash_remove_slot(size_t slot) {
+  const size_t mask = MEMFAULT_HEAP_STATS_HASH_SLOTS - 1;
+  size_t hole = slot;
+  size_t next = slot;
+  while (true) {
+    next = (next + 1) & mask;
+    const uint16_t value = s_heap_stats_hash[next];
+    if (value == 0) {
       break;
     }
+    const size_t home = prv_hash_slot(g_memfault_heap_stats_pool[value - 1].ptr);
+    // distance from home is computed modulo the table size to handle wrap-around
+    if (((next - home) & mask) >= ((next - hole) & mask)) {
+      s_heap_stats_hash[hole] = value;
+      hole = next;
+    }
+  }
+  s_heap_stats_hash[hole] = 0;
+}
+
+static void prv_hash_remove_entry(uint16_t entry_index) {
+  size_t slot = prv_hash_slot(g_memfault_heap_stats_pool[entry_index].ptr);
+  while (s_heap_stats_hash[slot] != 0) {
+    if (s_heap_stats_hash[slot] == entry_index + 1) {
+      prv_hash_remove_slot(slot);
+      return;
+    }
+    slot = (slot + 1) & (MEMFAULT_HEAP_STATS_HASH_SLOTS - 1);
+  }
+}
+
+//! Remove an entry from the in-use list, patching up its neighbors
+static void prv_list_unlink(uint16_t entry_index) {
+  const uint16_t newer = s_heap_stats_links[entry_index];
+  const uint16_t older = g_memfault_heap_stats_pool[entry_index].info.next_entry_index;
+
+  if (newer != MEMFAULT_HEAP_STATS_LIST_END) {
+    g_memfault_heap_stats_pool[newer].info.next_entry_index = older;
+  } else {
+    g_memfault_heap_stats.stats_pool_head = older;
+  }
+
+  if (older != MEMFAULT_HEAP_STATS_LIST_END) {
+    s_heap_stats_links[older] = newer;
+  } else {
+    s_heap_stats_tail = newer;
   }
 
-  return index;
+  g_memfault_heap_stats_pool[entry_index].info.next_entry_index = MEMFAULT_HEAP_STATS_LIST_END;
+}
+
+//! Insert an entry at the head (newest end) of the in-use list
+static void prv_list_push_head(uint16_t entry_index) {
+  const uint16_t old_head = g_memfault_heap_stats.stats_pool_head;
+
+  g_memfault_heap_stats_pool[entry_index].info.next_entry_index = old_head;
+  s_heap_stats_links[entry_index] = MEMFAULT_HEAP_STATS_LIST_END;
+
+  if (old_head != MEMFAULT_HEAP_STATS_LIST_END) {
+    s_heap_stats_links[old_head] = entry_index;
+  } else {
+    s_heap_stats_tail = entry_index;
+  }
+  g_memfault_heap_stats.stats_pool_head = entry_index;
+}
+
+static void prv_free_queue_push(uint16_t entry_index) {
+  s_heap_stats_links[entry_index] = MEMFAULT_HEAP_STATS_LIST_END;
+  if (s_heap_stats_free_tail != MEMFAULT_HEAP_STATS_LIST_END) {
+    s_heap_stats_links[s_heap_stats_free_tail] = entry_index;
+  } else {
+    s_heap_stats_free_head = entry_index;
+  }
+  s_heap_stats_free_tail = entry_index;
+}
+
+static uint16_t prv_free_queue_pop(void) {
+  const uint16_t entry_index = s_heap_stats_free_head;
+  if (entry_index != MEMFAULT_HEAP_STATS_LIST_END) {
+    s_heap_stats_free_head = s_heap_stats_links[entry_index];
+    if (s_heap_stats_free_head == MEMFAULT_HEAP_STATS_LIST_END) {
+      s_heap_stats_free_tail = MEMFAULT_HEAP_STATS_LIST_END;
+    }
+  }
+  return entry_index;
 }
 
 //! Return the next entry index to write new data to
 //!
-//! First searches for never-used entries, then unused (used + freed) entries.
-//! If none are found then traverses list to oldest (last) entry.
+//! First uses never-used entries, then unused (used + freed) entries, oldest freed first.
+//! If none are available, the oldest (last) entry in the list is evicted.
 static uint16_t prv_get_new_entry_index(void) {
-  sMfltHeapStatEntry *entry;
-  uint16_t unused_index = MEMFAULT_HEAP_STATS_LIST_END;
-
-  for (size_t i = 0; i < MEMFAULT_ARRAY_SIZE(g_memfault_heap_stats_pool); i++) {
-    entry = &g_memfault_heap_stats_pool[i];
-
-    if (!entry->info.in_use) {
-      if (entry->info.size == 0) {
-        return (uint16_t)i;  // favor never used entries
-      }
-      // save the first inactive entry found
-      if (unused_index == MEMFAULT_HEAP_STATS_LIST_END) {
-        unused_index = (uint16_t)i;
-      }
-    }
+  if (s_heap_stats_never_used < MEMFAULT_HEAP_STATS_MAX_COUNT) {
+    return s_heap_stats_never_used++;
   }
 
+  const uint16_t unused_index = prv_free_queue_pop();
   if (unused_index != MEMFAULT_HEAP_STATS_LIST_END) {
     return unused_index;
   }
 
-  // No unused entry found, return the oldest (entry with next index of
-  // MEMFAULT_HEAP_STATS_LIST_END)
-  return prv_get_previous_entry(MEMFAULT_HEAP_STATS_LIST_END);
+  const uint16_t oldest_index = s_heap_stats_tail;
+  if (oldest_index != MEMFAULT_HEAP_STATS_LIST_END) {
+    prv_hash_remove_entry(oldest_index);
+    prv_list_unlink(oldest_index);
+  }
+  return oldest_index;
 }
 
 void memfault_heap_stats_increment_in_use_block_count(void) {
@@ -152,17 +282,8 @@ void memfault_heap_stats_malloc(const void *lr, const void *ptr, size_t size) {
     };
 
     // Append new entry to head of the list
-    new_entry->info.next_entry_index = g_memfault_heap_stats.stats_pool_head;
-    g_memfault_heap_stats.stats_pool_head = new_entry_index;
-
-    // Find next oldest entry (points to new entry)
-    // Update next entry index to MEMFAULT_HEAP_STATS_LIST_END
-    uint16_t next_oldest_entry_index = prv_get_previous_entry(new_entry_index);
-
-    if (next_oldest_entry_index != MEMFAULT_HEAP_STATS_LIST_END) {
-      g_memfault_heap_stats_pool[next_oldest_entry_index].info.next_entry_index =
-        MEMFAULT_HEAP_STATS_LIST_END;
-    }
+    prv_list_push_head(new_entry_index);
+    prv_hash_insert(new_entry_index);
   }
 
   prv_heap_stats_unlock();
@@ -176,28 +297,14 @@ void memfault_heap_stats_free(const void *ptr) {
 #endif
 
     // if the pointer exists in the tracked stats, mark it as freed
-    for (size_t i = 0; i < MEMFAULT_ARRAY_SIZE(g_memfault_heap_stats_pool); i++) {
-      sMfltHeapStatEntry *entry = &g_memfault_heap_stats_pool[i];
-      if ((entry->ptr == ptr) && entry->info.in_use) {
-        entry->info.in_use = 0;
-
-        // Find the entry previous to the removed entry
-        uint16_t previous_entry_index = prv_get_previous_entry((uint16_t)i);
-
-        // If list head removed, set next entry as new list head
-        if (g_memfault_heap_stats.stats_pool_head == i) {
-          g_memfault_heap_stats.stats_pool_head = entry->info.next_entry_index;
-        }
-
-        // If there's a valid previous entry, set its next index to removed entry's
-        if (previous_entry_index != MEMFAULT_HEAP_STATS_LIST_END) {
-          g_memfault_heap_stats_pool[previous_entry_index].info.next_entry_index =
-            entry->info.next_entry_index;
-        }
-
-        entry->info.next_entry_index = MEMFAULT_HEAP_STATS_LIST_END;
-        break;
-      }
+    const size_t slot = prv_hash_find(ptr);
+    if (slot != MEMFAULT_HEAP_STATS_HASH_SLOTS) {
+      const uint16_t entry_index = (uint16_t)(s_heap_stats_hash[slot] - 1);
+      prv_hash_remove_slot(slot);
+
+      g_memfault_heap_stats_pool[entry_index].info.in_use = 0;
+      prv_list_unlink(entry_index);
+      prv_free_queue_push(entry_index);
     }
   }
   prv_heap_stats_unlock();
@@ -32,6 +32,15 @@
   #include "memfault_log_data_source_private.h"
 #endif
 
+#if MEMFAULT_LOG_ISR_STAGING_ENABLED
+  #if defined(__STDC_NO_ATOMICS__)
+    #error "MEMFAULT_LOG_ISR_STAGING_ENABLED requires C11 atomics"
+  #endif
+  #include <stdatomic.h>
+
+  #include "memfault/core/arch.h"
+#endif
+
 #define MEMFAULT_RAM_LOGGER_VERSION 1
 
 typedef struct MfltLogStorageInfo {
@@ -97,6 +106,91 @@ uint32_t memfault_log_get_recorded_count(void) {
   return s_memfault_ram_logger.recorded_msg_count;
 }
 
+#if MEMFAULT_LOG_ISR_STAGING_ENABLED
+
+MEMFAULT_STATIC_ASSERT((MEMFAULT_LOG_ISR_STAGING_NUM_ENTRIES &
+                        (MEMFAULT_LOG_ISR_STAGING_NUM_ENTRIES - 1)) == 0,
+                       "MEMFAULT_LOG_ISR_STAGING_NUM_ENTRIES must be a power of 2");
+MEMFAULT_STATIC_ASSERT(MEMFAULT_LOG_ISR_STAGING_MAX_LINE_LEN <= MEMFAULT_LOG_MAX_LINE_SAVE_LEN,
+                       "MEMFAULT_LOG_ISR_STAGING_MAX_LINE_LEN must be <= "
+                       "MEMFAULT_LOG_MAX_LINE_SAVE_LEN");
+
+typedef struct {
+  //! Set by the producer once the slot is populated, cleared by the drain once it's copied out
+  atomic_bool committed;
+  uint8_t level;
+  uint8_t type;
+  uint8_t len;
+  uint8_t msg[MEMFAULT_LOG_ISR_STAGING_MAX_LINE_LEN];
+} sMfltLogIsrStagingSlot;
+
+//! Multi-producer (ISRs, which may nest), single-consumer (the drain, which runs from task context
+//! with memfault_lock() held) ring of fixed size slots. Producers claim a slot by advancing
+//! write_idx and publish it by setting its committed flag, so an ISR never waits on anything.
+//! The indices are free running and only reduced modulo the number of slots on access.
+typedef struct {
+  atomic_uint write_idx;
+  atomic_uint read_idx;
+  atomic_uint dropped_count;
+  //! The part of dropped_count already added to the logger's dropped_msg_count (consumer only)
+  uint32_t dropped_count_reported;
+  sMfltLogIsrStagingSlot slots[MEMFAULT_LOG_ISR_STAGING_NUM_ENTRIES];
+} sMfltLogIsrStaging;
+static sMfltLogIsrStaging s_isr_staging;
+
+static void prv_isr_staging_reset(void) {
+  atomic_store(&s_isr_staging.write_idx, 0);
+  atomic_store(&s_isr_staging.read_idx, 0);
+  atomic_store(&s_isr_staging.dropped_count, 0);
+  s_isr_staging.dropped_count_reported = 0;
+  for (size_t i = 0; i < MEMFAULT_ARRAY_SIZE(s_isr_staging.slots); i++) {
+    atomic_store(&s_isr_staging.slots[i].committed, false);
+  }
+}
+
+static void prv_isr_staging_push(eMemfaultPlatformLogLevel level, const void *log, size_t log_len,
+                                 eMemfaultLogRecordType log_type) {
+  // compact logs can't be truncated
+  if ((log_type == kMemfaultLogRecordType_Compact) &&
+      (log_len > MEMFAULT_LOG_ISR_STAGING_MAX_LINE_LEN)) {
+    atomic_fetch_add_explicit(&s_isr_staging.dropped_count, 1, memory_order_relaxed);
+    return;
+  }
+
+  unsigned int write_idx = atomic_load_explicit(&s_isr_staging.write_idx, memory_order_relaxed);
+  do {
+    const unsigned int read_idx =
+      atomic_load_explicit(&s_isr_staging.read_idx, memory_order_acquire);
+    if ((write_idx - read_idx) >= MEMFAULT_LOG_ISR_STAGING_NUM_ENTRIES) {
+      atomic_fetch_add_explicit(&s_isr_staging.dropped_count, 1, memory_order_relaxed);
+      return;
+    }
+  } while (!atomic_compare_exchange_weak_explicit(&s_isr_staging.write_idx, &write_idx,
+                                                  write_idx + 1, memory_order_relaxed,
+                                                  memory_order_relaxed));
+
+  sMfltLogIsrStagingSlot *slot =
+    &s_isr_staging.slots[write_idx % MEMFAULT_LOG_ISR_STAGING_NUM_ENTRIES];
+  const size_t len = MEMFAULT_MIN(log_len, sizeof(slot->msg));
+  slot->level = (uint8_t)level;
+  slot->type = (uint8_t)log_type;
+  slot->len = (uint8_t)len;
+  memcpy(slot->msg, log, len);
+  atomic_store_explicit(&slot->committed, true, memory_order_release);
+}
+
+uint32_t memfault_log_get_isr_dropped_count(void) {
+  return atomic_load_explicit(&s_isr_staging.dropped_count, memory_order_relaxed);
+}
+
+#else
+
+uint32_t memfault_log_get_isr_dropped_count(void) {
+  return 0;
+}
+
+#endif /* MEMFAULT_LOG_ISR_STAGING_ENABLED */
+
 bool memfault_log_get_regions(sMemfaultLogRegions *regions) {
   if (!s_memfault_ram_logger.enabled) {
     return false;
@@ -436,6 +530,93 @@ void memfault_log_save(eMemfaultPlatformLogLevel level, const char *fmt, ...) {
   va_end(args);
 }
 
+//! Writes a log entry to the log buffer. The caller must hold memfault_lock().
+//!
+//! @param timestamp The timestamp to save with the log, or NULL if it has none
+//! @return true if the log was written, false if it was dropped for lack of space
+static bool prv_write_log_locked(eMemfaultPlatformLogLevel level, eMemfaultLogRecordType log_type,
+                                 const uint32_t *timestamp, const void *log, size_t log_len) {
+  const bool timestamped = (timestamp != NULL);
+  const size_t timestamped_len = timestamped ? sizeof(*timestamp) : 0;
+  // total log length for the log entry .len field includes the timestamp.
+  const uint8_t total_log_len = (uint8_t)(log_len + timestamped_len);
+  // circular buffer space needed includes the metadata (hdr + len) and msg
+  const size_t bytes_needed = sizeof(sMfltRamLogEntry) + total_log_len;
+
+  sMfltCircularBuffer *circ_bufp = &s_memfault_ram_logger.circ_buffer;
+  const bool space_free = prv_try_free_space(circ_bufp, (int)bytes_needed);
+  if (!space_free) {
+    s_memfault_ram_logger.dropped_msg_count++;
+    return false;
+  }
+
+  s_memfault_ram_logger.recorded_msg_count++;
+  sMfltRamLogEntry entry = {
+    .hdr = prv_build_header(level, log_type, timestamped),
+    .len = total_log_len,
+  };
+  memfault_circular_buffer_write(circ_bufp, &entry, sizeof(entry));
+  if (timestamped) {
+    memfault_circular_buffer_write(circ_bufp, timestamp, sizeof(*timestamp));
+  }
+  memfault_circular_buffer_write(circ_bufp, log, log_len);
+  return true;
+}
+
+//! @return timestamp_val populated with the time to save with a log, or NULL if the log should not
+//! be timestamped
+static const uint32_t *prv_get_timestamp(MEMFAULT_UNUSED uint32_t *timestamp_val) {
+#if MEMFAULT_LOG_TIMESTAMPS_ENABLE
+  sMemfaultCurrentTime timestamp;
+  if (memfault_platform_time_get_current(&timestamp)) {
+    *timestamp_val = (uint32_t)timestamp.info.unix_timestamp_secs;
+    return timestamp_val;
+  }
+#endif
+  return NULL;
+}
+
+//! @return true if any log was written to the log buffer
+static bool prv_drain_isr_logs_locked(void) {
+#if MEMFAULT_LOG_ISR_STAGING_ENABLED
+  bool log_written = false;
+  unsigned int read_idx = atomic_load_explicit(&s_isr_staging.read_idx, memory_order_relaxed);
+  while (1) {
+    sMfltLogIsrStagingSlot *slot =
+      &s_isr_staging.slots[read_idx % MEMFAULT_LOG_ISR_STAGING_NUM_ENTRIES];
+    // stop at the first slot which is still being written, it will be picked up next time
+    if (!atomic_load_explicit(&slot->committed, memory_order_acquire)) {
+      break;
+    }
+
+    // ISR logs are not timestamped, the platform time may not be readable from an ISR
+    log_written |= prv_write_log_locked((eMemfaultPlatformLogLevel)slot->level,
+                                        (eMemfaultLogRecordType)slot->type, NULL, slot->msg,
+                                        slot->len);
+
+    atomic_store_explicit(&slot->committed, false, memory_order_relaxed);
+    read_idx++;
+    // hands the slot back to the producers
+    atomic_store_explicit(&s_isr_staging.read_idx, read_idx, memory_order_release);
+  }
+
+  const uint32_t dropped_count =
+    atomic_load_explicit(&s_isr_staging.dropped_count, memory_order_relaxed);
+  s_memfault_ram_logger.dropped_msg_count += dropped_count - s_isr_staging.dropped_count_reported;
+  s_isr_staging.dropped_count_reported = dropped_count;
+  return log_written;
+#else
+  return false;
+#endif
+}
+
+void memfault_log_drain_isr_logs_locked(void) {
+  if (!s_memfault_ram_logger.enabled) {
+    return;
+  }
+  prv_drain_isr_logs_locked();
+}
+
 static void prv_log_save(eMemfaultPlatformLogLevel level, const void *log, size_t log_len,
                          eMemfaultLogRecordType log_type, bool should_lock) {
   if (!prv_should_log(level)) {
@@ -448,48 +629,30 @@ static void prv_log_save(eMemfaultPlatformLogLevel level, const void *log, size_
     return;
   }
 
-  bool log_written = false;
-#if MEMFAULT_LOG_TIMESTAMPS_ENABLE
-  sMemfaultCurrentTime timestamp;
-  const bool timestamped = memfault_platform_time_get_current(&timestamp);
-  uint32_t timestamp_val;  // forward declaration for sizeof()
-  const size_t timestamped_len = timestamped ? sizeof(timestamp_val) : 0;
-#else
-  const bool timestamped = false;
-  const size_t timestamped_len = 0;
+#if MEMFAULT_LOG_ISR_STAGING_ENABLED
+  if (memfault_arch_is_inside_isr()) {
+    // memfault_lock() can't be taken from an ISR, stage the log until the next task level save
+    prv_isr_staging_push(level, log, log_len, log_type);
+    return;
+  }
 #endif
 
+  uint32_t timestamp_val;
+  const uint32_t *timestampp = prv_get_timestamp(&timestamp_val);
+
   // safe to truncate now- this can only happen for preformatted logs
   const size_t truncated_log_len = MEMFAULT_MIN(log_len, MEMFAULT_LOG_MAX_LINE_SAVE_LEN);
-  // total log length for the log entry .len field includes the timestamp.
-  const uint8_t total_log_len = (uint8_t)(truncated_log_len + timestamped_len);
-  // circular buffer space needed includes the metadata (hdr + len) and msg
-  const size_t bytes_needed = sizeof(sMfltRamLogEntry) + total_log_len;
 
+  bool log_written;
   if (should_lock) {
     memfault_lock();
   }
   {
-    sMfltCircularBuffer *circ_bufp = &s_memfault_ram_logger.circ_buffer;
-    const bool space_free = prv_try_free_space(circ_bufp, (int)bytes_needed);
-    if (space_free) {
-      s_memfault_ram_logger.recorded_msg_count++;
-      sMfltRamLogEntry entry = {
-        .hdr = prv_build_header(level, log_type, timestamped),
-        .len = total_log_len,
-      };
-      memfault_circular_buffer_write(circ_bufp, &entry, sizeof(entry));
-#if MEMFAULT_LOG_TIMESTAMPS_ENABLE
-      if (timestamped) {
-        timestamp_val = timestamp.info.unix_timestamp_secs;
-        memfault_circular_buffer_write(circ_bufp, &timestamp_val, sizeof(timestamp_val));
-      }
-#endif
-      memfault_circular_buffer_write(circ_bufp, log, truncated_log_len);
-      log_written = true;
-    } else {
-      s_memfault_ram_logger.dropped_msg_count++;
-    }
+    // save any logs staged from ISRs first so the logs stay in order. The staging ring has a
+    // single consumer, so it's only drained when memfault_lock() is held.
+    const bool isr_log_written = should_lock && prv_drain_isr_logs_locked();
+    log_written = prv_write_log_locked(level, log_type, timestampp, log, truncated_log_len);
+    log_written |= isr_log_written;
   }
   if (should_lock) {
     memfault_unlock();
@@ -502,41 +665,172 @@ static void prv_log_save(eMemfaultPlatformLogLevel level, const void *log, size_
 
 #if MEMFAULT_COMPACT_LOG_ENABLE
 
-void memfault_compact_log_save(eMemfaultPlatformLogLevel level, uint32_t log_id,
-                               uint32_t compressed_fmt, ...) {
-  char log_buf[MEMFAULT_LOG_MAX_LINE_SAVE_LEN + 1];
+//! Destination a compact log is encoded into: either a buffer or a region reserved in the log
+//! buffer, which may wrap around the end of the log buffer
+typedef struct {
+  //! The buffer to encode into, or NULL to encode into the reserved region of the log buffer
+  uint8_t *buf;
+  //! Position of the reserved region in the log buffer and the offset of the log within it
+  size_t storage_idx;
+  size_t base_offset;
+  //! Bytes encoded past this are not written, but are still counted by the encoder so the full
+  //! size of a log which doesn't fit is known without encoding it a second time
+  size_t limit;
+} sMfltCompactLogSink;
+
+static void prv_compact_log_sink_write(void *ctx, uint32_t offset, const void *buf,
+                                       size_t buf_len) {
+  const sMfltCompactLogSink *sink = (const sMfltCompactLogSink *)ctx;
+  if (offset >= sink->limit) {
+    return;
+  }
+  const size_t len = MEMFAULT_MIN(buf_len, sink->limit - offset);
+  if (sink->buf != NULL) {
+    memcpy(&sink->buf[offset], buf, len);
+  } else {
+    memfault_circular_buffer_write_reserved(&s_memfault_ram_logger.circ_buffer, sink->storage_idx,
+                                            sink->base_offset + offset, buf, len);
+  }
+}
 
+//! Encodes a compact log into the sink. A log longer than MEMFAULT_LOG_MAX_LINE_SAVE_LEN is
+//! replaced with a fallback entry recording its size.
+//!
+//! @return The length of the encoded log, which did not fit in the sink if it exceeds sink->limit,
+//! or 0 if the log could not be serialized
+static size_t prv_compact_log_encode(sMfltCompactLogSink *sink, uint32_t log_id,
+                                     uint32_t compressed_fmt, va_list args) {
   sMemfaultCborEncoder encoder;
-  memfault_cbor_encoder_init(&encoder, memfault_cbor_encoder_memcpy_write, log_buf,
-                             sizeof(log_buf));
+  memfault_cbor_encoder_init(&encoder, prv_compact_log_sink_write, sink, UINT32_MAX);
+  bool success = memfault_vlog_compact_serialize(&encoder, log_id, compressed_fmt, args);
+  const bool no_mem = (memfault_cbor_encoder_get_status(&encoder) ==
+                       MEMFAULT_CBOR_ENCODER_STATUS_ENOMEM);
+  const size_t computed_size = memfault_cbor_encoder_deinit(&encoder);
+
+  const bool too_large = success ? (computed_size > MEMFAULT_LOG_MAX_LINE_SAVE_LEN) : no_mem;
+  if (!too_large) {
+    return success ? computed_size : 0;
+  }
+
+  // The log is too large, insert a placeholder instead. Note: truncation only handles string
+  // content being too long
+  memfault_cbor_encoder_init(&encoder, prv_compact_log_sink_write, sink, UINT32_MAX);
+  success = memfault_vlog_compact_serialize_fallback_entry(&encoder, log_id, computed_size);
+  const size_t bytes_written = memfault_cbor_encoder_deinit(&encoder);
+  return success ? bytes_written : 0;
+}
+
+//! Encodes a compact log straight into reserve_len bytes reserved at the end of the log buffer and
+//! commits it if it fits. The caller must hold memfault_lock().
+//!
+//! @return The length of the encoded log, which was not saved if it exceeds the reserved space, or
+//! 0 if the log could not be serialized
+static size_t prv_compact_log_write_locked(eMemfaultPlatformLogLevel level,
+                                           const uint32_t *timestamp, size_t reserve_len,
+                                           uint32_t log_id, uint32_t compressed_fmt,
+                                           va_list args) {
+  sMfltCircularBuffer *circ_bufp = &s_memfault_ram_logger.circ_buffer;
+  const size_t timestamp_len = (timestamp != NULL) ? sizeof(*timestamp) : 0;
+  const size_t hdr_len = sizeof(sMfltRamLogEntry) + timestamp_len;
+
+  // When there isn't even room for the header, the log is only sized
+  sMfltCompactLogSink sink = { .base_offset = hdr_len };
+  const bool reserved = (reserve_len >= hdr_len) &&
+                        memfault_circular_buffer_reserve(circ_bufp, reserve_len, &sink.storage_idx);
+  if (reserved) {
+    sink.limit = reserve_len - hdr_len;
+  }
+
+  const size_t log_len = prv_compact_log_encode(&sink, log_id, compressed_fmt, args);
+  if ((log_len == 0) || (log_len > sink.limit)) {
+    if (reserved) {
+      memfault_circular_buffer_consume_from_end(circ_bufp, reserve_len);
+    }
+    return log_len;
+  }
+
+  const sMfltRamLogEntry entry = {
+    .hdr = prv_build_header(level, kMemfaultLogRecordType_Compact, timestamp != NULL),
+    .len = (uint8_t)(timestamp_len + log_len),
+  };
+  memfault_circular_buffer_write_reserved(circ_bufp, sink.storage_idx, 0, &entry, sizeof(entry));
+  if (timestamp != NULL) {
+    memfault_circular_buffer_write_reserved(circ_bufp, sink.storage_idx, sizeof(entry), timestamp,
+                                            timestamp_len);
+  }
+  // give back the part of the reservation the log didn't need
+  memfault_circular_buffer_consume_from_end(circ_bufp, sink.limit - log_len);
+  s_memfault_ram_logger.recorded_msg_count++;
+  return log_len;
+}
+
+void memfault_compact_log_save(eMemfaultPlatformLogLevel level, uint32_t log_id,
+                               uint32_t compressed_fmt, ...) {
+  if (!prv_should_log(level)) {
+    return;
+  }
 
   va_list args;
-  va_start(args, compressed_fmt);
-  bool success = memfault_vlog_compact_serialize(&encoder, log_id, compressed_fmt, args);
-  va_end(args);
+  #if MEMFAULT_LOG_ISR_STAGING_ENABLED
+  if (memfault_arch_is_inside_isr()) {
+    // memfault_lock() can't be taken to encode into the log buffer, encode the log into a buffer
+    // it can be staged from
+    uint8_t log_buf[MEMFAULT_LOG_MAX_LINE_SAVE_LEN];
+    sMfltCompactLogSink sink = { .buf = log_buf, .limit = sizeof(log_buf) };
+    va_start(args, compressed_fmt);
+    const size_t log_len = prv_compact_log_encode(&sink, log_id, compressed_fmt, args);
+    va_end(args);
+    if ((log_len != 0) && (log_len <= sink.limit)) {
+      prv_log_save(level, log_buf, log_len, kMemfaultLogRecordType_Compact, true);
+    }
+    return;
+  }
+  #endif
+
+  uint32_t timestamp_val;
+  const uint32_t *timestampp = prv_get_timestamp(&timestamp_val);
+  const size_t hdr_len = sizeof(sMfltRamLogEntry) + ((timestampp != NULL) ? sizeof(uint32_t) : 0);
+  sMfltCircularBuffer *circ_bufp = &s_memfault_ram_logger.circ_buffer;
 
-  if (!success) {
-    // if we failed serialization due to lack of space (entire CBOR structure too large),
-    // insert a placeholder instead. Note: truncation only handles string content being too long
-    if (memfault_cbor_encoder_get_status(&encoder) == MEMFAULT_CBOR_ENCODER_STATUS_ENOMEM) {
-      // first compute serialized size
-      memfault_cbor_encoder_size_only_init(&encoder);
-      va_start(args, compressed_fmt);
-      memfault_vlog_compact_serialize(&encoder, log_id, compressed_fmt, args);
-      va_end(args);
-      size_t computed_size = memfault_cbor_encoder_deinit(&encoder);
-
-      // now serialize the fallback entry
-      memfault_cbor_encoder_init(&encoder, memfault_cbor_encoder_memcpy_write, log_buf,
-                                 sizeof(log_buf));
-      success = memfault_vlog_compact_serialize_fallback_entry(&encoder, log_id, computed_size);
+  bool log_written;
+  memfault_lock();
+  {
+    // save any logs staged from ISRs first so the logs stay in order
+    log_written = prv_drain_isr_logs_locked();
+
+    // Encode straight into the space that is free right now, without expiring old logs. The
+    // unused part of it is given back once the size of the log is known.
+    size_t reserve_len = memfault_circular_buffer_get_write_size(circ_bufp);
+    va_start(args, compressed_fmt);
+    size_t log_len = prv_compact_log_write_locked(level, timestampp, reserve_len, log_id,
+                                                  compressed_fmt, args);
+    va_end(args);
+
+    if ((log_len != 0) && ((hdr_len + log_len) > reserve_len)) {
+      // The log didn't fit, but its exact size is known now. Expire old logs to make room for it
+      // and encode it again.
+      reserve_len = hdr_len + log_len;
+      bool saved = false;
+      if (prv_try_free_space(circ_bufp, (int)reserve_len)) {
+        va_start(args, compressed_fmt);
+        log_len = prv_compact_log_write_locked(level, timestampp, reserve_len, log_id,
+                                               compressed_fmt, args);
+        va_end(args);
+        saved = (log_len != 0) && ((hdr_len + log_len) <= reserve_len);
+      }
+      if (saved) {
+        log_written = true;
+      } else {
+        s_memfault_ram_logger.dropped_msg_count++;
+      }
+    } else if (log_len != 0) {
+      log_written = true;
     }
   }
+  memfault_unlock();
 
-  // if we succeeded in serializing either the original or fallback entry, save it
-  if (success) {
-    const size_t bytes_written = memfault_cbor_encoder_deinit(&encoder);
-    prv_log_save(level, log_buf, bytes_written, kMemfaultLogRecordType_Compact, true);
+  if (log_written) {
+    memfault_log_handle_saved_callback();
   }
 }
 
@@ -603,6 +897,9 @@ void memfault_log_reset(void) {
   s_memfault_ram_logger = (sMfltRamLogger){
     .enabled = false,
   };
+#if MEMFAULT_LOG_ISR_STAGING_ENABLED
+  prv_isr_staging_reset();
+#endif
 }
 
 bool memfault_log_booted(void) {
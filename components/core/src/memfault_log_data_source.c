@@ -8,12 +8,14 @@
 
 #if MEMFAULT_LOG_DATA_SOURCE_ENABLED
 
+  #include <stddef.h>
   #include <stdint.h>
   #include <string.h>
 
   #include "memfault/core/compiler.h"
   #include "memfault/core/data_packetizer_source.h"
   #include "memfault/core/log.h"
+  #include "memfault/core/log_impl.h"
   #include "memfault/core/math.h"
   #include "memfault/core/platform/overrides.h"
   #include "memfault/core/platform/system_time.h"
@@ -23,10 +25,26 @@
   #include "memfault_log_data_source_private.h"
   #include "memfault_log_private.h"
 
+//! Tracks how far the previous read_msg_cb call got, so sequential reads can resume encoding
+//! where it left off instead of re-encoding the message from the start. The cursor always points
+//! at the beginning of a log entry (or the message header), so at most one entry is re-encoded
+//! per read.
+typedef struct {
+  //! true once the event metadata and log array header have been emitted
+  bool header_encoded;
+  //! offset within the encoded message where the entry at 'read_offset' begins
+  uint32_t encoded_offset;
+  //! position in the log buffer of the next entry to encode
+  uint32_t read_offset;
+  //! number of logs which have been completely encoded
+  size_t num_encoded_logs;
+} sMfltLogReadCursor;
+
 typedef struct {
   bool triggered;
   size_t num_logs;
   sMemfaultCurrentTime trigger_time;
+  sMfltLogReadCursor read_cursor;
 } sMfltLogDataSourceCtx;
 
 static sMfltLogDataSourceCtx s_memfault_log_data_source_ctx;
@@ -68,6 +86,9 @@ void memfault_log_trigger_collection(void) {
       return;
     }
 
+    // include any logs issued from ISRs since the last log was saved
+    memfault_log_drain_isr_logs_locked();
+
     sMfltLogCountingCtx ctx = { 0 };
     sMfltLogIterator iter = { .user_ctx = &ctx };
     memfault_log_iterate_locked(prv_log_iterate_counting_callback, &iter);
@@ -81,6 +102,7 @@ void memfault_log_trigger_collection(void) {
       s_memfault_log_data_source_ctx.trigger_time.type = kMemfaultCurrentTimeType_Unknown;
     }
     s_memfault_log_data_source_ctx.num_logs = ctx.num_logs;
+    s_memfault_log_data_source_ctx.read_cursor = (sMfltLogReadCursor){ 0 };
   }
   memfault_unlock();
 }
@@ -171,8 +193,7 @@ static bool prv_log_iterate_encode_callback(sMfltLogIterator *iter) {
   return true;
 }
 
-static bool prv_encode(sMemfaultCborEncoder *encoder, void *iter) {
-  sMfltLogEncodingCtx *ctx = (sMfltLogEncodingCtx *)((sMfltLogIterator *)iter)->user_ctx;
+static bool prv_encode_header(sMemfaultCborEncoder *encoder, const sMfltLogEncodingCtx *ctx) {
   #if MEMFAULT_LOG_TIMESTAMPS_ENABLE
   eMemfaultEventType event_type = kMemfaultEventType_LogsTimestamped;
   // To save space, all logs are encoded into a single array (as opposed to using a map or
@@ -191,7 +212,12 @@ static bool prv_encode(sMemfaultCborEncoder *encoder, void *iter) {
     return false;
   }
 
-  if (!memfault_cbor_encode_array_begin(encoder, elements_per_log * ctx->num_logs)) {
+  return memfault_cbor_encode_array_begin(encoder, elements_per_log * ctx->num_logs);
+}
+
+static bool prv_encode(sMemfaultCborEncoder *encoder, void *iter) {
+  sMfltLogEncodingCtx *ctx = (sMfltLogEncodingCtx *)((sMfltLogIterator *)iter)->user_ctx;
+  if (!prv_encode_header(encoder, ctx)) {
     return false;
   }
   memfault_log_iterate(prv_log_iterate_encode_callback, (sMfltLogIterator *)iter);
@@ -210,6 +236,9 @@ static bool prv_has_logs(size_t *total_size) {
     return false;
   }
 
+  // A new message is about to be read, start encoding from the beginning
+  s_memfault_log_data_source_ctx.read_cursor = (sMfltLogReadCursor){ 0 };
+
   sMfltLogEncodingCtx ctx;
   prv_init_encoding_ctx(&ctx);
 
@@ -220,24 +249,35 @@ static bool prv_has_logs(size_t *total_size) {
 }
 
 typedef struct {
+  // Note: must be the first member, the iterator callbacks receive a pointer to it as user_ctx
+  sMfltLogEncodingCtx encoding_ctx;
   uint32_t offset;
   uint8_t *buf;
   size_t buf_len;
   size_t data_source_bytes_written;
-  sMfltLogEncodingCtx encoding_ctx;
+  // offset within the message of the first byte produced by the encoder
+  uint32_t encoder_base_offset;
+  // offset within the message just past the last byte produced by the encoder
+  uint32_t encoded_end_offset;
+  sMfltLogReadCursor *cursor;
 } sMfltLogsDestCtx;
+MEMFAULT_STATIC_ASSERT(offsetof(sMfltLogsDestCtx, encoding_ctx) == 0,
+                       "encoding_ctx must be the first member of sMfltLogsDestCtx");
 
-static void prv_encoder_callback(void *encoder_ctx, uint32_t src_offset, const void *src_buf,
+static void prv_encoder_callback(void *encoder_ctx, uint32_t encoder_offset, const void *src_buf,
                                  size_t src_buf_len) {
   sMfltLogsDestCtx *dest = (sMfltLogsDestCtx *)encoder_ctx;
 
+  const size_t src_offset = dest->encoder_base_offset + encoder_offset;
   const size_t dest_end_offset = dest->offset + dest->buf_len;
+  const size_t src_end_offset = src_offset + src_buf_len;
+  dest->encoded_end_offset = src_end_offset;
+
   // Optimization: stop encoding if the encoder writes are past the destination buffer:
   if (src_offset > dest_end_offset) {
     dest->encoding_ctx.should_stop_encoding = true;
     return;
   }
-  const size_t src_end_offset = src_offset + src_buf_len;
   const size_t intersection_start_offset = MEMFAULT_MAX(src_offset, dest->offset);
   const size_t intersection_end_offset = MEMFAULT_MIN(src_end_offset, dest_end_offset);
   if (intersection_end_offset <= intersection_start_offset) {
@@ -249,24 +289,70 @@ static void prv_encoder_callback(void *encoder_ctx, uint32_t src_offset, const v
   dest->data_source_bytes_written += intersection_len;
 }
 
+static bool prv_log_iterate_read_callback(sMfltLogIterator *iter) {
+  sMfltLogsDestCtx *const dest = (sMfltLogsDestCtx *)iter->user_ctx;
+  const bool should_continue = prv_log_iterate_encode_callback(iter);
+
+  const size_t dest_end_offset = dest->offset + dest->buf_len;
+  if (dest->encoded_end_offset > dest_end_offset) {
+    // This entry straddles the end of the destination buffer. Leave the cursor pointing at its
+    // start so the next read picks up from here.
+    return false;
+  }
+
+  // The entry was fully emitted, so the next read never needs to encode it again
+  sMfltLogReadCursor *cursor = dest->cursor;
+  cursor->encoded_offset = dest->encoded_end_offset;
+  cursor->read_offset = iter->read_offset + sizeof(iter->entry) + iter->entry.len;
+  cursor->num_encoded_logs = dest->encoding_ctx.num_encoded_logs;
+  return should_continue && (dest->encoded_end_offset < dest_end_offset);
+}
+
 static bool prv_logs_read(uint32_t offset, void *buf, size_t buf_len) {
+  sMfltLogReadCursor *cursor = &s_memfault_log_data_source_ctx.read_cursor;
+  if (offset < cursor->encoded_offset) {
+    // Reads are expected to be sequential. If the offset went backwards (i.e the message is
+    // being re-sent after memfault_packetizer_abort()), fall back to encoding from the start.
+    *cursor = (sMfltLogReadCursor){ 0 };
+  }
+
   sMfltLogsDestCtx dest_ctx = (sMfltLogsDestCtx){
     .offset = offset,
     .buf = (uint8_t *)buf,
     .buf_len = buf_len,
+    .encoder_base_offset = cursor->encoded_offset,
+    .encoded_end_offset = cursor->encoded_offset,
+    .cursor = cursor,
   };
+  sMfltLogEncodingCtx *encoding_ctx = &dest_ctx.encoding_ctx;
 
-  sMfltLogIterator iter = {
-    .user_ctx = &dest_ctx.encoding_ctx,
-  };
-
-  prv_init_encoding_ctx(&dest_ctx.encoding_ctx);
+  prv_init_encoding_ctx(encoding_ctx);
+  encoding_ctx->num_encoded_logs = cursor->num_encoded_logs;
   // Note: UINT_MAX is passed as length, because it is possible and expected that the output is
   // written partially by the callback. The callback takes care of not overrunning the output buffer
   // itself.
-  memfault_cbor_encoder_init(&dest_ctx.encoding_ctx.encoder, prv_encoder_callback, &dest_ctx,
-                             UINT32_MAX);
-  prv_encode(&dest_ctx.encoding_ctx.encoder, &iter);
+  memfault_cbor_encoder_init(&encoding_ctx->encoder, prv_encoder_callback, &dest_ctx, UINT32_MAX);
+
+  const size_t dest_end_offset = offset + buf_len;
+  if (!cursor->header_encoded) {
+    if (!prv_encode_header(&encoding_ctx->encoder, encoding_ctx)) {
+      return false;
+    }
+    if (dest_ctx.encoded_end_offset > dest_end_offset) {
+      return buf_len == dest_ctx.data_source_bytes_written;
+    }
+    cursor->header_encoded = true;
+    cursor->encoded_offset = dest_ctx.encoded_end_offset;
+  }
+
+  if ((dest_ctx.encoded_end_offset < dest_end_offset) &&
+      (cursor->num_encoded_logs < encoding_ctx->num_logs)) {
+    sMfltLogIterator iter = {
+      .read_offset = cursor->read_offset,
+      .user_ctx = &dest_ctx,
+    };
+    memfault_log_iterate(prv_log_iterate_read_callback, &iter);
+  }
   return buf_len == dest_ctx.data_source_bytes_written;
 }
 
@@ -127,6 +127,7 @@ typedef bool (*MemfaultLogMsgCopyCallback)(sMfltLogIterator *iter, size_t offset
 //! assumes memfault_lock has been taken by the caller).
 bool memfault_log_iter_copy_msg(sMfltLogIterator *iter, MemfaultLogMsgCopyCallback callback);
 
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,450 @@
+//! @file
+//!
+//! Copyright (c) Memfault, Inc.
+//! See LICENSE for details
+//!
+//! @brief
+//! A log-structured non-volatile event store. See memfault/core/nv_event_log.h for details.
+//!
+//! Layout of the flash region:
+//!
+//!   Every sector in use starts with a sMfltNvEventLogSectorHdr holding a sequence number which
+//!   increments each time a sector is (re)opened for writing. The sectors in use are always a
+//!   contiguous run (wrapping around the end of the region) from the oldest to the most recently
+//!   opened sector, so sectors are erased in turn, which levels the wear across the region.
+//!
+//!   [ sector hdr ][ record hdr | event | pad ][ record hdr | event | pad ]...[ erased ]
+//!
+//!   Records are padded to a multiple of 4 bytes. A record that would not fit in the remainder of
+//!   the sector is written at the start of the next sector instead.
+
+#include <stddef.h>
+#include <string.h>
+
+#include "memfault/config.h"
+
+#if MEMFAULT_NV_EVENT_LOG_ENABLED
+
+  #include "memfault/core/compiler.h"
+  #include "memfault/core/debug_log.h"
+  #include "memfault/core/math.h"
+  #include "memfault/core/nv_event_log.h"
+  #include "memfault/core/platform/nonvolatile_event_storage.h"
+  #include "memfault/core/platform/nv_event_log.h"
+  #include "memfault/util/crc16.h"
+
+  #if !MEMFAULT_EVENT_STORAGE_NV_SUPPORT_ENABLED
+    #error "MEMFAULT_NV_EVENT_LOG_ENABLED requires MEMFAULT_EVENT_STORAGE_NV_SUPPORT_ENABLED=1"
+  #endif
+
+  #define MEMFAULT_NV_EVENT_LOG_SECTOR_MAGIC 0x4d464c47  // 'MFLG'
+  #define MEMFAULT_NV_EVENT_LOG_RECORD_MAGIC 0xa5
+  #define MEMFAULT_NV_EVENT_LOG_NOT_CONSUMED 0xff
+  #define MEMFAULT_NV_EVENT_LOG_RECORD_ALIGN 4
+
+typedef MEMFAULT_PACKED_STRUCT MfltNvEventLogSectorHdr {
+  uint32_t seq;
+  //! Programmed after seq, so a header torn by a power loss is never mistaken for a valid one
+  uint32_t magic;
+}
+sMfltNvEventLogSectorHdr;
+
+typedef MEMFAULT_PACKED_STRUCT MfltNvEventLogRecordHdr {
+  uint8_t magic;
+  //! Cleared to 0 when the event is consumed
+  uint8_t consumed;
+  uint16_t len;
+  //! CRC16 over len and the event data
+  uint16_t crc16;
+  uint16_t reserved;
+}
+sMfltNvEventLogRecordHdr;
+
+MEMFAULT_STATIC_ASSERT(MEMFAULT_NV_EVENT_LOG_WRITE_BUF_SIZE >= sizeof(sMfltNvEventLogRecordHdr),
+                       "MEMFAULT_NV_EVENT_LOG_WRITE_BUF_SIZE must hold at least a record header");
+
+typedef struct {
+  bool booted;
+  size_t sector_size;
+  size_t num_sectors;
+  //! The sectors in use run from oldest_sector to write_sector
+  size_t num_live_sectors;
+  size_t oldest_sector;
+  size_t write_sector;
+  uint32_t next_seq;
+  //! Where the next record will be written, within write_sector
+  uint32_t write_offset;
+  //! Set when write_sector can't be written to anymore (i.e after a failed write)
+  bool write_sector_closed;
+  //! The oldest event which has not been consumed yet. Only valid when num_events != 0
+  uint32_t read_offset;
+  size_t read_len;
+  size_t num_events;
+  uint32_t sector_erase_count;
+} sMfltNvEventLog;
+
+static sMfltNvEventLog s_nv_event_log;
+
+static uint32_t prv_sector_start(size_t sector) {
+  return (uint32_t)(sector * s_nv_event_log.sector_size);
+}
+
+static uint32_t prv_sector_end(size_t sector) {
+  return prv_sector_start(sector) + (uint32_t)s_nv_event_log.sector_size;
+}
+
+static size_t prv_sector_of(uint32_t offset) {
+  return offset / s_nv_event_log.sector_size;
+}
+
+static size_t prv_next_sector(size_t sector) {
+  return (sector + 1) % s_nv_event_log.num_sectors;
+}
+
+static uint32_t prv_first_record_offset(size_t sector) {
+  return prv_sector_start(sector) + sizeof(sMfltNvEventLogSectorHdr);
+}
+
+static uint32_t prv_record_size(size_t len) {
+  const size_t padded_len = (len + MEMFAULT_NV_EVENT_LOG_RECORD_ALIGN - 1) &
+                            ~((size_t)MEMFAULT_NV_EVENT_LOG_RECORD_ALIGN - 1);
+  return (uint32_t)(sizeof(sMfltNvEventLogRecordHdr) + padded_len);
+}
+
+static bool prv_read_sector_hdr(size_t sector, uint32_t *seq) {
+  sMfltNvEventLogSectorHdr hdr;
+  if (!memfault_platform_nv_event_log_read(prv_sector_start(sector), &hdr, sizeof(hdr)) ||
+      (hdr.magic != MEMFAULT_NV_EVENT_LOG_SECTOR_MAGIC)) {
+    return false;
+  }
+  *seq = hdr.seq;
+  return true;
+}
+
+//! @return true if a record which fits in the sector is stored at offset
+static bool prv_read_record_hdr(size_t sector, uint32_t offset, sMfltNvEventLogRecordHdr *hdr) {
+  const uint32_t sector_end = prv_sector_end(sector);
+  if ((offset + sizeof(*hdr)) > sector_end) {
+    return false;
+  }
+  if (!memfault_platform_nv_event_log_read(offset, hdr, sizeof(*hdr)) ||
+      (hdr->magic != MEMFAULT_NV_EVENT_LOG_RECORD_MAGIC)) {
+    return false;
+  }
+  return (offset + prv_record_size(hdr->len)) <= sector_end;
+}
+
+static bool prv_record_crc_valid(uint32_t offset, const sMfltNvEventLogRecordHdr *hdr) {
+  uint16_t crc = memfault_crc16_compute(MEMFAULT_CRC16_INITIAL_VALUE, &hdr->len, sizeof(hdr->len));
+  uint8_t buf[MEMFAULT_NV_EVENT_LOG_WRITE_BUF_SIZE];
+  const uint32_t data_offset = offset + sizeof(*hdr);
+  for (size_t i = 0; i < hdr->len; i += sizeof(buf)) {
+    const size_t read_len = MEMFAULT_MIN(sizeof(buf), hdr->len - i);
+    if (!memfault_platform_nv_event_log_read(data_offset + (uint32_t)i, buf, read_len)) {
+      return false;
+    }
+    crc = memfault_crc16_compute(crc, buf, read_len);
+  }
+  return crc == hdr->crc16;
+}
+
+static bool prv_mark_consumed(uint32_t offset) {
+  const uint8_t consumed = 0;
+  return memfault_platform_nv_event_log_write(
+    offset + offsetof(sMfltNvEventLogRecordHdr, consumed), &consumed, sizeof(consumed));
+}
+
+//! Finds the first record at or after offset which has not been consumed. Must only be called
+//! when such a record exists (num_events != 0).
+static uint32_t prv_find_unconsumed_record(size_t sector, uint32_t offset, size_t *len) {
+  for (size_t i = 0; i <= s_nv_event_log.num_sectors; i++) {
+    sMfltNvEventLogRecordHdr hdr;
+    while (prv_read_record_hdr(sector, offset, &hdr)) {
+      if (hdr.consumed == MEMFAULT_NV_EVENT_LOG_NOT_CONSUMED) {
+        *len = hdr.len;
+        return offset;
+      }
+      offset += prv_record_size(hdr.len);
+    }
+    // no more records in this sector
+    sector = prv_next_sector(sector);
+    offset = prv_first_record_offset(sector);
+  }
+
+  // only reachable if the flash contents changed underneath us
+  MEMFAULT_LOG_ERROR("NV event log corrupted");
+  s_nv_event_log.num_events = 0;
+  return s_nv_event_log.write_offset;
+}
+
+//! Walks the records of a sector in use, updating the read and write positions
+static void prv_recover_sector(size_t sector) {
+  const bool is_write_sector = (sector == s_nv_event_log.write_sector);
+  uint32_t offset = prv_first_record_offset(sector);
+
+  sMfltNvEventLogRecordHdr hdr;
+  while (prv_read_record_hdr(sector, offset, &hdr)) {
+    if (!prv_record_crc_valid(offset, &hdr)) {
+      // the event was only partially written when the device lost power. Discard it, and as the
+      // data following it can't be trusted, don't write anything else to this sector.
+      if (hdr.consumed == MEMFAULT_NV_EVENT_LOG_NOT_CONSUMED) {
+        prv_mark_consumed(offset);
+      }
+      s_nv_event_log.write_sector_closed |= is_write_sector;
+      break;
+    }
+
+    if (hdr.consumed == MEMFAULT_NV_EVENT_LOG_NOT_CONSUMED) {
+      if (s_nv_event_log.num_events == 0) {
+        s_nv_event_log.read_offset = offset;
+        s_nv_event_log.read_len = hdr.len;
+      }
+      s_nv_event_log.num_events++;
+    }
+    offset += prv_record_size(hdr.len);
+  }
+
+  if (!is_write_sector) {
+    return;
+  }
+
+  s_nv_event_log.write_offset = offset;
+  // anything other than erased flash after the last record means a record header was torn
+  uint8_t next_byte = 0xff;
+  if ((offset < prv_sector_end(sector)) &&
+      (!memfault_platform_nv_event_log_read(offset, &next_byte, sizeof(next_byte)) ||
+       (next_byte != 0xff))) {
+    s_nv_event_log.write_sector_closed = true;
+  }
+}
+
+bool memfault_nv_event_log_boot(void) {
+  sMfltNvEventLogStorageInfo info = { 0 };
+  memfault_platform_nv_event_log_get_info(&info);
+
+  s_nv_event_log = (sMfltNvEventLog){
+    .sector_size = info.sector_size,
+    .num_sectors = (info.sector_size != 0) ? (info.size / info.sector_size) : 0,
+  };
+
+  const size_t min_sector_size =
+    sizeof(sMfltNvEventLogSectorHdr) + prv_record_size(MEMFAULT_NV_EVENT_LOG_RECORD_ALIGN);
+  if ((s_nv_event_log.num_sectors < 2) || ((info.size % info.sector_size) != 0) ||
+      (info.sector_size < min_sector_size)) {
+    MEMFAULT_LOG_ERROR("Invalid NV event log storage: size=%d sector_size=%d", (int)info.size,
+                       (int)info.sector_size);
+    return false;
+  }
+
+  // The most recently opened sector is the one with the highest sequence number
+  uint32_t max_seq = 0;
+  for (size_t sector = 0; sector < s_nv_event_log.num_sectors; sector++) {
+    uint32_t seq;
+    if (prv_read_sector_hdr(sector, &seq) &&
+        ((s_nv_event_log.num_live_sectors == 0) || (seq > max_seq))) {
+      max_seq = seq;
+      s_nv_event_log.write_sector = sector;
+      s_nv_event_log.num_live_sectors = 1;
+    }
+  }
+
+  if (s_nv_event_log.num_live_sectors == 0) {
+    // nothing stored yet, the first write will open sector 0
+    s_nv_event_log.write_sector = s_nv_event_log.num_sectors - 1;
+    s_nv_event_log.booted = true;
+    return true;
+  }
+
+  // walk back through the sectors written before it
+  size_t sector = s_nv_event_log.write_sector;
+  while (s_nv_event_log.num_live_sectors < s_nv_event_log.num_sectors) {
+    sector = (sector + s_nv_event_log.num_sectors - 1) % s_nv_event_log.num_sectors;
+    uint32_t seq;
+    if (!prv_read_sector_hdr(sector, &seq) ||
+        (seq != max_seq - s_nv_event_log.num_live_sectors)) {
+      break;
+    }
+    s_nv_event_log.num_live_sectors++;
+  }
+  s_nv_event_log.oldest_sector =
+    (s_nv_event_log.write_sector + s_nv_event_log.num_sectors + 1 -
+     s_nv_event_log.num_live_sectors) %
+    s_nv_event_log.num_sectors;
+  s_nv_event_log.next_seq = max_seq + 1;
+
+  sector = s_nv_event_log.oldest_sector;
+  for (size_t i = 0; i < s_nv_event_log.num_live_sectors; i++) {
+    prv_recover_sector(sector);
+    sector = prv_next_sector(sector);
+  }
+
+  s_nv_event_log.booted = true;
+  return true;
+}
+
+//! Erases the next sector and starts writing records to it
+static bool prv_open_next_sector(void) {
+  const size_t next_sector = prv_next_sector(s_nv_event_log.write_sector);
+  if (s_nv_event_log.num_live_sectors == 0) {
+    s_nv_event_log.oldest_sector = next_sector;
+  } else if (next_sector == s_nv_event_log.oldest_sector) {
+    // the log has wrapped around, the oldest sector can only be reused once all its events have
+    // been consumed
+    const size_t read_sector = (s_nv_event_log.num_events != 0) ?
+                                 prv_sector_of(s_nv_event_log.read_offset) :
+                                 s_nv_event_log.write_sector;
+    if (read_sector == s_nv_event_log.oldest_sector) {
+      return false;
+    }
+    s_nv_event_log.oldest_sector = prv_next_sector(s_nv_event_log.oldest_sector);
+    s_nv_event_log.num_live_sectors--;
+  }
+
+  // From here on, the sector is no longer part of the log, even if the erase fails
+  s_nv_event_log.write_sector = next_sector;
+  s_nv_event_log.write_sector_closed = true;
+  s_nv_event_log.num_live_sectors++;
+
+  const uint32_t sector_start = prv_sector_start(next_sector);
+  s_nv_event_log.sector_erase_count++;
+  if (!memfault_platform_nv_event_log_erase(sector_start, s_nv_event_log.sector_size)) {
+    return false;
+  }
+
+  const sMfltNvEventLogSectorHdr hdr = {
+    .magic = MEMFAULT_NV_EVENT_LOG_SECTOR_MAGIC,
+    .seq = s_nv_event_log.next_seq++,
+  };
+  if (!memfault_platform_nv_event_log_write(sector_start, &hdr, sizeof(hdr))) {
+    return false;
+  }
+
+  s_nv_event_log.write_offset = prv_first_record_offset(next_sector);
+  s_nv_event_log.write_sector_closed = false;
+  return true;
+}
+
+static bool prv_nv_event_log_enabled(void) {
+  return s_nv_event_log.booted;
+}
+
+static bool prv_nv_event_log_has_event(size_t *event_length_out) {
+  if (!s_nv_event_log.booted || (s_nv_event_log.num_events == 0)) {
+    return false;
+  }
+  *event_length_out = s_nv_event_log.read_len;
+  return true;
+}
+
+static bool prv_nv_event_log_read(uint32_t offset, void *buf, size_t buf_len) {
+  if ((s_nv_event_log.num_events == 0) || ((offset + buf_len) > s_nv_event_log.read_len)) {
+    return false;
+  }
+  return memfault_platform_nv_event_log_read(
+    (uint32_t)(s_nv_event_log.read_offset + sizeof(sMfltNvEventLogRecordHdr) + offset), buf,
+    buf_len);
+}
+
+static void prv_nv_event_log_consume(void) {
+  if (s_nv_event_log.num_events == 0) {
+    return;
+  }
+
+  prv_mark_consumed(s_nv_event_log.read_offset);
+  s_nv_event_log.num_events--;
+  if (s_nv_event_log.num_events != 0) {
+    s_nv_event_log.read_offset = prv_find_unconsumed_record(
+      prv_sector_of(s_nv_event_log.read_offset),
+      s_nv_event_log.read_offset + prv_record_size(s_nv_event_log.read_len),
+      &s_nv_event_log.read_len);
+  }
+}
+
+static bool prv_nv_event_log_write(MemfaultEventReadCallback reader_callback, size_t total_size) {
+  const size_t max_event_size = s_nv_event_log.sector_size - sizeof(sMfltNvEventLogSectorHdr) -
+                                sizeof(sMfltNvEventLogRecordHdr);
+  if (!s_nv_event_log.booted || (total_size == 0) || (total_size > UINT16_MAX) ||
+      (total_size > max_event_size)) {
+    return false;
+  }
+
+  const uint32_t record_size = prv_record_size(total_size);
+  if ((s_nv_event_log.num_live_sectors == 0) || s_nv_event_log.write_sector_closed ||
+      ((s_nv_event_log.write_offset + record_size) >
+       prv_sector_end(s_nv_event_log.write_sector))) {
+    if (!prv_open_next_sector()) {
+      return false;
+    }
+  }
+
+  uint8_t buf[MEMFAULT_NV_EVENT_LOG_WRITE_BUF_SIZE];
+
+  // The CRC is part of the header, so the event is read twice: once to compute the CRC and once
+  // to write it out
+  sMfltNvEventLogRecordHdr hdr = {
+    .magic = MEMFAULT_NV_EVENT_LOG_RECORD_MAGIC,
+    .consumed = MEMFAULT_NV_EVENT_LOG_NOT_CONSUMED,
+    .len = (uint16_t)total_size,
+    .reserved = 0xffff,
+  };
+  uint16_t crc = memfault_crc16_compute(MEMFAULT_CRC16_INITIAL_VALUE, &hdr.len, sizeof(hdr.len));
+  for (size_t i = 0; i < total_size; i += sizeof(buf)) {
+    const size_t read_len = MEMFAULT_MIN(sizeof(buf), total_size - i);
+    if (!reader_callback((uint32_t)i, buf, read_len)) {
+      return false;
+    }
+    crc = memfault_crc16_compute(crc, buf, read_len);
+  }
+  hdr.crc16 = crc;
+
+  // Stage the header and the event data in the buffer so they are written in as few flash
+  // writes as possible
+  const uint32_t record_offset = s_nv_event_log.write_offset;
+  memcpy(buf, &hdr, sizeof(hdr));
+  size_t buf_used = sizeof(hdr);
+  uint32_t flash_offset = record_offset;
+  size_t event_offset = 0;
+  do {
+    const size_t read_len = MEMFAULT_MIN(sizeof(buf) - buf_used, total_size - event_offset);
+    if ((read_len != 0) &&
+        !reader_callback((uint32_t)event_offset, &buf[buf_used], read_len)) {
+      s_nv_event_log.write_sector_closed = true;
+      return false;
+    }
+    buf_used += read_len;
+    event_offset += read_len;
+
+    if (!memfault_platform_nv_event_log_write(flash_offset, buf, buf_used)) {
+      // the contents of the remainder of the sector are unknown now
+      s_nv_event_log.write_sector_closed = true;
+      return false;
+    }
+    flash_offset += (uint32_t)buf_used;
+    buf_used = 0;
+  } while (event_offset < total_size);
+
+  s_nv_event_log.write_offset = record_offset + record_size;
+  if (s_nv_event_log.num_events == 0) {
+    s_nv_event_log.read_offset = record_offset;
+    s_nv_event_log.read_len = total_size;
+  }
+  s_nv_event_log.num_events++;
+  return true;
+}
+
+void memfault_nv_event_log_get_stats(sMfltNvEventLogStats *stats) {
+  *stats = (sMfltNvEventLogStats){
+    .num_events = s_nv_event_log.num_events,
+    .sector_erase_count = s_nv_event_log.sector_erase_count,
+  };
+}
+
+const sMemfaultNonVolatileEventStorageImpl g_memfault_platform_nv_event_storage_impl = {
+  .enabled = prv_nv_event_log_enabled,
+  .has_event = prv_nv_event_log_has_event,
+  .read = prv_nv_event_log_read,
+  .consume = prv_nv_event_log_consume,
+  .write = prv_nv_event_log_write,
+};
+
+#endif /* MEMFAULT_NV_EVENT_LOG_ENABLED */
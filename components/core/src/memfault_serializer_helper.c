@@ -7,12 +7,14 @@
 //! See header for more details
 
 #include <inttypes.h>
+#include <string.h>
 
 #include "memfault/config.h"
 #include "memfault/core/compiler.h"
 #include "memfault/core/debug_log.h"
 #include "memfault/core/event_storage_implementation.h"
 #include "memfault/core/platform/device_info.h"
+#include "memfault/core/platform/overrides.h"
 #include "memfault/core/platform/system_time.h"
 #include "memfault/core/serializer_helper.h"
 #include "memfault/core/serializer_key_ids.h"
@@ -105,62 +107,233 @@ bool memfault_serializer_helper_encode_metadata(sMemfaultCborEncoder *encoder,
   return memfault_serializer_helper_encode_metadata_with_time(encoder, type, &time);
 }
 
-bool memfault_serializer_helper_encode_metadata_with_time(sMemfaultCborEncoder *encoder,
-                                                          eMemfaultEventType type,
-                                                          const sMemfaultCurrentTime *time) {
-  const bool unix_timestamp_available =
-    (time != NULL) && (time->type == kMemfaultCurrentTimeType_UnixEpochTimeSec);
+//! Encodes the part of the event metadata that does not change between events: the CBOR schema
+//! version, the device version info and the (optional) build id
+static bool prv_encode_invariant_metadata(sMemfaultCborEncoder *encoder, const void *build_id) {
+  if (!memfault_serializer_helper_encode_uint32_kv_pair(
+        encoder, kMemfaultEventKey_CborSchemaVersion, MEMFAULT_CBOR_SCHEMA_VERSION_V1)) {
+    return false;
+  }
+
+  if (!prv_encode_device_version_info(encoder)) {
+    return false;
+  }
 
 #if MEMFAULT_EVENT_INCLUDE_BUILD_ID
+  if ((build_id != NULL) && !memfault_serializer_helper_encode_byte_string_kv_pair(
+                               encoder, kMemfaultEventKey_BuildId, build_id,
+                               MEMFAULT_EVENT_INCLUDED_BUILD_ID_SIZE_BYTES)) {
+    return false;
+  }
+#else
+  (void)build_id;
+#endif
+
+  return true;
+}
+
+#if MEMFAULT_EVENT_METADATA_CACHE_ENABLED
+
+typedef enum {
+  kMemfaultMetadataCacheState_Invalid = 0,
+  kMemfaultMetadataCacheState_Valid,
+  //! The invariant metadata does not fit in the cache, it is encoded for every event instead
+  kMemfaultMetadataCacheState_TooLarge,
+} eMemfaultMetadataCacheState;
+
+typedef struct {
+  eMemfaultMetadataCacheState state;
+  bool has_build_id;
+  size_t encoded_len;
+  uint8_t encoded[MEMFAULT_EVENT_METADATA_CACHE_SIZE];
+} sMemfaultMetadataCache;
+
+//! Shared by all the tasks serializing events, so it's only accessed with memfault_lock() held
+static sMemfaultMetadataCache s_metadata_cache;
+
+void memfault_device_info_changed(void) {
+  memfault_lock();
+  s_metadata_cache.state = kMemfaultMetadataCacheState_Invalid;
+  memfault_unlock();
+}
+
+//! @note The caller must hold memfault_lock()
+static bool prv_metadata_cache_load(void) {
+  if (s_metadata_cache.state != kMemfaultMetadataCacheState_Invalid) {
+    return s_metadata_cache.state == kMemfaultMetadataCacheState_Valid;
+  }
+
+  #if MEMFAULT_EVENT_INCLUDE_BUILD_ID
   sMemfaultBuildInfo info;
   const bool has_build_id = memfault_build_info_read(&info);
-#else
+  const void *build_id = has_build_id ? info.build_id : NULL;
+  #else
   const bool has_build_id = false;
-#endif
+  const void *build_id = NULL;
+  #endif
+
+  sMemfaultCborEncoder encoder;
+  memfault_cbor_encoder_init(&encoder, memfault_cbor_encoder_memcpy_write,
+                             s_metadata_cache.encoded, sizeof(s_metadata_cache.encoded));
+  const bool success = prv_encode_invariant_metadata(&encoder, build_id);
+  const size_t encoded_len = memfault_cbor_encoder_deinit(&encoder);
+  if (!success) {
+    MEMFAULT_LOG_WARN("Event metadata does not fit in %d byte cache",
+                      (int)sizeof(s_metadata_cache.encoded));
+    s_metadata_cache.state = kMemfaultMetadataCacheState_TooLarge;
+    return false;
+  }
 
-  const size_t top_level_num_pairs = 1 /* type */ + (unix_timestamp_available ? 1 : 0) +
+  s_metadata_cache.has_build_id = has_build_id;
+  s_metadata_cache.encoded_len = encoded_len;
+  s_metadata_cache.state = kMemfaultMetadataCacheState_Valid;
+  return true;
+}
+
+//! Copies the cached metadata out, so it can be encoded without holding memfault_lock() while
+//! the encoder's write callback runs
+//!
+//! @return false if the cache can't be used and the metadata must be encoded from scratch
+static bool prv_metadata_cache_copy(sMemfaultMetadataCache *copy) {
+  memfault_lock();
+  const bool cache_valid = prv_metadata_cache_load();
+  if (cache_valid) {
+    copy->has_build_id = s_metadata_cache.has_build_id;
+    copy->encoded_len = s_metadata_cache.encoded_len;
+    memcpy(copy->encoded, s_metadata_cache.encoded, s_metadata_cache.encoded_len);
+  }
+  memfault_unlock();
+  return cache_valid;
+}
+
+#else
+
+void memfault_device_info_changed(void) { }
+
+#endif /* MEMFAULT_EVENT_METADATA_CACHE_ENABLED */
+
+//! @return the number of key-value pairs encoded by prv_encode_invariant_metadata()
+static size_t prv_invariant_metadata_num_pairs(bool has_build_id) {
+  return
 #if MEMFAULT_EVENT_INCLUDE_DEVICE_SERIAL
-                                     1 +
+    1 +
 #endif
-                                     3 /* sw version, sw type, hw version */ +
-                                     (has_build_id ? 1 : 0) + 1 /* cbor schema version */ +
+    3 /* sw version, sw type, hw version */ + (has_build_id ? 1 : 0) +
+    1 /* cbor schema version */;
+}
+
+//! Begins the top level event dictionary and encodes the event type
+static bool prv_encode_metadata_begin(sMemfaultCborEncoder *encoder, eMemfaultEventType type,
+                                      bool has_build_id, bool unix_timestamp_available) {
+  const size_t top_level_num_pairs = 1 /* type */ + (unix_timestamp_available ? 1 : 0) +
+                                     prv_invariant_metadata_num_pairs(has_build_id) +
                                      1 /* event_info */;
 
   memfault_cbor_encode_dictionary_begin(encoder, top_level_num_pairs);
 
-  if (!prv_encode_event_key_uint32_pair(encoder, kMemfaultEventKey_Type, type)) {
-    return false;
-  }
+  return prv_encode_event_key_uint32_pair(encoder, kMemfaultEventKey_Type, type);
+}
 
-  if (!memfault_serializer_helper_encode_uint32_kv_pair(
-        encoder, kMemfaultEventKey_CborSchemaVersion, MEMFAULT_CBOR_SCHEMA_VERSION_V1)) {
-    return false;
-  }
+bool memfault_serializer_helper_encode_metadata_with_time(sMemfaultCborEncoder *encoder,
+                                                          eMemfaultEventType type,
+                                                          const sMemfaultCurrentTime *time) {
+  const bool unix_timestamp_available =
+    (time != NULL) && (time->type == kMemfaultCurrentTimeType_UnixEpochTimeSec);
 
-  if (!prv_encode_device_version_info(encoder)) {
-    return false;
+#if MEMFAULT_EVENT_METADATA_CACHE_ENABLED
+  // the pre-encoded invariant metadata is copied in with a single write
+  sMemfaultMetadataCache cache;
+  if (prv_metadata_cache_copy(&cache)) {
+    if (!prv_encode_metadata_begin(encoder, type, cache.has_build_id, unix_timestamp_available) ||
+        !memfault_cbor_join(encoder, cache.encoded, cache.encoded_len)) {
+      return false;
+    }
+    return !unix_timestamp_available ||
+           prv_encode_event_key_uint32_pair(encoder, kMemfaultEventKey_CapturedDateUnixTimestamp,
+                                            (uint32_t)time->info.unix_timestamp_secs);
   }
+#endif
 
 #if MEMFAULT_EVENT_INCLUDE_BUILD_ID
+  sMemfaultBuildInfo info;
+  const bool has_build_id = memfault_build_info_read(&info);
   MEMFAULT_STATIC_ASSERT(
     MEMFAULT_EVENT_INCLUDED_BUILD_ID_SIZE_BYTES >= 5 &&
       MEMFAULT_EVENT_INCLUDED_BUILD_ID_SIZE_BYTES <= sizeof(info.build_id),
     "MEMFAULT_EVENT_INCLUDED_BUILD_ID_SIZE_BYTES must be between 5 and 20 (inclusive)");
-  if (has_build_id && !memfault_serializer_helper_encode_byte_string_kv_pair(
-                        encoder, kMemfaultEventKey_BuildId, info.build_id,
-                        MEMFAULT_EVENT_INCLUDED_BUILD_ID_SIZE_BYTES)) {
+  const void *build_id = has_build_id ? info.build_id : NULL;
+#else
+  const bool has_build_id = false;
+  const void *build_id = NULL;
+#endif
+
+  if (!prv_encode_metadata_begin(encoder, type, has_build_id, unix_timestamp_available) ||
+      !prv_encode_invariant_metadata(encoder, build_id)) {
     return false;
   }
-#endif
 
   return !unix_timestamp_available ||
          prv_encode_event_key_uint32_pair(encoder, kMemfaultEventKey_CapturedDateUnixTimestamp,
                                           (uint32_t)time->info.unix_timestamp_secs);
 }
 
+#if MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_ENABLED
+
+bool memfault_serializer_helper_encode_stored_event_metadata(sMemfaultCborEncoder *encoder,
+                                                             eMemfaultEventType type) {
+  sMemfaultCurrentTime time;
+  const bool unix_timestamp_available = memfault_platform_time_get_current(&time) &&
+                                        (time.type == kMemfaultCurrentTimeType_UnixEpochTimeSec);
+
+  // the invariant metadata is added to the batch header when the events are read out
+  const size_t top_level_num_pairs =
+    1 /* type */ + (unix_timestamp_available ? 1 : 0) + 1 /* event_info */;
+  if (!memfault_cbor_encode_dictionary_begin(encoder, top_level_num_pairs) ||
+      !prv_encode_event_key_uint32_pair(encoder, kMemfaultEventKey_Type, type)) {
+    return false;
+  }
+
+  return !unix_timestamp_available ||
+         prv_encode_event_key_uint32_pair(encoder, kMemfaultEventKey_CapturedDateUnixTimestamp,
+                                          (uint32_t)time.info.unix_timestamp_secs);
+}
+
+bool memfault_serializer_helper_encode_batch_metadata(sMemfaultCborEncoder *encoder) {
+  #if MEMFAULT_EVENT_METADATA_CACHE_ENABLED
+  sMemfaultMetadataCache cache;
+  if (prv_metadata_cache_copy(&cache)) {
+    return memfault_cbor_encode_dictionary_begin(
+             encoder, prv_invariant_metadata_num_pairs(cache.has_build_id)) &&
+           memfault_cbor_join(encoder, cache.encoded, cache.encoded_len);
+  }
+  #endif
+
+  #if MEMFAULT_EVENT_INCLUDE_BUILD_ID
+  sMemfaultBuildInfo info;
+  const bool has_build_id = memfault_build_info_read(&info);
+  const void *build_id = has_build_id ? info.build_id : NULL;
+  #else
+  const bool has_build_id = false;
+  const void *build_id = NULL;
+  #endif
+
+  return memfault_cbor_encode_dictionary_begin(encoder,
+                                               prv_invariant_metadata_num_pairs(has_build_id)) &&
+         prv_encode_invariant_metadata(encoder, build_id);
+}
+
+#else
+
+bool memfault_serializer_helper_encode_stored_event_metadata(sMemfaultCborEncoder *encoder,
+                                                             eMemfaultEventType type) {
+  return memfault_serializer_helper_encode_metadata(encoder, type);
+}
+
+#endif /* MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_ENABLED */
+
 bool memfault_serializer_helper_encode_trace_event(sMemfaultCborEncoder *e,
                                                    const sMemfaultTraceEventHelperInfo *info) {
-  if (!memfault_serializer_helper_encode_metadata(e, kMemfaultEventType_Trace)) {
+  if (!memfault_serializer_helper_encode_stored_event_metadata(e, kMemfaultEventType_Trace)) {
     return false;
   }
 
@@ -201,9 +374,50 @@ static void prv_encoder_write_cb(void *ctx, MEMFAULT_UNUSED uint32_t offset, con
   storage_impl->append_data_cb(buf, buf_len);
 }
 
-bool memfault_serializer_helper_encode_to_storage(
-  sMemfaultCborEncoder *encoder, const sMemfaultEventStorageImpl *storage_impl,
-  MemfaultSerializerHelperEncodeCallback encode_callback, void *ctx) {
+typedef struct {
+  const sMemfaultEventStorageImpl *storage_impl;
+  sMemfaultEventStorageReservation *reservation;
+} sMemfaultSerializerHelperReservedEncoderCtx;
+
+static void prv_reserved_encoder_write_cb(void *ctx, MEMFAULT_UNUSED uint32_t offset,
+                                          const void *buf, size_t buf_len) {
+  sMemfaultSerializerHelperReservedEncoderCtx *encoder_ctx =
+    (sMemfaultSerializerHelperReservedEncoderCtx *)ctx;
+  encoder_ctx->storage_impl->write_reserved_cb(encoder_ctx->reservation, buf, buf_len);
+}
+
+//! Encode into a reserved slot, so that concurrent producers never contend on storage while
+//! encoding. The event is encoded once, and the slot trimmed to fit it when committed.
+static bool prv_encode_to_reservation(sMemfaultCborEncoder *encoder,
+                                      const sMemfaultEventStorageImpl *storage_impl,
+                                      MemfaultSerializerHelperEncodeCallback encode_callback,
+                                      void *ctx) {
+  sMemfaultEventStorageReservation reservation;
+  if (!storage_impl->reserve_cb(MEMFAULT_EVENT_STORAGE_RESERVED_WRITES_MAX_EVENT_SIZE,
+                                &reservation)) {
+    return false;
+  }
+
+  sMemfaultSerializerHelperReservedEncoderCtx encoder_ctx = {
+    .storage_impl = storage_impl,
+    .reservation = &reservation,
+  };
+  memfault_cbor_encoder_init(encoder, prv_reserved_encoder_write_cb, &encoder_ctx,
+                             reservation.size);
+  const bool success = encode_callback(encoder, ctx);
+  memfault_cbor_encoder_deinit(encoder);
+
+  return storage_impl->commit_reserved_cb(&reservation, !success) && success;
+}
+
+static bool prv_encode_to_storage(sMemfaultCborEncoder *encoder,
+                                  const sMemfaultEventStorageImpl *storage_impl,
+                                  MemfaultSerializerHelperEncodeCallback encode_callback,
+                                  void *ctx) {
+  if (storage_impl->reserve_cb != NULL) {
+    return prv_encode_to_reservation(encoder, storage_impl, encode_callback, ctx);
+  }
+
   const size_t space_available = storage_impl->begin_write_cb();
   bool success;
   {
@@ -216,6 +430,13 @@ bool memfault_serializer_helper_encode_to_storage(
   }
   const bool rollback = !success;
   storage_impl->finish_write_cb(rollback);
+  return success;
+}
+
+bool memfault_serializer_helper_encode_to_storage(
+  sMemfaultCborEncoder *encoder, const sMemfaultEventStorageImpl *storage_impl,
+  MemfaultSerializerHelperEncodeCallback encode_callback, void *ctx) {
+  const bool success = prv_encode_to_storage(encoder, storage_impl, encode_callback, ctx);
 
   if (!success) {
     if (s_num_storage_drops == 0) {
@@ -259,5 +480,12 @@ bool memfault_serializer_helper_check_storage_size(const sMemfaultEventStorageIm
                       (int)storage_max_size, event_type, (int)worst_case_size_needed);
     return false;
   }
+  if ((storage_impl->reserve_cb != NULL) &&
+      (worst_case_size_needed > MEMFAULT_EVENT_STORAGE_RESERVED_WRITES_MAX_EVENT_SIZE)) {
+    MEMFAULT_LOG_WARN("Event reservation (%d) smaller than largest %s event (%d)",
+                      (int)MEMFAULT_EVENT_STORAGE_RESERVED_WRITES_MAX_EVENT_SIZE, event_type,
+                      (int)worst_case_size_needed);
+    return false;
+  }
   return true;
 }
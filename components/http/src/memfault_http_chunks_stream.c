@@ -0,0 +1,108 @@
+//! @file
+//!
+//! Copyright (c) Memfault, Inc.
+//! See LICENSE for details
+//!
+//! @brief
+//! Streams every message available from the packetizer as the body of a single chunks POST, using
+//! "Transfer-Encoding: chunked" so the length of the body doesn't have to be known up front
+
+#include <stdint.h>
+#include <string.h>
+
+#include "memfault/core/compiler.h"
+#include "memfault/core/data_packetizer.h"
+#include "memfault/core/debug_log.h"
+#include "memfault/http/utils.h"
+
+#define TRANSFER_CHUNK_END_LEN MEMFAULT_STATIC_STRLEN(MEMFAULT_HTTP_TRANSFER_CHUNK_END)
+
+//! Sends the data at &buf[reserved_len] as a single transfer chunk, rendering the chunk size line
+//! right in front of it and the chunk terminator after it
+static bool prv_write_transfer_chunk_in_place(MfltHttpClientSendCb write_callback, void *ctx,
+                                              uint8_t *buf, size_t reserved_len, size_t data_len) {
+  char size_line[2 * sizeof(size_t) + 3];
+  const size_t size_line_len =
+    memfault_http_chunks_stream_data_header(size_line, sizeof(size_line), data_len);
+  if ((size_line_len == 0) || (size_line_len > reserved_len)) {
+    return false;
+  }
+
+  uint8_t *transfer_chunk = &buf[reserved_len - size_line_len];
+  memcpy(transfer_chunk, size_line, size_line_len);
+  memcpy(&buf[reserved_len + data_len], MEMFAULT_HTTP_TRANSFER_CHUNK_END, TRANSFER_CHUNK_END_LEN);
+  return write_callback(transfer_chunk, size_line_len + data_len + TRANSFER_CHUNK_END_LEN, ctx);
+}
+
+int memfault_http_post_chunks_stream(MfltHttpClientSendCb write_callback, void *ctx, void *buf,
+                                     size_t buf_len, size_t max_messages) {
+  // Space is reserved in front of the data read from the packetizer for the longest chunk size
+  // line, and after it for the chunk terminator, so each read is sent with a single write
+  char size_line[2 * sizeof(size_t) + 3];
+  const size_t reserved_len =
+    memfault_http_chunks_stream_data_header(size_line, sizeof(size_line), buf_len);
+  if ((reserved_len == 0) ||
+      (buf_len < (reserved_len + MEMFAULT_PACKETIZER_MIN_BUF_LEN + TRANSFER_CHUNK_END_LEN))) {
+    MEMFAULT_LOG_ERROR("Chunks stream buffer too small: %d", (int)buf_len);
+    return -1;
+  }
+  const size_t max_data_len = buf_len - reserved_len - TRANSFER_CHUNK_END_LEN;
+  uint8_t *bufp = (uint8_t *)buf;
+
+  // every part of the body must start at the beginning of a message, so rewind any message which
+  // was partially sent by a previous upload
+  memfault_packetizer_abort();
+
+  const sMemfaultPacketizerConfig cfg = {
+    // let a single msg span many "memfault_packetizer_get_next" calls
+    .enable_multi_packet_chunk = true,
+  };
+
+  // the first message is started before the request header is sent, so no POST is sent when
+  // there is nothing to upload
+  sMemfaultPacketizerMetadata metadata;
+  if ((max_messages == 0) || !memfault_packetizer_begin(&cfg, &metadata)) {
+    return 0;
+  }
+  if (!memfault_http_start_chunks_stream_post(write_callback, ctx)) {
+    goto abort_message;
+  }
+
+  size_t num_messages = 0;
+  while (1) {
+    if (!memfault_http_write_chunks_stream_part_begin(write_callback, ctx,
+                                                      metadata.single_chunk_message_length)) {
+      goto abort_message;
+    }
+
+    eMemfaultPacketizerStatus status;
+    do {
+      size_t data_len = max_data_len;
+      status = memfault_packetizer_get_next(&bufp[reserved_len], &data_len);
+      if (status == kMemfaultPacketizerStatus_NoMoreData) {
+        // the message ended before single_chunk_message_length bytes were sent
+        goto abort_message;
+      }
+
+      if (!prv_write_transfer_chunk_in_place(write_callback, ctx, bufp, reserved_len, data_len)) {
+        goto abort_message;
+      }
+    } while (status != kMemfaultPacketizerStatus_EndOfChunk);
+
+    if (!memfault_http_write_chunks_stream_part_end(write_callback, ctx)) {
+      return -1;
+    }
+
+    num_messages++;
+    if ((num_messages == max_messages) || !memfault_packetizer_begin(&cfg, &metadata)) {
+      break;
+    }
+  }
+
+  return memfault_http_end_chunks_stream(write_callback, ctx) ? (int)num_messages : -1;
+
+abort_message:
+  // the message will be sent again in its entirety by the next upload
+  memfault_packetizer_abort();
+  return -1;
+}
@@ -0,0 +1,122 @@
+//! @file
+//!
+//! Copyright (c) Memfault, Inc.
+//! See LICENSE for details
+//!
+//! @brief
+//! Posts chunks with several requests in flight on the same connection, so the upload rate isn't
+//! bound by one round trip to the server per chunk
+
+#include <stdint.h>
+#include <string.h>
+
+#include "memfault/config.h"
+#include "memfault/core/data_packetizer.h"
+#include "memfault/core/debug_log.h"
+#include "memfault/http/utils.h"
+
+static size_t prv_msg_idx(const sMfltHttpPipeline *pipeline, size_t offset) {
+  return (pipeline->head + offset) % pipeline->depth;
+}
+
+static uint8_t *prv_msg_buf(const sMfltHttpPipeline *pipeline, size_t idx) {
+  return &pipeline->msg_bufs[idx * pipeline->msg_buf_len];
+}
+
+//! Post the next chunk which is not in flight yet, reading a new one from the packetizer if all
+//! queued chunks have already been posted.
+//!
+//! Returns:
+//! 0  - no more data to send
+//! 1  - data sent, awaiting response
+//! -1 - error
+static int prv_send_next_msg(sMfltHttpPipeline *pipeline, MfltHttpClientSendCb send_callback,
+                             void *ctx, int *max_messages_to_send) {
+  if (pipeline->in_flight == pipeline->count) {
+    if (*max_messages_to_send <= 0) {
+      return 0;
+    }
+
+    const size_t idx = prv_msg_idx(pipeline, pipeline->count);
+    size_t chunk_len = pipeline->msg_buf_len - MEMFAULT_HTTP_REQUEST_HEADER_MAX_LEN;
+    if (!memfault_packetizer_get_chunk(
+          &prv_msg_buf(pipeline, idx)[MEMFAULT_HTTP_REQUEST_HEADER_MAX_LEN], &chunk_len)) {
+      MEMFAULT_LOG_DEBUG("No more data to send");
+      return 0;
+    }
+    pipeline->chunk_lens[idx] = chunk_len;
+    pipeline->count++;
+    (*max_messages_to_send)--;
+  }
+
+  // The request header is rendered right in front of the chunk, so both are sent with a single
+  // write. A header which doesn't fit is sent piecewise instead. The chunk itself is never
+  // modified, so it can be posted again.
+  const size_t idx = prv_msg_idx(pipeline, pipeline->in_flight);
+  uint8_t *buf = prv_msg_buf(pipeline, idx);
+  const size_t chunk_len = pipeline->chunk_lens[idx];
+  const size_t hdr_len =
+    memfault_http_build_chunk_post_header(buf, MEMFAULT_HTTP_REQUEST_HEADER_MAX_LEN, chunk_len);
+  bool sent;
+  if (hdr_len == 0) {
+    sent = memfault_http_start_chunk_post(send_callback, ctx, chunk_len) &&
+           send_callback(&buf[MEMFAULT_HTTP_REQUEST_HEADER_MAX_LEN], chunk_len, ctx);
+  } else {
+    uint8_t *post = &buf[MEMFAULT_HTTP_REQUEST_HEADER_MAX_LEN - hdr_len];
+    memmove(post, buf, hdr_len);
+    sent = send_callback(post, hdr_len + chunk_len, ctx);
+  }
+  if (!sent) {
+    // the chunk stays queued, and is posted again by the next upload
+    return -1;
+  }
+
+  pipeline->in_flight++;
+  return 1;
+}
+
+bool memfault_http_pipeline_upload(sMfltHttpPipeline *pipeline,
+                                   MfltHttpClientSendCb send_callback,
+                                   MfltHttpPipelineResponseCb response_callback, void *ctx,
+                                   int *max_messages_to_send) {
+  bool success = true;
+  bool more_data = true;
+
+  // nothing is in flight on a new connection, so chunks which were not acknowledged during the
+  // previous upload are posted again first
+  pipeline->in_flight = 0;
+
+  while (1) {
+    while (success && more_data && (pipeline->in_flight < pipeline->depth)) {
+      const int rv = prv_send_next_msg(pipeline, send_callback, ctx, max_messages_to_send);
+      if (rv < 0) {
+        return false;
+      }
+      more_data = (rv != 0);
+    }
+
+    if (pipeline->in_flight == 0) {
+      return success;
+    }
+
+    const int http_status = response_callback(ctx);
+    if (http_status < 0) {
+      // the state of the connection is unknown, so everything which was not acknowledged is
+      // posted again by the next upload
+      return false;
+    }
+
+    // the server has processed the oldest chunk, so it is dropped even if it was rejected
+    pipeline->head = prv_msg_idx(pipeline, 1);
+    pipeline->count--;
+    pipeline->in_flight--;
+    if (http_status / 100 != 2) {
+      MEMFAULT_LOG_ERROR("Chunk post rejected: HTTP Status %d", http_status);
+      success = false;
+    }
+  }
+}
+
+bool memfault_http_pipeline_has_unacked_chunks(const sMfltHttpPipeline *pipeline) {
+  return pipeline->count != 0;
+}
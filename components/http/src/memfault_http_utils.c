@@ -82,17 +82,22 @@ static bool prv_write_project_key_hdr(MfltHttpClientSendCb write_callback, void
   return prv_write_crlf(write_callback, ctx);
 }
 
-bool memfault_http_start_chunk_post(MfltHttpClientSendCb write_callback, void *ctx,
-                                    size_t content_body_length) {
-  // Request built will look like this:
-  //  POST /api/v0/chunks/<device_serial> HTTP/1.1\r\n
-  //  Host:chunks.memfault.com\r\n
-  //  User-Agent: MemfaultSDK/0.4.2\r\n
-  //  Memfault-Project-Key:<PROJECT_KEY>\r\n
-  //  Content-Type:application/octet-stream\r\n
-  //  Content-Length:<content_body_length>\r\n
-  //  \r\n
+static bool prv_append(char *buf, size_t buf_len, size_t *offset, const void *data,
+                       size_t data_len) {
+  if (data_len > (buf_len - *offset)) {
+    return false;
+  }
+  memcpy(&buf[*offset], data, data_len);
+  *offset += data_len;
+  return true;
+}
+
+//! Passed as the content body length of a POST whose body is sent with "Transfer-Encoding: chunked"
+#define MEMFAULT_HTTP_CHUNKED_TRANSFER_LENGTH SIZE_MAX
 
+static bool prv_start_chunk_post(MfltHttpClientSendCb write_callback, void *ctx,
+                                 const char *content_type_hdr, size_t content_type_hdr_len,
+                                 size_t content_body_length) {
   sMemfaultDeviceInfo device_info;
   memfault_http_get_device_info(&device_info);
 
@@ -118,19 +123,211 @@ bool memfault_http_start_chunk_post(MfltHttpClientSendCb write_callback, void *c
     return false;
   }
 
-#define CONTENT_TYPE "Content-Type:application/octet-stream\r\n"
-  const size_t content_type_len = MEMFAULT_STATIC_STRLEN(CONTENT_TYPE);
-  if (!write_callback(CONTENT_TYPE, content_type_len, ctx)) {
+  if (!write_callback(content_type_hdr, content_type_hdr_len, ctx)) {
     return false;
   }
 
-  msg_len =
-    (size_t)snprintf(buffer, sizeof(buffer), "Content-Length:%d\r\n", (int)content_body_length);
+  msg_len = (content_body_length == MEMFAULT_HTTP_CHUNKED_TRANSFER_LENGTH) ?
+              (size_t)snprintf(buffer, sizeof(buffer), "Transfer-Encoding:chunked\r\n") :
+              (size_t)snprintf(buffer, sizeof(buffer), "Content-Length:%d\r\n",
+                               (int)content_body_length);
 
   return prv_write_msg(write_callback, ctx, buffer, msg_len, max_msg_len) &&
          prv_write_crlf(write_callback, ctx);
 }
 
+//! A buffer the header of a chunk POST is rendered into, by passing prv_buffer_write() to
+//! prv_start_chunk_post() as its write callback
+typedef struct {
+  char *buf;
+  size_t buf_len;
+  size_t offset;
+} sMfltHttpHdrBuffer;
+
+static bool prv_buffer_write(const void *data, size_t data_len, void *ctx) {
+  sMfltHttpHdrBuffer *hdr_buf = (sMfltHttpHdrBuffer *)ctx;
+  return prv_append(hdr_buf->buf, hdr_buf->buf_len, &hdr_buf->offset, data, data_len);
+}
+
+bool memfault_http_start_chunk_post(MfltHttpClientSendCb write_callback, void *ctx,
+                                    size_t content_body_length) {
+  // Request built will look like this:
+  //  POST /api/v0/chunks/<device_serial> HTTP/1.1\r\n
+  //  Host:chunks.memfault.com\r\n
+  //  User-Agent: MemfaultSDK/0.4.2\r\n
+  //  Memfault-Project-Key:<PROJECT_KEY>\r\n
+  //  Content-Type:application/octet-stream\r\n
+  //  Content-Length:<content_body_length>\r\n
+  //  \r\n
+
+#define CONTENT_TYPE "Content-Type:application/octet-stream\r\n"
+  const size_t content_type_len = MEMFAULT_STATIC_STRLEN(CONTENT_TYPE);
+  return prv_start_chunk_post(write_callback, ctx, CONTENT_TYPE, content_type_len,
+                              content_body_length);
+}
+
+size_t memfault_http_build_chunk_post_header(void *buf, size_t buf_len,
+                                              size_t content_body_length) {
+  if (buf == NULL) {
+    return 0;
+  }
+
+  sMfltHttpHdrBuffer hdr_buf = { .buf = (char *)buf, .buf_len = buf_len };
+  if (!prv_start_chunk_post(prv_buffer_write, &hdr_buf, CONTENT_TYPE,
+                            MEMFAULT_STATIC_STRLEN(CONTENT_TYPE), content_body_length)) {
+    return 0;
+  }
+  return hdr_buf.offset;
+}
+
+bool memfault_http_start_chunks_batch_post(MfltHttpClientSendCb write_callback, void *ctx,
+                                           size_t content_body_length) {
+  // Identical to memfault_http_start_chunk_post() except for the Content-Type header:
+  //  Content-Type:multipart/mixed; boundary=<MEMFAULT_HTTP_CHUNKS_BATCH_BOUNDARY>\r\n
+
+#define BATCH_CONTENT_TYPE \
+  "Content-Type:multipart/mixed; boundary=" MEMFAULT_HTTP_CHUNKS_BATCH_BOUNDARY "\r\n"
+  const size_t content_type_len = MEMFAULT_STATIC_STRLEN(BATCH_CONTENT_TYPE);
+  return prv_start_chunk_post(write_callback, ctx, BATCH_CONTENT_TYPE, content_type_len,
+                              content_body_length);
+}
+
+// Each chunk in a batch is framed as its own part of the multipart body:
+//  --<boundary>\r\n
+//  Content-Length:<chunk_len>\r\n
+//  \r\n
+//  <chunk>\r\n
+// and the body is terminated by a closing delimiter:
+//  --<boundary>--\r\n
+#define BATCH_PART_DELIMITER "--" MEMFAULT_HTTP_CHUNKS_BATCH_BOUNDARY "\r\n"
+#define BATCH_PART_CONTENT_LENGTH "Content-Length:"
+#define BATCH_CLOSE_DELIMITER "--" MEMFAULT_HTTP_CHUNKS_BATCH_BOUNDARY "--\r\n"
+
+static size_t prv_num_decimal_digits(size_t value) {
+  size_t num_digits = 1;
+  while (value >= 10) {
+    value /= 10;
+    num_digits++;
+  }
+  return num_digits;
+}
+
+size_t memfault_http_chunks_batch_body_length(const size_t *chunk_lens, size_t num_chunks) {
+  if ((chunk_lens == NULL) || (num_chunks == 0)) {
+    return 0;
+  }
+
+  size_t body_len = MEMFAULT_STATIC_STRLEN(BATCH_CLOSE_DELIMITER);
+  for (size_t i = 0; i < num_chunks; i++) {
+    body_len += MEMFAULT_STATIC_STRLEN(BATCH_PART_DELIMITER) +
+                MEMFAULT_STATIC_STRLEN(BATCH_PART_CONTENT_LENGTH) +
+                prv_num_decimal_digits(chunk_lens[i]) + MEMFAULT_STATIC_STRLEN("\r\n\r\n") +
+                chunk_lens[i] + MEMFAULT_STATIC_STRLEN("\r\n");
+  }
+  return body_len;
+}
+
+bool memfault_http_write_chunks_batch_body(MfltHttpClientSendCb write_callback, void *ctx,
+                                           const void *chunks, const size_t *chunk_lens,
+                                           size_t num_chunks) {
+  if ((chunks == NULL) || (chunk_lens == NULL) || (num_chunks == 0)) {
+    return false;
+  }
+
+  const uint8_t *chunkp = (const uint8_t *)chunks;
+  char buffer[32];
+  const size_t max_msg_len = sizeof(buffer);
+
+  for (size_t i = 0; i < num_chunks; i++) {
+    if (!write_callback(BATCH_PART_DELIMITER, MEMFAULT_STATIC_STRLEN(BATCH_PART_DELIMITER),
+                        ctx)) {
+      return false;
+    }
+
+    const size_t msg_len = (size_t)snprintf(buffer, sizeof(buffer),
+                                            BATCH_PART_CONTENT_LENGTH "%d\r\n\r\n",
+                                            (int)chunk_lens[i]);
+    if (!prv_write_msg(write_callback, ctx, buffer, msg_len, max_msg_len)) {
+      return false;
+    }
+
+    if (!write_callback(chunkp, chunk_lens[i], ctx) || !prv_write_crlf(write_callback, ctx)) {
+      return false;
+    }
+    chunkp += chunk_lens[i];
+  }
+
+  return write_callback(BATCH_CLOSE_DELIMITER, MEMFAULT_STATIC_STRLEN(BATCH_CLOSE_DELIMITER),
+                        ctx);
+}
+
+bool memfault_http_start_chunks_stream_post(MfltHttpClientSendCb write_callback, void *ctx) {
+  // Identical to memfault_http_start_chunks_batch_post() except the Content-Length header is
+  // replaced with:
+  //  Transfer-Encoding:chunked\r\n
+  const size_t content_type_len = MEMFAULT_STATIC_STRLEN(BATCH_CONTENT_TYPE);
+  return prv_start_chunk_post(write_callback, ctx, BATCH_CONTENT_TYPE, content_type_len,
+                              MEMFAULT_HTTP_CHUNKED_TRANSFER_LENGTH);
+}
+
+// The body of a chunks stream POST is the multipart body of a chunks batch, sent as a sequence of
+// transfer chunks:
+//  <data_len in hex>\r\n
+//  <data>\r\n
+// and terminated by an empty one:
+//  0\r\n
+//  \r\n
+#define LAST_TRANSFER_CHUNK "0\r\n\r\n"
+
+size_t memfault_http_chunks_stream_data_header(char *buf, size_t buf_len, size_t data_len) {
+  const int rv = snprintf(buf, buf_len, "%x\r\n", (unsigned int)data_len);
+  return ((rv <= 0) || ((size_t)rv >= buf_len)) ? 0 : (size_t)rv;
+}
+
+//! Sends data which is short enough to be framed in a small buffer as a single transfer chunk
+static bool prv_write_transfer_chunk(MfltHttpClientSendCb write_callback, void *ctx,
+                                     const char *data, size_t data_len) {
+  char buffer[80];
+  size_t len = memfault_http_chunks_stream_data_header(buffer, sizeof(buffer), data_len);
+  if ((len == 0) || !prv_append(buffer, sizeof(buffer), &len, data, data_len) ||
+      !prv_append(buffer, sizeof(buffer), &len, MEMFAULT_HTTP_TRANSFER_CHUNK_END,
+                  MEMFAULT_STATIC_STRLEN(MEMFAULT_HTTP_TRANSFER_CHUNK_END))) {
+    return false;
+  }
+  return write_callback(buffer, len, ctx);
+}
+
+bool memfault_http_write_chunks_stream_part_begin(MfltHttpClientSendCb write_callback, void *ctx,
+                                                  size_t chunk_len) {
+  char buffer[64];
+  const int msg_len = snprintf(buffer, sizeof(buffer),
+                               BATCH_PART_DELIMITER BATCH_PART_CONTENT_LENGTH "%d\r\n\r\n",
+                               (int)chunk_len);
+  if ((msg_len <= 0) || ((size_t)msg_len >= sizeof(buffer))) {
+    return false;
+  }
+  return prv_write_transfer_chunk(write_callback, ctx, buffer, (size_t)msg_len);
+}
+
+bool memfault_http_write_chunks_stream_part_end(MfltHttpClientSendCb write_callback, void *ctx) {
+  return prv_write_transfer_chunk(write_callback, ctx, END_HEADER_SECTION,
+                                  MEMFAULT_STATIC_STRLEN(END_HEADER_SECTION));
+}
+
+bool memfault_http_end_chunks_stream(MfltHttpClientSendCb write_callback, void *ctx) {
+  char buffer[64];
+  size_t len = memfault_http_chunks_stream_data_header(
+    buffer, sizeof(buffer), MEMFAULT_STATIC_STRLEN(BATCH_CLOSE_DELIMITER));
+  const bool success =
+    (len != 0) &&
+    prv_append(buffer, sizeof(buffer), &len,
+               BATCH_CLOSE_DELIMITER MEMFAULT_HTTP_TRANSFER_CHUNK_END,
+               MEMFAULT_STATIC_STRLEN(BATCH_CLOSE_DELIMITER MEMFAULT_HTTP_TRANSFER_CHUNK_END)) &&
+    prv_append(buffer, sizeof(buffer), &len, LAST_TRANSFER_CHUNK,
+               MEMFAULT_STATIC_STRLEN(LAST_TRANSFER_CHUNK));
+  return success && write_callback(buffer, len, ctx);
+}
+
 static bool prv_write_qparam(MfltHttpClientSendCb write_callback, void *ctx, const void *name,
                              size_t name_strlen, const char *value) {
   return write_callback("&", 1, ctx) && write_callback(name, name_strlen, ctx) &&
@@ -339,6 +536,120 @@ static bool prv_parse_header(char *line, size_t len, int *content_length_out) {
   return (bytes_processed > 0);
 }
 
+//! @return true if the line is a "Transfer-Encoding" header and the last transfer coding it lists
+//! is "chunked"
+static bool prv_is_chunked_transfer_encoding_header(const char *line, size_t len) {
+#define TRANSFER_ENCODING "transfer-encoding"
+#define CHUNKED_TRANSFER_CODING "chunked"
+  const size_t transfer_encoding_hdr_len = MEMFAULT_STATIC_STRLEN(TRANSFER_ENCODING);
+  if ((len < transfer_encoding_hdr_len) ||
+      !prv_strcasecmp(line, TRANSFER_ENCODING, transfer_encoding_hdr_len)) {
+    return false;
+  }
+
+  size_t idx = transfer_encoding_hdr_len;
+  idx += prv_count_spaces(line, idx, len);
+  if ((idx >= len) || (line[idx] != ':')) {
+    return false;
+  }
+
+  while ((len > idx) && (line[len - 1] == ' ')) {
+    len--;
+  }
+  const size_t chunked_len = MEMFAULT_STATIC_STRLEN(CHUNKED_TRANSFER_CODING);
+  return ((len - idx) > chunked_len) &&
+         prv_strcasecmp(&line[len - chunked_len], CHUNKED_TRANSFER_CODING, chunked_len);
+}
+
+static int prv_hex_digit(char c) {
+  if (prv_is_number(c)) {
+    return c - '0';
+  }
+  const char lower_c = prv_lower(c);
+  if ((lower_c >= 'a') && (lower_c <= 'f')) {
+    return lower_c - 'a' + 10;
+  }
+  return -1;
+}
+
+static bool prv_chunked_body_error(sMemfaultHttpResponseContext *ctx) {
+  ctx->parse_error = MfltHttpParseStatus_ParseChunkedBodyError;
+  return true;
+}
+
+//! Parses one character of a message body sent with "Transfer-Encoding: chunked":
+//!  chunk-size [ chunk-ext ] CRLF
+//!  chunk-data CRLF
+//!  ...
+//!  0 [ chunk-ext ] CRLF
+//!  *( trailer-field CRLF )
+//!  CRLF
+//!
+//! @return true once the whole body has been parsed or a parse error occurred
+static bool prv_parse_chunked_body(sMemfaultHttpResponseContext *ctx, char c) {
+  switch (ctx->phase) {
+    case kMfltHttpParsePhase_ExpectingChunkSize: {
+      if (c == '\n') {
+        if (ctx->chunk_line_len == 0) {
+          return prv_chunked_body_error(ctx);
+        }
+        ctx->phase = (ctx->chunk_remaining == 0) ? kMfltHttpParsePhase_ExpectingTrailer :
+                                                   kMfltHttpParsePhase_ExpectingChunkData;
+        ctx->chunk_line_len = 0;
+        ctx->chunk_size_done = false;
+        return false;
+      }
+
+      const int digit = ctx->chunk_size_done ? -1 : prv_hex_digit(c);
+      if (digit >= 0) {
+        if (ctx->chunk_remaining > ((INT_MAX - digit) / 16)) {
+          return prv_chunked_body_error(ctx);  // chunk size will overflow
+        }
+        ctx->chunk_remaining = (ctx->chunk_remaining * 16) + digit;
+        ctx->chunk_line_len++;
+      } else if (ctx->chunk_line_len == 0) {
+        return prv_chunked_body_error(ctx);
+      } else {
+        // chunk extensions are ignored
+        ctx->chunk_size_done = true;
+      }
+      return false;
+    }
+    case kMfltHttpParsePhase_ExpectingChunkData:
+      ctx->content_received++;
+      if (ctx->line_len < (sizeof(ctx->line_buf) - 1)) {
+        ctx->line_buf[ctx->line_len] = c;
+        ctx->line_len++;
+      }
+      ctx->chunk_remaining--;
+      if (ctx->chunk_remaining == 0) {
+        ctx->phase = kMfltHttpParsePhase_ExpectingChunkDataEnd;
+      }
+      return false;
+    case kMfltHttpParsePhase_ExpectingChunkDataEnd:
+      if (c == '\n') {
+        ctx->phase = kMfltHttpParsePhase_ExpectingChunkSize;
+        return false;
+      }
+      return (c == '\r') ? false : prv_chunked_body_error(ctx);
+    case kMfltHttpParsePhase_ExpectingTrailer:
+      if (c == '\n') {
+        if (ctx->chunk_line_len == 0) {
+          // an empty line ends the trailer section and the message
+          ctx->line_buf[ctx->line_len] = '\0';
+          ctx->http_body = ctx->line_buf;
+          return true;
+        }
+        ctx->chunk_line_len = 0;
+      } else if (c != '\r') {
+        ctx->chunk_line_len++;
+      }
+      return false;
+    default:
+      return prv_chunked_body_error(ctx);
+  }
+}
+
 static bool prv_parse_status_line(char *line, size_t len, int *http_status) {
 #define HTTP_VERSION "HTTP/1."
   const size_t http_ver_len = MEMFAULT_STATIC_STRLEN(HTTP_VERSION);
@@ -390,11 +701,20 @@ static bool prv_parse_http_response(sMemfaultHttpResponseContext *ctx, const voi
   char *line_buf = &ctx->line_buf[0];
   for (size_t i = 0; i < data_len; i++, ctx->data_bytes_processed++) {
     const char c = chars[i];
-    if (ctx->phase == kMfltHttpParsePhase_ExpectingBody) {
+    // all phases after the header section parse the message body
+    if (ctx->phase >= kMfltHttpParsePhase_ExpectingBody) {
       if (parse_header_only) {
         return true;
       }
 
+      if (ctx->chunked_body) {
+        if (!prv_parse_chunked_body(ctx, c)) {
+          continue;
+        }
+        ctx->data_bytes_processed++;
+        return true;
+      }
+
       // Just eat the message body so we can handle response lengths of arbitrary size
       ctx->content_received++;
 
@@ -456,13 +776,24 @@ static bool prv_parse_http_response(sMemfaultHttpResponseContext *ctx, const voi
           ctx->parse_error = MfltHttpParseStatus_ParseHeaderError;
           return true;
         }
+        if (prv_is_chunked_transfer_encoding_header(line_buf, len)) {
+          ctx->chunked_body = true;
+        }
 
         if (len != 0) {
           continue;
         }
         // We've reached the end of headers marker
+        if (ctx->chunked_body) {
+          // the message length is determined by the chunked transfer coding and any
+          // Content-Length is ignored
+          ctx->content_length = 0;
+          ctx->phase = kMfltHttpParsePhase_ExpectingChunkSize;
+          continue;
+        }
         if (ctx->content_length == 0) {
           // no body to read
+          ctx->data_bytes_processed++;
           return true;
         }
         ctx->phase = kMfltHttpParsePhase_ExpectingBody;
@@ -28,11 +28,13 @@
 #include "memfault/core/heap_stats.h"
 #include "memfault/core/log.h"
 #include "memfault/core/math.h"
+#include "memfault/core/nv_event_log.h"
 #include "memfault/core/platform/core.h"
 #include "memfault/core/platform/crc32.h"
 #include "memfault/core/platform/debug_log.h"
 #include "memfault/core/platform/device_info.h"
 #include "memfault/core/platform/nonvolatile_event_storage.h"
+#include "memfault/core/platform/nv_event_log.h"
 #include "memfault/core/platform/overrides.h"
 #include "memfault/core/platform/reboot_tracking.h"
 #include "memfault/core/platform/system_time.h"
@@ -8,14 +8,23 @@
 //! @brief
 //! Helpers used for serializing multiple events into a single message
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
+#include "memfault/config.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-#define MEMFAULT_BATCHED_EVENTS_MAX_HEADER_LENGTH 5
+#if MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_ENABLED
+  //! Outer array (1) + metadata dictionary (1 + metadata) + events array (5)
+  #define MEMFAULT_BATCHED_EVENTS_MAX_HEADER_LENGTH \
+    (MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_METADATA_MAX_LEN + 7)
+#else
+  #define MEMFAULT_BATCHED_EVENTS_MAX_HEADER_LENGTH 5
+#endif
 
 typedef struct {
   size_t length;
@@ -30,6 +39,37 @@ typedef struct {
 void memfault_batched_events_build_header(size_t num_events,
                                           sMemfaultBatchedEventsHeader *header_out);
 
+#if MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_ENABLED
+
+//! The encoded metadata shared by the events of a compact batch
+typedef struct {
+  size_t length;
+  uint8_t data[MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_METADATA_MAX_LEN];
+} sMemfaultBatchedEventsMetadata;
+
+//! Encodes the current event metadata (schema version, device info and build id)
+//!
+//! @metadata_out Populated with the encoded metadata
+//!
+//! @return false if the metadata does not fit in
+//!  MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_METADATA_MAX_LEN bytes
+bool memfault_batched_events_capture_metadata(sMemfaultBatchedEventsMetadata *metadata_out);
+
+//! Builds the header of a compact batch
+//!
+//! The message is encoded as [metadata, [event, ...]], so unlike
+//! memfault_batched_events_build_header() a header is emitted for any number of events.
+//!
+//! @num_events The number events that will be sent in one message
+//! @metadata The metadata shared by all the events, from memfault_batched_events_capture_metadata()
+//! @header_out Populated with the header that needs to lead the events to send. The length is 0
+//!  if there are no events.
+void memfault_batched_events_build_compact_header(size_t num_events,
+                                                  const sMemfaultBatchedEventsMetadata *metadata,
+                                                  sMemfaultBatchedEventsHeader *header_out);
+
+#endif /* MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_ENABLED */
+
 #ifdef __cplusplus
 }
 #endif
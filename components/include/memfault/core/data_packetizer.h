@@ -36,6 +36,29 @@ extern "C" {
 //! @return true if the buffer was filled, false otherwise
 bool memfault_packetizer_get_chunk(void *buf, size_t *buf_len);
 
+//! Fill a large buffer with as many chunks as fit
+//!
+//! Repeatedly invokes memfault_packetizer_get_chunk() on the unused tail of the buffer so that a
+//! transport with a large MTU (i.e an HTTP request body) can be filled with several complete
+//! messages at once rather than one message per transport write. If the next message does not fit
+//! in the space remaining, the tail of the buffer is filled with the first part of that message
+//! and the rest of it is returned on the next call.
+//!
+//! Each chunk packed is self-delimiting and must be forwarded to the Memfault cloud as a separate
+//! chunk (for example, see memfault_http_write_chunks_batch_body() in memfault/http/utils.h).
+//! @note This function must not be called from an ISR context.
+//!
+//! @param[out] buf The buffer to copy the chunks into, back to back
+//! @param[in,out] buf_len The size of the buffer. On return, populated with the total number of
+//!  bytes copied into the buffer
+//! @param[out] chunk_lens Populated with the length of each chunk copied into the buffer
+//! @param[in,out] num_chunks The number of entries available in chunk_lens. On return, populated
+//!  with the number of chunks copied into the buffer
+//!
+//! @return true if at least one chunk was copied into the buffer, false otherwise
+bool memfault_packetizer_get_chunks_bulk(void *buf, size_t *buf_len, size_t *chunk_lens,
+                                         size_t *num_chunks);
+
 typedef enum {
   //! Indicates there is no more data to be sent at this time
   kMemfaultPacketizerStatus_NoMoreData = 0,
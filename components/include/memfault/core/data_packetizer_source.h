@@ -53,10 +53,23 @@ typedef bool(MemfaultDataSourceReadMessageCallback)(uint32_t offset, void *buf,
 //! a info about a new message or nothing if there are no more messages to read
 typedef void(MemfaultDataSourceMarkMessageReadCallback)(void);
 
+//! Optional: Look up the run length encoded size of the currently queued up message
+//!
+//! Allows a data source which already knows the RLE size of its message (for example because it
+//! was computed when the message was saved) to spare the RLE data source
+//! (memfault/core/data_source_rle.h) from reading the entire message to compute it.
+//!
+//! @param rle_size On return, populated with the RLE size of the currently queued up message
+//!
+//! @return true if rle_size was populated, false if the size is not known
+typedef bool(MemfaultDataSourceGetRleSizeCallback)(size_t *rle_size);
+
 typedef struct MemfaultDataSourceImpl {
   MemfaultDataSourceHasMoreMessagesCallback *has_more_msgs_cb;
   MemfaultDataSourceReadMessageCallback *read_msg_cb;
   MemfaultDataSourceMarkMessageReadCallback *mark_msg_read_cb;
+  //! Optional, may be NULL
+  MemfaultDataSourceGetRleSizeCallback *get_rle_size_cb;
 } sMemfaultDataSourceImpl;
 
 //! "Coredump" data source provided as part of "panics" component
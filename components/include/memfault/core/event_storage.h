@@ -118,6 +118,14 @@ size_t memfault_event_storage_bytes_used(void);
 //! @return zero if the storage has not been allocated.
 size_t memfault_event_storage_bytes_free(void);
 
+#if MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_ENABLED
+//! Return the number of events that were not stored because their metadata could not be tracked
+//! for a compact batch (see MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_ENABLED)
+//!
+//! @note Calling this function resets the counter.
+uint32_t memfault_event_storage_read_metadata_drop_count(void);
+#endif
+
 //! Check if event storage component has booted
 //!
 //! @note This function must not be called from an ISR context.
@@ -19,6 +19,16 @@
 extern "C" {
 #endif
 
+//! A region of event storage reserved for a single event, see reserve_cb below
+typedef struct MemfaultEventStorageReservation {
+  //! Location of the reserved region within the storage implementation
+  size_t storage_idx;
+  //! Number of event bytes that were reserved
+  size_t size;
+  //! Number of event bytes written to the region so far
+  size_t bytes_written;
+} sMemfaultEventStorageReservation;
+
 struct MemfaultEventStorageImpl {
   //! Opens a session to begin writing a heartbeat event to storage
   //!
@@ -47,6 +57,35 @@ struct MemfaultEventStorageImpl {
 
   //! Returns the _total_ size that can be used by event storage
   size_t (*get_storage_size_cb)(void);
+
+  //! Optional: Reserve space for an event of up to num_bytes
+  //!
+  //! Unlike begin_write_cb(), multiple reservations can be outstanding at once, so independent
+  //! producers can encode events concurrently. Events become readable in reservation order.
+  //!
+  //! @note May be NULL, in which case begin_write_cb() & friends must be used
+  //!
+  //! @param num_bytes The most bytes the event can occupy. If less space is free, all of the free
+  //!  space is reserved instead.
+  //! @param reservation Populated with the reserved region on success. reservation->size holds the
+  //!  number of bytes which were reserved.
+  //!
+  //! @return true if the space was reserved, false otherwise (i.e. storage is full)
+  bool (*reserve_cb)(size_t num_bytes, sMemfaultEventStorageReservation *reservation);
+
+  //! Append data to a reserved event. Does not take memfault_lock().
+  //!
+  //! @return true if the write was successful, false if it exceeds the reserved size
+  bool (*write_reserved_cb)(sMemfaultEventStorageReservation *reservation, const void *bytes,
+                            size_t num_bytes);
+
+  //! Complete a reserved event. Reserved space which was not written to is released.
+  //!
+  //! @param rollback If false, the bytes written to the reservation are published for reading as
+  //!  an event. Otherwise, the event is discarded.
+  //!
+  //! @return true if the event was published, false otherwise
+  bool (*commit_reserved_cb)(sMemfaultEventStorageReservation *reservation, bool rollback);
 };
 
 #ifdef __cplusplus
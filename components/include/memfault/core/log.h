@@ -127,6 +127,10 @@ void memfault_log_save_preformatted(eMemfaultPlatformLogLevel level, const char
                                     size_t log_len);
 
 //! As above, but do not acquire a lock internally.
+//!
+//! @note Logs staged from ISRs (MEMFAULT_LOG_ISR_STAGING_ENABLED) are not moved into the log buffer
+//! by this call, as that requires memfault_lock(). Callers must take the lock and call
+//! memfault_log_drain_isr_logs_locked() from task context before saving.
 void memfault_log_save_preformatted_nolock(eMemfaultPlatformLogLevel level, const char *log,
                                            size_t log_len);
 
@@ -241,6 +245,13 @@ uint32_t memfault_log_get_dropped_count(void);
 //! Return the count of lines that have been written to the logging buffer.
 uint32_t memfault_log_get_recorded_count(void);
 
+//! Return the count of lines issued from ISR context that were dropped because the ISR staging
+//! ring was full (see MEMFAULT_LOG_ISR_STAGING_ENABLED). Monotonically incrementing from boot.
+//!
+//! @note These lines are also included in memfault_log_get_dropped_count() once the staging ring
+//! has been drained.
+uint32_t memfault_log_get_isr_dropped_count(void);
+
 typedef struct {
   size_t num_logs;
   size_t bytes;
@@ -38,6 +38,15 @@ typedef struct {
 //!   to get decoded in a coredump (https://mflt.io/logging)
 bool memfault_log_get_regions(sMemfaultLogRegions *regions);
 
+//! Moves logs issued from ISR context out of the staging ring and into the log buffer. This is a
+//! no-op unless MEMFAULT_LOG_ISR_STAGING_ENABLED is set.
+//!
+//! @note Ports that save logs with memfault_log_save_preformatted_nolock() must call this
+//! periodically, as the nolock save can't drain the staging ring itself.
+//! @note This MUST ONLY be called from task context, by a caller that has already taken
+//! memfault_lock().
+void memfault_log_drain_isr_logs_locked(void);
+
 #ifdef __cplusplus
 }
 #endif
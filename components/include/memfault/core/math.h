@@ -20,6 +20,15 @@ extern "C" {
 #define MEMFAULT_ABS(a) (((a) < 0) ? -(a) : (a))
 #define MEMFAULT_CEIL_DIV(x, y) (((x) + (y) - 1) / (y))
 
+//! Round x up to the next power of 2 (x <= 2^32), usable in constant expressions
+#define MEMFAULT_ROUND_UP_POW2(x) (MEMFAULT_SMEAR16_((x) - 1u) + 1u)
+
+#define MEMFAULT_SMEAR1_(x) ((x) | ((x) >> 1))
+#define MEMFAULT_SMEAR2_(x) (MEMFAULT_SMEAR1_(x) | (MEMFAULT_SMEAR1_(x) >> 2))
+#define MEMFAULT_SMEAR4_(x) (MEMFAULT_SMEAR2_(x) | (MEMFAULT_SMEAR2_(x) >> 4))
+#define MEMFAULT_SMEAR8_(x) (MEMFAULT_SMEAR4_(x) | (MEMFAULT_SMEAR4_(x) >> 8))
+#define MEMFAULT_SMEAR16_(x) (MEMFAULT_SMEAR8_(x) | (MEMFAULT_SMEAR8_(x) >> 16))
+
 #ifdef __cplusplus
 }
 #endif
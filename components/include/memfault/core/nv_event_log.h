@@ -0,0 +1,52 @@
+#pragma once
+
+//! @file
+//!
+//! Copyright (c) Memfault, Inc.
+//! See LICENSE for details
+//!
+//! @brief
+//! A reference implementation of the non-volatile event storage dependencies
+//! (memfault/core/platform/nonvolatile_event_storage.h) on top of a flash region.
+//!
+//! Events are appended to a log which rotates through the sectors of the region, so every event
+//! is written once and sectors are erased in turn as the events they hold have been consumed:
+//!  - Each record is protected by a CRC16, so an event which was only partially written when the
+//!    device lost power is discarded when the log is recovered.
+//!  - Consuming an event clears a flag in its record instead of rewriting the sector.
+//!  - The position of the oldest and newest event are kept in RAM so has_event() and consume()
+//!    only touch the flash around a single record.
+//!
+//! To use, compile with MEMFAULT_EVENT_STORAGE_NV_SUPPORT_ENABLED=1 and
+//! MEMFAULT_NV_EVENT_LOG_ENABLED=1, implement the dependencies in
+//! memfault/core/platform/nv_event_log.h and call memfault_nv_event_log_boot() on boot.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! Recovers the state of the event log from flash
+//!
+//! Must be called before any events are persisted. A region which holds no valid log is treated
+//! as empty, sectors are only erased once they are needed to store new events.
+//!
+//! @return true if the event log is ready for use, false if the storage configuration is invalid
+//! or the flash could not be accessed
+bool memfault_nv_event_log_boot(void);
+
+typedef struct MfltNvEventLogStats {
+  //! Number of events stored which have not been consumed yet
+  size_t num_events;
+  //! Number of sector erases since memfault_nv_event_log_boot() was called
+  uint32_t sector_erase_count;
+} sMfltNvEventLogStats;
+
+void memfault_nv_event_log_get_stats(sMfltNvEventLogStats *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -47,6 +47,15 @@ typedef struct MemfaultDeviceInfo {
 //! @note This function must be safe to call from an interrupt
 void memfault_platform_get_device_info(sMemfaultDeviceInfo *info);
 
+//! Notify the SDK that the information returned by memfault_platform_get_device_info() changed
+//!
+//! Must be called after a runtime change (i.e a device serial provisioned after boot) when
+//! MEMFAULT_EVENT_METADATA_CACHE_ENABLED is set so that subsequent events are serialized with the
+//! new information. A no-op otherwise.
+//!
+//! @note This function takes memfault_lock() and must not be called from an interrupt
+void memfault_device_info_changed(void);
+
 //! Allows caller to get a pointer to a unique version string
 //! starting with their supplied version. Will insert a plus
 //! sign between the supplied version and the unique suffix
@@ -0,0 +1,62 @@
+#pragma once
+
+//! @file
+//!
+//! Copyright (c) Memfault, Inc.
+//! See LICENSE for details
+//!
+//! @brief
+//! Dependency functions required in order to use the non-volatile event log
+//! (MEMFAULT_NV_EVENT_LOG_ENABLED, see memfault/core/nv_event_log.h)
+//!
+//! The storage is expected to behave like NOR flash: erasing sets all the bytes of a sector to
+//! 0xff and writes can only clear bits. Each byte is written at most twice between erases (once
+//! when data is written, once when it is marked as consumed).
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct MfltNvEventLogStorageInfo {
+  //! The size of the flash region reserved for the event log. Must be a multiple of sector_size
+  //! and span at least 2 sectors.
+  size_t size;
+  //! The size of the smallest region that can be erased
+  size_t sector_size;
+} sMfltNvEventLogStorageInfo;
+
+void memfault_platform_nv_event_log_get_info(sMfltNvEventLogStorageInfo *info);
+
+//! Read data from the event log region
+//!
+//! @param offset The offset within the region to read from
+//! @param buf The buffer to copy the data to
+//! @param buf_len The number of bytes to read
+//!
+//! @return true if the read was successful, false otherwise
+bool memfault_platform_nv_event_log_read(uint32_t offset, void *buf, size_t buf_len);
+
+//! Write data to the event log region
+//!
+//! @param offset The offset within the region to write to. Not guaranteed to be aligned.
+//! @param buf The data to write
+//! @param buf_len The number of bytes to write
+//!
+//! @return true if the write was successful, false otherwise
+bool memfault_platform_nv_event_log_write(uint32_t offset, const void *buf, size_t buf_len);
+
+//! Erase a sector of the event log region
+//!
+//! @param offset The offset of the sector to erase, always a multiple of the sector size
+//! @param erase_size The number of bytes to erase, always the sector size
+//!
+//! @return true if the erase was successful, false otherwise
+bool memfault_platform_nv_event_log_erase(uint32_t offset, size_t erase_size);
+
+#ifdef __cplusplus
+}
+#endif
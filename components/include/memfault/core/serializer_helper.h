@@ -29,6 +29,19 @@ bool memfault_serializer_helper_encode_metadata_with_time(sMemfaultCborEncoder *
 bool memfault_serializer_helper_encode_metadata(sMemfaultCborEncoder *encoder,
                                                 eMemfaultEventType type);
 
+//! Encodes the metadata of an event which is saved to event storage
+//!
+//! When MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_ENABLED is set, only the event type and timestamp
+//! are encoded. The metadata shared by all events is instead captured by event storage when the
+//! event is written and added to the header of the batch it is read out in, see
+//! memfault_serializer_helper_encode_batch_metadata(). Otherwise, this
+//! is equivalent to memfault_serializer_helper_encode_metadata().
+bool memfault_serializer_helper_encode_stored_event_metadata(sMemfaultCborEncoder *encoder,
+                                                             eMemfaultEventType type);
+
+//! Encodes the metadata shared by all events in a compact batch as a CBOR dictionary
+bool memfault_serializer_helper_encode_batch_metadata(sMemfaultCborEncoder *encoder);
+
 bool memfault_serializer_helper_encode_uint32_kv_pair(sMemfaultCborEncoder *encoder, uint32_t key,
                                                       uint32_t value);
 
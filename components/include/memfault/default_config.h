@@ -107,6 +107,24 @@ extern "C" {
   #define MEMFAULT_EVENT_INCLUDED_BUILD_ID_SIZE_BYTES 6
 #endif
 
+//! Controls whether the metadata that is identical for every event (the device info returned by
+//! memfault_platform_get_device_info() and the Build Id) is encoded once and cached.
+//!
+//! Saves querying the device info and re-encoding it each time an event is serialized. If the
+//! device info changes at runtime (i.e the device serial is provisioned after boot),
+//! memfault_device_info_changed() must be called so the cache is rebuilt.
+#ifndef MEMFAULT_EVENT_METADATA_CACHE_ENABLED
+  #define MEMFAULT_EVENT_METADATA_CACHE_ENABLED 0
+#endif
+
+//! The size of the buffer holding the cached event metadata. If the encoded metadata does not fit,
+//! it is encoded for every event instead as if the cache were disabled. The cached metadata is
+//! copied to a buffer of this size on the stack of the task serializing an event, so that
+//! memfault_lock() isn't held while the event is written to storage.
+#ifndef MEMFAULT_EVENT_METADATA_CACHE_SIZE
+  #define MEMFAULT_EVENT_METADATA_CACHE_SIZE 128
+#endif
+
 //! Controls whether or not run length encoding (RLE) is used when packetizing
 //! data
 //!
@@ -116,6 +134,55 @@ extern "C" {
   #define MEMFAULT_DATA_SOURCE_RLE_ENABLED 1
 #endif
 
+//! Size of the window used to read the backing data source (i.e. coredump storage) while
+//! run length encoding it
+//!
+//! The window is cached between RLE sequences so each byte in storage is only read once while
+//! draining a message. Larger values result in fewer, larger reads which is typically much faster
+//! for storage such as QSPI or SPI-NOR flash at the cost of RAM.
+#ifndef MEMFAULT_DATA_SOURCE_RLE_READ_BUF_SIZE
+  #define MEMFAULT_DATA_SOURCE_RLE_READ_BUF_SIZE 128
+#endif
+
+//! When enabled, the run length encoded size of a coredump is computed while it is being saved
+//! and cached in the coredump footer.
+//!
+//! This removes the full read pass over coredump storage otherwise needed to compute the RLE size
+//! before a coredump can be drained. Only the header and the last few bytes saved are read back
+//! to complete the size once the coredump is drained.
+//!
+//! Cost in the fault handler: every byte saved is also fed through the RLE encoder as it is
+//! written, in the same pass (a handful of instructions per byte, typically far less than the
+//! time spent writing to storage), and the save context grows by one sMemfaultRleCtx (about 40
+//! bytes of stack on 32-bit targets). Only takes effect when MEMFAULT_DATA_SOURCE_RLE_ENABLED=1
+#ifndef MEMFAULT_COREDUMP_CACHE_RLE_SIZE
+  #define MEMFAULT_COREDUMP_CACHE_RLE_SIZE 0
+#endif
+
+//! When enabled, coredump storage is erased one sector at a time, just ahead of the data being
+//! written, instead of erasing the entire storage region before a coredump is saved.
+//!
+//! This reduces the time spent in the fault handler when a coredump only uses a fraction of the
+//! storage. Requires memfault_platform_coredump_storage_get_info() to report the sector_size of
+//! the storage (when it reports 0, the entire region is erased up front as usual).
+#ifndef MEMFAULT_COREDUMP_STORAGE_INCREMENTAL_ERASE
+  #define MEMFAULT_COREDUMP_STORAGE_INCREMENTAL_ERASE 0
+#endif
+
+//! When enabled, sectors of coredump storage which already read back as erased are not erased
+//! again while saving a coredump (requires MEMFAULT_COREDUMP_STORAGE_INCREMENTAL_ERASE=1).
+//!
+//! Paired with memfault_coredump_storage_pre_erase(), called from a background task after a
+//! coredump has been cleared, the fault handler then only needs to write to storage.
+#ifndef MEMFAULT_COREDUMP_STORAGE_PRE_ERASE_ENABLED
+  #define MEMFAULT_COREDUMP_STORAGE_PRE_ERASE_ENABLED 0
+#endif
+
+//! The value every byte of coredump storage reads back as after being erased
+#ifndef MEMFAULT_COREDUMP_STORAGE_ERASED_BYTE
+  #define MEMFAULT_COREDUMP_STORAGE_ERASED_BYTE 0xff
+#endif
+
 //! Controls default log level that will be saved to https://mflt.io/logging
 #ifndef MEMFAULT_RAM_LOGGER_DEFAULT_MIN_LOG_LEVEL
   #define MEMFAULT_RAM_LOGGER_DEFAULT_MIN_LOG_LEVEL kMemfaultPlatformLogLevel_Info
@@ -142,6 +209,34 @@ extern "C" {
   #define MEMFAULT_LOG_MAX_LINE_SAVE_LEN 128
 #endif
 
+//! Saves logs issued from ISR context (see memfault_arch_is_inside_isr()) instead of dropping
+//! them. As the RAM log buffer requires memfault_lock(), ISR logs are first copied into a small
+//! lock-free staging ring, which is drained into the log buffer by the next log saved from task
+//! context or by memfault_log_trigger_collection(). Logs which don't fit in the ring are counted
+//! by memfault_log_get_isr_dropped_count().
+//!
+//! Logs saved with memfault_log_save_preformatted_nolock() don't drain the ring, callers of it
+//! (e.g. the Zephyr log backend) call memfault_log_drain_isr_logs_locked() from task context
+//! first. ISR logs still in the ring when the system faults are lost: the ring isn't drained from
+//! the fault handler, as the log buffer may be in the middle of an update, and it isn't captured
+//! in coredumps.
+//!
+//! @note Requires C11 atomics (<stdatomic.h>)
+#ifndef MEMFAULT_LOG_ISR_STAGING_ENABLED
+  #define MEMFAULT_LOG_ISR_STAGING_ENABLED 0
+#endif
+
+//! Number of ISR logs the staging ring can hold until it is drained. Must be a power of 2.
+#ifndef MEMFAULT_LOG_ISR_STAGING_NUM_ENTRIES
+  #define MEMFAULT_LOG_ISR_STAGING_NUM_ENTRIES 8
+#endif
+
+//! Maximum length of an ISR log. Longer preformatted logs are truncated, longer compact logs are
+//! dropped.
+#ifndef MEMFAULT_LOG_ISR_STAGING_MAX_LINE_LEN
+  #define MEMFAULT_LOG_ISR_STAGING_MAX_LINE_LEN 64
+#endif
+
 //! Control whether or automatic persisting of MEMFAULT_LOG_*'s is enabled
 #ifndef MEMFAULT_SDK_LOG_SAVE_DISABLE
   #define MEMFAULT_SDK_LOG_SAVE_DISABLE 0
@@ -197,6 +292,25 @@ extern "C" {
   #define MEMFAULT_EVENT_STORAGE_READ_BATCHING_ENABLED 0
 #endif
 
+//! Allows several tasks to write events to the RAM event storage concurrently.
+//!
+//! When enabled, a slot of up to MEMFAULT_EVENT_STORAGE_RESERVED_WRITES_MAX_EVENT_SIZE bytes is
+//! reserved in storage for each event. The event is then encoded directly into its slot without
+//! holding memfault_lock(), and published by updating the slot header once encoding completes,
+//! at which point the unused part of the slot is released. Without this, only one event can be
+//! written at a time and memfault_lock() is taken for every encoded CBOR token.
+#ifndef MEMFAULT_EVENT_STORAGE_RESERVED_WRITES_ENABLED
+  #define MEMFAULT_EVENT_STORAGE_RESERVED_WRITES_ENABLED 0
+#endif
+
+//! The space reserved for each event when MEMFAULT_EVENT_STORAGE_RESERVED_WRITES_ENABLED=1. It
+//! must be at least the size of the largest event (i.e the value returned by
+//! memfault_metrics_heartbeat_compute_worst_case_storage_size()), larger events are dropped.
+//! Smaller values allow more producers to encode events at the same time.
+#ifndef MEMFAULT_EVENT_STORAGE_RESERVED_WRITES_MAX_EVENT_SIZE
+  #define MEMFAULT_EVENT_STORAGE_RESERVED_WRITES_MAX_EVENT_SIZE 512
+#endif
+
 //! Enables support for non-volatile event storage. At run-time the non-volatile
 //! storage must be enabled before use. See nonvolatile_event_storage.h for
 //! details.
@@ -204,6 +318,20 @@ extern "C" {
   #define MEMFAULT_EVENT_STORAGE_NV_SUPPORT_ENABLED 0
 #endif
 
+//! Provides g_memfault_platform_nv_event_storage_impl, backed by an append-only log of events
+//! which rotates through the sectors of a flash region. The flash region is accessed through the
+//! dependencies in memfault/core/platform/nv_event_log.h. See memfault/core/nv_event_log.h for
+//! details.
+#ifndef MEMFAULT_NV_EVENT_LOG_ENABLED
+  #define MEMFAULT_NV_EVENT_LOG_ENABLED 0
+#endif
+
+//! Size of the stack buffer events are staged in while being written to the non-volatile event
+//! log. Larger values result in fewer, larger flash writes.
+#ifndef MEMFAULT_NV_EVENT_LOG_WRITE_BUF_SIZE
+  #define MEMFAULT_NV_EVENT_LOG_WRITE_BUF_SIZE 64
+#endif
+
 #if MEMFAULT_EVENT_STORAGE_READ_BATCHING_ENABLED != 0
 
   //! When batching is enabled, controls the maximum amount of event data bytes
@@ -217,8 +345,45 @@ extern "C" {
     #define MEMFAULT_EVENT_STORAGE_READ_BATCHING_MAX_BYTES UINT32_MAX
   #endif
 
+  //! Hoists the metadata common to all events (schema version, device info and build id) out
+  //! of each stored event and into the header of the batch read from event storage. Events are
+  //! then stored with only their type, timestamp and event info, which saves both event storage
+  //! space and transport bandwidth.
+  //!
+  //! The metadata is captured in RAM when each event is written (set
+  //! MEMFAULT_EVENT_METADATA_CACHE_ENABLED to avoid re-encoding it every time), and a batch ends
+  //! where it changed. An event is not stored if its metadata does not fit in
+  //! MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_METADATA_MAX_LEN, or if storage already holds events
+  //! with MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_MAX_GENERATIONS different sets of metadata.
+  //! These events are counted by memfault_event_storage_read_metadata_drop_count().
+  //!
+  //! @note Batches are sent with the "compact events" message type (5), which the backend the
+  //! chunks are forwarded to must support. Don't enable this unless it does.
+  //!
+  //! @note The captured metadata is not part of the saved event storage state, so this cannot be
+  //! combined with MEMFAULT_EVENT_STORAGE_RESTORE_STATE.
+  #ifndef MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_ENABLED
+    #define MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_ENABLED 0
+  #endif
+
+  //! The number of different sets of metadata (i.e the device info changing at runtime) the events
+  //! in storage can have at once. Each costs
+  //! MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_METADATA_MAX_LEN + 2 * sizeof(size_t) bytes of RAM.
+  #ifndef MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_MAX_GENERATIONS
+    #define MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_MAX_GENERATIONS 3
+  #endif
+
+  //! The space reserved for the encoded metadata in the header of a compact batch
+  #ifndef MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_METADATA_MAX_LEN
+    #define MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_METADATA_MAX_LEN 160
+  #endif
+
 #endif /* MEMFAULT_EVENT_STORAGE_READ_BATCHING_ENABLED */
 
+#ifndef MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_ENABLED
+  #define MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_ENABLED 0
+#endif
+
 //! Include a stub, weakly defined implementation of
 //! memfault_platform_time_get_current(). Most build systems will be able to
 //! override the symbol with a custom implementation at link time, but some will
@@ -254,6 +419,18 @@ extern "C" {
   #define MEMFAULT_MESSAGE_HEADER_CONTAINS_PROJECT_KEY 0
 #endif
 
+//! When a message has been sent in full, pick the next one from the highest priority data source
+//! with data (events, then logs, then custom data recordings, then coredumps) instead of sending
+//! any pending coredump first.
+//!
+//! @note This only chooses which message is started next. Messages are sent one at a time and
+//! the chunks on the wire are unchanged, so once a coredump upload has started, events recorded
+//! in the meantime are only sent after the coredump has been sent in full (or the upload is
+//! restarted with memfault_packetizer_abort()).
+#ifndef MEMFAULT_PACKETIZER_PRIORITY_CHANNELS_ENABLED
+  #define MEMFAULT_PACKETIZER_PRIORITY_CHANNELS_ENABLED 0
+#endif
+
 //
 // Heap Statistics Configuration
 //
@@ -273,6 +450,10 @@ extern "C" {
 
 //! Max number of recent outstanding heap allocations to track.
 //! oldest tracked allocations are expired (by allocation order)
+//! Note: In addition to the pool itself, the lookup tables that keep the malloc & free hooks
+//! constant time use 2 * MAX_COUNT + 2 * H bytes of RAM, where H is 2 * MAX_COUNT rounded up to a
+//! power of 2. That is 6 bytes per entry when MAX_COUNT is a power of 2, and up to ~10 bytes per
+//! entry when it is just above one (e.g. 33 entries use 2 * 33 + 2 * 128 = 322 bytes).
 #ifndef MEMFAULT_HEAP_STATS_MAX_COUNT
   #define MEMFAULT_HEAP_STATS_MAX_COUNT 32
 #endif
@@ -408,6 +589,35 @@ extern "C" {
   #define MEMFAULT_METRICS_RESTORE_STATE 0
 #endif
 
+//! Enable memfault_metrics_heartbeat_add_lockless(), which adds to an integer metric with an
+//! atomic add instead of taking memfault_lock(). Amounts are accumulated per metric and folded
+//! into the metric value when heartbeat or session data is collected, so hot counters updated
+//! from many threads don't contend on the global lock.
+//!
+//! @note Requires C11 atomics (<stdatomic.h>)
+#ifndef MEMFAULT_METRICS_LOCKLESS_COUNTERS_ENABLED
+  #define MEMFAULT_METRICS_LOCKLESS_COUNTERS_ENABLED 0
+#endif
+
+//! Resolution of histogram metrics (MEMFAULT_METRICS_HISTOGRAM_KEY_DEFINE). Each power of 2 range
+//! of values is split into 2^MEMFAULT_METRICS_HISTOGRAM_SUB_BUCKET_BITS linear buckets, so the
+//! reported percentiles are within 1 / 2^MEMFAULT_METRICS_HISTOGRAM_SUB_BUCKET_BITS of the
+//! recorded values (6.25% by default).
+#ifndef MEMFAULT_METRICS_HISTOGRAM_SUB_BUCKET_BITS
+  #define MEMFAULT_METRICS_HISTOGRAM_SUB_BUCKET_BITS 4
+#endif
+
+//! Values recorded to a histogram metric are bucketed up to 2^MEMFAULT_METRICS_HISTOGRAM_MAX_BITS
+//! (about 16.7 s for values in microseconds by default). Larger values are counted in a separate
+//! overflow bucket and reported by the "_overflow" metric. A percentile which falls in the overflow
+//! bucket is reported as the "_max" value, the only bound known for it. Each histogram uses
+//!   (MEMFAULT_METRICS_HISTOGRAM_MAX_BITS - MEMFAULT_METRICS_HISTOGRAM_SUB_BUCKET_BITS + 1) *
+//!   2^MEMFAULT_METRICS_HISTOGRAM_SUB_BUCKET_BITS + 1
+//! 32-bit counters of RAM, 337 (1348 bytes) with the defaults. Lower either setting to save RAM.
+#ifndef MEMFAULT_METRICS_HISTOGRAM_MAX_BITS
+  #define MEMFAULT_METRICS_HISTOGRAM_MAX_BITS 24
+#endif
+
 //
 // Panics Component Configs
 //
@@ -552,6 +762,13 @@ extern "C" {
   #endif
 #endif
 
+//! Space reserved in front of a chunk for the header of its POST request, so the header and the
+//! chunk can be sent with a single write. A header which doesn't fit, because of an unusually long
+//! device serial, chunks API host or project key, is sent in several writes instead.
+#ifndef MEMFAULT_HTTP_REQUEST_HEADER_MAX_LEN
+  #define MEMFAULT_HTTP_REQUEST_HEADER_MAX_LEN 320
+#endif
+
 //
 // Util Configuration Options
 //
@@ -571,6 +788,25 @@ extern "C" {
   #define MEMFAULT_CRC16_LOOKUP_TABLE_ENABLE 1
 #endif
 
+// When the lookup table is enabled, process the data this many bytes at a time (1, 4 or 8) using
+// "slice-by-N" lookup tables. Slicing breaks the dependency between consecutive table lookups at
+// the cost of an additional 512 bytes of flash per extra table (1.5 KiB for 4, 3.5 KiB for 8)
+#ifndef MEMFAULT_CRC16_SLICE_BY
+  #define MEMFAULT_CRC16_SLICE_BY 1
+#endif
+
+// When the lookup table is disabled, use a 32 byte table to process the data 4 bits at a time
+// instead of computing the CRC bit by bit
+#ifndef MEMFAULT_CRC16_NIBBLE_TABLE_ENABLE
+  #define MEMFAULT_CRC16_NIBBLE_TABLE_ENABLE 0
+#endif
+
+// Offer each CRC16 computation to memfault_platform_crc16_compute() first, for example to make use
+// of a hardware CRC peripheral. See memfault/util/crc16.h for details
+#ifndef MEMFAULT_CRC16_PLATFORM_HOOK_ENABLE
+  #define MEMFAULT_CRC16_PLATFORM_HOOK_ENABLE 0
+#endif
+
 //
 // Demo Configuration Options
 //
@@ -667,6 +903,15 @@ extern "C" {
   #define MEMFAULT_PLATFORM_MAX_TRACKED_TASKS 16
 #endif
 
+//! By default, the RTOS ports scan the array of tracked TCBs when a task is created or deleted.
+//! Enable this flag to find the slot of a task in constant time instead, for systems tracking
+//! many tasks (roughly 64 or more, where the scan becomes the slower of the two). It costs
+//! 2 * N + 2 * H bytes of RAM, where N is the number of tracked tasks and H is 2 * N rounded up
+//! to a power of 2 (e.g. 32 tasks use 2 * 32 + 2 * 64 = 192 bytes).
+#ifndef MEMFAULT_TASK_REGISTRY_CONSTANT_TIME
+  #define MEMFAULT_TASK_REGISTRY_CONSTANT_TIME 0
+#endif
+
 //! The default amount of stack for each task to collect in bytes.  The larger
 //! the size, the more stack frames Memfault will be able to unwind when the
 //! coredump is uploaded.
@@ -47,6 +47,207 @@ typedef bool (*MfltHttpClientSendCb)(const void *data, size_t data_len, void *ct
 bool memfault_http_start_chunk_post(MfltHttpClientSendCb callback, void *ctx,
                                     size_t content_body_length);
 
+//! Renders the HTTP 'Request-Line' and Headers for a POST to the Memfault Chunk Endpoint into a
+//! caller provided buffer, the same as memfault_http_start_chunk_post() sends them
+//!
+//! This allows the header and the chunk to be sent with a single write by rendering the chunk
+//! after the header in the same buffer. memfault_http_start_chunk_post() sends the header in
+//! several writes instead, and should be used when it does not fit.
+//!
+//! @param buf The buffer to render the header into
+//! @param buf_len The size of buf. MEMFAULT_HTTP_REQUEST_HEADER_MAX_LEN bytes fit the header
+//!  unless the device serial, chunks API host or project key are unusually long.
+//! @param content_body_length The length of the chunk payload to be sent
+//!
+//! @return the length of the header, or 0 if it does not fit in buf
+size_t memfault_http_build_chunk_post_header(void *buf, size_t buf_len,
+                                             size_t content_body_length);
+
+//! The boundary delimiting the chunks in the body of a chunks batch POST
+#define MEMFAULT_HTTP_CHUNKS_BATCH_BOUNDARY "MemfaultChunksBatch"
+
+//! Builds the HTTP 'Request-Line' and Headers for a POST of a batch of several chunks to the
+//! Memfault Chunk Endpoint
+//!
+//! Uploading a batch amortizes the cost of the request headers and the round trip to the server
+//! across all of the chunks returned from memfault_packetizer_get_chunks_bulk().
+//!
+//! @note Upon completion of this call, a caller then needs to send the body of the request with
+//! memfault_http_write_chunks_batch_body().
+//!
+//! @param callback The callback invoked to send post request data.
+//! @param ctx A user specific context that gets passed to 'callback' invocations.
+//! @param content_body_length The length of the batch body to be sent, as computed by
+//!  memfault_http_chunks_batch_body_length(). This value will be populated in the HTTP
+//!  "Content-Length" header.
+//!
+//! @return true if the post was successful, false otherwise
+bool memfault_http_start_chunks_batch_post(MfltHttpClientSendCb callback, void *ctx,
+                                           size_t content_body_length);
+
+//! Computes the length of the multipart body framing a batch of chunks
+//!
+//! @param chunk_lens The length of each chunk in the batch
+//! @param num_chunks The number of chunks in the batch
+//!
+//! @return The number of bytes memfault_http_write_chunks_batch_body() will write
+size_t memfault_http_chunks_batch_body_length(const size_t *chunk_lens, size_t num_chunks);
+
+//! Sends the multipart body of a chunks batch POST
+//!
+//! @param callback The callback invoked to send the body data.
+//! @param ctx A user specific context that gets passed to 'callback' invocations.
+//! @param chunks The chunks to send, stored back to back (as populated by
+//!  memfault_packetizer_get_chunks_bulk())
+//! @param chunk_lens The length of each chunk in the batch
+//! @param num_chunks The number of chunks in the batch
+//!
+//! @return true if the body was sent successfully, false otherwise
+bool memfault_http_write_chunks_batch_body(MfltHttpClientSendCb callback, void *ctx,
+                                           const void *chunks, const size_t *chunk_lens,
+                                           size_t num_chunks);
+
+//! Builds the HTTP 'Request-Line' and Headers for a POST which streams several chunks to the
+//! Memfault Chunk Endpoint
+//!
+//! The body is the same multipart body as a chunks batch POST, but it is sent with
+//! "Transfer-Encoding: chunked", so every message available from the packetizer can be sent in a
+//! single POST through a small buffer without knowing the length of the body up front.
+//!
+//! @note memfault_http_post_chunks_stream() sends this header followed by the body of the
+//! request, and should be used instead unless the body is built by hand.
+//!
+//! @param callback The callback invoked to send post request data.
+//! @param ctx A user specific context that gets passed to 'callback' invocations.
+//!
+//! @return true if the post was successful, false otherwise
+bool memfault_http_start_chunks_stream_post(MfltHttpClientSendCb callback, void *ctx);
+
+//! Sends a chunks stream POST, reading messages from the packetizer until none are left or
+//! max_messages have been sent, and terminates the body
+//!
+//! Nothing is sent if no message is available, since a body without any message is rejected.
+//!
+//! @note Messages are marked as sent once they have been streamed. If the POST fails after that,
+//! they are not sent again. The message being streamed when a write fails is rewound with
+//! memfault_packetizer_abort() and sent again by the next upload.
+//!
+//! @param callback The callback invoked to send the request data.
+//! @param ctx A user specific context that gets passed to 'callback' invocations.
+//! @param buf A working buffer. Each write of the body sends at most buf_len bytes.
+//! @param buf_len The size of buf. Must be large enough to hold the framing of a transfer chunk
+//!  and MEMFAULT_PACKETIZER_MIN_BUF_LEN bytes of data.
+//! @param max_messages The maximum number of messages to send
+//!
+//! @return the number of messages sent, 0 if no message was available and nothing was sent, or
+//!  -1 if sending the request failed
+int memfault_http_post_chunks_stream(MfltHttpClientSendCb callback, void *ctx, void *buf,
+                                     size_t buf_len, size_t max_messages);
+
+//! Terminates each transfer chunk of the body of a chunks stream POST
+#define MEMFAULT_HTTP_TRANSFER_CHUNK_END "\r\n"
+
+//! Renders the size line of a transfer chunk carrying data_len bytes
+//!
+//! @return the length of the size line, or 0 if it does not fit in buf
+size_t memfault_http_chunks_stream_data_header(char *buf, size_t buf_len, size_t data_len);
+
+//! Sends the transfer chunk starting a part of the body of a chunks stream POST. The chunk data
+//! must be sent with a transfer chunk of its own, followed by
+//! memfault_http_write_chunks_stream_part_end().
+//!
+//! @param chunk_len The length of the chunk sent in this part
+//!
+//! @return true if the data was sent successfully, false otherwise
+bool memfault_http_write_chunks_stream_part_begin(MfltHttpClientSendCb callback, void *ctx,
+                                                  size_t chunk_len);
+
+//! Sends the transfer chunk ending a part of the body of a chunks stream POST
+//!
+//! @return true if the data was sent successfully, false otherwise
+bool memfault_http_write_chunks_stream_part_end(MfltHttpClientSendCb callback, void *ctx);
+
+//! Sends the closing delimiter of the body of a chunks stream POST and the last transfer chunk
+//!
+//! @return true if the data was sent successfully, false otherwise
+bool memfault_http_end_chunks_stream(MfltHttpClientSendCb callback, void *ctx);
+
+//! Waits for the response to the oldest chunk POST still in flight on the connection
+//!
+//! @param ctx The user specific context passed to memfault_http_pipeline_upload()
+//!
+//! @return the HTTP status code of the response, or -1 if the response could not be received
+typedef int (*MfltHttpPipelineResponseCb)(void *ctx);
+
+//! Chunk POSTs which are in flight or waiting to be re-posted. Define one with
+//! MEMFAULT_HTTP_PIPELINE_DEFINE().
+typedef struct {
+  //! depth buffers of msg_buf_len bytes, each holding a chunk and room for its request header
+  uint8_t *msg_bufs;
+  size_t *chunk_lens;
+  size_t depth;
+  size_t msg_buf_len;
+
+  // For internal use only
+  size_t head;
+  size_t count;
+  size_t in_flight;
+} sMfltHttpPipeline;
+
+//! The size of a buffer holding a chunk of up to max_chunk_len bytes and its request header
+#define MEMFAULT_HTTP_PIPELINE_MSG_BUF_LEN(max_chunk_len) \
+  (MEMFAULT_HTTP_REQUEST_HEADER_MAX_LEN + (max_chunk_len))
+
+//! Defines a static pipeline keeping up to 'pipeline_depth' chunk POSTs of up to max_chunk_len
+//! bytes in flight
+#define MEMFAULT_HTTP_PIPELINE_DEFINE(name, pipeline_depth, max_chunk_len)                 \
+  static uint8_t                                                                           \
+    name##_msg_bufs[(pipeline_depth) * MEMFAULT_HTTP_PIPELINE_MSG_BUF_LEN(max_chunk_len)]; \
+  static size_t name##_chunk_lens[(pipeline_depth)];                                       \
+  static sMfltHttpPipeline name = {                                                        \
+    .msg_bufs = name##_msg_bufs,                                                           \
+    .chunk_lens = name##_chunk_lens,                                                       \
+    .depth = (pipeline_depth),                                                             \
+    .msg_buf_len = MEMFAULT_HTTP_PIPELINE_MSG_BUF_LEN(max_chunk_len),                      \
+  }
+
+//! Posts chunks from the packetizer with up to pipeline->depth POSTs in flight on the same
+//! connection (HTTP/1.1 pipelining), matching the responses to the POSTs in order
+//!
+//! Every POST is sent with a single call to 'send_callback', holding the request header followed
+//! by the chunk, unless the header is longer than MEMFAULT_HTTP_REQUEST_HEADER_MAX_LEN.
+//!
+//! Retry semantics:
+//!  - The packetizer moves past a chunk as soon as it is read, so the chunk is kept in the
+//!    pipeline until the server responds to its POST.
+//!  - A chunk is acknowledged, and dropped from the pipeline, by any response to its POST. Like
+//!    a non-pipelined upload, a chunk the server rejects (non-2xx response) is not sent again.
+//!    No new chunks are posted after a rejection, but the responses to the POSTs already in
+//!    flight are still read.
+//!  - If a send fails or a response can't be received, the state of the connection is unknown
+//!    and the upload stops. Every chunk not acknowledged yet stays in the pipeline, and the next
+//!    upload (on a new connection) re-posts them first, in their original order.
+//!  - The server may have processed some of the re-posted chunks before the connection failed,
+//!    so a chunk can be delivered more than once (at-least-once delivery). Chunks are never lost
+//!    or re-ordered.
+//!
+//! @param pipeline The pipeline, holding the chunks not acknowledged by a previous upload
+//! @param send_callback The callback invoked to send the POSTs
+//! @param response_callback The callback invoked to wait for the response to the oldest POST
+//! @param ctx A user specific context that gets passed to the callbacks
+//! @param max_messages_to_send Decremented for every chunk read from the packetizer. No new chunk
+//!  is read once it reaches 0, but chunks already in the pipeline are still posted.
+//!
+//! @return true if every POST was sent and accepted, false otherwise
+bool memfault_http_pipeline_upload(sMfltHttpPipeline *pipeline,
+                                   MfltHttpClientSendCb send_callback,
+                                   MfltHttpPipelineResponseCb response_callback, void *ctx,
+                                   int *max_messages_to_send);
+
+//! @return true if the pipeline holds chunks which were not acknowledged by the server and will
+//! be re-posted by the next upload
+bool memfault_http_pipeline_has_unacked_chunks(const sMfltHttpPipeline *pipeline);
+
 //! Builds the HTTP GET request to query the Memfault cloud to see if a new OTA Payload is available
 //!
 //! For more details about release management and OTA payloads in general, check out:
@@ -83,12 +284,18 @@ typedef enum MfltHttpParseStatus {
   MfltHttpParseStatus_ParseStatusLineError,
   MfltHttpParseStatus_ParseHeaderError,
   MfltHttpParseStatus_HeaderTooLongError,
+  MfltHttpParseStatus_ParseChunkedBodyError,
 } eMfltHttpParseStatus;
 
 typedef enum MfltHttpParsePhase {
   kMfltHttpParsePhase_ExpectingStatusLine = 0,
   kMfltHttpParsePhase_ExpectingHeader,
   kMfltHttpParsePhase_ExpectingBody,
+  // Phases of a body sent with "Transfer-Encoding: chunked"
+  kMfltHttpParsePhase_ExpectingChunkSize,
+  kMfltHttpParsePhase_ExpectingChunkData,
+  kMfltHttpParsePhase_ExpectingChunkDataEnd,
+  kMfltHttpParsePhase_ExpectingTrailer,
 } eMfltHttpParsePhase;
 
 typedef struct {
@@ -106,11 +313,18 @@ typedef struct {
   //! Valid upon parsing completion if no parse_error was returned
   int content_length;
 
+  //! true if the response body is sent with "Transfer-Encoding: chunked". The body then has no
+  //! Content-Length and content_length is left at 0.
+  bool chunked_body;
+
   // For internal use only
   eMfltHttpParsePhase phase;
   int content_received;
   size_t line_len;
   char line_buf[128];
+  int chunk_remaining;
+  size_t chunk_line_len;
+  bool chunk_size_done;
 } sMemfaultHttpResponseContext;
 
 //! A *minimal* HTTP response parser for Memfault API calls
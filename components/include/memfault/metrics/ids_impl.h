@@ -16,6 +16,44 @@ extern "C" {
 
 #include "memfault/config.h"
 
+//! Define a histogram metric, which tracks the distribution of the values recorded to it with
+//! MEMFAULT_METRIC_HISTOGRAM_RECORD() during a heartbeat. It's reported as 5 unsigned metrics:
+//! - "<key_name>_p50", "<key_name>_p90", "<key_name>_p99": the 50th, 90th and 99th percentiles of
+//!   the recorded values, accurate to within the bucket resolution set by
+//!   MEMFAULT_METRICS_HISTOGRAM_SUB_BUCKET_BITS
+//! - "<key_name>_max": the largest recorded value
+//! - "<key_name>_overflow": the number of recorded values of 2^MEMFAULT_METRICS_HISTOGRAM_MAX_BITS
+//!   or more, which are beyond the bucket range
+//!
+//! Should only be used in the heartbeat config .def files. Histograms are expressed in terms of
+//! the other key definitions, so they don't need to be handled by each x-macro expansion.
+#define MEMFAULT_METRICS_HISTOGRAM_KEY_DEFINE(key_name)                          \
+  MEMFAULT_METRICS_HISTOGRAM_DEFINE_(key_name, heartbeat)                        \
+  MEMFAULT_METRICS_KEY_DEFINE(key_name##_p50, kMemfaultMetricType_Unsigned)      \
+  MEMFAULT_METRICS_KEY_DEFINE(key_name##_p90, kMemfaultMetricType_Unsigned)      \
+  MEMFAULT_METRICS_KEY_DEFINE(key_name##_p99, kMemfaultMetricType_Unsigned)      \
+  MEMFAULT_METRICS_KEY_DEFINE(key_name##_max, kMemfaultMetricType_Unsigned)      \
+  MEMFAULT_METRICS_KEY_DEFINE(key_name##_overflow, kMemfaultMetricType_Unsigned)
+
+//! Same as MEMFAULT_METRICS_HISTOGRAM_KEY_DEFINE, for a histogram tracked in a metric session.
+//! Values are recorded with MEMFAULT_METRIC_SESSION_HISTOGRAM_RECORD().
+#define MEMFAULT_METRICS_HISTOGRAM_KEY_DEFINE_WITH_SESSION(key_name, session_key)             \
+  MEMFAULT_METRICS_HISTOGRAM_DEFINE_(key_name, session_key)                                   \
+  MEMFAULT_METRICS_KEY_DEFINE_WITH_SESSION(key_name##_p50, kMemfaultMetricType_Unsigned,      \
+                                           session_key)                                       \
+  MEMFAULT_METRICS_KEY_DEFINE_WITH_SESSION(key_name##_p90, kMemfaultMetricType_Unsigned,      \
+                                           session_key)                                       \
+  MEMFAULT_METRICS_KEY_DEFINE_WITH_SESSION(key_name##_p99, kMemfaultMetricType_Unsigned,      \
+                                           session_key)                                       \
+  MEMFAULT_METRICS_KEY_DEFINE_WITH_SESSION(key_name##_max, kMemfaultMetricType_Unsigned,      \
+                                           session_key)                                       \
+  MEMFAULT_METRICS_KEY_DEFINE_WITH_SESSION(key_name##_overflow, kMemfaultMetricType_Unsigned, \
+                                           session_key)
+
+//! Only expanded when generating the histogram index enum below, and the histogram table in
+//! memfault_metrics.c
+#define MEMFAULT_METRICS_HISTOGRAM_DEFINE_(key_name, session_name)
+
 // Clear any potential issues from transitive dependencies in these files by
 // including them one time, with stubs for the macros we need to define. This
 // set up any multiple-include guards, and we can safely include the x-macro
@@ -157,6 +195,41 @@ typedef enum MfltMetricSessionIndex {
     kMfltMetricsSessionKey_COUNT,
 } eMfltMetricsSessionIndex;
 
+//! Generate an enum for all histogram metrics, used to index into the histogram bucket storage
+#undef MEMFAULT_METRICS_HISTOGRAM_DEFINE_
+#define MEMFAULT_METRICS_HISTOGRAM_DEFINE_(key_name, session_name) \
+  kMfltMetricsHistogramIndex_##session_name##__##key_name,
+#define MEMFAULT_METRICS_SESSION_KEY_DEFINE(key_name)
+#define MEMFAULT_METRICS_KEY_DEFINE(key_name, value_type)
+#define MEMFAULT_METRICS_KEY_DEFINE_WITH_RANGE(key_name, value_type, min_value, max_value)
+#define MEMFAULT_METRICS_STRING_KEY_DEFINE(key_name, max_length)
+#define MEMFAULT_METRICS_KEY_DEFINE_WITH_SCALE_VALUE(key_name, value_type, scale_value)
+
+#define MEMFAULT_METRICS_STRING_KEY_DEFINE_WITH_SESSION(key_name, max_length, session_key)
+#define MEMFAULT_METRICS_KEY_DEFINE_WITH_SESSION(key_name, value_type, session_name)
+#define MEMFAULT_METRICS_KEY_DEFINE_WITH_RANGE_AND_SESSION(key_name, value_type, min_value, \
+                                                           max_value, session_name)
+
+#define MEMFAULT_METRICS_KEY_DEFINE_WITH_SESSION_AND_SCALE_VALUE(key_name, value_type, \
+                                                                 session_key, scale_value)
+
+typedef enum MfltMetricsHistogramIndex {
+#include "memfault/metrics/heartbeat_config.def"
+#include MEMFAULT_METRICS_USER_HEARTBEAT_DEFS_FILE
+#undef MEMFAULT_METRICS_SESSION_KEY_DEFINE
+#undef MEMFAULT_METRICS_KEY_DEFINE
+#undef MEMFAULT_METRICS_KEY_DEFINE_WITH_RANGE
+#undef MEMFAULT_METRICS_STRING_KEY_DEFINE
+#undef MEMFAULT_METRICS_STRING_KEY_DEFINE_WITH_SESSION
+#undef MEMFAULT_METRICS_KEY_DEFINE_WITH_SESSION
+#undef MEMFAULT_METRICS_KEY_DEFINE_WITH_RANGE_AND_SESSION
+#undef MEMFAULT_METRICS_KEY_DEFINE_WITH_SCALE_VALUE
+#undef MEMFAULT_METRICS_KEY_DEFINE_WITH_SESSION_AND_SCALE_VALUE
+  kMfltMetricsHistogramIndex_COUNT,
+} eMfltMetricsHistogramIndex;
+#undef MEMFAULT_METRICS_HISTOGRAM_DEFINE_
+#define MEMFAULT_METRICS_HISTOGRAM_DEFINE_(key_name, session_name)
+
 //! Compute the total size of string key metric storage, by tallying up the
 //! individual string metric sizes. Use a uint8_t array to compute the size,
 //! because we can't x-macro within a #define. Set it to 1 byte to account for
@@ -281,6 +354,9 @@ typedef struct {
 #define _MEMFAULT_METRICS_ID(id, session_name) \
   ((MemfaultMetricId){ kMfltMetricsIndex_##session_name##__##id })
 
+#define _MEMFAULT_METRICS_HISTOGRAM_ID(id, session_name) \
+  kMfltMetricsHistogramIndex_##session_name##__##id
+
 #ifdef __cplusplus
 }
 #endif
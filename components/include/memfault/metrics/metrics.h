@@ -216,6 +216,37 @@ int memfault_metrics_heartbeat_timer_stop(MemfaultMetricId key);
 //! @note The metric must be of type kMemfaultMetricType_Unsigned or kMemfaultMetricType_Signed
 int memfault_metrics_heartbeat_add(MemfaultMetricId key, int32_t amount);
 
+//! Record a value to a histogram metric
+//!
+//! The percentiles of the recorded values are computed and stored to the histogram's "_p50",
+//! "_p90" and "_p99" metrics, along with the "_overflow" count of values beyond the bucket range,
+//! when the heartbeat or session is collected. The "_max" metric is updated as values are recorded.
+//!
+//! @param histogram The histogram to record to. Use MEMFAULT_METRIC_HISTOGRAM_RECORD() or
+//! MEMFAULT_METRIC_SESSION_HISTOGRAM_RECORD() rather than calling this function directly.
+//! @param value The value to record
+//!
+//! @return 0 on success, else error code
+int memfault_metrics_histogram_record(eMfltMetricsHistogramIndex histogram, uint32_t value);
+
+#if MEMFAULT_METRICS_LOCKLESS_COUNTERS_ENABLED
+//! Same as memfault_metrics_heartbeat_add(), but without taking memfault_lock()
+//!
+//! The amount is atomically added to a pending total for the metric, which is folded into the
+//! metric value (with the same clipping as memfault_metrics_heartbeat_add()) when the heartbeat
+//! or a session containing the metric is collected. Until then it is not visible to the
+//! memfault_metrics_heartbeat_read_*() APIs.
+//!
+//! @param key The key of the metric to add to
+//! @param amount The amount to add. The amounts added to a metric between two collections must
+//! sum to a value that fits in an int32_t.
+//!
+//! @return 0 on success, else error code
+//! @note The metric must be of type kMemfaultMetricType_Unsigned or kMemfaultMetricType_Signed
+//! @note Requires MEMFAULT_METRICS_LOCKLESS_COUNTERS_ENABLED=1
+int memfault_metrics_heartbeat_add_lockless(MemfaultMetricId key, int32_t amount);
+#endif
+
 //! Alternate API that includes the 'MEMFAULT_METRICS_KEY()' expansion
 #define MEMFAULT_METRIC_SET_SIGNED(key_name, signed_value) \
   memfault_metrics_heartbeat_set_signed(MEMFAULT_METRICS_KEY(key_name), (signed_value))
@@ -229,6 +260,10 @@ int memfault_metrics_heartbeat_add(MemfaultMetricId key, int32_t amount);
   memfault_metrics_heartbeat_timer_stop(MEMFAULT_METRICS_KEY(key_name))
 #define MEMFAULT_METRIC_ADD(key_name, amount) \
   memfault_metrics_heartbeat_add(MEMFAULT_METRICS_KEY(key_name), (amount))
+#define MEMFAULT_METRIC_ADD_LOCKLESS(key_name, amount) \
+  memfault_metrics_heartbeat_add_lockless(MEMFAULT_METRICS_KEY(key_name), (amount))
+#define MEMFAULT_METRIC_HISTOGRAM_RECORD(key_name, value) \
+  memfault_metrics_histogram_record(_MEMFAULT_METRICS_HISTOGRAM_ID(key_name, heartbeat), (value))
 
 //! Alternate API for Session metrics
 #define MEMFAULT_METRIC_SESSION_SET_SIGNED(key_name, session_key, signed_value)                   \
@@ -246,6 +281,12 @@ int memfault_metrics_heartbeat_add(MemfaultMetricId key, int32_t amount);
   memfault_metrics_heartbeat_timer_stop(MEMFAULT_METRICS_KEY_WITH_SESSION(key_name, session_key))
 #define MEMFAULT_METRIC_SESSION_ADD(key_name, session_key, amount) \
   memfault_metrics_heartbeat_add(MEMFAULT_METRICS_KEY_WITH_SESSION(key_name, session_key), (amount))
+#define MEMFAULT_METRIC_SESSION_ADD_LOCKLESS(key_name, session_key, amount) \
+  memfault_metrics_heartbeat_add_lockless(                                 \
+    MEMFAULT_METRICS_KEY_WITH_SESSION(key_name, session_key), (amount))
+#define MEMFAULT_METRIC_SESSION_HISTOGRAM_RECORD(key_name, session_key, value) \
+  memfault_metrics_histogram_record(                                          \
+    _MEMFAULT_METRICS_HISTOGRAM_ID(key_name, session_key), (value))
 
 //! For debugging purposes: prints the current heartbeat values using
 //! MEMFAULT_LOG_DEBUG(). Before printing, any active timer values are computed.
@@ -44,6 +44,14 @@ typedef bool (*MemfaultMetricIteratorCallback)(void *ctx, const sMemfaultMetricI
 
 void memfault_metrics_heartbeat_iterate(MemfaultMetricIteratorCallback cb, void *ctx);
 
+//! Same as "memfault_metrics_heartbeat_iterate" but only invokes the callback for the metrics
+//! belonging to the given session
+//!
+//! @note Cost scales with the number of metrics in the session rather than the total number of
+//! metrics defined
+void memfault_metrics_session_iterate(eMfltMetricsSessionIndex session_key,
+                                      MemfaultMetricIteratorCallback cb, void *ctx);
+
 //! @return the number of metrics being required for a heartbeat
 size_t memfault_metrics_heartbeat_get_num_metrics(void);
 
@@ -82,6 +82,19 @@ void memfault_coredump_size_and_storage_capacity(size_t *total_size, size_t *cap
 //! @return true when a valid coredump is present in the storage.
 bool memfault_coredump_has_valid_coredump(size_t *total_size_out);
 
+//! Erases coredump storage ahead of time so saving the next coredump only requires writes
+//!
+//! Only available when MEMFAULT_COREDUMP_STORAGE_PRE_ERASE_ENABLED=1. Intended to be called from a
+//! background task once a coredump has been uploaded and memfault_platform_coredump_storage_clear()
+//! has been called, since erasing the entire storage region can take a while.
+//!
+//! @note If a fault occurs while the storage is being erased, the sectors which were not erased
+//! yet are erased by the fault handler as usual.
+//!
+//! @return true if the storage was erased, false if a valid coredump is still stored or an erase
+//! failed
+bool memfault_coredump_storage_pre_erase(void);
+
 //
 // Integration utilities
 //
@@ -70,6 +70,16 @@ const sMfltCoredumpRegion *memfault_coredump_get_arch_regions(size_t *num_region
 //!   regions to collect
 const sMfltCoredumpRegion *memfault_coredump_get_sdk_regions(size_t *num_regions);
 
+//! Look up the run length encoded size of the saved coredump which was cached at save time
+//!
+//! The header and the last RLE sequence of the coredump are read back to complete the size.
+//!
+//! @note Only available when MEMFAULT_COREDUMP_CACHE_RLE_SIZE=1
+//!
+//! @param rle_size_out On return, populated with the RLE size of the saved coredump
+//! @return true if a valid coredump with a cached RLE size is saved, false otherwise
+bool memfault_coredump_get_rle_size(size_t *rle_size_out);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,50 @@
+#pragma once
+
+//! @file
+//!
+//! Copyright (c) Memfault, Inc.
+//! See LICENSE for details
+//!
+//! @brief
+//! Helper for computing the high watermark of a painted thread stack, used by the RTOS ports when
+//! adding per-thread stack usage to a coredump.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! Compute how many bytes at the bottom of a full-descending stack still hold the paint pattern
+//! the RTOS filled the stack with when the thread was created, i.e. the part of the stack that
+//! has never been used.
+//!
+//! The stack is compared a word (and, while the stack stays unused, several words) at a time.
+//! Individual bytes are only compared at the unaligned edges of the stack and at the word where
+//! the watermark is found.
+//!
+//! @param stack_start The lowest address of the stack
+//! @param stack_size The size of the stack, in bytes
+//! @param paint_pattern The pattern the stack was painted with, as read from an aligned word of
+//!  the stack. For a pattern made of a single repeated byte, such as Zephyr's 0xAA, this is the
+//!  byte repeated 4 times (0xAAAAAAAA)
+//! @param cached_bytes_unused A value previously returned by this function for the same stack,
+//!  or 0 if there is none. Stack usage only grows, so when the cached watermark is still valid,
+//!  the scan starts from it and walks down through the newly used part of the stack instead of
+//!  scanning all the unused bytes from stack_start. A stale value (for example, the stack was
+//!  painted again for a new thread) is detected and a full scan is done instead.
+//!
+//! @note Starting from a cached watermark, the scan stops at the first 16 aligned bytes that
+//!  still hold the paint pattern. Used bytes below an unwritten local buffer at least that large
+//!  are only found by a full scan, so the cache should be refreshed with a full scan
+//!  (cached_bytes_unused of 0) from time to time, and the stack of a thread which crashed, whose
+//!  usage matters most when it overflowed, should always be scanned in full.
+//!
+//! @return The number of unused bytes, from 0 (the stack is exhausted) to stack_size
+size_t memfault_stack_watermark_bytes_unused(const void *stack_start, size_t stack_size,
+                                             uint32_t paint_pattern, size_t cached_bytes_unused);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,106 @@
+#pragma once
+
+//! @file
+//!
+//! Copyright (c) Memfault, Inc.
+//! See LICENSE for details
+//!
+//! @brief
+//! Registry used by the RTOS ports to track the TCBs of the tasks that exist, so their state can
+//! be collected in a coredump.
+//!
+//! The TCB pointers are kept in an array owned by the port, which is captured as-is in the
+//! coredump. By default, a task is added and removed by scanning the array. When
+//! MEMFAULT_TASK_REGISTRY_CONSTANT_TIME is enabled, the registry adds the bookkeeping needed to
+//! do it in constant time from the task create and delete hooks, which typically run with
+//! interrupts disabled: a stack of free slots in the array, and a TCB -> slot hash table.
+//!
+//! The registry does no locking. Calls for the same registry must be serialized by the caller.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "memfault/config.h"
+#include "memfault/core/compiler.h"
+#include "memfault/core/math.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct MfltTaskRegistry {
+  //! The array of TCB pointers, with a NULL entry for every free slot
+  void *tcbs;
+#if MEMFAULT_TASK_REGISTRY_CONSTANT_TIME
+  //! Slots that were freed, most recently freed last
+  uint16_t *free_slots;
+  //! Open-addressing (linear probing) table mapping TCB pointers to their slot. Entries hold the
+  //! slot + 1, so a zeroed table is empty.
+  uint16_t *index;
+#endif
+  uint16_t num_slots;
+#if MEMFAULT_TASK_REGISTRY_CONSTANT_TIME
+  uint16_t index_mask;
+  uint16_t num_free;
+  //! Slots are handed out in order until all have been used once, so [never_used, num_slots)
+  //! have never been used
+  uint16_t never_used;
+#endif
+} sMfltTaskRegistry;
+
+#if MEMFAULT_TASK_REGISTRY_CONSTANT_TIME
+  //! Number of entries in the hash table of a registry with num_slots slots. Kept at a load
+  //! factor of at most 0.5 so probe sequences stay short.
+  #define MEMFAULT_TASK_REGISTRY_INDEX_SIZE(num_slots) MEMFAULT_ROUND_UP_POW2(2 * (num_slots))
+
+  //! Define a registry named 'name' for the statically allocated array of TCB pointers
+  //! 'tcb_array'. The array must be zero-initialized, like the registry itself, so that no call
+  //! is needed before the first task is added.
+  #define MEMFAULT_TASK_REGISTRY_DEFINE(name, tcb_array)                               \
+    MEMFAULT_STATIC_ASSERT(MEMFAULT_ARRAY_SIZE(tcb_array) < UINT16_MAX,                \
+                           "Too many slots for a task registry");                      \
+    static uint16_t name##_free_slots[MEMFAULT_ARRAY_SIZE(tcb_array)];                 \
+    static uint16_t                                                                    \
+      name##_index[MEMFAULT_TASK_REGISTRY_INDEX_SIZE(MEMFAULT_ARRAY_SIZE(tcb_array))]; \
+    static sMfltTaskRegistry name = {                                                  \
+      .tcbs = tcb_array,                                                               \
+      .free_slots = name##_free_slots,                                                 \
+      .index = name##_index,                                                           \
+      .num_slots = MEMFAULT_ARRAY_SIZE(tcb_array),                                     \
+      .index_mask = MEMFAULT_ARRAY_SIZE(name##_index) - 1,                             \
+    }
+#else
+  //! Define a registry named 'name' for the statically allocated array of TCB pointers
+  //! 'tcb_array'. The array must be zero-initialized, so that no call is needed before the first
+  //! task is added.
+  #define MEMFAULT_TASK_REGISTRY_DEFINE(name, tcb_array)                \
+    MEMFAULT_STATIC_ASSERT(MEMFAULT_ARRAY_SIZE(tcb_array) < UINT16_MAX, \
+                           "Too many slots for a task registry");       \
+    static sMfltTaskRegistry name = {                                   \
+      .tcbs = tcb_array,                                                \
+      .num_slots = MEMFAULT_ARRAY_SIZE(tcb_array),                      \
+    }
+#endif
+
+//! Add a TCB to the registry
+//!
+//! @param registry The registry to add the TCB to
+//! @param tcb The TCB to add. Adding a TCB that is already in the registry is a no-op.
+//! @param[out] slot If not NULL, set to the index of the TCB in the array of TCB pointers
+//!
+//! @return false if the TCB is NULL or the registry is full, true otherwise
+bool memfault_task_registry_add(sMfltTaskRegistry *registry, void *tcb, size_t *slot);
+
+//! Remove a TCB from the registry
+//!
+//! @param registry The registry to remove the TCB from
+//! @param tcb The TCB to remove
+//! @param[out] slot If not NULL, set to the index the TCB was removed from
+//!
+//! @return false if the TCB was not in the registry, true otherwise
+bool memfault_task_registry_remove(sMfltTaskRegistry *registry, const void *tcb, size_t *slot);
+
+#ifdef __cplusplus
+}
+#endif
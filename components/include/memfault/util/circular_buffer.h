@@ -138,6 +138,37 @@ bool memfault_circular_buffer_write_at_offset(sMfltCircularBuffer *circular_buf,
                                               size_t offset_from_end, const void *data,
                                               size_t data_len);
 
+//! Claim space at the end of the circular buffer to be filled in later
+//!
+//! The reserved bytes are accounted for as written immediately, so later writes (and
+//! reservations) land after them. Use @ref memfault_circular_buffer_write_reserved() to populate
+//! the region.
+//!
+//! @param circular_buffer The buffer to reserve space in
+//! @param data_len The number of bytes to reserve
+//! @param storage_idx Populated with the position of the reserved region within the storage
+//!
+//! @return true if there was enough space and the region was reserved, false otherwise
+bool memfault_circular_buffer_reserve(sMfltCircularBuffer *circular_buf, size_t data_len,
+                                      size_t *storage_idx);
+
+//! Copy data into a region claimed with @ref memfault_circular_buffer_reserve()
+//!
+//! @note The circular buffer state is not modified so it is safe for the owner of a reserved
+//! region to call this without synchronizing against other users of the buffer, as long as the
+//! region has not yet been consumed.
+//!
+//! @param circular_buffer The buffer the region was reserved in
+//! @param storage_idx The position of the reserved region, as returned at reservation time
+//! @param offset Offset within the reserved region to begin the write at
+//! @param data The buffer to copy
+//! @param data_len Length of buffer to copy
+//!
+//! @return true if the data was copied, false on invalid input
+bool memfault_circular_buffer_write_reserved(sMfltCircularBuffer *circular_buf,
+                                             size_t storage_idx, size_t offset, const void *data,
+                                             size_t data_len);
+
 //! @return Amount of bytes available to read
 size_t memfault_circular_buffer_get_read_size(const sMfltCircularBuffer *circular_buf);
 
@@ -11,6 +11,7 @@
 //! More details:
 //!   http://reveng.sourceforge.net/crc-catalogue/16.htm#crc.cat.crc-16-xmodem
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -31,6 +32,23 @@ extern "C" {
 uint16_t memfault_crc16_compute(uint16_t crc_initial_value, const void *data,
                                 size_t data_len_bytes);
 
+//! Optional platform hook for computing CRC-16/XMODEM, i.e with a hardware CRC peripheral
+//!
+//! When MEMFAULT_CRC16_PLATFORM_HOOK_ENABLE is set, every call to memfault_crc16_compute() is
+//! first offered to this function. The hook must implement the same CRC as
+//! memfault_crc16_compute() (polynomial 0x1021, no input/output reflection, no final XOR).
+//!
+//! @param crc_initial_value The CRC value to continue the computation from
+//! @param data The data to compute the crc over
+//! @param data_len_bytes the length of the data to compute the crc over, in bytes
+//! @param[out] crc_out Populated with the resulting CRC when true is returned
+//!
+//! @return true if the CRC was computed, false to fall back to the built-in software
+//!  implementation (for example when the peripheral is busy or the data is too short to be
+//!  worth the setup cost)
+bool memfault_platform_crc16_compute(uint16_t crc_initial_value, const void *data,
+                                     size_t data_len_bytes, uint16_t *crc_out);
+
 #ifdef __cplusplus
 }
 #endif
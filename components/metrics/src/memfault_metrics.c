@@ -27,6 +27,13 @@
 #include "memfault/metrics/serializer.h"
 #include "memfault/metrics/utils.h"
 
+#if MEMFAULT_METRICS_LOCKLESS_COUNTERS_ENABLED
+  #if defined(__STDC_NO_ATOMICS__)
+    #error "MEMFAULT_METRICS_LOCKLESS_COUNTERS_ENABLED requires C11 atomics"
+  #endif
+  #include <stdatomic.h>
+#endif
+
 //! Disable this warning; it trips when there's no custom macros defined of a
 //! given type
 MEMFAULT_DISABLE_WARNING("-Wunused-macros")
@@ -379,6 +386,55 @@ static const MemfaultMetricId s_memfault_metrics_session_timer_keys[] = {
   { 0 }  // dummy entry to prevent empty array
 };
 
+// Generate the histogram table, mapping each histogram to its session and reported metrics
+#define MEMFAULT_METRICS_KEY_DEFINE(key_name, value_type)
+#define MEMFAULT_METRICS_STRING_KEY_DEFINE(key_name, max_length)
+#define MEMFAULT_METRICS_STRING_KEY_DEFINE_WITH_SESSION(key_name, max_length, session_key)
+#define MEMFAULT_METRICS_KEY_DEFINE_WITH_RANGE(key_name, value_type, min_value, max_value)
+#define MEMFAULT_METRICS_KEY_DEFINE_WITH_RANGE_AND_SESSION(key_name, value_type, min_value, \
+                                                           max_value, session_key)
+#define MEMFAULT_METRICS_KEY_DEFINE_WITH_SESSION(key_name, value_type, session_key)
+#define MEMFAULT_METRICS_SESSION_KEY_DEFINE(key_name)
+#define MEMFAULT_METRICS_KEY_DEFINE_WITH_SCALE_VALUE(key_name, value_type, scale_value)
+#define MEMFAULT_METRICS_KEY_DEFINE_WITH_SESSION_AND_SCALE_VALUE(key_name, value_type, \
+                                                                 session_key, scale_value)
+#undef MEMFAULT_METRICS_HISTOGRAM_DEFINE_
+#define MEMFAULT_METRICS_HISTOGRAM_DEFINE_(key_name, session_name)                  \
+  {                                                                                 \
+    .p50_key = _MEMFAULT_METRICS_ID_CREATE(key_name##_p50, session_name),           \
+    .p90_key = _MEMFAULT_METRICS_ID_CREATE(key_name##_p90, session_name),           \
+    .p99_key = _MEMFAULT_METRICS_ID_CREATE(key_name##_p99, session_name),           \
+    .max_key = _MEMFAULT_METRICS_ID_CREATE(key_name##_max, session_name),           \
+    .overflow_key = _MEMFAULT_METRICS_ID_CREATE(key_name##_overflow, session_name), \
+    .session_key = MEMFAULT_METRICS_SESSION_KEY(session_name),                      \
+  },
+
+typedef struct MemfaultMetricsHistogramInfo {
+  MemfaultMetricId p50_key;
+  MemfaultMetricId p90_key;
+  MemfaultMetricId p99_key;
+  MemfaultMetricId max_key;
+  MemfaultMetricId overflow_key;
+  eMfltMetricsSessionIndex session_key;
+} sMemfaultMetricsHistogramInfo;
+
+static const sMemfaultMetricsHistogramInfo s_memfault_metrics_histograms[] = {
+#include "memfault/metrics/heartbeat_config.def"
+#include MEMFAULT_METRICS_USER_HEARTBEAT_DEFS_FILE
+#undef MEMFAULT_METRICS_KEY_DEFINE
+#undef MEMFAULT_METRICS_KEY_DEFINE_WITH_RANGE
+#undef MEMFAULT_METRICS_STRING_KEY_DEFINE
+#undef MEMFAULT_METRICS_STRING_KEY_DEFINE_WITH_SESSION
+#undef MEMFAULT_METRICS_SESSION_KEY_DEFINE
+#undef MEMFAULT_METRICS_KEY_DEFINE_WITH_SESSION
+#undef MEMFAULT_METRICS_KEY_DEFINE_WITH_RANGE_AND_SESSION
+#undef MEMFAULT_METRICS_KEY_DEFINE_WITH_SCALE_VALUE
+#undef MEMFAULT_METRICS_KEY_DEFINE_WITH_SESSION_AND_SCALE_VALUE
+#undef MEMFAULT_METRICS_HISTOGRAM_DEFINE_
+  { 0 }  // dummy entry to prevent empty array
+};
+#define MEMFAULT_METRICS_HISTOGRAM_DEFINE_(key_name, session_name)
+
 #if MEMFAULT_METRICS_SESSIONS_ENABLED
   // Generate session key to operational_crashes metric key mapping
   #define MEMFAULT_METRICS_KEY_DEFINE(key_name, value_type)
@@ -660,6 +716,43 @@ static const int s_metric_timer_metadata_mapping[] = {
 #define MEMFAULT_METRICS_ID_TO_KV_INDEX(id) \
   (MEMFAULT_METRICS_KEY_TO_KV_INDEX(MEMFAULT_METRICS_ID_TO_KEY(id)))
 
+// Per-session key tables, so iterating, counting and serializing the metrics of one session only
+// touches that session's keys. s_memfault_session_key_indices holds the indices into
+// s_memfault_heartbeat_keys grouped by session (preserving definition order within a session).
+// Session N owns the entries from s_memfault_session_key_offsets[N] up to (but not including)
+// s_memfault_session_key_offsets[N + 1].
+//
+// The tables are derived from s_memfault_heartbeat_keys once, on first use.
+MEMFAULT_STATIC_ASSERT(MEMFAULT_ARRAY_SIZE(s_memfault_heartbeat_keys) <= UINT16_MAX,
+                       "Too many metrics defined for 16-bit session key tables");
+static uint16_t s_memfault_session_key_indices[MEMFAULT_ARRAY_SIZE(s_memfault_heartbeat_keys)];
+static uint16_t s_memfault_session_key_offsets[kMfltMetricsSessionKey_COUNT + 1];
+static bool s_memfault_session_key_tables_initialized;
+
+static void prv_session_key_tables_init(void) {
+  if (s_memfault_session_key_tables_initialized) {
+    return;
+  }
+
+  uint16_t *offsets = s_memfault_session_key_offsets;
+  memset(offsets, 0, sizeof(s_memfault_session_key_offsets));
+  for (size_t idx = 0; idx < MEMFAULT_ARRAY_SIZE(s_memfault_heartbeat_keys); idx++) {
+    offsets[s_memfault_heartbeat_keys[idx].session_key + 1]++;
+  }
+  for (size_t session = 0; session < kMfltMetricsSessionKey_COUNT; session++) {
+    offsets[session + 1] += offsets[session];
+  }
+
+  uint16_t next_slot[kMfltMetricsSessionKey_COUNT];
+  memcpy(next_slot, offsets, sizeof(next_slot));
+  for (size_t idx = 0; idx < MEMFAULT_ARRAY_SIZE(s_memfault_heartbeat_keys); idx++) {
+    const eMfltMetricsSessionIndex session = s_memfault_heartbeat_keys[idx].session_key;
+    s_memfault_session_key_indices[next_slot[session]++] = (uint16_t)idx;
+  }
+
+  s_memfault_session_key_tables_initialized = true;
+}
+
 //
 // Routines which can be overridden by customers
 //
@@ -815,16 +908,36 @@ static eMemfaultMetricType prv_find_value_for_key(MemfaultMetricId id,
 
 typedef bool (*MemfaultMetricKvIteratorCb)(void *ctx, const sMemfaultMetricKVPair *kv_pair,
                                            const sMemfaultMetricValueInfo *value_info);
+
+//! @return true if iteration should continue, false otherwise
+static bool prv_metric_iterate_key(size_t idx, void *ctx, MemfaultMetricKvIteratorCb cb) {
+  const sMemfaultMetricKVPair *const kv_pair = &s_memfault_heartbeat_keys[idx];
+  sMemfaultMetricValueInfo value_info = { 0 };
+
+  (void)prv_find_value_for_key(kv_pair->key, &value_info);
+
+  return cb(ctx, kv_pair, &value_info);
+}
+
 static void prv_metric_iterator(void *ctx, MemfaultMetricKvIteratorCb cb) {
   for (uint32_t idx = 0; idx < MEMFAULT_ARRAY_SIZE(s_memfault_heartbeat_keys); ++idx) {
-    const sMemfaultMetricKVPair *const kv_pair = &s_memfault_heartbeat_keys[idx];
-    sMemfaultMetricValueInfo value_info = { 0 };
-
-    (void)prv_find_value_for_key(kv_pair->key, &value_info);
+    if (!prv_metric_iterate_key(idx, ctx, cb)) {
+      break;
+    }
+  }
+}
 
-    bool do_continue = cb(ctx, kv_pair, &value_info);
+//! Same as prv_metric_iterator() but only visits the keys belonging to session_key
+static void prv_metric_session_iterator(eMfltMetricsSessionIndex session_key, void *ctx,
+                                        MemfaultMetricKvIteratorCb cb) {
+  if ((size_t)session_key >= kMfltMetricsSessionKey_COUNT) {
+    return;
+  }
 
-    if (!do_continue) {
+  prv_session_key_tables_init();
+  const uint16_t end = s_memfault_session_key_offsets[session_key + 1];
+  for (uint16_t i = s_memfault_session_key_offsets[session_key]; i < end; ++i) {
+    if (!prv_metric_iterate_key(s_memfault_session_key_indices[i], ctx, cb)) {
       break;
     }
   }
@@ -1011,6 +1124,164 @@ static bool prv_tally_and_update_timer_cb(MEMFAULT_UNUSED void *ctx,
   return true;
 }
 
+//
+// Histograms
+//
+// Recorded values are counted in log-linear buckets: values below
+// MEMFAULT_METRICS_HISTOGRAM_SUB_BUCKETS get a bucket each, and each larger power of 2 range is
+// split into MEMFAULT_METRICS_HISTOGRAM_SUB_BUCKETS equally sized buckets. Values of
+// 2^MEMFAULT_METRICS_HISTOGRAM_MAX_BITS or more are counted in an extra overflow bucket.
+// Recording a value is a single counter increment, and the percentiles are computed by walking the
+// buckets once when the histogram is collected.
+
+#define MEMFAULT_METRICS_HISTOGRAM_SUB_BUCKETS (1u << MEMFAULT_METRICS_HISTOGRAM_SUB_BUCKET_BITS)
+#define MEMFAULT_METRICS_HISTOGRAM_NUM_BUCKETS                                     \
+  ((MEMFAULT_METRICS_HISTOGRAM_MAX_BITS - MEMFAULT_METRICS_HISTOGRAM_SUB_BUCKET_BITS + 1) * \
+   MEMFAULT_METRICS_HISTOGRAM_SUB_BUCKETS)
+#define MEMFAULT_METRICS_HISTOGRAM_OVERFLOW_BUCKET MEMFAULT_METRICS_HISTOGRAM_NUM_BUCKETS
+#define MEMFAULT_METRICS_HISTOGRAM_NUM_COUNTS (MEMFAULT_METRICS_HISTOGRAM_NUM_BUCKETS + 1)
+
+MEMFAULT_STATIC_ASSERT((MEMFAULT_METRICS_HISTOGRAM_SUB_BUCKET_BITS <
+                        MEMFAULT_METRICS_HISTOGRAM_MAX_BITS) &&
+                         (MEMFAULT_METRICS_HISTOGRAM_MAX_BITS <= 32),
+                       "MEMFAULT_METRICS_HISTOGRAM_SUB_BUCKET_BITS must be less than "
+                       "MEMFAULT_METRICS_HISTOGRAM_MAX_BITS, which must be at most 32");
+
+//! @return true if the index is a histogram, and not the dummy entry at the end of
+//! s_memfault_metrics_histograms
+static bool prv_is_histogram(size_t histogram) {
+  return (histogram + 1) < MEMFAULT_ARRAY_SIZE(s_memfault_metrics_histograms);
+}
+
+//! Bucket counts for all histograms. Kept outside of s_memfault_metrics_ctx, so they are not
+//! saved/restored with MEMFAULT_METRICS_RESTORE_STATE.
+static uint32_t s_memfault_metrics_histogram_counts[kMfltMetricsHistogramIndex_COUNT *
+                                                      MEMFAULT_METRICS_HISTOGRAM_NUM_COUNTS +
+                                                    1];  // dummy entry to prevent empty array
+
+static uint32_t *prv_histogram_get_counts(size_t histogram) {
+  return &s_memfault_metrics_histogram_counts[histogram * MEMFAULT_METRICS_HISTOGRAM_NUM_COUNTS];
+}
+
+static size_t prv_histogram_bucket_for_value(uint32_t value) {
+  if (value < MEMFAULT_METRICS_HISTOGRAM_SUB_BUCKETS) {
+    return value;
+  }
+
+  const uint32_t msb = 31 - MEMFAULT_CLZ(value);
+  if (msb >= MEMFAULT_METRICS_HISTOGRAM_MAX_BITS) {
+    return MEMFAULT_METRICS_HISTOGRAM_OVERFLOW_BUCKET;
+  }
+  const uint32_t shift = msb - MEMFAULT_METRICS_HISTOGRAM_SUB_BUCKET_BITS;
+  return ((size_t)(shift + 1) << MEMFAULT_METRICS_HISTOGRAM_SUB_BUCKET_BITS) +
+         ((value >> shift) & (MEMFAULT_METRICS_HISTOGRAM_SUB_BUCKETS - 1));
+}
+
+//! @return the largest value counted in the bucket
+static uint32_t prv_histogram_bucket_max_value(size_t bucket) {
+  if (bucket < MEMFAULT_METRICS_HISTOGRAM_SUB_BUCKETS) {
+    return (uint32_t)bucket;
+  }
+  if (bucket == MEMFAULT_METRICS_HISTOGRAM_OVERFLOW_BUCKET) {
+    return UINT32_MAX;
+  }
+
+  const uint32_t shift = (uint32_t)(bucket >> MEMFAULT_METRICS_HISTOGRAM_SUB_BUCKET_BITS) - 1;
+  const uint64_t sub_bucket = bucket & (MEMFAULT_METRICS_HISTOGRAM_SUB_BUCKETS - 1);
+  const uint64_t min_value = (MEMFAULT_METRICS_HISTOGRAM_SUB_BUCKETS + sub_bucket) << shift;
+  return (uint32_t)(min_value + (1ull << shift) - 1);
+}
+
+int memfault_metrics_histogram_record(eMfltMetricsHistogramIndex histogram, uint32_t value) {
+  if (!prv_is_histogram((size_t)histogram)) {
+    return MEMFAULT_METRICS_KEY_NOT_FOUND;
+  }
+  const MemfaultMetricId max_key = s_memfault_metrics_histograms[histogram].max_key;
+
+  int rv;
+  memfault_lock();
+  {
+    uint32_t *count = &prv_histogram_get_counts(histogram)[prv_histogram_bucket_for_value(value)];
+    if (*count != UINT32_MAX) {
+      (*count)++;
+    }
+
+    sMemfaultMetricValueInfo value_info = { 0 };
+    rv = prv_find_value_info_for_type(max_key, kMemfaultMetricType_Unsigned, &value_info);
+    if ((rv == 0) && (!value_info.is_set || (value > value_info.valuep->u32))) {
+      prv_set_value_for_key(max_key, &(union MemfaultMetricValue){ .u32 = value }, &value_info);
+    }
+  }
+  memfault_unlock();
+  return rv;
+}
+
+//! Computes the percentiles of the histograms in the session and stores them to their metrics.
+//! Must be called with memfault_lock() held.
+static void prv_histograms_collect(eMfltMetricsSessionIndex session_key) {
+  for (size_t i = 0; prv_is_histogram(i); i++) {
+    const sMemfaultMetricsHistogramInfo *info = &s_memfault_metrics_histograms[i];
+    if (info->session_key != session_key) {
+      continue;
+    }
+
+    const uint32_t *counts = prv_histogram_get_counts(i);
+    uint64_t total = 0;
+    for (size_t bucket = 0; bucket < MEMFAULT_METRICS_HISTOGRAM_NUM_COUNTS; bucket++) {
+      total += counts[bucket];
+    }
+    sMemfaultMetricValueInfo max_info = { 0 };
+    if ((total == 0) ||
+        (prv_find_value_info_for_type(info->max_key, kMemfaultMetricType_Unsigned, &max_info) !=
+         0)) {
+      continue;
+    }
+
+    prv_find_and_set_value_for_key(
+      info->overflow_key, kMemfaultMetricType_Unsigned,
+      &(union MemfaultMetricValue){ .u32 = counts[MEMFAULT_METRICS_HISTOGRAM_OVERFLOW_BUCKET] });
+
+    const struct {
+      MemfaultMetricId key;
+      uint32_t percent;
+    } percentiles[] = {
+      { info->p50_key, 50 },
+      { info->p90_key, 90 },
+      { info->p99_key, 99 },
+    };
+
+    // the percentile is in the first bucket where the running count reaches percent% of the total.
+    // It's reported as the upper bound of the bucket, limited to the max, which is also the only
+    // bound known for the overflow bucket.
+    const size_t num_percentiles = MEMFAULT_ARRAY_SIZE(percentiles);
+    size_t p = 0;
+    uint64_t running_count = 0;
+    for (size_t bucket = 0; bucket < MEMFAULT_METRICS_HISTOGRAM_NUM_COUNTS; bucket++) {
+      running_count += counts[bucket];
+      while ((p < num_percentiles) &&
+             (running_count * 100 >= total * percentiles[p].percent)) {
+        const uint32_t value =
+          MEMFAULT_MIN(prv_histogram_bucket_max_value(bucket), max_info.valuep->u32);
+        prv_find_and_set_value_for_key(percentiles[p].key, kMemfaultMetricType_Unsigned,
+                                       &(union MemfaultMetricValue){ .u32 = value });
+        p++;
+      }
+      if (p == num_percentiles) {
+        break;
+      }
+    }
+  }
+}
+
+static void prv_histograms_reset(bool full_reset, eMfltMetricsSessionIndex session_key) {
+  for (size_t i = 0; prv_is_histogram(i); i++) {
+    if (full_reset || (s_memfault_metrics_histograms[i].session_key == session_key)) {
+      memset(prv_histogram_get_counts(i), 0,
+             MEMFAULT_METRICS_HISTOGRAM_NUM_COUNTS * sizeof(uint32_t));
+    }
+  }
+}
+
 static void prv_reset_metrics(bool full_reset, eMfltMetricsSessionIndex session_key) {
   if (full_reset) {
     // if a full reset is indicated zero out all metrics regardless of session.
@@ -1029,14 +1300,13 @@ static void prv_reset_metrics(bool full_reset, eMfltMetricsSessionIndex session_
         ((char *)s_memfault_heartbeat_string_values[i].ptr)[0] = 0;
       }
     }
-  } else {
+  } else if ((size_t)session_key < kMfltMetricsSessionKey_COUNT) {
     // otherwise only clear metrics from the specified session
-    for (uint32_t idx = 0; idx < MEMFAULT_ARRAY_SIZE(s_memfault_heartbeat_keys); ++idx) {
+    prv_session_key_tables_init();
+    const uint16_t end = s_memfault_session_key_offsets[session_key + 1];
+    for (uint16_t i = s_memfault_session_key_offsets[session_key]; i < end; ++i) {
+      const size_t idx = s_memfault_session_key_indices[i];
       const sMemfaultMetricKVPair *const kv_pair = &s_memfault_heartbeat_keys[idx];
-      // Skip all metrics from a different session
-      if (kv_pair->session_key != session_key) {
-        continue;
-      }
 
       eMfltMetricStringKeyToIndex string_idx = s_memfault_heartbeat_string_key_to_index[idx];
       eMfltMetricKeyToValueIndex key_index = MEMFAULT_METRICS_KEY_TO_KV_INDEX(idx);
@@ -1060,6 +1330,8 @@ static void prv_reset_metrics(bool full_reset, eMfltMetricsSessionIndex session_
       }
     }
   }
+
+  prv_histograms_reset(full_reset, session_key);
 }
 
 static void prv_heartbeat_timer_update(void) {
@@ -1067,11 +1339,24 @@ static void prv_heartbeat_timer_update(void) {
   prv_metric_iterator(NULL, prv_tally_and_update_timer_cb);
 }
 
+#if MEMFAULT_METRICS_LOCKLESS_COUNTERS_ENABLED
+static void prv_fold_lockless_counters(void);
+#endif
+
 //! Triggers a heartbeat update only, no timer update
 static void prv_heartbeat_update(void) {
+#if MEMFAULT_METRICS_LOCKLESS_COUNTERS_ENABLED
+  memfault_lock();
+  { prv_fold_lockless_counters(); }
+  memfault_unlock();
+#endif
   memfault_metrics_heartbeat_collect_sdk_data();
   prv_collect_builtin_data();
   memfault_metrics_heartbeat_collect_data();
+
+  memfault_lock();
+  { prv_histograms_collect(MEMFAULT_METRICS_SESSION_KEY(heartbeat)); }
+  memfault_unlock();
 }
 
 //! Trigger an update of heartbeat timers + metrics, serialize out to storage, and reset.
@@ -1142,6 +1427,82 @@ int memfault_metrics_heartbeat_add(MemfaultMetricId key, int32_t amount) {
   return rv;
 }
 
+#if MEMFAULT_METRICS_LOCKLESS_COUNTERS_ENABLED
+//! Amounts added by memfault_metrics_heartbeat_add_lockless() since the last fold, and whether
+//! anything was added, indexed the same as heartbeat_values. Kept outside of
+//! s_memfault_metrics_ctx so they don't change the layout of the saved/restored metrics state.
+static atomic_int_least32_t
+  s_lockless_counter_amounts[MEMFAULT_ARRAY_SIZE(((sMemfaultMetricValues *)0)->values)];
+static atomic_bool
+  s_lockless_counter_pending[MEMFAULT_ARRAY_SIZE(((sMemfaultMetricValues *)0)->values)];
+
+int memfault_metrics_heartbeat_add_lockless(MemfaultMetricId key, int32_t amount) {
+  const size_t idx = MEMFAULT_METRICS_ID_TO_KEY(key);
+  if (idx >= MEMFAULT_ARRAY_SIZE(s_memfault_heartbeat_keys)) {
+    return MEMFAULT_METRICS_KEY_NOT_FOUND;
+  }
+  const eMemfaultMetricType type = s_memfault_heartbeat_keys[idx].type;
+  if ((type != kMemfaultMetricType_Signed) && (type != kMemfaultMetricType_Unsigned)) {
+    // To easily get name of metric in gdb, p/s (eMfltMetricsIndex)0
+    MEMFAULT_LOG_ERROR("Can only add to number types (key: %d)", key._impl);
+    return MEMFAULT_METRICS_TYPE_INCOMPATIBLE;
+  }
+
+  const eMfltMetricKeyToValueIndex value_index = MEMFAULT_METRICS_KEY_TO_KV_INDEX(idx);
+  atomic_fetch_add_explicit(&s_lockless_counter_amounts[value_index], amount,
+                            memory_order_relaxed);
+  // Only write the flag when it changes, so repeated adds from different cores don't keep
+  // writing to it
+  if (!atomic_load_explicit(&s_lockless_counter_pending[value_index], memory_order_relaxed)) {
+    atomic_store_explicit(&s_lockless_counter_pending[value_index], true, memory_order_relaxed);
+  }
+  return 0;
+}
+
+//! Moves the pending lockless amounts into heartbeat_values. Must be called with memfault_lock()
+//! held. An add racing with the fold lands either in this fold or the next one.
+static void prv_fold_lockless_counters(void) {
+  for (size_t idx = 0; idx < MEMFAULT_ARRAY_SIZE(s_memfault_heartbeat_keys); idx++) {
+    const sMemfaultMetricKVPair *const kv_pair = &s_memfault_heartbeat_keys[idx];
+    if ((kv_pair->type != kMemfaultMetricType_Signed) &&
+        (kv_pair->type != kMemfaultMetricType_Unsigned)) {
+      continue;
+    }
+
+    const eMfltMetricKeyToValueIndex value_index = MEMFAULT_METRICS_KEY_TO_KV_INDEX(idx);
+    const bool pending = atomic_exchange_explicit(&s_lockless_counter_pending[value_index], false,
+                                                  memory_order_relaxed);
+    const int32_t amount = atomic_exchange_explicit(&s_lockless_counter_amounts[value_index], 0,
+                                                    memory_order_relaxed);
+    if (!pending && (amount == 0)) {
+      continue;
+    }
+
+    if (prv_find_key_and_add(kv_pair->key, amount) == 0) {
+      prv_read_write_is_value_set(kv_pair->key, true);
+    }
+  }
+}
+
+//! Discards the pending lockless amounts of all metrics, or only those of the given session
+static void prv_reset_lockless_counters(bool full_reset, eMfltMetricsSessionIndex session_key) {
+  for (size_t idx = 0; idx < MEMFAULT_ARRAY_SIZE(s_memfault_heartbeat_keys); idx++) {
+    const sMemfaultMetricKVPair *const kv_pair = &s_memfault_heartbeat_keys[idx];
+    if ((kv_pair->type != kMemfaultMetricType_Signed) &&
+        (kv_pair->type != kMemfaultMetricType_Unsigned)) {
+      continue;
+    }
+    if (!full_reset && (kv_pair->session_key != session_key)) {
+      continue;
+    }
+
+    const eMfltMetricKeyToValueIndex value_index = MEMFAULT_METRICS_KEY_TO_KV_INDEX(idx);
+    atomic_store_explicit(&s_lockless_counter_amounts[value_index], 0, memory_order_relaxed);
+    atomic_store_explicit(&s_lockless_counter_pending[value_index], false, memory_order_relaxed);
+  }
+}
+#endif  // MEMFAULT_METRICS_LOCKLESS_COUNTERS_ENABLED
+
 static int prv_find_key_of_type(MemfaultMetricId key, eMemfaultMetricType expected_type,
                                 union MemfaultMetricValue **value_out) {
   sMemfaultMetricValueInfo value_info = { 0 };
@@ -1251,6 +1612,9 @@ static int prv_metrics_session_start(eMfltMetricsSessionIndex session_key, bool
     // Reset all metrics for the session. Any changes that happened before the
     // session was started don't matter and can be discarded.
     prv_reset_metrics(false, session_key);
+#if MEMFAULT_METRICS_LOCKLESS_COUNTERS_ENABLED
+    prv_reset_lockless_counters(false, session_key);
+#endif
 
     if (start_timer) {
       MemfaultMetricId key = s_memfault_metrics_session_timer_keys[session_key];
@@ -1284,11 +1648,16 @@ static int prv_metrics_session_end(eMfltMetricsSessionIndex session_key, bool st
   int rv = 0;
   memfault_lock();
   {
+#if MEMFAULT_METRICS_LOCKLESS_COUNTERS_ENABLED
+    prv_fold_lockless_counters();
+#endif
     if (stop_timer) {
       MemfaultMetricId key = s_memfault_metrics_session_timer_keys[session_key];
       rv = prv_find_timer_metric_and_update(key, kMemfaultTimerOp_Stop);
     }
 
+    prv_histograms_collect(session_key);
+
     if (rv == 0) {
       bool serialize_result =
         memfault_metrics_session_serialize(s_memfault_metrics_ctx.storage_impl, session_key);
@@ -1370,27 +1739,34 @@ void memfault_metrics_heartbeat_iterate(MemfaultMetricIteratorCallback cb, void
   memfault_unlock();
 }
 
-typedef struct {
-  size_t num_metrics;
-  eMfltMetricsSessionIndex session_key;
-} sGetNumMetricsCtx;
-
-static bool prv_get_num_metrics_iter_cb(void *ctx, const sMemfaultMetricInfo *metric_info) {
-  sGetNumMetricsCtx *num_metrics_ctx = (sGetNumMetricsCtx *)ctx;
-
-  if (metric_info->session_key == num_metrics_ctx->session_key) {
-    num_metrics_ctx->num_metrics++;
+void memfault_metrics_session_iterate(eMfltMetricsSessionIndex session_key,
+                                      MemfaultMetricIteratorCallback cb, void *ctx) {
+  memfault_lock();
+  {
+    sMetricHeartbeatIterateCtx user_ctx = {
+      .user_cb = cb,
+      .user_ctx = ctx,
+    };
+    prv_metric_session_iterator(session_key, &user_ctx, prv_metrics_heartbeat_iterate_cb);
   }
-
-  return true;
+  memfault_unlock();
 }
 
 static size_t prv_get_num_metrics(eMfltMetricsSessionIndex session_key) {
-  sGetNumMetricsCtx ctx = { .session_key = session_key };
+  if ((size_t)session_key >= kMfltMetricsSessionKey_COUNT) {
+    return 0;
+  }
 
-  memfault_metrics_heartbeat_iterate(prv_get_num_metrics_iter_cb, (void *)&ctx);
+  size_t num_metrics;
+  memfault_lock();
+  {
+    prv_session_key_tables_init();
+    num_metrics = (size_t)(s_memfault_session_key_offsets[session_key + 1] -
+                           s_memfault_session_key_offsets[session_key]);
+  }
+  memfault_unlock();
 
-  return ctx.num_metrics;
+  return num_metrics;
 }
 
 size_t memfault_metrics_heartbeat_get_num_metrics(void) {
@@ -1482,7 +1858,7 @@ void memfault_metrics_session_debug_print(eMfltMetricsSessionIndex session_key)
     .session_key = session_key,
     .print_filter = &prv_session_debug_print_filter,
   };
-  memfault_metrics_heartbeat_iterate(prv_metrics_debug_print, (void *)&ctx);
+  memfault_metrics_session_iterate(session_key, prv_metrics_debug_print, (void *)&ctx);
 }
 
 void memfault_metrics_all_sessions_debug_print(void) {
@@ -1589,6 +1965,9 @@ int memfault_metrics_boot(const sMemfaultEventStorageImpl *storage_impl,
     // Reset reliability state
     memfault_metrics_reliability_boot(NULL);
     prv_reset_metrics(true, MEMFAULT_METRICS_SESSION_KEY(heartbeat));
+#if MEMFAULT_METRICS_LOCKLESS_COUNTERS_ENABLED
+    prv_reset_lockless_counters(true, MEMFAULT_METRICS_SESSION_KEY(heartbeat));
+#endif
 
     int rv = MEMFAULT_METRIC_TIMER_START(MemfaultSdkMetric_IntervalMs);
     if (rv != 0) {
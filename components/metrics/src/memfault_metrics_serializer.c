@@ -58,12 +58,6 @@ static bool prv_metric_heartbeat_writer(void *ctx, const sMemfaultMetricInfo *me
   sMemfaultSerializerState *state = (sMemfaultSerializerState *)ctx;
   sMemfaultCborEncoder *encoder = &state->encoder;
 
-  // only encode metrics for the session we are interested in
-  if (metric_info->session_key != state->session) {
-    state->encode_success = true;
-    return state->encode_success;
-  }
-
   // encode the value
   switch (metric_info->type) {
     case kMemfaultMetricType_Timer: {
@@ -94,7 +88,8 @@ static bool prv_serialize_latest_heartbeat_and_deinit(sMemfaultSerializerState *
   bool success = false;
 
   sMemfaultCborEncoder *encoder = &state->encoder;
-  if (!memfault_serializer_helper_encode_metadata(encoder, kMemfaultEventType_Heartbeat)) {
+  if (!memfault_serializer_helper_encode_stored_event_metadata(encoder,
+                                                               kMemfaultEventType_Heartbeat)) {
     goto cleanup;
   }
 
@@ -109,7 +104,8 @@ static bool prv_serialize_latest_heartbeat_and_deinit(sMemfaultSerializerState *
     goto cleanup;
   }
 
-  memfault_metrics_heartbeat_iterate(prv_metric_heartbeat_writer, state);
+  state->encode_success = true;
+  memfault_metrics_session_iterate(state->session, prv_metric_heartbeat_writer, state);
   success = state->encode_success;
 
 cleanup:
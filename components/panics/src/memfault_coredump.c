@@ -10,6 +10,7 @@
 //! Memfault coredump format
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <string.h>
 
 #include "memfault/core/build_info.h"
@@ -20,6 +21,18 @@
 #include "memfault/panics/coredump.h"
 #include "memfault/panics/coredump_impl.h"
 #include "memfault/panics/platform/coredump.h"
+#include "memfault/util/rle.h"
+
+#define MEMFAULT_COREDUMP_RLE_SIZE_CACHE_ENABLED \
+  (MEMFAULT_COREDUMP_CACHE_RLE_SIZE && MEMFAULT_DATA_SOURCE_RLE_ENABLED)
+
+//! The number of bytes after the coredump header run length encoded with and without the header
+//! in front of them before giving up on the two encodings lining up
+#define MEMFAULT_COREDUMP_RLE_HEADER_LOOKAHEAD_LEN 32
+
+#if MEMFAULT_COREDUMP_STORAGE_PRE_ERASE_ENABLED && !MEMFAULT_COREDUMP_STORAGE_INCREMENTAL_ERASE
+  #error "MEMFAULT_COREDUMP_STORAGE_PRE_ERASE_ENABLED=1 requires incremental erase to be enabled"
+#endif
 
 #define MEMFAULT_COREDUMP_MAGIC 0x45524f43
 
@@ -47,8 +60,12 @@ typedef enum MfltCoredumpFooterFlags {
 typedef MEMFAULT_PACKED_STRUCT MfltCoredumpFooter {
   uint32_t magic;
   uint32_t flags;
-  // reserving for future footer additions such as a CRC over the contents saved
-  uint32_t rsvd[2];
+  // The run length encoded size of the coredump from the end of the header up to rle_tail_offset.
+  // See MEMFAULT_COREDUMP_CACHE_RLE_SIZE
+  uint32_t rle_size;
+  // The offset the last RLE sequence found while saving starts at or 0 if the RLE size was not
+  // computed at save time
+  uint32_t rle_tail_offset;
 }
 sMfltCoredumpFooter;
 
@@ -124,6 +141,18 @@ typedef struct {
   bool truncated;
   // set to true if a call to "memfault_platform_coredump_storage_write" failed
   bool write_error;
+#if MEMFAULT_COREDUMP_STORAGE_INCREMENTAL_ERASE
+  // storage up to this offset has been erased
+  uint32_t erased_offset;
+  // the size of the entire storage region and of the sectors it is erased in
+  uint32_t erase_region_size;
+  uint32_t sector_size;
+#endif
+#if MEMFAULT_COREDUMP_RLE_SIZE_CACHE_ENABLED
+  // set to true while data written is also being run length encoded into rle_ctx
+  bool rle_active;
+  sMemfaultRleCtx rle_ctx;
+#endif
 } sMfltCoredumpWriteCtx;
 
 // Checks to see if the block is a cached region and applies
@@ -156,8 +185,74 @@ static bool prv_fixup_if_cached_block(sMfltCoredumpRegion *region, uint32_t *cac
   return true;
 }
 
+#if MEMFAULT_COREDUMP_RLE_SIZE_CACHE_ENABLED
+static void prv_rle_encode_all(sMemfaultRleCtx *rle_ctx, const void *data, size_t len) {
+  const uint8_t *buf = (const uint8_t *)data;
+  size_t bytes_encoded = 0;
+  while (bytes_encoded != len) {
+    bytes_encoded += memfault_rle_encode(rle_ctx, &buf[bytes_encoded], len - bytes_encoded);
+  }
+}
+#endif
+
+//! Callback that will be called to write coredump data.
+typedef bool (*MfltCoredumpReadCb)(uint32_t offset, void *data, size_t read_len);
+
+#if MEMFAULT_COREDUMP_STORAGE_PRE_ERASE_ENABLED
+static bool prv_storage_is_erased(MfltCoredumpReadCb coredump_read_cb, uint32_t offset,
+                                  size_t len) {
+  uint32_t buf[8];
+  for (size_t i = 0; i < len; i += sizeof(buf)) {
+    const size_t read_len = MEMFAULT_MIN(sizeof(buf), len - i);
+    if (!coredump_read_cb(offset + (uint32_t)i, buf, read_len)) {
+      return false;
+    }
+    const uint8_t *bytes = (const uint8_t *)buf;
+    for (size_t j = 0; j < read_len; j++) {
+      if (bytes[j] != MEMFAULT_COREDUMP_STORAGE_ERASED_BYTE) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+#endif
+
+#if MEMFAULT_COREDUMP_STORAGE_INCREMENTAL_ERASE
+//! Erases the sectors backing the next len bytes to be written which have not been erased yet
+static bool prv_erase_ahead(size_t len, sMfltCoredumpWriteCtx *write_ctx) {
+  const uint32_t end_offset = write_ctx->offset + len;
+  while (write_ctx->erased_offset < end_offset) {
+    const uint32_t offset = write_ctx->erased_offset;
+    const size_t erase_size =
+      MEMFAULT_MIN(write_ctx->sector_size, write_ctx->erase_region_size - offset);
+    if (erase_size == 0) {
+      // past the end of storage, let the write itself fail
+      return true;
+    }
+  #if MEMFAULT_COREDUMP_STORAGE_PRE_ERASE_ENABLED
+    if (!prv_storage_is_erased(memfault_platform_coredump_storage_read, offset, erase_size))
+  #endif
+    {
+      if (!memfault_platform_coredump_storage_erase(offset, erase_size)) {
+        return false;
+      }
+    }
+    write_ctx->erased_offset += erase_size;
+  }
+  return true;
+}
+#endif
+
 static bool prv_platform_coredump_write(const void *data, size_t len,
                                         sMfltCoredumpWriteCtx *write_ctx) {
+#if MEMFAULT_COREDUMP_STORAGE_INCREMENTAL_ERASE
+  if (!write_ctx->compute_size_only && !prv_erase_ahead(len, write_ctx)) {
+    write_ctx->write_error = true;
+    return false;
+  }
+#endif
+
   // if we are just computing the size needed, don't write any data but keep
   // a count of how many bytes would be written.
   if (!write_ctx->compute_size_only &&
@@ -166,6 +261,12 @@ static bool prv_platform_coredump_write(const void *data, size_t len,
     return false;
   }
 
+#if MEMFAULT_COREDUMP_RLE_SIZE_CACHE_ENABLED
+  if (write_ctx->rle_active) {
+    prv_rle_encode_all(&write_ctx->rle_ctx, data, len);
+  }
+#endif
+
   write_ctx->offset += len;
   return true;
 }
@@ -215,11 +316,17 @@ static bool prv_write_block_with_address(eMfltCoredumpBlockType block_type,
 
   // We have a region that needs to be read 32 bits at a time.
   //
-  // Typically these are very small regions such as a memory mapped register address
-  const uint32_t *word_data = (const uint32_t *)block_payload;
-  for (uint32_t i = 0; i < block_payload_size / 4; i++) {
-    const uint32_t data = word_data[i];
-    if (!prv_platform_coredump_write(&data, sizeof(data), write_ctx)) {
+  // Typically these are very small regions such as a memory mapped register address. The words
+  // are staged on the stack so they are written to storage in a few larger writes.
+  const volatile uint32_t *word_data = (const volatile uint32_t *)block_payload;
+  uint32_t words[8];
+  const size_t num_words = block_payload_size / 4;
+  for (size_t i = 0; i < num_words; i += MEMFAULT_ARRAY_SIZE(words)) {
+    const size_t words_to_copy = MEMFAULT_MIN(MEMFAULT_ARRAY_SIZE(words), num_words - i);
+    for (size_t j = 0; j < words_to_copy; j++) {
+      words[j] = word_data[i + j];
+    }
+    if (!prv_platform_coredump_write(words, words_to_copy * sizeof(words[0]), write_ctx)) {
       return false;
     }
   }
@@ -370,9 +477,6 @@ static void prv_insert_padding_if_necessary(sMfltCoredumpWriteCtx *write_ctx) {
                              write_ctx);
 }
 
-//! Callback that will be called to write coredump data.
-typedef bool (*MfltCoredumpReadCb)(uint32_t offset, void *data, size_t read_len);
-
 static bool prv_get_info_and_header(sMfltCoredumpHeader *hdr_out,
                                     sMfltCoredumpStorageInfo *info_out,
                                     MfltCoredumpReadCb coredump_read_cb) {
@@ -431,6 +535,30 @@ static bool prv_write_regions(sMfltCoredumpWriteCtx *write_ctx, const sMfltCored
   return true;
 }
 
+#if MEMFAULT_COREDUMP_RLE_SIZE_CACHE_ENABLED
+//! Finish run length encoding the coredump and populate the RLE fields of the footer
+//!
+//! Everything after the header is encoded while it is written, in the same pass. The footer
+//! records the encoded size of the sequences found before the last one and where that sequence
+//! starts, so the few bytes left, including the footer itself, and the header, which is written
+//! last, are encoded when the size is looked up. See memfault_coredump_get_rle_size()
+//!
+//! @note The cached size is only valid because every byte saved goes through
+//! prv_platform_coredump_write() exactly as it is later read out by the RLE data source. Any
+//! transformation of the data while saving must be applied before it is fed to rle_ctx.
+static void prv_rle_finish(sMfltCoredumpWriteCtx *write_ctx, sMfltCoredumpFooter *footer) {
+  if (!write_ctx->rle_active) {
+    return;
+  }
+  write_ctx->rle_active = false;
+
+  // the footer fields preceding the RLE ones don't depend on the encoded size
+  prv_rle_encode_all(&write_ctx->rle_ctx, footer, offsetof(sMfltCoredumpFooter, rle_size));
+  footer->rle_size = write_ctx->rle_ctx.total_rle_size;
+  footer->rle_tail_offset = sizeof(sMfltCoredumpHeader) + write_ctx->rle_ctx.seq_start_offset;
+}
+#endif /* MEMFAULT_COREDUMP_RLE_SIZE_CACHE_ENABLED */
+
 static bool prv_write_coredump_sections(const sMemfaultCoredumpSaveInfo *save_info,
                                         bool compute_size_only, size_t *total_size) {
   sMfltCoredumpStorageInfo info = { 0 };
@@ -461,24 +589,45 @@ static bool prv_write_coredump_sections(const sMemfaultCoredumpSaveInfo *save_in
     }
   }
 
-  // erase storage provided we aren't just computing the size
-  if (!compute_size_only && !memfault_platform_coredump_storage_erase(0, info.size)) {
-    return false;
-  }
-
   sMfltCoredumpWriteCtx write_ctx = {
     // We will write the header last as a way to mark validity
     // so advance the offset past it to start
     .offset = sizeof(hdr),
     .compute_size_only = compute_size_only,
     .storage_size = info.size,
+#if MEMFAULT_COREDUMP_STORAGE_INCREMENTAL_ERASE
+    .erase_region_size = info.size,
+    .sector_size = info.sector_size,
+#endif
   };
 
+#if MEMFAULT_COREDUMP_STORAGE_INCREMENTAL_ERASE
+  // storage is erased as it is written, unless the sector size is unknown
+  const bool erase_all = (info.sector_size == 0);
+#else
+  const bool erase_all = true;
+#endif
+
+  // erase storage provided we aren't just computing the size
+  if (!compute_size_only && erase_all) {
+    if (!memfault_platform_coredump_storage_erase(0, info.size)) {
+      return false;
+    }
+#if MEMFAULT_COREDUMP_STORAGE_INCREMENTAL_ERASE
+    write_ctx.erased_offset = info.size;
+#endif
+  }
+
   if (write_ctx.storage_size > sizeof(sMfltCoredumpFooter)) {
     // always leave space for footer
     write_ctx.storage_size -= sizeof(sMfltCoredumpFooter);
   }
 
+#if MEMFAULT_COREDUMP_RLE_SIZE_CACHE_ENABLED
+  // everything after the header is run length encoded as it is written
+  write_ctx.rle_active = !compute_size_only;
+#endif
+
   const void *regs = save_info->regs;
   const size_t regs_size = save_info->regs_size;
   if (regs != NULL) {
@@ -525,10 +674,13 @@ static bool prv_write_coredump_sections(const sMemfaultCoredumpSaveInfo *save_in
     return false;
   }
 
-  const sMfltCoredumpFooter footer = (sMfltCoredumpFooter){
+  sMfltCoredumpFooter footer = (sMfltCoredumpFooter){
     .magic = MEMFAULT_COREDUMP_FOOTER_MAGIC,
     .flags = write_ctx.truncated ? (1 << kMfltCoredumpBlockType_SaveTruncated) : 0,
   };
+#if MEMFAULT_COREDUMP_RLE_SIZE_CACHE_ENABLED
+  prv_rle_finish(&write_ctx, &footer);
+#endif
   write_ctx.storage_size = info.size;
   if (!prv_platform_coredump_write(&footer, sizeof(footer), &write_ctx)) {
     return false;
@@ -582,13 +734,130 @@ bool memfault_coredump_has_valid_coredump(size_t *total_size_out) {
   return true;
 }
 
+#if MEMFAULT_COREDUMP_STORAGE_PRE_ERASE_ENABLED
+bool memfault_coredump_storage_pre_erase(void) {
+  if (memfault_coredump_has_valid_coredump(NULL)) {
+    return false;
+  }
+
+  sMfltCoredumpStorageInfo info = { 0 };
+  memfault_platform_coredump_storage_get_info(&info);
+  if (info.sector_size == 0) {
+    return memfault_platform_coredump_storage_erase(0, info.size);
+  }
+
+  // erase a sector at a time, skipping any that are still erased from a previous call
+  for (size_t offset = 0; offset < info.size; offset += info.sector_size) {
+    const size_t erase_size = MEMFAULT_MIN(info.sector_size, info.size - offset);
+    if (!prv_storage_is_erased(memfault_coredump_read, (uint32_t)offset, erase_size) &&
+        !memfault_platform_coredump_storage_erase((uint32_t)offset, erase_size)) {
+      return false;
+    }
+  }
+  return true;
+}
+#endif
+
 MEMFAULT_WEAK bool memfault_coredump_read(uint32_t offset, void *buf, size_t buf_len) {
   return memfault_platform_coredump_storage_read(offset, buf, buf_len);
 }
 
+#if MEMFAULT_COREDUMP_RLE_SIZE_CACHE_ENABLED
+//! Run length encodes the saved coredump bytes from start_offset up to end_offset into rle_ctx
+static bool prv_rle_encode_saved(sMemfaultRleCtx *rle_ctx, uint32_t start_offset,
+                                 uint32_t end_offset) {
+  uint8_t buf[32];
+  for (uint32_t offset = start_offset; offset < end_offset;) {
+    const size_t read_len = MEMFAULT_MIN(sizeof(buf), end_offset - offset);
+    if (!memfault_coredump_read(offset, buf, read_len)) {
+      return false;
+    }
+    prv_rle_encode_all(rle_ctx, buf, read_len);
+    offset += read_len;
+  }
+  return true;
+}
+
+//! @return true if the encoders will find the same sequences for the bytes fed to them from now on
+static bool prv_rle_ctx_state_equal(const sMemfaultRleCtx *a, const sMemfaultRleCtx *b) {
+  return (a->state == b->state) && (a->last_byte == b->last_byte) &&
+         (a->seq_count == b->seq_count) && (a->num_repeats == b->num_repeats);
+}
+
+//! Computes how much encoding the header in front of the rest of the coredump, as the RLE data
+//! source does, adds to the RLE size of the rest of the coredump encoded on its own
+//!
+//! The bytes following the header are encoded both with and without the header in front of them
+//! until the two encoders are in the same state. From then on they find the same sequences, so
+//! the difference between the sizes encoded so far is the difference overall.
+static bool prv_rle_header_size_delta(uint32_t total_size, int32_t *delta) {
+  sMemfaultRleCtx with_hdr = { 0 };
+  if (!prv_rle_encode_saved(&with_hdr, 0, sizeof(sMfltCoredumpHeader))) {
+    return false;
+  }
+  sMemfaultRleCtx without_hdr = { 0 };
+
+  uint8_t buf[MEMFAULT_COREDUMP_RLE_HEADER_LOOKAHEAD_LEN];
+  const size_t read_len = MEMFAULT_MIN(sizeof(buf), total_size - sizeof(sMfltCoredumpHeader));
+  if (!memfault_coredump_read(sizeof(sMfltCoredumpHeader), buf, read_len)) {
+    return false;
+  }
+
+  for (size_t i = 0; i < read_len; i++) {
+    memfault_rle_encode(&with_hdr, &buf[i], 1);
+    memfault_rle_encode(&without_hdr, &buf[i], 1);
+    if (prv_rle_ctx_state_equal(&with_hdr, &without_hdr)) {
+      *delta = (int32_t)(with_hdr.total_rle_size - without_hdr.total_rle_size);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool memfault_coredump_get_rle_size(size_t *rle_size_out) {
+  size_t total_size = 0;
+  if (!memfault_coredump_has_valid_coredump(&total_size)) {
+    return false;
+  }
+
+  sMfltCoredumpFooter footer;
+  if ((total_size < (sizeof(sMfltCoredumpHeader) + sizeof(footer))) ||
+      !memfault_coredump_read(total_size - sizeof(footer), &footer, sizeof(footer))) {
+    return false;
+  }
+
+  if ((footer.magic != MEMFAULT_COREDUMP_FOOTER_MAGIC) ||
+      (footer.rle_tail_offset < sizeof(sMfltCoredumpHeader)) ||
+      (footer.rle_tail_offset >= total_size)) {
+    return false;
+  }
+
+  // Encoding from scratch at the start of a sequence finds the same sequences as an encoder which
+  // got there from the start of the coredump, so the rest of the encoded size can be computed
+  // from the tail alone
+  sMemfaultRleCtx tail_ctx = { 0 };
+  if (!prv_rle_encode_saved(&tail_ctx, footer.rle_tail_offset, total_size)) {
+    return false;
+  }
+  memfault_rle_encode_finalize(&tail_ctx);
+
+  int32_t header_size_delta = 0;
+  if (!prv_rle_header_size_delta(total_size, &header_size_delta)) {
+    return false;
+  }
+
+  *rle_size_out =
+    (size_t)((int32_t)(footer.rle_size + tail_ctx.total_rle_size) + header_size_delta);
+  return true;
+}
+#endif
+
 //! Expose a data source for use by the Memfault Packetizer
 const sMemfaultDataSourceImpl g_memfault_coredump_data_source = {
   .has_more_msgs_cb = memfault_coredump_has_valid_coredump,
   .read_msg_cb = memfault_coredump_read,
   .mark_msg_read_cb = memfault_platform_coredump_storage_clear,
+#if MEMFAULT_COREDUMP_RLE_SIZE_CACHE_ENABLED
+  .get_rle_size_cb = memfault_coredump_get_rle_size,
+#endif
 };
@@ -0,0 +1,104 @@
+//! @file
+//!
+//! Copyright (c) Memfault, Inc.
+//! See LICENSE for details
+//!
+//! @brief
+//! Word-at-a-time scan of a painted stack for its high watermark. See header for more details.
+
+#include "memfault/panics/stack_watermark.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#define MEMFAULT_STACK_WORD_SIZE sizeof(uint32_t)
+#define MEMFAULT_STACK_BLOCK_WORDS 4
+#define MEMFAULT_STACK_BLOCK_SIZE (MEMFAULT_STACK_BLOCK_WORDS * MEMFAULT_STACK_WORD_SIZE)
+
+typedef struct {
+  uint32_t word;
+  // The pattern as it is laid out in memory, indexed by address modulo the word size
+  uint8_t bytes[MEMFAULT_STACK_WORD_SIZE];
+} sMfltStackPaint;
+
+static bool prv_is_word_aligned(const uint8_t *p) {
+  return ((uintptr_t)p % MEMFAULT_STACK_WORD_SIZE) == 0;
+}
+
+static bool prv_is_painted_byte(const sMfltStackPaint *paint, const uint8_t *p) {
+  return *p == paint->bytes[(uintptr_t)p % MEMFAULT_STACK_WORD_SIZE];
+}
+
+static const uint32_t *prv_words(const uint8_t *p) {
+  return (const uint32_t *)(const void *)p;
+}
+
+static bool prv_is_painted_block(const sMfltStackPaint *paint, const uint8_t *p) {
+  const uint32_t *w = prv_words(p);
+  return ((w[0] ^ paint->word) | (w[1] ^ paint->word) | (w[2] ^ paint->word) |
+          (w[3] ^ paint->word)) == 0;
+}
+
+//! @return the address of the first byte in [p, end) that doesn't hold the paint pattern, or end
+static const uint8_t *prv_find_first_used(const sMfltStackPaint *paint, const uint8_t *p,
+                                          const uint8_t *end) {
+  for (; (p < end) && !prv_is_word_aligned(p); p++) {
+    if (!prv_is_painted_byte(paint, p)) {
+      return p;
+    }
+  }
+
+  for (; ((size_t)(end - p) >= MEMFAULT_STACK_BLOCK_SIZE) && prv_is_painted_block(paint, p);
+       p += MEMFAULT_STACK_BLOCK_SIZE) { }
+
+  for (; ((size_t)(end - p) >= MEMFAULT_STACK_WORD_SIZE) && (*prv_words(p) == paint->word);
+       p += MEMFAULT_STACK_WORD_SIZE) { }
+
+  // the watermark is in this word, or in the unaligned tail of the stack
+  for (; (p < end) && prv_is_painted_byte(paint, p); p++) { }
+
+  return p;
+}
+
+//! Walk down from a previously computed watermark through the part of the stack that has been
+//! used since, until reaching a block that is still painted.
+//!
+//! @return the address to scan up for the watermark from
+static const uint8_t *prv_find_scan_start(const sMfltStackPaint *paint, const uint8_t *start,
+                                          const uint8_t *end, const uint8_t *cached_watermark) {
+  // The first byte above the cached watermark was in use when it was computed, and used stack
+  // is never painted again while the thread is alive
+  if ((cached_watermark < end) && prv_is_painted_byte(paint, cached_watermark)) {
+    return start;
+  }
+
+  const uint8_t *p = cached_watermark - ((uintptr_t)cached_watermark % MEMFAULT_STACK_WORD_SIZE);
+  while ((p >= start) && ((size_t)(p - start) >= MEMFAULT_STACK_BLOCK_SIZE)) {
+    p -= MEMFAULT_STACK_WORD_SIZE;
+    if (*prv_words(p) == paint->word) {
+      const uint8_t *block = p + MEMFAULT_STACK_WORD_SIZE - MEMFAULT_STACK_BLOCK_SIZE;
+      if (prv_is_painted_block(paint, block)) {
+        return block;
+      }
+    }
+  }
+
+  // The remaining bytes are scanned up from the bottom of the stack
+  return start;
+}
+
+size_t memfault_stack_watermark_bytes_unused(const void *stack_start, size_t stack_size,
+                                             uint32_t paint_pattern, size_t cached_bytes_unused) {
+  sMfltStackPaint paint = { .word = paint_pattern };
+  memcpy(paint.bytes, &paint_pattern, sizeof(paint.bytes));
+
+  const uint8_t *const start = (const uint8_t *)stack_start;
+  const uint8_t *const end = start + stack_size;
+
+  const uint8_t *scan_start = start;
+  if ((cached_bytes_unused != 0) && (cached_bytes_unused <= stack_size)) {
+    scan_start = prv_find_scan_start(&paint, start, end, start + cached_bytes_unused);
+  }
+
+  return (size_t)(prv_find_first_used(&paint, scan_start, end) - start);
+}
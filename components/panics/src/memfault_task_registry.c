@@ -0,0 +1,181 @@
+//! @file
+//!
+//! Copyright (c) Memfault, Inc.
+//! See LICENSE for details
+//!
+//! @brief
+//! Task registry for the RTOS ports. See header for more details.
+
+#include "memfault/panics/task_registry.h"
+
+#include <string.h>
+
+// The array of TCB pointers is declared by the port with its RTOS's TCB type (e.g. 'struct
+// k_thread *'), so entries are copied in and out rather than accessed through a 'void *' lvalue
+static void *prv_get_tcb(const sMfltTaskRegistry *registry, size_t slot) {
+  void *tcb;
+  memcpy(&tcb, (const uint8_t *)registry->tcbs + (slot * sizeof(tcb)), sizeof(tcb));
+  return tcb;
+}
+
+static void prv_set_tcb(sMfltTaskRegistry *registry, size_t slot, void *tcb) {
+  memcpy((uint8_t *)registry->tcbs + (slot * sizeof(tcb)), &tcb, sizeof(tcb));
+}
+
+#if MEMFAULT_TASK_REGISTRY_CONSTANT_TIME
+
+static size_t prv_hash_home(const sMfltTaskRegistry *registry, const void *tcb) {
+  // TCBs are at least 4-byte aligned, so mix the upper bits down before masking
+  uint32_t hash = (uint32_t)((uintptr_t)tcb >> 2);
+  hash ^= hash >> 16;
+  hash *= 0x45d9f3bu;
+  hash ^= hash >> 16;
+  return hash & registry->index_mask;
+}
+
+//! Find the hash table entry for a TCB
+//!
+//! @param[out] pos The entry for the TCB if it's found, otherwise the free entry to insert it in
+//! @return true if the TCB was found
+static bool prv_hash_find(const sMfltTaskRegistry *registry, const void *tcb, size_t *pos) {
+  size_t i = prv_hash_home(registry, tcb);
+  while (registry->index[i] != 0) {
+    if (prv_get_tcb(registry, registry->index[i] - 1u) == tcb) {
+      *pos = i;
+      return true;
+    }
+    i = (i + 1) & registry->index_mask;
+  }
+  *pos = i;
+  return false;
+}
+
+//! Remove an entry from the hash table
+//!
+//! Uses backward-shift deletion so no tombstones are needed: subsequent entries of the probe
+//! sequence are moved up into the hole unless their home entry lies (cyclically) after it.
+static void prv_hash_remove(sMfltTaskRegistry *registry, size_t pos) {
+  const size_t mask = registry->index_mask;
+  size_t hole = pos;
+  size_t next = pos;
+  while (true) {
+    next = (next + 1) & mask;
+    const uint16_t value = registry->index[next];
+    if (value == 0) {
+      break;
+    }
+    const size_t home = prv_hash_home(registry, prv_get_tcb(registry, value - 1u));
+    // distance from home is computed modulo the table size to handle wrap-around
+    if (((next - home) & mask) >= ((next - hole) & mask)) {
+      registry->index[hole] = value;
+      hole = next;
+    }
+  }
+  registry->index[hole] = 0;
+}
+
+bool memfault_task_registry_add(sMfltTaskRegistry *registry, void *tcb, size_t *slot) {
+  if (tcb == NULL) {
+    return false;
+  }
+
+  size_t pos;
+  size_t new_slot;
+  if (prv_hash_find(registry, tcb, &pos)) {
+    new_slot = registry->index[pos] - 1u;
+  } else {
+    if (registry->num_free > 0) {
+      registry->num_free--;
+      new_slot = registry->free_slots[registry->num_free];
+    } else if (registry->never_used < registry->num_slots) {
+      new_slot = registry->never_used;
+      registry->never_used++;
+    } else {
+      return false;
+    }
+
+    prv_set_tcb(registry, new_slot, tcb);
+    registry->index[pos] = (uint16_t)(new_slot + 1);
+  }
+
+  if (slot != NULL) {
+    *slot = new_slot;
+  }
+  return true;
+}
+
+bool memfault_task_registry_remove(sMfltTaskRegistry *registry, const void *tcb, size_t *slot) {
+  size_t pos;
+  if ((tcb == NULL) || !prv_hash_find(registry, tcb, &pos)) {
+    return false;
+  }
+
+  const uint16_t old_slot = (uint16_t)(registry->index[pos] - 1u);
+  prv_hash_remove(registry, pos);
+  prv_set_tcb(registry, old_slot, NULL);
+  registry->free_slots[registry->num_free] = old_slot;
+  registry->num_free++;
+
+  if (slot != NULL) {
+    *slot = old_slot;
+  }
+  return true;
+}
+
+#else  // MEMFAULT_TASK_REGISTRY_CONSTANT_TIME
+
+//! Scan the array of TCB pointers for a TCB
+//!
+//! @param[out] slot The slot of the TCB if it's found, otherwise the first free slot, or
+//!  num_slots if there is none
+//! @return true if the TCB was found
+static bool prv_find_slot(const sMfltTaskRegistry *registry, const void *tcb, size_t *slot) {
+  size_t free_slot = registry->num_slots;
+  for (size_t i = 0; i < registry->num_slots; i++) {
+    const void *entry = prv_get_tcb(registry, i);
+    if (entry == tcb) {
+      *slot = i;
+      return true;
+    }
+    if ((entry == NULL) && (free_slot == registry->num_slots)) {
+      free_slot = i;
+    }
+  }
+  *slot = free_slot;
+  return false;
+}
+
+bool memfault_task_registry_add(sMfltTaskRegistry *registry, void *tcb, size_t *slot) {
+  size_t new_slot;
+  if (tcb == NULL) {
+    return false;
+  }
+
+  if (!prv_find_slot(registry, tcb, &new_slot)) {
+    if (new_slot == registry->num_slots) {
+      return false;
+    }
+    prv_set_tcb(registry, new_slot, tcb);
+  }
+
+  if (slot != NULL) {
+    *slot = new_slot;
+  }
+  return true;
+}
+
+bool memfault_task_registry_remove(sMfltTaskRegistry *registry, const void *tcb, size_t *slot) {
+  size_t old_slot;
+  if ((tcb == NULL) || !prv_find_slot(registry, tcb, &old_slot)) {
+    return false;
+  }
+
+  prv_set_tcb(registry, old_slot, NULL);
+
+  if (slot != NULL) {
+    *slot = old_slot;
+  }
+  return true;
+}
+
+#endif  // MEMFAULT_TASK_REGISTRY_CONSTANT_TIME
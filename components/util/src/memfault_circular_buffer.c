@@ -195,6 +195,47 @@ bool memfault_circular_buffer_write_at_offset(sMfltCircularBuffer *circular_buf,
   return prv_write_at_offset_from_end(circular_buf, offset_from_end, data, data_len);
 }
 
+bool memfault_circular_buffer_reserve(sMfltCircularBuffer *circular_buf, size_t data_len,
+                                      size_t *storage_idx) {
+  if ((circular_buf == NULL) || (storage_idx == NULL)) {
+    return false;
+  }
+
+  if (prv_get_space_available(circular_buf) < data_len) {
+    return false;
+  }
+
+  *storage_idx =
+    (circular_buf->read_offset + circular_buf->read_size) % circular_buf->total_space;
+  circular_buf->read_size += data_len;
+  return true;
+}
+
+bool memfault_circular_buffer_write_reserved(sMfltCircularBuffer *circular_buf,
+                                             size_t storage_idx, size_t offset, const void *data,
+                                             size_t data_len) {
+  if ((circular_buf == NULL) || (data == NULL) || (storage_idx >= circular_buf->total_space) ||
+      ((offset + data_len) > circular_buf->total_space)) {
+    return false;
+  }
+
+  size_t write_idx = (storage_idx + offset) % circular_buf->total_space;
+  size_t contiguous_space_available = circular_buf->total_space - write_idx;
+
+  size_t bytes_to_write =
+    (contiguous_space_available > data_len) ? data_len : contiguous_space_available;
+
+  const uint8_t *buf = (const uint8_t *)data;
+  memcpy(&circular_buf->storage[write_idx], buf, bytes_to_write);
+  buf += bytes_to_write;
+  size_t bytes_rem = data_len - bytes_to_write;
+  if (bytes_rem != 0) {
+    memcpy(&circular_buf->storage[0], buf, bytes_rem);
+  }
+
+  return true;
+}
+
 size_t memfault_circular_buffer_get_read_size(const sMfltCircularBuffer *circular_buf) {
   if (circular_buf == NULL) {
     return 0;
@@ -83,6 +83,7 @@
 #include "memfault/core/debug_log.h"
 #include "memfault/core/math.h"
 #include "memfault/panics/coredump.h"
+#include "memfault/panics/task_registry.h"
 #include "memfault/ports/freertos_coredump.h"
 
 // Espressif's esp-idf project uses a different include directory by default.
@@ -175,16 +176,8 @@ static struct MfltTaskWatermarks {
 static void *s_task_tcbs[MEMFAULT_PLATFORM_MAX_TRACKED_TASKS];
 #define EMPTY_SLOT 0
 
-static bool prv_find_slot(size_t *idx, void *desired_tcb) {
-  for (size_t i = 0; i < MEMFAULT_ARRAY_SIZE(s_task_tcbs); i++) {
-    if (s_task_tcbs[i] == desired_tcb) {
-      *idx = i;
-      return true;
-    }
-  }
-
-  return false;
-}
+//! Tracks which entry of s_task_tcbs each TCB is in
+MEMFAULT_TASK_REGISTRY_DEFINE(s_task_registry, s_task_tcbs);
 
 // We're not locking around the 'memfault_freertos_trace_task_create()' /
 // 'memfault_freertos_trace_task_delete()' operations, since they are expected
@@ -192,27 +185,15 @@ static bool prv_find_slot(size_t *idx, void *desired_tcb) {
 // / 'traceTASK_DELETE()'), which are already serialized with a kernel lock or
 // port critical section
 void memfault_freertos_trace_task_create(void *tcb) {
-  size_t idx = 0;
-
-  const bool slot_found = prv_find_slot(&idx, EMPTY_SLOT);
-  if (slot_found) {
-    s_task_tcbs[idx] = tcb;
-  }
-
-  if (!slot_found) {
+  if (!memfault_task_registry_add(&s_task_registry, tcb, NULL)) {
     MEMFAULT_FREERTOS_REGISTRY_FULL_ERROR_LOG(
       "Task registry full (" MEMFAULT_EXPAND_AND_QUOTE(MEMFAULT_PLATFORM_MAX_TRACKED_TASKS) ")");
   }
 }
 
 void memfault_freertos_trace_task_delete(void *tcb) {
-  size_t idx = 0;
-  if (!prv_find_slot(&idx, tcb)) {
-    // A TCB not currently in the registry
-    return;
-  }
-
-  s_task_tcbs[idx] = EMPTY_SLOT;
+  // A TCB not currently in the registry is ignored
+  memfault_task_registry_remove(&s_task_registry, tcb, NULL);
 }
 
 #if MEMFAULT_COREDUMP_COMPUTE_THREAD_STACK_USAGE
@@ -268,7 +249,8 @@ size_t memfault_freertos_get_task_regions(sMfltCoredumpRegion *regions, size_t n
       memfault_platform_sanitize_address_range(tcb_address, MEMFAULT_FREERTOS_TCB_SIZE);
     if (tcb_size == 0) {
       // An invalid address, scrub the TCB from the list so we don't try to dereference
-      // it when grabbing stacks below and move on.
+      // it when grabbing stacks below and move on. The slot is cleared directly since a
+      // corrupted entry won't be found in the task registry.
       s_task_tcbs[i] = EMPTY_SLOT;
       continue;
     }
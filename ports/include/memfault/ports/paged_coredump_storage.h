@@ -0,0 +1,217 @@
+#pragma once
+
+//! @file
+//!
+//! Copyright (c) Memfault, Inc.
+//! See LICENSE for details
+//!
+//! @brief
+//! A double-buffered variant of memfault/ports/buffered_coredump_storage.h for storage which is
+//! programmed a page (typically 256 bytes to 4kB) at a time, such as QSPI NOR flash.
+//!
+//! The many small writes issued while a coredump is saved (block headers, words of peripheral
+//! registers, etc) are coalesced into page sized, page aligned programs. Two page buffers are
+//! used so a port can start programming one page (i.e kick off a DMA or QSPI transfer) and return
+//! while the coredump continues to be written into the other.
+//!
+//! Like the buffered writer, this relies on the Memfault SDK writing to coredump storage
+//! sequentially, with the exception of the header which is written at offset 0 as the last step.
+//! The first page of storage is held in a third buffer until then, so RAM usage is
+//! 3 * MEMFAULT_COREDUMP_STORAGE_PAGE_SIZE.
+//!
+//! To use:
+//!
+//! 1. Include this file in your storage port
+//! 2. Implement the page writer:
+//!   bool memfault_platform_coredump_storage_page_write_start(const sCoredumpStoragePage *page) {
+//!     const addr = your_storage_base_addr + page->write_offset;
+//!     return your_storage_program_async(addr, page->data, MEMFAULT_COREDUMP_STORAGE_PAGE_SIZE);
+//!   }
+//!
+//!   bool memfault_platform_coredump_storage_page_write_wait(void) {
+//!     return your_storage_wait_for_program_complete();
+//!   }
+//!
+//!   A port which programs pages synchronously can do so in
+//!   memfault_platform_coredump_storage_page_write_start() and return true from
+//!   memfault_platform_coredump_storage_page_write_wait().
+//!
+//! Usage Notes:
+//!  - The size of coredump storage must be a multiple of MEMFAULT_COREDUMP_STORAGE_PAGE_SIZE
+//!  - Bytes of the last page which are not part of the coredump are written as zero
+
+#include <stdint.h>
+#include <string.h>
+
+#include "memfault/config.h"
+#include "memfault/core/compiler.h"
+#include "memfault/core/math.h"
+#include "memfault/panics/platform/coredump.h"
+
+#ifndef MEMFAULT_COREDUMP_STORAGE_PAGE_SIZE
+  #define MEMFAULT_COREDUMP_STORAGE_PAGE_SIZE 256
+#endif
+
+MEMFAULT_STATIC_ASSERT((MEMFAULT_COREDUMP_STORAGE_PAGE_SIZE &
+                        (MEMFAULT_COREDUMP_STORAGE_PAGE_SIZE - 1)) == 0,
+                       "MEMFAULT_COREDUMP_STORAGE_PAGE_SIZE must be a power of 2");
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct CoredumpStoragePage {
+  // data to write
+  MEMFAULT_ALIGNED(8) uint8_t data[MEMFAULT_COREDUMP_STORAGE_PAGE_SIZE];
+  // offset within storage to be written to, always page aligned
+  uint32_t write_offset;
+} sCoredumpStoragePage;
+
+//! Callback invoked to start programming a page of coredump storage
+//!
+//! The implementation may return as soon as the program has been started. The page will not be
+//! modified until memfault_platform_coredump_storage_page_write_wait() has returned.
+//!
+//! @param page The page to write. The size to write is always MEMFAULT_COREDUMP_STORAGE_PAGE_SIZE.
+//!
+//! @return true if the write was started successfully, false otherwise
+bool memfault_platform_coredump_storage_page_write_start(const sCoredumpStoragePage *page);
+
+//! Callback invoked to wait for the program started by the last call to
+//! memfault_platform_coredump_storage_page_write_start() to complete
+//!
+//! @return true if the page was written successfully, false otherwise
+bool memfault_platform_coredump_storage_page_write_wait(void);
+
+//
+// Paged Storage Implementation, single-file header style so it can easily be picked up
+// by a coredump storage port by simply including this file.
+//
+
+typedef struct CoredumpPagedWriter {
+  // the pages data is alternately staged in while the other one is being programmed
+  sCoredumpStoragePage pages[2];
+  // the first page of storage, programmed once the coredump header has been written
+  sCoredumpStoragePage first_page;
+  // index of the page being filled and whether any data has been staged in it
+  uint8_t active_page;
+  bool active_page_in_use;
+  // true while the other page is being programmed
+  bool write_in_flight;
+} sCoredumpPagedWriter;
+
+static sCoredumpPagedWriter s_coredump_paged_writer;
+
+static bool prv_paged_storage_wait(void) {
+  if (!s_coredump_paged_writer.write_in_flight) {
+    return true;
+  }
+  s_coredump_paged_writer.write_in_flight = false;
+  return memfault_platform_coredump_storage_page_write_wait();
+}
+
+static bool prv_paged_storage_program(const sCoredumpStoragePage *page) {
+  // only one page can be programmed at a time
+  if (!prv_paged_storage_wait() || !memfault_platform_coredump_storage_page_write_start(page)) {
+    return false;
+  }
+  s_coredump_paged_writer.write_in_flight = true;
+  return true;
+}
+
+//! Starts programming the page being filled and switches to filling the other page
+static bool prv_paged_storage_flush_active_page(void) {
+  sCoredumpPagedWriter *writer = &s_coredump_paged_writer;
+  if (!writer->active_page_in_use) {
+    return true;
+  }
+  if (!prv_paged_storage_program(&writer->pages[writer->active_page])) {
+    return false;
+  }
+  writer->active_page ^= 1;
+  writer->active_page_in_use = false;
+  return true;
+}
+
+//! Returns the buffer the page of storage at page_offset is staged in
+static sCoredumpStoragePage *prv_paged_storage_get_page(uint32_t page_offset) {
+  sCoredumpPagedWriter *writer = &s_coredump_paged_writer;
+  if (page_offset == 0) {
+    return &writer->first_page;
+  }
+
+  sCoredumpStoragePage *page = &writer->pages[writer->active_page];
+  if (writer->active_page_in_use && (page->write_offset != page_offset)) {
+    // moved on to a new page before the active one was filled
+    if (!prv_paged_storage_flush_active_page()) {
+      return NULL;
+    }
+    page = &writer->pages[writer->active_page];
+  }
+
+  if (!writer->active_page_in_use) {
+    // the program of this buffer's previous contents completed before the other buffer started
+    // programming, so it can be filled while the other buffer is programmed
+    memset(page->data, 0x0, sizeof(page->data));
+    page->write_offset = page_offset;
+    writer->active_page_in_use = true;
+  }
+  return page;
+}
+
+//! Programs everything still staged, called once the coredump header has been written
+static bool prv_paged_storage_finish(void) {
+  sCoredumpPagedWriter *writer = &s_coredump_paged_writer;
+  const bool success = prv_paged_storage_flush_active_page() &&
+                       prv_paged_storage_program(&writer->first_page) &&
+                       prv_paged_storage_wait();
+
+  *writer = (sCoredumpPagedWriter){ 0 };
+  return success;
+}
+
+static bool memfault_coredump_storage_paged_write(uint32_t offset, const void *data,
+                                                  size_t data_len) {
+  sMfltCoredumpStorageInfo info = { 0 };
+  memfault_platform_coredump_storage_get_info(&info);
+  if (((offset + data_len) > info.size) ||
+      ((info.size % MEMFAULT_COREDUMP_STORAGE_PAGE_SIZE) != 0) ||
+      (info.size < MEMFAULT_COREDUMP_STORAGE_PAGE_SIZE)) {
+    return false;  // out of bounds write
+  }
+
+  // the header is the only write issued at offset 0 and is always written last
+  const bool is_final_write = (offset == 0);
+
+  const uint8_t *datap = (const uint8_t *)data;
+  while (data_len != 0) {
+    const uint32_t page_offset = offset & ~((uint32_t)MEMFAULT_COREDUMP_STORAGE_PAGE_SIZE - 1);
+    sCoredumpStoragePage *page = prv_paged_storage_get_page(page_offset);
+    if (page == NULL) {
+      return false;
+    }
+
+    const uint32_t offset_in_page = offset - page_offset;
+    const size_t bytes_to_copy =
+      MEMFAULT_MIN(MEMFAULT_COREDUMP_STORAGE_PAGE_SIZE - offset_in_page, data_len);
+    memcpy(&page->data[offset_in_page], datap, bytes_to_copy);
+    offset += bytes_to_copy;
+    datap += bytes_to_copy;
+    data_len -= bytes_to_copy;
+
+    const bool page_full = ((offset & (MEMFAULT_COREDUMP_STORAGE_PAGE_SIZE - 1)) == 0);
+    if (page_full && (page_offset != 0) && !prv_paged_storage_flush_active_page()) {
+      return false;
+    }
+  }
+
+  return is_final_write ? prv_paged_storage_finish() : true;
+}
+
+bool memfault_platform_coredump_storage_write(uint32_t offset, const void *data, size_t data_len) {
+  return memfault_coredump_storage_paged_write(offset, data, data_len);
+}
+
+#ifdef __cplusplus
+}
+#endif
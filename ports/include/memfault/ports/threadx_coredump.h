@@ -51,6 +51,15 @@ extern "C" {
 //! @return Number of entries written to @p regions (always <= @p num_regions).
 size_t memfault_threadx_get_thread_regions(sMfltCoredumpRegion *regions, size_t num_regions);
 
+//! Scan the stack of every ThreadX thread and cache its watermark. When a coredump is captured,
+//! memfault_threadx_get_thread_regions() starts each thread's scan from the cached watermark
+//! instead of from the bottom of the stack, which shortens the time spent in the fault handler.
+//! The stack of the running thread, which crashed, is always scanned in full.
+//!
+//! Call this from a background context at a regular interval, for example when collecting
+//! heartbeat metrics in memfault_metrics_heartbeat_collect_data().
+void memfault_threadx_update_stack_watermarks(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -3,12 +3,14 @@
 //! Copyright (c) Memfault, Inc.
 //! See LICENSE for details
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
 
 #include "memfault/core/math.h"
 #include "memfault/panics/coredump.h"
 #include "memfault/panics/platform/coredump.h"
+#include "memfault/panics/stack_watermark.h"
 #include "memfault/ports/threadx_coredump.h"
 #include "tx_api.h"
 
@@ -37,11 +39,38 @@ static sMfltThreadXStackInfo s_mflt_threadx_stack_info[MEMFAULT_THREADX_MAX_THRE
 extern TX_THREAD *_tx_thread_created_ptr;
 extern ULONG _tx_thread_created_count;
 
+// Watermarks computed by memfault_threadx_update_stack_watermarks(), used as the starting point
+// when the watermarks are computed again while capturing a coredump
+typedef struct {
+  const TX_THREAD *thread;
+  uint32_t stack_bytes_unused;
+} sMfltThreadXWatermarkCache;
+
+static sMfltThreadXWatermarkCache s_mflt_threadx_watermark_cache[MEMFAULT_THREADX_MAX_THREADS];
+
+// Check that the TCB pointer falls entirely within valid memory and that the TCB magic is
+// intact. If it isn't, the rest of the TCB (including all stack-related fields) cannot be trusted.
+static bool prv_is_valid_tcb(TX_THREAD *t) {
+  return (memfault_platform_sanitize_address_range(t, sizeof(TX_THREAD)) >= sizeof(TX_THREAD)) &&
+         (t->tx_thread_id == TX_THREAD_ID);
+}
+
+static uint32_t prv_get_cached_stack_bytes_unused(const TX_THREAD *thread) {
+  for (size_t i = 0; i < MEMFAULT_ARRAY_SIZE(s_mflt_threadx_watermark_cache); i++) {
+    if (s_mflt_threadx_watermark_cache[i].thread == thread) {
+      return s_mflt_threadx_watermark_cache[i].stack_bytes_unused;
+    }
+  }
+  return 0;
+}
+
 // Scan the stack fill pattern from the bottom (stack_start, lowest address)
 // upward and return the number of consecutive bytes still holding the fill
 // value. Returns 0 if the sanitize check fails, or
 // MEMFAULT_THREADX_STACK_UNUSED_FULLY_EXHAUSTED if the stack is fully used.
-static uint32_t prv_scan_stack_bytes_unused(const TX_THREAD *thread) {
+// A non-zero cached_bytes_unused from a previous scan lets the scan start from
+// that watermark instead of from the bottom of the stack.
+static uint32_t prv_scan_stack_bytes_unused(const TX_THREAD *thread, uint32_t cached_bytes_unused) {
   // Validate the entire stack range before touching it
   const size_t sanitized = memfault_platform_sanitize_address_range(thread->tx_thread_stack_start,
                                                                     thread->tx_thread_stack_size);
@@ -58,21 +87,46 @@ static uint32_t prv_scan_stack_bytes_unused(const TX_THREAD *thread) {
   const ULONG fill = (ULONG)0xEFEFEFEFUL;
 #endif
 
-  const ULONG *stack_bottom = (const ULONG *)thread->tx_thread_stack_start;
-  const ULONG stack_size_words = thread->tx_thread_stack_size / sizeof(ULONG);
+  const size_t bytes_unused =
+    memfault_stack_watermark_bytes_unused(thread->tx_thread_stack_start,
+                                          thread->tx_thread_stack_size, (uint32_t)fill,
+                                          cached_bytes_unused);
 
-  ULONG unused_words = 0;
-  for (ULONG i = 0; i < stack_size_words; i++) {
-    if (stack_bottom[i] != fill) {
+  if (bytes_unused == 0) {
+    return MEMFAULT_THREADX_STACK_UNUSED_FULLY_EXHAUSTED;
+  }
+  return (uint32_t)bytes_unused;
+}
+
+void memfault_threadx_update_stack_watermarks(void) {
+  memset(s_mflt_threadx_watermark_cache, 0, sizeof(s_mflt_threadx_watermark_cache));
+
+  size_t cache_idx = 0;
+  TX_THREAD *t = _tx_thread_created_ptr;
+  for (ULONG i = 0; i < _tx_thread_created_count && t != NULL &&
+                    cache_idx < MEMFAULT_ARRAY_SIZE(s_mflt_threadx_watermark_cache);
+       i++) {
+    if (!prv_is_valid_tcb(t)) {
       break;
     }
-    unused_words++;
-  }
 
-  if (unused_words == 0) {
-    return MEMFAULT_THREADX_STACK_UNUSED_FULLY_EXHAUSTED;
+    if (t->tx_thread_stack_start != NULL && t->tx_thread_stack_size > 0) {
+      // A full scan, so the cache doesn't carry over anything a scan starting
+      // from the previous watermark could have missed
+      const uint32_t bytes_unused = prv_scan_stack_bytes_unused(t, 0);
+      if (bytes_unused != 0 && bytes_unused != MEMFAULT_THREADX_STACK_UNUSED_FULLY_EXHAUSTED) {
+        s_mflt_threadx_watermark_cache[cache_idx].thread = t;
+        s_mflt_threadx_watermark_cache[cache_idx].stack_bytes_unused = bytes_unused;
+        cache_idx++;
+      }
+    }
+
+    TX_THREAD *next = t->tx_thread_created_next;
+    if (next == _tx_thread_created_ptr) {
+      break;
+    }
+    t = next;
   }
-  return (uint32_t)(unused_words * sizeof(ULONG));
 }
 
 size_t memfault_threadx_get_thread_regions(sMfltCoredumpRegion *regions, size_t num_regions) {
@@ -85,16 +139,16 @@ size_t memfault_threadx_get_thread_regions(sMfltCoredumpRegion *regions, size_t
   size_t region_idx = 0;
   size_t info_idx = 0;
 
+  // The running thread is the one which crashed, and its stack usage matters most when it
+  // overflowed. A scan starting from the cached watermark can stop at an unwritten local buffer
+  // below it, so this stack is always scanned in full.
+  const TX_THREAD *current = tx_thread_identify();
+
   TX_THREAD *t = _tx_thread_created_ptr;
   for (ULONG i = 0; i < _tx_thread_created_count && t != NULL; i++) {
-    // Guard 1: TCB pointer must fall entirely within valid memory.
-    if (memfault_platform_sanitize_address_range(t, sizeof(TX_THREAD)) < sizeof(TX_THREAD)) {
-      break;
-    }
-
-    // Guard 2: TCB magic must be intact - if it isn't, the rest of the TCB
-    // (including all stack-related fields) cannot be trusted.
-    if (t->tx_thread_id != TX_THREAD_ID) {
+    // Guards 1 and 2: TCB pointer must fall entirely within valid memory, and
+    // the TCB magic must be intact.
+    if (!prv_is_valid_tcb(t)) {
       break;
     }
 
@@ -112,7 +166,10 @@ size_t memfault_threadx_get_thread_regions(sMfltCoredumpRegion *regions, size_t
         // Compute the watermark and record it in the sidecar.
         if (info_idx < MEMFAULT_ARRAY_SIZE(s_mflt_threadx_stack_info)) {
           s_mflt_threadx_stack_info[info_idx].tx_thread_ptr = (uint32_t)(uintptr_t)t;
-          s_mflt_threadx_stack_info[info_idx].stack_bytes_unused = prv_scan_stack_bytes_unused(t);
+          const uint32_t cached_bytes_unused =
+            (t == current) ? 0 : prv_get_cached_stack_bytes_unused(t);
+          s_mflt_threadx_stack_info[info_idx].stack_bytes_unused =
+            prv_scan_stack_bytes_unused(t, cached_bytes_unused);
           info_idx++;
         }
 
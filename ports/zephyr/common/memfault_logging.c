@@ -19,6 +19,7 @@
 #include <stdio.h>
 
 #include "memfault/components.h"
+#include "memfault/core/log_impl.h"
 #include "memfault/ports/zephyr/log_backend.h"
 #include "memfault/ports/zephyr/version.h"
 // clang-format on
@@ -105,8 +106,9 @@ typedef struct MfltLogProcessCtx {
 
 static void prv_log_process(const struct log_backend *const backend, union log_msg_generic *msg) {
   // This can be called in IMMEDIATE mode from an ISR or when flushing logs via LOG_PANIC, so
-  // immediately bail. We currently can't safely serialize to the Memfault buffer from ISR context
-  if (memfault_arch_is_inside_isr()) {
+  // immediately bail, unless ISR logs are staged (MEMFAULT_LOG_ISR_STAGING_ENABLED). The
+  // Memfault buffer can't be written to directly from ISR context
+  if (!MEMFAULT_LOG_ISR_STAGING_ENABLED && memfault_arch_is_inside_isr()) {
     return;
   }
 
@@ -167,8 +169,10 @@ static int prv_log_out(uint8_t *data, size_t length, void *ctx) {
   // save info while in an ISR to avoid wrapping over the info we are collecting. This function may
   // also be run from LOG_PANIC. We also want to skip saving data in this case because we currently
   // can't safely serialize to the Memfault buffer from ISR context and the context object uses
-  // local stack memory which may not be valid when run from LOG_PANIC
-  if (memfault_arch_is_inside_isr()) {
+  // local stack memory which may not be valid when run from LOG_PANIC. With
+  // MEMFAULT_LOG_ISR_STAGING_ENABLED, ISR logs are copied to a staging ring instead, and
+  // prv_log_process() (which owns the context) is reentrancy protected by s_log_output_busy_flag.
+  if (!MEMFAULT_LOG_ISR_STAGING_ENABLED && memfault_arch_is_inside_isr()) {
     return (int)length;
   }
 
@@ -216,6 +220,17 @@ static int prv_log_out(uint8_t *data, size_t length, void *ctx) {
   // Note: Context should always be populated via our call to log_output_ctx_set() above.
   // Assert to catch any behavior changes in future versions of Zephyr
   MEMFAULT_SDK_ASSERT(mflt_ctx != NULL);
+
+#if MEMFAULT_LOG_ISR_STAGING_ENABLED
+  if (!memfault_arch_is_inside_isr()) {
+    // The nolock save below can't move logs staged from ISRs into the log buffer. Drain them
+    // first so they are saved, and saved ahead of this log.
+    memfault_lock();
+    memfault_log_drain_isr_logs_locked();
+    memfault_unlock();
+  }
+#endif
+
   memfault_log_save_preformatted_nolock(mflt_ctx->memfault_level, data, save_length);
 
   return (int)length;
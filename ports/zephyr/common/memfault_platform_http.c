@@ -64,6 +64,12 @@
 // Timeout for the socket file descriptor to become available for I/0
 #define POLL_TIMEOUT_MS CONFIG_MEMFAULT_HTTP_CLIENT_TIMEOUT_MS
 
+#if defined(CONFIG_MEMFAULT_HTTP_PIPELINE_DEPTH) && (CONFIG_MEMFAULT_HTTP_PIPELINE_DEPTH > 1)
+  #define MEMFAULT_HTTP_PIPELINE_ENABLED 1
+#else
+  #define MEMFAULT_HTTP_PIPELINE_ENABLED 0
+#endif
+
 #if defined(CONFIG_MEMFAULT_HTTP_SOCKET_DISPATCH)
 // Runtime configurable
 static char s_mflt_http_net_interface_name[IFNAMSIZ];
@@ -343,26 +349,45 @@ static int prv_open_socket(struct zsock_addrinfo **res, const char *host, int po
   return sock_fd;
 }
 
+#if !MEMFAULT_HTTP_PIPELINE_ENABLED && !defined(CONFIG_MEMFAULT_HTTP_STREAM_UPLOAD)
+  #if CONFIG_MEMFAULT_HTTP_MAX_POST_SIZE > 0
+//! Size of a buffer holding a whole chunk POST. The chunk is stored at
+//! &buf[MEMFAULT_HTTP_REQUEST_HEADER_MAX_LEN], and the request header is rendered right in front
+//! of it so both are sent with a single write. A header which doesn't fit is sent piecewise.
+    #define MEMFAULT_HTTP_POST_BUF_SIZE \
+      (MEMFAULT_HTTP_REQUEST_HEADER_MAX_LEN + CONFIG_MEMFAULT_HTTP_MAX_POST_SIZE)
+
+static bool prv_send_chunk_post(int sock_fd, uint8_t *buf, size_t chunk_len) {
+  const size_t hdr_len =
+    memfault_http_build_chunk_post_header(buf, MEMFAULT_HTTP_REQUEST_HEADER_MAX_LEN, chunk_len);
+  if (hdr_len == 0) {
+    return memfault_http_start_chunk_post(prv_send_data, &sock_fd, chunk_len) &&
+           prv_try_send(sock_fd, &buf[MEMFAULT_HTTP_REQUEST_HEADER_MAX_LEN], chunk_len);
+  }
+
+  uint8_t *post = &buf[MEMFAULT_HTTP_REQUEST_HEADER_MAX_LEN - hdr_len];
+  memmove(post, buf, hdr_len);
+  return prv_try_send(sock_fd, post, hdr_len + chunk_len);
+}
+  #endif /* CONFIG_MEMFAULT_HTTP_MAX_POST_SIZE */
+
 //! Returns:
 //! 0  - no more data to send
 //! 1  - data sent, awaiting response
 //! -1 - error
 static int prv_send_next_msg(sMemfaultHttpContext *ctx) {
-  int sock = ctx->sock_fd;
-
-#if CONFIG_MEMFAULT_HTTP_MAX_POST_SIZE > 0
-  uint8_t buf[CONFIG_MEMFAULT_HTTP_MAX_POST_SIZE];
-  size_t buf_len = sizeof(buf);
+  #if CONFIG_MEMFAULT_HTTP_MAX_POST_SIZE > 0
+  uint8_t buf[MEMFAULT_HTTP_POST_BUF_SIZE];
+  size_t buf_len = CONFIG_MEMFAULT_HTTP_MAX_POST_SIZE;
 
-  bool data_available = memfault_packetizer_get_chunk(buf, &buf_len);
+  bool data_available =
+    memfault_packetizer_get_chunk(&buf[MEMFAULT_HTTP_REQUEST_HEADER_MAX_LEN], &buf_len);
   if (!data_available) {
     MEMFAULT_LOG_DEBUG("No more data to send");
     return 0;  // no more data to send
   }
 
-  memfault_http_start_chunk_post(prv_send_data, &sock, buf_len);
-
-  if (!prv_try_send(sock, buf, buf_len)) {
+  if (!prv_send_chunk_post(ctx->sock_fd, buf, buf_len)) {
     // unexpected failure, abort in-flight transaction
     memfault_packetizer_abort();
     return -1;
@@ -374,7 +399,9 @@ static int prv_send_next_msg(sMemfaultHttpContext *ctx) {
   // message sent, await response
   return 1;
 
-#else
+  #else
+  int sock = ctx->sock_fd;
+
   const sMemfaultPacketizerConfig cfg = {
     // let a single msg span many "memfault_packetizer_get_next" calls
     .enable_multi_packet_chunk = true,
@@ -392,16 +419,16 @@ static int prv_send_next_msg(sMemfaultHttpContext *ctx) {
 
   // If the configured buffer size is large, use malloc instead of stack to
   // avoid stack overflow.
-  #if CONFIG_MEMFAULT_HTTP_PACKETIZER_BUFFER_SIZE > 512
+    #if CONFIG_MEMFAULT_HTTP_PACKETIZER_BUFFER_SIZE > 512
   uint8_t *buf = memfault_zephyr_port_calloc(1, CONFIG_MEMFAULT_HTTP_PACKETIZER_BUFFER_SIZE);
   if (buf == NULL) {
     MEMFAULT_LOG_ERROR("Failed to allocate buffer for reading data");
     memfault_packetizer_abort();
     return -1;
   }
-  #else
+    #else
   uint8_t buf[CONFIG_MEMFAULT_HTTP_PACKETIZER_BUFFER_SIZE];
-  #endif
+    #endif
   while (1) {
     size_t buf_len = CONFIG_MEMFAULT_HTTP_PACKETIZER_BUFFER_SIZE;
     eMemfaultPacketizerStatus status = memfault_packetizer_get_next(buf, &buf_len);
@@ -411,9 +438,9 @@ static int prv_send_next_msg(sMemfaultHttpContext *ctx) {
 
     if (!prv_try_send(sock, buf, buf_len)) {
       // unexpected failure, abort in-flight transaction
-  #if CONFIG_MEMFAULT_HTTP_PACKETIZER_BUFFER_SIZE > 512
+    #if CONFIG_MEMFAULT_HTTP_PACKETIZER_BUFFER_SIZE > 512
       memfault_zephyr_port_free(buf);
-  #endif
+    #endif
 
       memfault_packetizer_abort();
       return -1;
@@ -427,14 +454,15 @@ static int prv_send_next_msg(sMemfaultHttpContext *ctx) {
     }
   }
 
-  #if CONFIG_MEMFAULT_HTTP_PACKETIZER_BUFFER_SIZE > 512
+    #if CONFIG_MEMFAULT_HTTP_PACKETIZER_BUFFER_SIZE > 512
   memfault_zephyr_port_free(buf);
-  #endif
+    #endif
 
   // message sent, await response
   return 1;
-#endif /* CONFIG_MEMFAULT_HTTP_MAX_POST_SIZE */
+  #endif /* CONFIG_MEMFAULT_HTTP_MAX_POST_SIZE */
 }
+#endif /* !MEMFAULT_HTTP_PIPELINE_ENABLED && !CONFIG_MEMFAULT_HTTP_STREAM_UPLOAD */
 
 static bool prv_read_socket_data(int sock_fd, void *buf, size_t *buf_len) {
   int rv = prv_poll_socket(sock_fd, ZSOCK_POLLIN);
@@ -456,22 +484,34 @@ static bool prv_read_socket_data(int sock_fd, void *buf, size_t *buf_len) {
   return true;
 }
 
-//! Wait for the HTTP response to be fully received and parsed, returning the
+//! Receive buffer for HTTP responses. Responses to pipelined requests can arrive back to back,
+//! so bytes following the end of one response are kept for the next one.
+typedef struct {
+  // We don't expect any response that needs to be parsed so
+  // just use an arbitrarily small receive buffer
+  char buf[32];
+  size_t len;
+  size_t offset;
+} sMemfaultHttpRxBuf;
+
+//! Wait for the next HTTP response to be fully received and parsed, returning the
 //! HTTP status code of the response.
 //!
 //! @return HTTP status code on success, or -1 on error
-static int prv_wait_for_http_response(int sock_fd) {
+static int prv_wait_for_next_http_response(int sock_fd, sMemfaultHttpRxBuf *rx) {
   sMemfaultHttpResponseContext ctx = { 0 };
   while (1) {
-    // We don't expect any response that needs to be parsed so
-    // just use an arbitrarily small receive buffer
-    char buf[32];
-    size_t bytes_read = sizeof(buf);
-    if (!prv_read_socket_data(sock_fd, buf, &bytes_read)) {
-      return -1;
+    if (rx->offset == rx->len) {
+      rx->offset = 0;
+      rx->len = sizeof(rx->buf);
+      if (!prv_read_socket_data(sock_fd, rx->buf, &rx->len)) {
+        rx->len = 0;
+        return -1;
+      }
     }
 
-    bool done = memfault_http_parse_response(&ctx, buf, bytes_read);
+    bool done = memfault_http_parse_response(&ctx, &rx->buf[rx->offset], rx->len - rx->offset);
+    rx->offset += (size_t)ctx.data_bytes_processed;
     if (done) {
       MEMFAULT_LOG_DEBUG("Response Complete: Parse Status %d HTTP Status %d!", (int)ctx.parse_error,
                          ctx.http_status_code);
@@ -487,6 +527,123 @@ static int prv_wait_for_http_response(int sock_fd) {
   }
 }
 
+//! Wait for the HTTP response to be fully received and parsed, returning the
+//! HTTP status code of the response.
+//!
+//! @return HTTP status code on success, or -1 on error
+static int prv_wait_for_http_response(int sock_fd) {
+  sMemfaultHttpRxBuf rx = { 0 };
+  return prv_wait_for_next_http_response(sock_fd, &rx);
+}
+
+#if MEMFAULT_HTTP_PIPELINE_ENABLED
+
+//! Chunks which have been posted but not acknowledged yet. The packetizer has already moved past
+//! them, so they are kept here until the server responds, and re-sent on the next upload if the
+//! connection fails before then.
+MEMFAULT_HTTP_PIPELINE_DEFINE(s_http_pipeline, CONFIG_MEMFAULT_HTTP_PIPELINE_DEPTH,
+                              CONFIG_MEMFAULT_HTTP_MAX_POST_SIZE);
+
+typedef struct {
+  sMemfaultHttpContext *http_ctx;
+  sMemfaultHttpRxBuf rx;
+} sMemfaultHttpPipelineCtx;
+
+static bool prv_pipeline_send_data(const void *data, size_t data_len, void *ctx) {
+  sMemfaultHttpContext *http_ctx = ((sMemfaultHttpPipelineCtx *)ctx)->http_ctx;
+  if (!prv_try_send(http_ctx->sock_fd, data, data_len)) {
+    return false;
+  }
+
+  // count bytes sent
+  http_ctx->bytes_sent += data_len;
+  return true;
+}
+
+static int prv_pipeline_wait_for_response(void *ctx) {
+  sMemfaultHttpPipelineCtx *pipeline_ctx = (sMemfaultHttpPipelineCtx *)ctx;
+  return prv_wait_for_next_http_response(pipeline_ctx->http_ctx->sock_fd, &pipeline_ctx->rx);
+}
+
+//! Keeps up to CONFIG_MEMFAULT_HTTP_PIPELINE_DEPTH chunk POSTs in flight on the socket. See
+//! memfault_http_pipeline_upload() for how chunks are re-sent when the connection fails.
+static bool prv_upload_pipelined(sMemfaultHttpContext *ctx, int *max_messages_to_send) {
+  sMemfaultHttpPipelineCtx pipeline_ctx = { .http_ctx = ctx };
+  return memfault_http_pipeline_upload(&s_http_pipeline, prv_pipeline_send_data,
+                                       prv_pipeline_wait_for_response, &pipeline_ctx,
+                                       max_messages_to_send);
+}
+
+#endif /* MEMFAULT_HTTP_PIPELINE_ENABLED */
+
+#if defined(CONFIG_MEMFAULT_HTTP_STREAM_UPLOAD)
+
+static bool prv_stream_send_data(const void *data, size_t data_len, void *ctx) {
+  sMemfaultHttpContext *http_ctx = (sMemfaultHttpContext *)ctx;
+  if (!prv_try_send(http_ctx->sock_fd, data, data_len)) {
+    return false;
+  }
+
+  // count bytes sent
+  http_ctx->bytes_sent += data_len;
+  return true;
+}
+
+//! Posts every available message in a single request, whose body is streamed with
+//! "Transfer-Encoding: chunked" through a CONFIG_MEMFAULT_HTTP_PACKETIZER_BUFFER_SIZE buffer
+static bool prv_upload_streamed(sMemfaultHttpContext *ctx, int *max_messages_to_send) {
+  if (!memfault_packetizer_data_available()) {
+    MEMFAULT_LOG_DEBUG("No more data to send");
+    return true;
+  }
+
+  // If the configured buffer size is large, use malloc instead of stack to
+  // avoid stack overflow.
+  #if CONFIG_MEMFAULT_HTTP_PACKETIZER_BUFFER_SIZE > 512
+  uint8_t *buf = memfault_zephyr_port_calloc(1, CONFIG_MEMFAULT_HTTP_PACKETIZER_BUFFER_SIZE);
+  if (buf == NULL) {
+    MEMFAULT_LOG_ERROR("Failed to allocate buffer for reading data");
+    return false;
+  }
+  #else
+  uint8_t buf[CONFIG_MEMFAULT_HTTP_PACKETIZER_BUFFER_SIZE];
+  #endif
+
+  const int messages_sent =
+    memfault_http_post_chunks_stream(prv_stream_send_data, ctx, buf,
+                                     CONFIG_MEMFAULT_HTTP_PACKETIZER_BUFFER_SIZE,
+                                     (size_t)*max_messages_to_send);
+
+  #if CONFIG_MEMFAULT_HTTP_PACKETIZER_BUFFER_SIZE > 512
+  memfault_zephyr_port_free(buf);
+  #endif
+
+  if (messages_sent <= 0) {
+    // 0 if no message was available anymore, in which case no POST was sent
+    return (messages_sent == 0);
+  }
+
+  // every available message was streamed, unless the message limit was hit
+  if ((messages_sent == *max_messages_to_send) && memfault_packetizer_data_available()) {
+    MEMFAULT_LOG_WARN(
+      "Hit max message limit: " STRINGIFY(CONFIG_MEMFAULT_HTTP_MAX_MESSAGES_TO_SEND));
+  }
+
+  const int http_status = prv_wait_for_http_response(ctx->sock_fd);
+  return (http_status / 100 == 2);
+}
+
+#endif /* CONFIG_MEMFAULT_HTTP_STREAM_UPLOAD */
+
+static bool prv_data_available(void) {
+#if MEMFAULT_HTTP_PIPELINE_ENABLED
+  if (memfault_http_pipeline_has_unacked_chunks(&s_http_pipeline)) {
+    return true;
+  }
+#endif
+  return memfault_packetizer_data_available();
+}
+
 static bool prv_wait_for_http_response_header(int sock_fd, sMemfaultHttpResponseContext *ctx,
                                               void *buf, size_t *buf_len) {
   const size_t orig_buf_len = *buf_len;
@@ -766,7 +923,7 @@ int memfault_zephyr_port_ota_update(const sMemfaultOtaUpdateHandler *handler) {
 }
 
 ssize_t memfault_zephyr_port_http_post_data_return_size(void) {
-  if (!memfault_packetizer_data_available()) {
+  if (!prv_data_available()) {
     return 0;
   }
 
@@ -872,6 +1029,12 @@ int memfault_zephyr_port_http_upload_sdk_data(sMemfaultHttpContext *ctx) {
                  CONFIG_MEMFAULT_RAM_BACKED_COREDUMP_SIZE / CONFIG_MEMFAULT_HTTP_MAX_POST_SIZE);
 #endif
   bool success = true;
+
+#if MEMFAULT_HTTP_PIPELINE_ENABLED
+  success = prv_upload_pipelined(ctx, &max_messages_to_send);
+#elif defined(CONFIG_MEMFAULT_HTTP_STREAM_UPLOAD)
+  success = prv_upload_streamed(ctx, &max_messages_to_send);
+#else
   int rv = -1;
 
   while (max_messages_to_send-- > 0) {
@@ -889,8 +1052,9 @@ int memfault_zephyr_port_http_upload_sdk_data(sMemfaultHttpContext *ctx) {
       break;
     }
   }
+#endif
 
-  if ((max_messages_to_send <= 0) && memfault_packetizer_data_available()) {
+  if ((max_messages_to_send <= 0) && prv_data_available()) {
     MEMFAULT_LOG_WARN(
       "Hit max message limit: " STRINGIFY(CONFIG_MEMFAULT_HTTP_MAX_MESSAGES_TO_SEND));
   }
@@ -13,6 +13,8 @@
 // clang-format on
 
 #include "memfault/components.h"
+#include "memfault/panics/stack_watermark.h"
+#include "memfault/panics/task_registry.h"
 #include "memfault/ports/zephyr/coredump.h"
 
 static struct k_thread *s_task_tcbs[CONFIG_MEMFAULT_COREDUMP_MAX_TRACKED_TASKS];
@@ -34,16 +36,12 @@ static struct MfltTaskWatermarks {
 
 #define EMPTY_SLOT 0
 
-static bool prv_find_slot(size_t *idx, struct k_thread *desired_tcb) {
-  for (size_t i = 0; i < MEMFAULT_ARRAY_SIZE(s_task_tcbs); i++) {
-    if (s_task_tcbs[i] == desired_tcb) {
-      *idx = i;
-      return true;
-    }
-  }
+//! Tracks which entry of s_task_tcbs each thread is in
+MEMFAULT_TASK_REGISTRY_DEFINE(s_task_registry, s_task_tcbs);
 
-  return false;
-}
+//! Threads can be created and aborted concurrently, and the registry does no
+//! locking of its own
+static struct k_spinlock s_task_registry_lock;
 
 // We intercept calls to arch_new_thread() so we can track when new tasks
 // are created
@@ -60,11 +58,17 @@ void __real_arch_new_thread(struct k_thread *thread, k_thread_stack_t *stack, ch
 
 void __wrap_arch_new_thread(struct k_thread *thread, k_thread_stack_t *stack, char *stack_ptr,
                             k_thread_entry_t entry, void *p1, void *p2, void *p3) {
+  k_spinlock_key_t key = k_spin_lock(&s_task_registry_lock);
+#if defined(CONFIG_MEMFAULT_COREDUMP_COMPUTE_THREAD_STACK_USAGE)
   size_t idx = 0;
-  const bool slot_found = prv_find_slot(&idx, EMPTY_SLOT);
-  if (slot_found) {
-    s_task_tcbs[idx] = thread;
+  if (memfault_task_registry_add(&s_task_registry, thread, &idx)) {
+    // Don't start the new thread's stack scan from the previous thread's watermark
+    s_memfault_task_watermarks_v2[idx].bytes_unused = 0;
   }
+#else
+  memfault_task_registry_add(&s_task_registry, thread, NULL);
+#endif
+  k_spin_unlock(&s_task_registry_lock, key);
 
   __real_arch_new_thread(thread, stack, stack_ptr, entry, p1, p2, p3);
 }
@@ -73,11 +77,9 @@ void __wrap_z_thread_abort(struct k_thread *thread);
 void __real_z_thread_abort(struct k_thread *thread);
 
 void __wrap_z_thread_abort(struct k_thread *thread) {
-  size_t idx = 0;
-  const bool slot_found = prv_find_slot(&idx, thread);
-  if (slot_found) {
-    s_task_tcbs[idx] = EMPTY_SLOT;
-  }
+  k_spinlock_key_t key = k_spin_lock(&s_task_registry_lock);
+  memfault_task_registry_remove(&s_task_registry, thread, NULL);
+  k_spin_unlock(&s_task_registry_lock, key);
 
   __real_z_thread_abort(thread);
 }
@@ -110,7 +112,12 @@ MEMFAULT_WEAK size_t memfault_platform_sanitize_address_range(void *start_addr,
 #if defined(CONFIG_MEMFAULT_COREDUMP_COMPUTE_THREAD_STACK_USAGE)
 //! Compute the high watermark of a task's stack. This is the amount of stack
 //! that has been written to since the task was created.
-static ssize_t prv_stack_bytes_unused(uintptr_t stack_start, size_t stack_size) {
+//!
+//! A watermark computed previously for the same stack (cached_bytes_unused, 0
+//! if there is none) lets the scan start from that watermark instead of from
+//! the bottom of the stack.
+static ssize_t prv_stack_bytes_unused(uintptr_t stack_start, size_t stack_size,
+                                      uint32_t cached_bytes_unused) {
   // First confirm that it's safe to traverse the stack region. If the TCB has
   // been corrupted, we don't want to trigger a memory error.
   if (memfault_platform_sanitize_address_range((void *)stack_start, stack_size) != stack_size) {
@@ -129,16 +136,19 @@ static ssize_t prv_stack_bytes_unused(uintptr_t stack_start, size_t stack_size)
   // So we're not going to correctly mark stack utilization in this case.
 
   // Stack sentinel pattern takes the top 4 bytes of the stack, so skip over that
-  const uint8_t *stack_max = (const uint8_t *)stack_start + sizeof(STACK_SENTINEL);
+  const size_t skip = sizeof(STACK_SENTINEL);
   #else
-  const uint8_t *stack_max = (const uint8_t *)stack_start;
+  const size_t skip = 0;
   #endif
-  const uint8_t *const stack_bottom = (const uint8_t *const)(stack_start + stack_size);
 
-  for (; (stack_max < stack_bottom) && (*stack_max == 0xAA); stack_max++) { }
+  // MEMFAULT_THREAD_STACK_0_BYTES_UNUSED is larger than any stack, so it's ignored like a missing
+  // cached value
+  const size_t cached = (cached_bytes_unused > skip) ? (cached_bytes_unused - skip) : 0;
+  const size_t painted_bytes = memfault_stack_watermark_bytes_unused(
+    (const void *)(stack_start + skip), stack_size - skip, 0xAAAAAAAA, cached);
+  const ssize_t bytes_unused = (ssize_t)(skip + painted_bytes);
 
   // Return the "bytes unused" count for the stack
-  const ssize_t bytes_unused = (uintptr_t)stack_max - stack_start;
   // In the case of a fully exhausted stack, return -1. This is converted back
   // to 0 in the backend. We can't use 0 here, because that's also the
   // initialization value of the s_memfault_task_watermarks_v2 data structure, and if
@@ -151,6 +161,36 @@ static ssize_t prv_stack_bytes_unused(uintptr_t stack_start, size_t stack_size)
     return bytes_unused;
   }
 }
+
+void memfault_zephyr_update_task_watermarks(void) {
+  for (size_t i = 0; i < MEMFAULT_ARRAY_SIZE(s_task_tcbs); i++) {
+    // Threads can be created and aborted while the slots are walked, so each
+    // slot is read under the lock. The stack is scanned without holding it.
+    k_spinlock_key_t key = k_spin_lock(&s_task_registry_lock);
+    struct k_thread *thread = s_task_tcbs[i];
+    const bool valid =
+      (thread != EMPTY_SLOT) &&
+      (memfault_platform_sanitize_address_range(thread, sizeof(*thread)) == sizeof(*thread));
+    const uintptr_t stack_start = valid ? thread->stack_info.start : 0;
+    const size_t stack_size = valid ? thread->stack_info.size : 0;
+    k_spin_unlock(&s_task_registry_lock, key);
+    if (!valid) {
+      continue;
+    }
+
+    // A full scan, so the cached watermark doesn't carry over anything a scan
+    // starting from the previous watermark could have missed
+    const ssize_t bytes_unused = prv_stack_bytes_unused(stack_start, stack_size, 0);
+
+    // A thread which took over the slot during the scan has had the watermark
+    // reset, so it's only stored if the slot still holds the scanned thread
+    key = k_spin_lock(&s_task_registry_lock);
+    if (s_task_tcbs[i] == thread) {
+      s_memfault_task_watermarks_v2[i].bytes_unused = bytes_unused;
+    }
+    k_spin_unlock(&s_task_registry_lock, key);
+  }
+}
 #endif  // defined(CONFIG_MEMFAULT_COREDUMP_COMPUTE_THREAD_STACK_USAGE)
 
 size_t memfault_zephyr_get_task_regions(sMfltCoredumpRegion *regions, size_t num_regions) {
@@ -179,7 +219,8 @@ size_t memfault_zephyr_get_task_regions(sMfltCoredumpRegion *regions, size_t num
     const size_t tcb_size = memfault_platform_sanitize_address_range(thread, sizeof(*thread));
     if (tcb_size == 0) {
       // An invalid address, scrub the TCB from the list so we don't try to dereference
-      // it when grabbing stacks below and move on.
+      // it when grabbing stacks below and move on. The slot is cleared directly since a
+      // corrupted entry won't be found in the task registry.
       s_task_tcbs[i] = EMPTY_SLOT;
       continue;
     }
@@ -196,6 +237,15 @@ size_t memfault_zephyr_get_task_regions(sMfltCoredumpRegion *regions, size_t num
       continue;
     }
 
+#if defined(CONFIG_MEMFAULT_COREDUMP_COMPUTE_THREAD_STACK_USAGE)
+    // The active thread is the one which crashed, and its stack usage matters most when it
+    // overflowed. A scan starting from the cached watermark can stop at an unwritten local
+    // buffer below it, so this stack is always scanned in full.
+    const bool is_current = (uintptr_t)_kernel.cpus[0].current == (uintptr_t)thread;
+    const uint32_t cached_bytes_unused =
+      is_current ? 0 : s_memfault_task_watermarks_v2[i].bytes_unused;
+#endif  // defined(CONFIG_MEMFAULT_COREDUMP_COMPUTE_THREAD_STACK_USAGE)
+
     // When capturing full thread stacks, also include the active thread. Note
     // that the active stack may already be partially collected in a previous
     // region, so we might be duplicating it here; it's a little wasteful, but
@@ -207,8 +257,8 @@ size_t memfault_zephyr_get_task_regions(sMfltCoredumpRegion *regions, size_t num
       // is _not_ running so we skip collecting it. just update the watermark
       // for the thread
   #if defined(CONFIG_MEMFAULT_COREDUMP_COMPUTE_THREAD_STACK_USAGE)
-      s_memfault_task_watermarks_v2[i].bytes_unused =
-        prv_stack_bytes_unused(thread->stack_info.start, thread->stack_info.size);
+      s_memfault_task_watermarks_v2[i].bytes_unused = prv_stack_bytes_unused(
+        thread->stack_info.start, thread->stack_info.size, cached_bytes_unused);
   #endif  // defined(CONFIG_MEMFAULT_COREDUMP_COMPUTE_THREAD_STACK_USAGE)
       continue;
     }
@@ -263,8 +313,8 @@ size_t memfault_zephyr_get_task_regions(sMfltCoredumpRegion *regions, size_t num
 
 #if defined(CONFIG_MEMFAULT_COREDUMP_COMPUTE_THREAD_STACK_USAGE)
     // compute high watermarks for each task
-    s_memfault_task_watermarks_v2[i].bytes_unused =
-      prv_stack_bytes_unused(thread->stack_info.start, thread->stack_info.size);
+    s_memfault_task_watermarks_v2[i].bytes_unused = prv_stack_bytes_unused(
+      thread->stack_info.start, thread->stack_info.size, cached_bytes_unused);
 #endif  // defined(CONFIG_MEMFAULT_COREDUMP_COMPUTE_THREAD_STACK_USAGE)
 
     regions[region_idx] = MEMFAULT_COREDUMP_MEMORY_REGION_INIT(sp, stack_size_to_collect);
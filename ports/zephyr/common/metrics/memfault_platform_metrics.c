@@ -19,6 +19,7 @@
 #include "memfault/core/debug_log.h"
 #include "memfault/metrics/metrics.h"
 #include "memfault/metrics/platform/timer.h"
+#include "memfault/ports/zephyr/coredump.h"
 #include "memfault/ports/zephyr/version.h"
 #include "memfault/ports/zephyr/thread_metrics.h"
 
@@ -292,6 +293,10 @@ void memfault_metrics_heartbeat_collect_sdk_data(void) {
   memfault_zephyr_thread_metrics_record();
 #endif
 
+#if defined(CONFIG_MEMFAULT_COREDUMP_COMPUTE_THREAD_STACK_USAGE)
+  memfault_zephyr_update_task_watermarks();
+#endif
+
 #if defined(CONFIG_MEMFAULT_METRICS_BLUETOOTH)
   memfault_bluetooth_metrics_heartbeat_update();
 #endif
@@ -64,6 +64,10 @@ extern "C" {
   #define MEMFAULT_COMPACT_LOG_ENABLE 1
 #endif
 
+#if defined(CONFIG_MEMFAULT_LOGGING_ISR_STAGING)
+  #define MEMFAULT_LOG_ISR_STAGING_ENABLED 1
+#endif
+
 #if defined(CONFIG_MEMFAULT_METRICS_SYNC_SUCCESS)
   #define MEMFAULT_METRICS_SYNC_SUCCESS 1
 #endif
@@ -112,6 +116,10 @@ extern "C" {
   #define MEMFAULT_MPU_REGIONS_TO_COLLECT CONFIG_MEMFAULT_COREDUMP_MPU_REGIONS_TO_COLLECT
 #endif
 
+#if defined(CONFIG_MEMFAULT_COREDUMP_TASK_REGISTRY_CONSTANT_TIME)
+  #define MEMFAULT_TASK_REGISTRY_CONSTANT_TIME 1
+#endif
+
 #if defined(CONFIG_MEMFAULT_CRC16_BUILTIN)
   #define MEMFAULT_CRC16_BUILTIN 1
 #else
@@ -55,6 +55,14 @@ size_t memfault_zephyr_coredump_get_regions(const sCoredumpCrashInfo *crash_info
 //!  be <= num_regions
 size_t memfault_zephyr_get_task_regions(sMfltCoredumpRegion *regions, size_t num_regions);
 
+//! Scan the stack of every tracked thread and cache its high watermark. When a coredump is
+//! captured, memfault_zephyr_get_task_regions() starts each thread's scan from the cached
+//! watermark instead of from the bottom of the stack, which shortens the time spent in the fault
+//! handler. The stack of the thread which crashed is always scanned in full.
+//!
+//! This is called at each heartbeat when CONFIG_MEMFAULT_METRICS is enabled.
+void memfault_zephyr_update_task_watermarks(void);
+
 //! Helper to collect regions of RAM used for BSS variables
 //!
 //! @return The number of entries that were populated in the 'regions' argument. Will always
@@ -294,6 +294,11 @@ snapshots['test_eclipse_project_patcher 1'] = {
 \t\t<locationURI>PARENT-3-PROJECT_LOC/components/core/src/memfault_log_data_source.c</locationURI>
 \t</link>
 \t<link>
+\t\t<name>memfault_components/memfault_nv_event_log.c</name>
+\t\t<type>1</type>
+\t\t<locationURI>PARENT-3-PROJECT_LOC/components/core/src/memfault_nv_event_log.c</locationURI>
+\t</link>
+\t<link>
 \t\t<name>memfault_components/memfault_ram_reboot_info_tracking.c</name>
 \t\t<type>1</type>
 \t\t<locationURI>PARENT-3-PROJECT_LOC/components/core/src/memfault_ram_reboot_info_tracking.c</locationURI>
@@ -444,11 +449,21 @@ snapshots['test_eclipse_project_patcher 1'] = {
 \t\t<locationURI>PARENT-3-PROJECT_LOC/components/panics/src/memfault_fault_handling_riscv.c</locationURI>
 \t</link>
 \t<link>
+\t\t<name>memfault_components/memfault_stack_watermark.c</name>
+\t\t<type>1</type>
+\t\t<locationURI>PARENT-3-PROJECT_LOC/components/panics/src/memfault_stack_watermark.c</locationURI>
+\t</link>
+\t<link>
 \t\t<name>memfault_components/memfault_stdlib_assert.c</name>
 \t\t<type>1</type>
 \t\t<locationURI>PARENT-3-PROJECT_LOC/components/panics/src/memfault_stdlib_assert.c</locationURI>
 \t</link>
 \t<link>
+\t\t<name>memfault_components/memfault_task_registry.c</name>
+\t\t<type>1</type>
+\t\t<locationURI>PARENT-3-PROJECT_LOC/components/panics/src/memfault_task_registry.c</locationURI>
+\t</link>
+\t<link>
 \t\t<name>memfault_components/memfault_demo_cli_drain_chunks.c</name>
 \t\t<type>1</type>
 \t\t<locationURI>PARENT-3-PROJECT_LOC/components/demo/src/memfault_demo_cli_drain_chunks.c</locationURI>
@@ -794,6 +809,11 @@ snapshots['test_eclipse_project_patcher_nested_port 1'] = {
 \t\t<locationURI>PARENT-3-PROJECT_LOC/components/core/src/memfault_log_data_source.c</locationURI>
 \t</link>
 \t<link>
+\t\t<name>memfault_components/memfault_nv_event_log.c</name>
+\t\t<type>1</type>
+\t\t<locationURI>PARENT-3-PROJECT_LOC/components/core/src/memfault_nv_event_log.c</locationURI>
+\t</link>
+\t<link>
 \t\t<name>memfault_components/memfault_ram_reboot_info_tracking.c</name>
 \t\t<type>1</type>
 \t\t<locationURI>PARENT-3-PROJECT_LOC/components/core/src/memfault_ram_reboot_info_tracking.c</locationURI>
@@ -944,11 +964,21 @@ snapshots['test_eclipse_project_patcher_nested_port 1'] = {
 \t\t<locationURI>PARENT-3-PROJECT_LOC/components/panics/src/memfault_fault_handling_riscv.c</locationURI>
 \t</link>
 \t<link>
+\t\t<name>memfault_components/memfault_stack_watermark.c</name>
+\t\t<type>1</type>
+\t\t<locationURI>PARENT-3-PROJECT_LOC/components/panics/src/memfault_stack_watermark.c</locationURI>
+\t</link>
+\t<link>
 \t\t<name>memfault_components/memfault_stdlib_assert.c</name>
 \t\t<type>1</type>
 \t\t<locationURI>PARENT-3-PROJECT_LOC/components/panics/src/memfault_stdlib_assert.c</locationURI>
 \t</link>
 \t<link>
+\t\t<name>memfault_components/memfault_task_registry.c</name>
+\t\t<type>1</type>
+\t\t<locationURI>PARENT-3-PROJECT_LOC/components/panics/src/memfault_task_registry.c</locationURI>
+\t</link>
+\t<link>
 \t\t<name>memfault_components/memfault_demo_cli_drain_chunks.c</name>
 \t\t<type>1</type>
 \t\t<locationURI>PARENT-3-PROJECT_LOC/components/demo/src/memfault_demo_cli_drain_chunks.c</locationURI>
@@ -1329,6 +1359,11 @@ snapshots['test_eclipse_project_patcher_single_dir_port 1'] = {
 \t\t<locationURI>PARENT-3-PROJECT_LOC/components/core/src/memfault_log_data_source.c</locationURI>
 \t</link>
 \t<link>
+\t\t<name>memfault_components/memfault_nv_event_log.c</name>
+\t\t<type>1</type>
+\t\t<locationURI>PARENT-3-PROJECT_LOC/components/core/src/memfault_nv_event_log.c</locationURI>
+\t</link>
+\t<link>
 \t\t<name>memfault_components/memfault_ram_reboot_info_tracking.c</name>
 \t\t<type>1</type>
 \t\t<locationURI>PARENT-3-PROJECT_LOC/components/core/src/memfault_ram_reboot_info_tracking.c</locationURI>
@@ -1479,11 +1514,21 @@ snapshots['test_eclipse_project_patcher_single_dir_port 1'] = {
 \t\t<locationURI>PARENT-3-PROJECT_LOC/components/panics/src/memfault_fault_handling_riscv.c</locationURI>
 \t</link>
 \t<link>
+\t\t<name>memfault_components/memfault_stack_watermark.c</name>
+\t\t<type>1</type>
+\t\t<locationURI>PARENT-3-PROJECT_LOC/components/panics/src/memfault_stack_watermark.c</locationURI>
+\t</link>
+\t<link>
 \t\t<name>memfault_components/memfault_stdlib_assert.c</name>
 \t\t<type>1</type>
 \t\t<locationURI>PARENT-3-PROJECT_LOC/components/panics/src/memfault_stdlib_assert.c</locationURI>
 \t</link>
 \t<link>
+\t\t<name>memfault_components/memfault_task_registry.c</name>
+\t\t<type>1</type>
+\t\t<locationURI>PARENT-3-PROJECT_LOC/components/panics/src/memfault_task_registry.c</locationURI>
+\t</link>
+\t<link>
 \t\t<name>memfault_components/memfault_demo_cli_drain_chunks.c</name>
 \t\t<type>1</type>
 \t\t<locationURI>PARENT-3-PROJECT_LOC/components/demo/src/memfault_demo_cli_drain_chunks.c</locationURI>
@@ -158,7 +158,9 @@ export CPPUTEST_C_WARNINGFLAGS
 
 export CPPUTEST_LDFLAGS
 
-MEMFAULT_RESULT_DIR=$(BUILD_DIR)/$(COMPONENT_NAME)
+# Tests with a build parameter that can be overridden from the command line (i.e the benchmarks)
+# set MEMFAULT_TEST_VARIANT to its value so each value is built in a directory of its own
+MEMFAULT_RESULT_DIR=$(BUILD_DIR)/$(COMPONENT_NAME)$(MEMFAULT_TEST_VARIANT:%=_%)
 
 export TEST_TARGET=$(MEMFAULT_RESULT_DIR)/$(COMPONENT_NAME)_tests
 export CPPUTEST_OBJS_DIR=$(MEMFAULT_RESULT_DIR)/objs
@@ -0,0 +1,344 @@
+//! @file
+//!
+//! Copyright (c) Memfault, Inc.
+//! See LICENSE for details
+
+#include "fake_memfault_http_loopback_server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "CppUTest/TestHarness.h"
+#include "memfault/core/math.h"
+#include "memfault/http/utils.h"
+
+#define FAKE_SERVER_MAX_REQUESTS 1024
+#define FAKE_SERVER_MAX_PENDING_RESPONSES 64
+#define FAKE_SERVER_POLL_INTERVAL_MS 10
+
+typedef struct {
+  uint64_t due_ms;
+  int http_status;
+} sFakeServerResponse;
+
+static struct {
+  pthread_mutex_t lock;
+  pthread_t thread;
+  volatile bool running;
+  int listen_fd;
+  sFakeHttpLoopbackServerConfig config;
+
+  sFakeHttpLoopbackServerRequest requests[FAKE_SERVER_MAX_REQUESTS];
+  size_t num_requests;
+  size_t num_connections;
+
+  // state of the current connection, only accessed by the server thread
+  int conn_fd;
+  bool conn_closing;
+  sFakeHttpLoopbackServerConfig conn_config;
+  char rx_buf[4096];
+  size_t rx_len;
+  size_t conn_requests;
+  size_t conn_responses;
+  sFakeServerResponse pending[FAKE_SERVER_MAX_PENDING_RESPONSES];
+  size_t pending_head;
+  size_t pending_count;
+} s_server = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static uint64_t prv_now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+static void prv_set_nodelay(int fd) {
+  const int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+static void prv_close_connection(void) {
+  close(s_server.conn_fd);
+  s_server.conn_fd = -1;
+  s_server.pending_count = 0;
+}
+
+static void prv_accept_connection(void) {
+  struct pollfd pfd = { .fd = s_server.listen_fd, .events = POLLIN };
+  if (poll(&pfd, 1, FAKE_SERVER_POLL_INTERVAL_MS) <= 0) {
+    return;
+  }
+  const int fd = accept(s_server.listen_fd, NULL, NULL);
+  if (fd < 0) {
+    return;
+  }
+  prv_set_nodelay(fd);
+
+  pthread_mutex_lock(&s_server.lock);
+  s_server.conn_config = s_server.config;
+  s_server.num_connections++;
+  pthread_mutex_unlock(&s_server.lock);
+
+  s_server.conn_fd = fd;
+  s_server.conn_closing = false;
+  s_server.rx_len = 0;
+  s_server.conn_requests = 0;
+  s_server.conn_responses = 0;
+  s_server.pending_head = 0;
+  s_server.pending_count = 0;
+}
+
+//! Records the request received and schedules the response to it
+static void prv_handle_request(const char *body, size_t body_len) {
+  // this runs on the server thread, so failures can't be reported with CHECK(). Requests which
+  // don't fit are still counted, which the tests catch when reading them back.
+  pthread_mutex_lock(&s_server.lock);
+  const size_t request_num = ++s_server.num_requests;
+  if (request_num <= FAKE_SERVER_MAX_REQUESTS) {
+    sFakeHttpLoopbackServerRequest *request = &s_server.requests[request_num - 1];
+    const size_t copy_len = MEMFAULT_MIN(body_len, sizeof(request->body) - 1);
+    memcpy(request->body, body, copy_len);
+    request->body[copy_len] = '\0';
+    request->connection = s_server.num_connections - 1;
+  }
+  pthread_mutex_unlock(&s_server.lock);
+
+  s_server.conn_requests++;
+  const sFakeHttpLoopbackServerConfig *config = &s_server.conn_config;
+  if ((config->close_after_requests != 0) &&
+      (s_server.conn_requests > config->acks_before_close)) {
+    return;
+  }
+
+  if (s_server.pending_count == FAKE_SERVER_MAX_PENDING_RESPONSES) {
+    return;
+  }
+  const size_t idx =
+    (s_server.pending_head + s_server.pending_count) % FAKE_SERVER_MAX_PENDING_RESPONSES;
+  s_server.pending[idx] = (sFakeServerResponse){
+    .due_ms = prv_now_ms() + config->rtt_ms,
+    .http_status = (request_num == config->reject_request) ? 500 : 202,
+  };
+  s_server.pending_count++;
+}
+
+//! Parses every complete request in the receive buffer, closing the connection if a request is
+//! malformed
+static void prv_parse_requests(void) {
+  while (1) {
+    const char *hdr_end =
+      (const char *)memmem(s_server.rx_buf, s_server.rx_len, "\r\n\r\n", strlen("\r\n\r\n"));
+    if (hdr_end == NULL) {
+      return;
+    }
+    const size_t hdr_len = (size_t)(hdr_end - s_server.rx_buf) + strlen("\r\n\r\n");
+
+    const char *content_length_field = "Content-Length:";
+    const char *content_length = (const char *)memmem(
+      s_server.rx_buf, hdr_len, content_length_field, strlen(content_length_field));
+    if (content_length == NULL) {
+      prv_close_connection();
+      return;
+    }
+    const size_t body_len = strtoul(content_length + strlen(content_length_field), NULL, 10);
+    const size_t request_len = hdr_len + body_len;
+    if (request_len > sizeof(s_server.rx_buf)) {
+      prv_close_connection();
+      return;
+    }
+    if (s_server.rx_len < request_len) {
+      return;
+    }
+
+    prv_handle_request(&s_server.rx_buf[hdr_len], body_len);
+    memmove(s_server.rx_buf, &s_server.rx_buf[request_len], s_server.rx_len - request_len);
+    s_server.rx_len -= request_len;
+  }
+}
+
+static void prv_send_due_responses(void) {
+  const uint64_t now = prv_now_ms();
+  while ((s_server.pending_count != 0) && (s_server.pending[s_server.pending_head].due_ms <= now)) {
+    const sFakeServerResponse *response = &s_server.pending[s_server.pending_head];
+    char buf[128];
+    const int len = snprintf(buf, sizeof(buf), "HTTP/1.1 %d %s\r\nContent-Length: 0\r\n\r\n",
+                             response->http_status,
+                             (response->http_status == 202) ? "Accepted" : "Internal Server Error");
+    if (send(s_server.conn_fd, buf, (size_t)len, MSG_NOSIGNAL) != len) {
+      prv_close_connection();
+      return;
+    }
+    s_server.pending_head = (s_server.pending_head + 1) % FAKE_SERVER_MAX_PENDING_RESPONSES;
+    s_server.pending_count--;
+    s_server.conn_responses++;
+  }
+}
+
+static void prv_serve_connection(void) {
+  int timeout_ms = FAKE_SERVER_POLL_INTERVAL_MS;
+  if (s_server.pending_count != 0) {
+    const uint64_t due_ms = s_server.pending[s_server.pending_head].due_ms;
+    const uint64_t now = prv_now_ms();
+    timeout_ms = (due_ms <= now) ? 0 : (int)MEMFAULT_MIN(due_ms - now, (uint64_t)timeout_ms);
+  }
+
+  struct pollfd pfd = { .fd = s_server.conn_fd, .events = POLLIN };
+  if (poll(&pfd, 1, timeout_ms) > 0) {
+    const ssize_t rv = recv(s_server.conn_fd, &s_server.rx_buf[s_server.rx_len],
+                            sizeof(s_server.rx_buf) - s_server.rx_len, 0);
+    if (rv <= 0) {
+      prv_close_connection();
+      return;
+    }
+    if (s_server.conn_closing) {
+      // requests are discarded until the client closes the connection as well
+      return;
+    }
+    s_server.rx_len += (size_t)rv;
+    prv_parse_requests();
+  }
+
+  if ((s_server.conn_fd < 0) || s_server.conn_closing) {
+    return;
+  }
+  prv_send_due_responses();
+
+  // The connection is shut down instead of closed, so the responses already sent are not
+  // discarded by a reset when more requests arrive
+  const sFakeHttpLoopbackServerConfig *config = &s_server.conn_config;
+  if ((s_server.conn_fd >= 0) && (config->close_after_requests != 0) &&
+      (s_server.conn_requests >= config->close_after_requests) &&
+      (s_server.conn_responses >= config->acks_before_close)) {
+    shutdown(s_server.conn_fd, SHUT_WR);
+    s_server.conn_closing = true;
+  }
+}
+
+static void *prv_server_thread(void *arg) {
+  (void)arg;
+  while (s_server.running) {
+    if (s_server.conn_fd < 0) {
+      prv_accept_connection();
+    } else {
+      prv_serve_connection();
+    }
+  }
+  return NULL;
+}
+
+uint16_t fake_http_loopback_server_start(const sFakeHttpLoopbackServerConfig *config) {
+  s_server.config = *config;
+  s_server.num_requests = 0;
+  s_server.num_connections = 0;
+  s_server.conn_fd = -1;
+
+  s_server.listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+  CHECK(s_server.listen_fd >= 0);
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = 0;
+  CHECK(bind(s_server.listen_fd, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+  CHECK(listen(s_server.listen_fd, 1) == 0);
+  socklen_t addr_len = sizeof(addr);
+  CHECK(getsockname(s_server.listen_fd, (struct sockaddr *)&addr, &addr_len) == 0);
+
+  s_server.running = true;
+  CHECK(pthread_create(&s_server.thread, NULL, prv_server_thread, NULL) == 0);
+  return ntohs(addr.sin_port);
+}
+
+void fake_http_loopback_server_stop(void) {
+  s_server.running = false;
+  pthread_join(s_server.thread, NULL);
+  if (s_server.conn_fd >= 0) {
+    prv_close_connection();
+  }
+  close(s_server.listen_fd);
+}
+
+void fake_http_loopback_server_set_config(const sFakeHttpLoopbackServerConfig *config) {
+  pthread_mutex_lock(&s_server.lock);
+  s_server.config = *config;
+  pthread_mutex_unlock(&s_server.lock);
+}
+
+size_t fake_http_loopback_server_num_requests(void) {
+  pthread_mutex_lock(&s_server.lock);
+  const size_t num_requests = s_server.num_requests;
+  pthread_mutex_unlock(&s_server.lock);
+  return num_requests;
+}
+
+sFakeHttpLoopbackServerRequest fake_http_loopback_server_get_request(size_t idx) {
+  pthread_mutex_lock(&s_server.lock);
+  CHECK(idx < MEMFAULT_MIN(s_server.num_requests, FAKE_SERVER_MAX_REQUESTS));
+  const sFakeHttpLoopbackServerRequest request = s_server.requests[idx];
+  pthread_mutex_unlock(&s_server.lock);
+  return request;
+}
+
+void fake_http_loopback_client_connect(sFakeHttpLoopbackClient *client, uint16_t port) {
+  *client = (sFakeHttpLoopbackClient){ .sock_fd = socket(AF_INET, SOCK_STREAM, 0) };
+  CHECK(client->sock_fd >= 0);
+  prv_set_nodelay(client->sock_fd);
+
+  // a response which never arrives fails the upload instead of hanging the test
+  const struct timeval timeout = { .tv_sec = 5, .tv_usec = 0 };
+  setsockopt(client->sock_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(port);
+  CHECK(connect(client->sock_fd, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+}
+
+void fake_http_loopback_client_close(sFakeHttpLoopbackClient *client) {
+  close(client->sock_fd);
+  client->sock_fd = -1;
+}
+
+bool fake_http_loopback_client_send(const void *data, size_t data_len, void *ctx) {
+  sFakeHttpLoopbackClient *client = (sFakeHttpLoopbackClient *)ctx;
+  const uint8_t *buf = (const uint8_t *)data;
+  while (data_len != 0) {
+    const ssize_t rv = send(client->sock_fd, buf, data_len, MSG_NOSIGNAL);
+    if (rv <= 0) {
+      return false;
+    }
+    buf += rv;
+    data_len -= (size_t)rv;
+  }
+  return true;
+}
+
+int fake_http_loopback_client_wait_for_response(void *ctx) {
+  sFakeHttpLoopbackClient *client = (sFakeHttpLoopbackClient *)ctx;
+  sMemfaultHttpResponseContext response = {};
+  while (1) {
+    if (client->rx_offset == client->rx_len) {
+      const ssize_t rv = recv(client->sock_fd, client->rx_buf, sizeof(client->rx_buf), 0);
+      if (rv <= 0) {
+        return -1;
+      }
+      client->rx_len = (size_t)rv;
+      client->rx_offset = 0;
+    }
+
+    const bool done = memfault_http_parse_response(
+      &response, &client->rx_buf[client->rx_offset], client->rx_len - client->rx_offset);
+    client->rx_offset += (size_t)response.data_bytes_processed;
+    if (done) {
+      return (response.parse_error == kMfltHttpParseStatus_Ok) ? response.http_status_code : -1;
+    }
+  }
+}
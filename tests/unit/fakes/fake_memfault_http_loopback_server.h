@@ -0,0 +1,84 @@
+#pragma once
+
+//! @file
+//!
+//! Copyright (c) Memfault, Inc.
+//! See LICENSE for details
+//!
+//! @brief
+//! A stand-in for the Memfault chunks endpoint listening on a loopback TCP socket. It accepts
+//! pipelined chunk POSTs and answers them in order, each one a round trip time after it was
+//! received, and can drop the connection or reject a POST to test how a client recovers.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  //! Delay between receiving a request and sending the response to it
+  uint32_t rtt_ms;
+  //! Close a connection, without responding to the remaining requests, once this many requests
+  //! have been received on it. 0 never closes the connection.
+  size_t close_after_requests;
+  //! Number of the requests received on a connection which are responded to before it is closed
+  //! by close_after_requests
+  size_t acks_before_close;
+  //! Request, counting from 1 across all connections, answered with "500 Internal Server Error"
+  //! instead of "202 Accepted". 0 accepts every request.
+  size_t reject_request;
+} sFakeHttpLoopbackServerConfig;
+
+//! A request received by the server
+typedef struct {
+  //! The body of the POST, NULL terminated
+  char body[64];
+  //! The connection the request was received on, counting from 0
+  size_t connection;
+} sFakeHttpLoopbackServerRequest;
+
+//! Starts the server on a thread of its own
+//!
+//! @return the port the server listens on
+uint16_t fake_http_loopback_server_start(const sFakeHttpLoopbackServerConfig *config);
+
+//! Stops the server, closing every socket
+void fake_http_loopback_server_stop(void);
+
+//! Changes the config used for the connections accepted from now on
+void fake_http_loopback_server_set_config(const sFakeHttpLoopbackServerConfig *config);
+
+//! @return the number of requests received so far
+size_t fake_http_loopback_server_num_requests(void);
+
+//! @return the request received in position idx, counting from 0
+sFakeHttpLoopbackServerRequest fake_http_loopback_server_get_request(size_t idx);
+
+//! A client connection to the server
+typedef struct {
+  int sock_fd;
+  char rx_buf[32];
+  size_t rx_len;
+  size_t rx_offset;
+} sFakeHttpLoopbackClient;
+
+//! Connects client to the server listening on port
+void fake_http_loopback_client_connect(sFakeHttpLoopbackClient *client, uint16_t port);
+
+void fake_http_loopback_client_close(sFakeHttpLoopbackClient *client);
+
+//! Send callback (MfltHttpClientSendCb) writing to the sFakeHttpLoopbackClient passed as ctx
+bool fake_http_loopback_client_send(const void *data, size_t data_len, void *ctx);
+
+//! Response callback (MfltHttpPipelineResponseCb) reading the next response on the
+//! sFakeHttpLoopbackClient passed as ctx
+//!
+//! @return the HTTP status code of the response, or -1 if it could not be received
+int fake_http_loopback_client_wait_for_response(void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
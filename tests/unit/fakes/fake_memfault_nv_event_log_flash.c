@@ -0,0 +1,104 @@
+//! @file
+//!
+//! Copyright (c) Memfault, Inc.
+//! See LICENSE for details
+//! RAM backed NOR flash simulator: erases set bytes to 0xff and writes can only clear bits
+
+#include "fake_memfault_nv_event_log_flash.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "memfault/core/platform/nv_event_log.h"
+
+#define FAKE_NV_EVENT_LOG_MAX_SECTORS 64
+
+typedef struct FakeMfltNvEventLogFlash {
+  uint8_t *buf;
+  size_t size;
+  size_t sector_size;
+  int power_loss_after;
+  bool powered_off;
+  uint32_t write_count;
+  uint32_t erase_count[FAKE_NV_EVENT_LOG_MAX_SECTORS];
+} sFakeMfltNvEventLogFlash;
+
+static sFakeMfltNvEventLogFlash s_flash;
+
+void fake_memfault_nv_event_log_flash_setup(void *storage_buf, size_t storage_size,
+                                            size_t sector_size) {
+  assert((sector_size == 0) || ((storage_size / sector_size) <= FAKE_NV_EVENT_LOG_MAX_SECTORS));
+  s_flash = (sFakeMfltNvEventLogFlash){
+    .buf = (uint8_t *)storage_buf,
+    .size = storage_size,
+    .sector_size = sector_size,
+    .power_loss_after = -1,
+  };
+}
+
+void fake_memfault_nv_event_log_flash_erase_all(void) {
+  memset(s_flash.buf, 0xff, s_flash.size);
+}
+
+void fake_memfault_nv_event_log_flash_set_power_loss_after(int num_bytes) {
+  s_flash.power_loss_after = num_bytes;
+  s_flash.powered_off = false;
+}
+
+uint32_t fake_memfault_nv_event_log_flash_get_erase_count(size_t sector) {
+  return s_flash.erase_count[sector];
+}
+
+uint32_t fake_memfault_nv_event_log_flash_get_write_count(void) {
+  return s_flash.write_count;
+}
+
+void memfault_platform_nv_event_log_get_info(sMfltNvEventLogStorageInfo *info) {
+  *info = (sMfltNvEventLogStorageInfo){
+    .size = s_flash.size,
+    .sector_size = s_flash.sector_size,
+  };
+}
+
+bool memfault_platform_nv_event_log_read(uint32_t offset, void *buf, size_t buf_len) {
+  assert(s_flash.buf != NULL);
+  if ((offset + buf_len) > s_flash.size) {
+    return false;
+  }
+  memcpy(buf, &s_flash.buf[offset], buf_len);
+  return true;
+}
+
+bool memfault_platform_nv_event_log_write(uint32_t offset, const void *buf, size_t buf_len) {
+  assert(s_flash.buf != NULL);
+  if (s_flash.powered_off || ((offset + buf_len) > s_flash.size)) {
+    return false;
+  }
+  s_flash.write_count++;
+
+  const uint8_t *data = (const uint8_t *)buf;
+  for (size_t i = 0; i < buf_len; i++) {
+    if (s_flash.power_loss_after == 0) {
+      s_flash.powered_off = true;
+      return false;
+    }
+    if (s_flash.power_loss_after > 0) {
+      s_flash.power_loss_after--;
+    }
+    // NOR flash can only clear bits
+    s_flash.buf[offset + i] &= data[i];
+  }
+  return true;
+}
+
+bool memfault_platform_nv_event_log_erase(uint32_t offset, size_t erase_size) {
+  assert(s_flash.buf != NULL);
+  assert((offset % s_flash.sector_size) == 0);
+  assert(erase_size == s_flash.sector_size);
+  if (s_flash.powered_off || ((offset + erase_size) > s_flash.size)) {
+    return false;
+  }
+  s_flash.erase_count[offset / s_flash.sector_size]++;
+  memset(&s_flash.buf[offset], 0xff, erase_size);
+  return true;
+}
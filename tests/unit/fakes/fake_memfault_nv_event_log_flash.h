@@ -0,0 +1,37 @@
+#pragma once
+
+//! @file
+//!
+//! Copyright (c) Memfault, Inc.
+//! See LICENSE for details
+//! RAM backed NOR flash simulator implementing the dependencies in
+//! memfault/core/platform/nv_event_log.h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! Sets up the simulated flash. The contents are left untouched so the flash "survives" a
+//! reboot, call fake_memfault_nv_event_log_flash_erase_all() to start from erased flash.
+void fake_memfault_nv_event_log_flash_setup(void *storage_buf, size_t storage_size,
+                                            size_t sector_size);
+
+void fake_memfault_nv_event_log_flash_erase_all(void);
+
+//! Simulates losing power after num_bytes more bytes have been programmed: the write in progress
+//! is torn and all writes and erases fail from then on. Pass -1 to disable.
+void fake_memfault_nv_event_log_flash_set_power_loss_after(int num_bytes);
+
+//! Number of times each sector has been erased
+uint32_t fake_memfault_nv_event_log_flash_get_erase_count(size_t sector);
+
+//! Number of calls to memfault_platform_nv_event_log_write()
+uint32_t fake_memfault_nv_event_log_flash_get_write_count(void);
+
+#ifdef __cplusplus
+}
+#endif
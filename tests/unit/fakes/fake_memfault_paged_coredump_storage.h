@@ -0,0 +1,38 @@
+//! @file
+//!
+//! Copyright (c) Memfault, Inc.
+//! See LICENSE for details
+//!
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MEMFAULT_PAGED_STORAGE_MAX_SIZE (256 * 1024)
+extern uint8_t g_paged_storage[MEMFAULT_PAGED_STORAGE_MAX_SIZE];
+
+//! Erases the simulated flash and resets the paged writer and all statistics
+void fake_paged_coredump_storage_reset(size_t size);
+
+//! When set, memfault_platform_coredump_storage_page_write_start() blocks until the page has been
+//! programmed instead of returning once the program has been started
+void fake_paged_coredump_storage_set_blocking(bool blocking);
+
+void fake_paged_coredump_storage_inject_write_failure(void);
+
+bool fake_paged_coredump_storage_write_in_flight(void);
+uint32_t fake_paged_coredump_storage_get_num_programs(void);
+
+//! The time (in ns) of the simulated clock, which advances with the host clock and whenever the
+//! writer has to wait on the simulated flash
+uint64_t fake_paged_coredump_storage_get_time_ns(void);
+
+#ifdef __cplusplus
+}
+#endif
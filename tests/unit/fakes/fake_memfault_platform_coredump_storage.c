@@ -15,6 +15,7 @@ typedef struct FakeMfltStorage {
   uint8_t *buf;
   size_t size;
   size_t sector_size;
+  size_t erase_count;
 } sFakeMfltStorage;
 
 static sFakeMfltStorage s_fake_mflt_storage_ctx;
@@ -35,6 +36,10 @@ void fake_memfault_platform_coredump_storage_setup(void *storage_buf, size_t sto
   };
 }
 
+size_t fake_memfault_platform_coredump_storage_get_erase_count(void) {
+  return s_fake_mflt_storage_ctx.erase_count;
+}
+
 bool fake_memfault_platform_coredump_storage_read(uint32_t offset, void *data, size_t read_len) {
   assert(s_fake_mflt_storage_ctx.buf != NULL);
   if ((offset + read_len) > s_fake_mflt_storage_ctx.size) {
@@ -62,7 +67,8 @@ bool memfault_platform_coredump_storage_erase(uint32_t offset, size_t erase_size
   assert((erase_size % sector_size) == 0);
   assert((offset % sector_size) == 0);
 
-  for (size_t i = offset; i < erase_size; i += sector_size) {
+  s_fake_mflt_storage_ctx.erase_count++;
+  for (size_t i = 0; i < erase_size; i += sector_size) {
     uint8_t erase_pattern[sector_size];
     memset(erase_pattern, 0xff, sizeof(erase_pattern));
     if (!memfault_platform_coredump_storage_write(i + offset, erase_pattern,
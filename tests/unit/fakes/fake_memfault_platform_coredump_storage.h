@@ -14,3 +14,6 @@ void fake_memfault_platform_coredump_storage_setup(void *storage_buf, size_t sto
                                                    size_t sector_size);
 
 bool fake_memfault_platform_coredump_storage_read(uint32_t offset, void *buf, size_t buf_len);
+
+//! Number of calls to memfault_platform_coredump_storage_erase() since the last setup
+size_t fake_memfault_platform_coredump_storage_get_erase_count(void);
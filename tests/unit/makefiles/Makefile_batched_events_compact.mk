@@ -0,0 +1,18 @@
+SRC_FILES = \
+  $(MFLT_COMPONENTS_DIR)/core/src/memfault_batched_events.c
+
+TEST_SRC_FILES = \
+  $(MFLT_COMPONENTS_DIR)/core/src/memfault_serializer_helper.c \
+  $(MFLT_COMPONENTS_DIR)/util/src/memfault_minimal_cbor.c \
+  $(MFLT_TEST_FAKE_DIR)/fake_memfault_build_id.c \
+  $(MFLT_TEST_FAKE_DIR)/fake_memfault_platform_debug_log.c \
+  $(MFLT_TEST_FAKE_DIR)/fake_memfault_platform_get_device_info.c \
+  $(MFLT_TEST_FAKE_DIR)/fake_memfault_platform_time.c \
+  $(MFLT_TEST_FAKE_DIR)/fake_memfault_sdk_assert.c \
+  $(MFLT_TEST_STUB_DIR)/stub_memfault_log_save.c \
+  $(MFLT_TEST_SRC_DIR)/test_memfault_batched_events.cpp
+
+CPPUTEST_CPPFLAGS += -DMEMFAULT_EVENT_STORAGE_READ_BATCHING_ENABLED=1
+CPPUTEST_CPPFLAGS += -DMEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_ENABLED=1
+
+include $(CPPUTEST_MAKFILE_INFRA)
@@ -0,0 +1,18 @@
+SRC_FILES = \
+  $(MFLT_PORTS_DIR)/freertos/src/memfault_freertos_ram_regions.c \
+  $(MFLT_COMPONENTS_DIR)/panics/src/memfault_task_registry.c
+
+MOCK_AND_FAKE_SRC_FILES = \
+  $(MFLT_TEST_FAKE_DIR)/fake_memfault_platform_debug_log.c \
+  $(MFLT_TEST_STUB_DIR)/stub_memfault_log_save.c
+
+TEST_SRC_FILES = \
+  $(MFLT_TEST_SRC_DIR)/test_memfault_freertos_ram_regions.cpp \
+  $(MOCK_AND_FAKE_SRC_FILES)
+
+# These FreeRTOS stubs need to be found before the ones in stub_includes
+CPPUTEST_CPPFLAGS += \
+  -I$(MFLT_TEST_ROOT)/stub_includes/freertos_ram_regions \
+  -DMEMFAULT_COREDUMP_COMPUTE_THREAD_STACK_USAGE=1
+
+include $(CPPUTEST_MAKFILE_INFRA)
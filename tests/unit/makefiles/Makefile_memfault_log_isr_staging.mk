@@ -0,0 +1,20 @@
+SRC_FILES = \
+  $(MFLT_COMPONENTS_DIR)/util/src/memfault_base64.c \
+  $(MFLT_COMPONENTS_DIR)/core/src/memfault_log.c
+
+MOCK_AND_FAKE_SRC_FILES += \
+  $(MFLT_COMPONENTS_DIR)/util/src/memfault_circular_buffer.c \
+  $(MFLT_COMPONENTS_DIR)/util/src/memfault_crc16_ccitt.c \
+  $(MFLT_TEST_FAKE_DIR)/fake_memfault_platform_debug_log.c \
+  $(MFLT_TEST_FAKE_DIR)/fake_memfault_platform_locking.c \
+  $(MFLT_TEST_FAKE_DIR)/fake_memfault_sdk_assert.c
+
+TEST_SRC_FILES = \
+  $(MFLT_TEST_SRC_DIR)/test_memfault_log_isr_staging.cpp \
+  $(MOCK_AND_FAKE_SRC_FILES)
+
+CPPUTEST_CPPFLAGS += \
+  -DMEMFAULT_LOG_TIMESTAMPS_ENABLE=0 \
+  -DMEMFAULT_LOG_ISR_STAGING_ENABLED=1
+
+include $(CPPUTEST_MAKFILE_INFRA)
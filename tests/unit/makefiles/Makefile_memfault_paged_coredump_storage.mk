@@ -0,0 +1,12 @@
+SRC_FILES = \
+  $(MFLT_TEST_SRC_DIR)/test_memfault_paged_coredump_storage_impl.c
+
+MOCK_AND_FAKE_SRC_FILES +=
+
+TEST_SRC_FILES = \
+  $(MOCK_AND_FAKE_SRC_FILES) \
+  $(MFLT_TEST_SRC_DIR)/test_memfault_paged_coredump_storage.cpp
+
+CPPUTEST_CPPFLAGS += -DMEMFAULT_COREDUMP_STORAGE_PAGE_SIZE=64
+
+include $(CPPUTEST_MAKFILE_INFRA)
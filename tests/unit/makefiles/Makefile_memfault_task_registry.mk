@@ -0,0 +1,7 @@
+SRC_FILES = \
+  $(MFLT_COMPONENTS_DIR)/panics/src/memfault_task_registry.c
+
+TEST_SRC_FILES = \
+  $(MFLT_TEST_SRC_DIR)/test_memfault_task_registry.cpp
+
+include $(CPPUTEST_MAKFILE_INFRA)
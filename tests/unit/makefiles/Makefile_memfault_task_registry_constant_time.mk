@@ -0,0 +1,9 @@
+SRC_FILES = \
+  $(MFLT_COMPONENTS_DIR)/panics/src/memfault_task_registry.c
+
+TEST_SRC_FILES = \
+  $(MFLT_TEST_SRC_DIR)/test_memfault_task_registry.cpp
+
+CPPUTEST_CPPFLAGS += -DMEMFAULT_TASK_REGISTRY_CONSTANT_TIME=1
+
+include $(CPPUTEST_MAKFILE_INFRA)
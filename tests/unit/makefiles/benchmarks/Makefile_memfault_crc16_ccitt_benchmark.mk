@@ -0,0 +1,28 @@
+SRC_FILES = \
+  $(MFLT_COMPONENTS_DIR)/util/src/memfault_crc16_ccitt.c
+
+TEST_SRC_FILES = \
+  $(MFLT_TEST_SRC_DIR)/test_memfault_crc16_ccitt_benchmark.cpp
+
+# The CRC16 implementation to benchmark: byte_table, slice_by_4, slice_by_8, nibble_table or
+# bitwise. To compare, run each one, i.e:
+#   make benchmarks TEST_MAKEFILE_FILTER=memfault_crc16_ccitt_benchmark.mk \
+#     CRC16_BENCHMARK_VARIANT=bitwise
+CRC16_BENCHMARK_VARIANT ?= byte_table
+
+CRC16_BENCHMARK_CPPFLAGS_byte_table =
+CRC16_BENCHMARK_CPPFLAGS_slice_by_4 = -DMEMFAULT_CRC16_SLICE_BY=4
+CRC16_BENCHMARK_CPPFLAGS_slice_by_8 = -DMEMFAULT_CRC16_SLICE_BY=8
+CRC16_BENCHMARK_CPPFLAGS_nibble_table = \
+  -DMEMFAULT_CRC16_LOOKUP_TABLE_ENABLE=0 \
+  -DMEMFAULT_CRC16_NIBBLE_TABLE_ENABLE=1
+CRC16_BENCHMARK_CPPFLAGS_bitwise = -DMEMFAULT_CRC16_LOOKUP_TABLE_ENABLE=0
+
+ifeq (,$(filter byte_table slice_by_4 slice_by_8 nibble_table bitwise,$(CRC16_BENCHMARK_VARIANT)))
+$(error Unknown CRC16_BENCHMARK_VARIANT: $(CRC16_BENCHMARK_VARIANT))
+endif
+
+CPPUTEST_CPPFLAGS += $(CRC16_BENCHMARK_CPPFLAGS_$(CRC16_BENCHMARK_VARIANT))
+MEMFAULT_TEST_VARIANT = $(CRC16_BENCHMARK_VARIANT)
+
+include $(CPPUTEST_MAKFILE_INFRA)
@@ -0,0 +1,20 @@
+SRC_FILES = \
+  $(MFLT_COMPONENTS_DIR)/core/src/memfault_heap_stats.c
+
+MOCK_AND_FAKE_SRC_FILES += \
+  $(MFLT_TEST_FAKE_DIR)/fake_memfault_platform_locking.c \
+  $(MFLT_TEST_FAKE_DIR)/fake_memfault_sdk_assert.c
+
+TEST_SRC_FILES = \
+  $(MFLT_TEST_SRC_DIR)/test_memfault_heap_stats_benchmark.cpp \
+  $(MOCK_AND_FAKE_SRC_FILES)
+
+# The heap stats pool size to benchmark, i.e to compare against a large pool:
+#   make benchmarks TEST_MAKEFILE_FILTER=memfault_heap_stats_benchmark.mk \
+#     HEAP_STATS_BENCHMARK_MAX_COUNT=1024
+HEAP_STATS_BENCHMARK_MAX_COUNT ?= 32
+
+CPPUTEST_CPPFLAGS += -DMEMFAULT_HEAP_STATS_MAX_COUNT=$(HEAP_STATS_BENCHMARK_MAX_COUNT)
+MEMFAULT_TEST_VARIANT = $(HEAP_STATS_BENCHMARK_MAX_COUNT)
+
+include $(CPPUTEST_MAKFILE_INFRA)
@@ -0,0 +1,17 @@
+SRC_FILES = \
+  $(MFLT_COMPONENTS_DIR)/core/src/memfault_nv_event_log.c
+
+MOCK_AND_FAKE_SRC_FILES += \
+  $(MFLT_COMPONENTS_DIR)/util/src/memfault_crc16_ccitt.c \
+  $(MFLT_TEST_FAKE_DIR)/fake_memfault_nv_event_log_flash.c \
+  $(MFLT_TEST_FAKE_DIR)/fake_memfault_platform_debug_log.c \
+  $(MFLT_TEST_STUB_DIR)/stub_memfault_log_save.c
+
+TEST_SRC_FILES = \
+  $(MFLT_TEST_SRC_DIR)/test_memfault_nv_event_log_benchmark.cpp \
+  $(MOCK_AND_FAKE_SRC_FILES)
+
+CPPUTEST_CPPFLAGS += -DMEMFAULT_EVENT_STORAGE_NV_SUPPORT_ENABLED=1
+CPPUTEST_CPPFLAGS += -DMEMFAULT_NV_EVENT_LOG_ENABLED=1
+
+include $(CPPUTEST_MAKFILE_INFRA)
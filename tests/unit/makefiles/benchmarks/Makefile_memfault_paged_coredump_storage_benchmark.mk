@@ -0,0 +1,16 @@
+SRC_FILES = \
+  $(MFLT_COMPONENTS_DIR)/panics/src/memfault_coredump.c \
+  $(MFLT_TEST_SRC_DIR)/test_memfault_paged_coredump_storage_impl.c
+
+TEST_SRC_FILES = \
+  $(MFLT_TEST_SRC_DIR)/test_memfault_paged_coredump_storage_benchmark.cpp
+
+# The storage page size to benchmark, i.e to compare against small pages:
+#   make benchmarks TEST_MAKEFILE_FILTER=memfault_paged_coredump_storage_benchmark.mk \
+#     PAGED_COREDUMP_BENCHMARK_PAGE_SIZE=32
+PAGED_COREDUMP_BENCHMARK_PAGE_SIZE ?= 256
+
+CPPUTEST_CPPFLAGS += -DMEMFAULT_COREDUMP_STORAGE_PAGE_SIZE=$(PAGED_COREDUMP_BENCHMARK_PAGE_SIZE)
+MEMFAULT_TEST_VARIANT = $(PAGED_COREDUMP_BENCHMARK_PAGE_SIZE)
+
+include $(CPPUTEST_MAKFILE_INFRA)
@@ -6,13 +6,69 @@
 #include "CppUTest/MemoryLeakDetectorNewMacros.h"
 #include "CppUTest/TestHarness.h"
 #include "CppUTestExt/MockSupport.h"
+#include "fakes/fake_memfault_platform_get_device_info.h"
+#include "memfault/config.h"
 #include "memfault/core/batched_events.h"
+#include "memfault/core/platform/device_info.h"
+#include "memfault/core/serializer_helper.h"
+#include "memfault/util/cbor.h"
 
 TEST_GROUP(MemfaultBatchedEvents) {
   void setup() { }
   void teardown() { }
 };
 
+#if MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_ENABLED
+static void prv_check_compact_header(const sMemfaultBatchedEventsMetadata *metadata,
+                                     size_t num_events, const uint8_t *events_array_hdr,
+                                     size_t events_array_hdr_len) {
+  sMemfaultBatchedEventsHeader header;
+  memfault_batched_events_build_compact_header(num_events, metadata, &header);
+  LONGS_EQUAL(1 + metadata->length + events_array_hdr_len, header.length);
+  LONGS_EQUAL(0x82, header.data[0]);
+  MEMCMP_EQUAL(metadata->data, &header.data[1], metadata->length);
+  MEMCMP_EQUAL(events_array_hdr, &header.data[1 + metadata->length], events_array_hdr_len);
+}
+
+TEST(MemfaultBatchedEvents, Test_MemfaultCompactBatchedHeader) {
+  uint8_t expected[MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_METADATA_MAX_LEN];
+  sMemfaultCborEncoder encoder;
+  memfault_cbor_encoder_init(&encoder, memfault_cbor_encoder_memcpy_write, expected,
+                             sizeof(expected));
+  CHECK(memfault_serializer_helper_encode_batch_metadata(&encoder));
+  const size_t expected_len = memfault_cbor_encoder_deinit(&encoder);
+
+  sMemfaultBatchedEventsMetadata metadata;
+  CHECK(memfault_batched_events_capture_metadata(&metadata));
+  LONGS_EQUAL(expected_len, metadata.length);
+  MEMCMP_EQUAL(expected, metadata.data, expected_len);
+
+  const uint8_t cbor_enc_1[] = { 0x81 };
+  prv_check_compact_header(&metadata, 1, cbor_enc_1, sizeof(cbor_enc_1));
+
+  const uint8_t cbor_enc_1000000[] = { 0x9a, 0x00, 0x0f, 0x42, 0x40 };
+  prv_check_compact_header(&metadata, 1000000, cbor_enc_1000000, sizeof(cbor_enc_1000000));
+
+  sMemfaultBatchedEventsHeader header;
+  memfault_batched_events_build_compact_header(0, &metadata, &header);
+  LONGS_EQUAL(0, header.length);
+}
+
+TEST(MemfaultBatchedEvents, Test_MemfaultCompactMetadataTooLarge) {
+  const char *original_software_version = g_fake_device_info.software_version;
+  char software_version[MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_METADATA_MAX_LEN + 1];
+  memset(software_version, 'a', sizeof(software_version) - 1);
+  software_version[sizeof(software_version) - 1] = '\0';
+  g_fake_device_info.software_version = software_version;
+
+  sMemfaultBatchedEventsMetadata metadata;
+  const bool success = memfault_batched_events_capture_metadata(&metadata);
+  g_fake_device_info.software_version = original_software_version;
+
+  CHECK_FALSE(success);
+  LONGS_EQUAL(0, metadata.length);
+}
+#else
 TEST(MemfaultBatchedEvents, Test_MemfaultBatchedHeader) {
   sMemfaultBatchedEventsHeader header;
 
@@ -32,3 +88,4 @@ TEST(MemfaultBatchedEvents, Test_MemfaultBatchedHeader) {
   LONGS_EQUAL(0, header.length);
 
 }
+#endif
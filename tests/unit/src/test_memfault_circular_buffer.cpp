@@ -228,6 +228,54 @@ TEST(MfltCircularBufferTestGroup, Test_MfltCircularWriteAndReadWrapAround) {
   }
 }
 
+TEST(MfltCircularBufferTestGroup, Test_MfltCircularReserve) {
+  uint8_t storage_buf[10];
+  sMfltCircularBuffer buffer;
+  bool success = memfault_circular_buffer_init(&buffer, storage_buf, sizeof(storage_buf));
+  CHECK(success);
+
+  size_t idx;
+  CHECK(!memfault_circular_buffer_reserve(NULL, 1, &idx));
+  CHECK(!memfault_circular_buffer_reserve(&buffer, 1, NULL));
+  CHECK(!memfault_circular_buffer_reserve(&buffer, sizeof(storage_buf) + 1, &idx));
+
+  // move the read offset so the second reservation wraps around the end of the storage
+  const uint8_t filler[6] = { 0 };
+  CHECK(memfault_circular_buffer_write(&buffer, filler, sizeof(filler)));
+  CHECK(memfault_circular_buffer_consume(&buffer, sizeof(filler)));
+
+  size_t first_idx;
+  size_t second_idx;
+  CHECK(memfault_circular_buffer_reserve(&buffer, 2, &first_idx));
+  CHECK(memfault_circular_buffer_reserve(&buffer, 5, &second_idx));
+  LONGS_EQUAL(6, first_idx);
+  LONGS_EQUAL(8, second_idx);
+  LONGS_EQUAL(7, memfault_circular_buffer_get_read_size(&buffer));
+  LONGS_EQUAL(3, memfault_circular_buffer_get_write_size(&buffer));
+
+  // a plain write lands after the reservations
+  const uint8_t tail[] = { 0x8 };
+  CHECK(memfault_circular_buffer_write(&buffer, tail, sizeof(tail)));
+
+  // fill the reservations out of order
+  const uint8_t second[] = { 0x3, 0x4, 0x5, 0x6, 0x7 };
+  CHECK(memfault_circular_buffer_write_reserved(&buffer, second_idx, 1, &second[1], 4));
+  CHECK(memfault_circular_buffer_write_reserved(&buffer, second_idx, 0, &second[0], 1));
+  const uint8_t first[] = { 0x1, 0x2 };
+  CHECK(memfault_circular_buffer_write_reserved(&buffer, first_idx, 0, first, sizeof(first)));
+
+  CHECK(!memfault_circular_buffer_write_reserved(NULL, first_idx, 0, first, sizeof(first)));
+  CHECK(!memfault_circular_buffer_write_reserved(&buffer, first_idx, 0, NULL, sizeof(first)));
+  CHECK(!memfault_circular_buffer_write_reserved(&buffer, sizeof(storage_buf), 0, first, 1));
+  CHECK(!memfault_circular_buffer_write_reserved(&buffer, first_idx, sizeof(storage_buf), first,
+                                                 1));
+
+  const uint8_t expected[] = { 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7, 0x8 };
+  uint8_t actual[sizeof(expected)];
+  CHECK(memfault_circular_buffer_read(&buffer, 0, actual, sizeof(actual)));
+  MEMCMP_EQUAL(expected, actual, sizeof(expected));
+}
+
 TEST(MfltCircularBufferTestGroup, Test_MfltCircularWriteAndGetReadPointerBadInput) {
   const uint8_t buffer_size = 20;
   uint8_t storage_buf[buffer_size];
@@ -18,6 +18,7 @@
 #include "memfault/core/log.h"
 #include "memfault/core/log_impl.h"
 #include "memfault/core/sdk_assert.h"
+#include "memfault/util/cbor.h"
 #include "memfault_log_data_source_private.h"
 #include "memfault_log_private.h"
 
@@ -121,3 +122,75 @@ TEST(MemfaultCompactLogSaveTruncation, Test_CompactLogSaveWithFallback_TooSmallS
   LONGS_EQUAL(kMemfaultPlatformLogLevel_Warning, log.level);
   STRCMP_EQUAL("... 1 messages dropped ...", log.msg);
 }
+
+// Compact logs are encoded straight into the log buffer, check one which wraps around the end of
+// the buffer reads back intact
+TEST(MemfaultCompactLogSaveTruncation, Test_CompactLogWrapsAroundLogBuffer) {
+  uint8_t s_ram_log_store[64];
+  memfault_log_boot(s_ram_log_store, sizeof(s_ram_log_store));
+
+  const char *log_a = "aaaaaaaaaaaaaaaaaaaa";
+  const char *log_b = "bbbbbbbbbbbbbbbbbbbb";
+  memfault_log_save_preformatted(kMemfaultPlatformLogLevel_Info, log_a, strlen(log_a));
+  memfault_log_save_preformatted(kMemfaultPlatformLogLevel_Info, log_b, strlen(log_b));
+  sMemfaultLog log;
+  CHECK(memfault_log_read(&log));
+  STRCMP_EQUAL(log_a, log.msg);
+
+  // [log id offset, 1234, "abcdefghijklmnopqrst"] doesn't fit in the 20 bytes left before the end
+  // of the buffer
+  const uint32_t log_id = prv_get_fake_log_id();
+  const uint32_t compressed_fmt = 0x13;  // 0b1.00.11 (int, string)
+  const char *str_arg = "abcdefghijklmnopqrst";
+  memfault_compact_log_save(kMemfaultPlatformLogLevel_Error, log_id, compressed_fmt, 1234,
+                            str_arg);
+
+  uint8_t expected_cbor[MEMFAULT_LOG_MAX_LINE_SAVE_LEN];
+  sMemfaultCborEncoder encoder;
+  memfault_cbor_encoder_init(&encoder, memfault_cbor_encoder_memcpy_write, expected_cbor,
+                             sizeof(expected_cbor));
+  CHECK(memfault_log_compact_serialize(&encoder, log_id, compressed_fmt, 1234, str_arg));
+  const size_t expected_cbor_len = memfault_cbor_encoder_deinit(&encoder);
+  CHECK(expected_cbor_len > 20);
+
+  // log_a, which had been read, made room for the log
+  LONGS_EQUAL(0, memfault_log_get_dropped_count());
+  LONGS_EQUAL(3, memfault_log_get_recorded_count());
+  CHECK(memfault_log_read(&log));
+  STRCMP_EQUAL(log_b, log.msg);
+  CHECK(memfault_log_read(&log));
+  LONGS_EQUAL(kMemfaultLogRecordType_Compact, log.type);
+  LONGS_EQUAL(kMemfaultPlatformLogLevel_Error, log.level);
+  LONGS_EQUAL(expected_cbor_len, log.msg_len);
+  MEMCMP_EQUAL(expected_cbor, log.msg, expected_cbor_len);
+
+  // only the space the log needed was kept, the next log follows it directly
+  const char *log_c = "c";
+  memfault_log_save_preformatted(kMemfaultPlatformLogLevel_Info, log_c, strlen(log_c));
+  LONGS_EQUAL(0, memfault_log_get_dropped_count());
+  CHECK(memfault_log_read(&log));
+  STRCMP_EQUAL(log_c, log.msg);
+  CHECK_FALSE(memfault_log_read(&log));
+}
+
+// The space for the largest compact log is reserved up front, but a log which fits in the space
+// left in a buffer smaller than that is still saved
+TEST(MemfaultCompactLogSaveTruncation, Test_CompactLogSmallLogBuffer) {
+  uint8_t s_ram_log_store[16];
+  memfault_log_boot(s_ram_log_store, sizeof(s_ram_log_store));
+
+  const uint32_t compressed_fmt = 0x4;  // 0b1.00 (int)
+  memfault_compact_log_save(kMemfaultPlatformLogLevel_Info, prv_get_fake_log_id(), compressed_fmt,
+                            1);
+  memfault_compact_log_save(kMemfaultPlatformLogLevel_Info, prv_get_fake_log_id(), compressed_fmt,
+                            2);
+  LONGS_EQUAL(2, memfault_log_get_recorded_count());
+  LONGS_EQUAL(0, memfault_log_get_dropped_count());
+
+  const uint8_t expected_cbor[] = { 0x82, 0x0A, 0x02 };
+  sMemfaultLog log;
+  CHECK(memfault_log_read(&log));
+  CHECK(memfault_log_read(&log));
+  LONGS_EQUAL(sizeof(expected_cbor), log.msg_len);
+  MEMCMP_EQUAL(expected_cbor, log.msg, sizeof(expected_cbor));
+}
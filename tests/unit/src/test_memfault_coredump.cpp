@@ -9,11 +9,14 @@ extern "C" {
 #include "fakes/fake_memfault_platform_coredump_storage.h"
 #include "memfault/core/build_info.h"
 #include "memfault/core/compiler.h"
+#include "memfault/core/data_packetizer_source.h"
+#include "memfault/core/math.h"
 #include "memfault/core/platform/core.h"
 #include "memfault/core/platform/device_info.h"
 #include "memfault/panics/coredump.h"
 #include "memfault/panics/coredump_impl.h"
 #include "memfault/panics/platform/coredump.h"
+#include "memfault/util/rle.h"
 
 MEMFAULT_ALIGNED(0x8) static uint8_t s_storage_buf[4 * 1024];
 
@@ -166,13 +169,35 @@ static void prv_assert_storage_empty(void) {
   MEMCMP_EQUAL(empty_storage, s_storage_buf, sizeof(s_storage_buf));
 }
 
+#if MEMFAULT_COREDUMP_CACHE_RLE_SIZE
+//! Checks the RLE size cached for the coredump saved in storage against an RLE pass over all of it
+static void prv_check_cached_rle_size(const uint8_t *storage, size_t total_coredump_size) {
+  sMemfaultRleCtx rle_ctx = { 0 };
+  for (size_t i = 0; i < total_coredump_size;) {
+    i += memfault_rle_encode(&rle_ctx, &storage[i], total_coredump_size - i);
+  }
+  memfault_rle_encode_finalize(&rle_ctx);
+
+  // the header, the bytes following it and the tail of the coredump are read back
+  mock().ignoreOtherCalls();
+  size_t rle_size = 0;
+  CHECK(memfault_coredump_get_rle_size(&rle_size));
+  LONGS_EQUAL(rle_ctx.total_rle_size, rle_size);
+  mock().checkExpectations();
+  mock().clear();
+}
+#endif
+
 static bool prv_collect_regions_and_save(void *regs, size_t size, uint32_t trace_reason) {
   size_t num_regions = 0;
   const sMfltCoredumpRegion *regions = memfault_platform_coredump_get_regions(NULL, &num_regions);
 
   if (num_regions != 0) {
+#if !MEMFAULT_COREDUMP_STORAGE_PRE_ERASE_ENABLED
     // we are going to try and write a coredump so this should trigger a header read
+    // (when pre-erase is enabled, storage is also read to check which sectors are still erased)
     mock().expectOneCall("memfault_platform_coredump_storage_read");
+#endif
     mock().ignoreOtherCalls();  // We will test handling memfault_build_info_read() explicitly
   }
 
@@ -331,6 +356,9 @@ TEST(MfltCoredumpTestGroup, Test_MfltCoredumpTruncated) {
   CHECK(has_coredump);
   // second to last region should be truncated by one word
   LONGS_EQUAL(storage_size - 3, coredump_size);
+#if MEMFAULT_COREDUMP_CACHE_RLE_SIZE
+  prv_check_cached_rle_size(storage, coredump_size);
+#endif
   memfault_platform_coredump_storage_clear();
 
   // size with not enough space for the last region
@@ -644,8 +672,13 @@ TEST(MfltCoredumpTestGroup, Test_MfltCoredumpSaveCore) {
   const uint32_t expected_footer_magic = 0x504d5544;
   MEMCMP_EQUAL(coredump_buf, &expected_footer_magic, sizeof(expected_footer_magic));
   coredump_buf += sizeof(expected_footer_magic);
-  uint32_t rsvd[] = { 0x0, 0x0, 0x0 };
+  const uint32_t expected_footer_flags = 0x0;
+  MEMCMP_EQUAL(coredump_buf, &expected_footer_flags, sizeof(expected_footer_flags));
+  coredump_buf += sizeof(expected_footer_flags);
+#if !MEMFAULT_COREDUMP_CACHE_RLE_SIZE
+  uint32_t rsvd[] = { 0x0, 0x0 };
   MEMCMP_EQUAL(coredump_buf, &rsvd[0], sizeof(rsvd));
+#endif
 
   // should have been no calls to memfault_coredump_read
   mock().checkExpectations();
@@ -655,4 +688,171 @@ TEST(MfltCoredumpTestGroup, Test_MfltCoredumpSaveCore) {
   bool has_coredump = prv_check_coredump_validity_and_get_size(&total_coredump_size);
   CHECK(has_coredump);
   LONGS_EQUAL(total_length, total_coredump_size);
+
+#if MEMFAULT_COREDUMP_CACHE_RLE_SIZE
+  POINTERS_EQUAL(memfault_coredump_get_rle_size, g_memfault_coredump_data_source.get_rle_size_cb);
+  prv_check_cached_rle_size(s_storage_buf, total_coredump_size);
+#endif
+}
+
+#if MEMFAULT_COREDUMP_CACHE_RLE_SIZE
+TEST(MfltCoredumpTestGroup, Test_MfltCoredumpRleSizeCacheCompressibleRegion) {
+  // long runs mixed with non-repeating data, so the encoded stream is much smaller than the
+  // coredump and every kind of RLE sequence is exercised
+  static uint8_t s_compressible_region[1024];
+  memset(s_compressible_region, 0x0, sizeof(s_compressible_region));
+  for (size_t i = 0; i < 100; i++) {
+    s_compressible_region[400 + i] = (uint8_t)i;
+  }
+  memset(&s_compressible_region[700], 0xA5, 200);
+  s_fake_memory_region[0].region_start = s_compressible_region;
+  s_fake_memory_region[0].region_size = sizeof(s_compressible_region);
+
+  const uint32_t regs[] = { 0x1, 0x2, 0x3, 0x4, 0x5 };
+  CHECK(prv_collect_regions_and_save((void *)&regs, sizeof(regs), 0xdead));
+
+  size_t total_coredump_size = 0;
+  CHECK(prv_check_coredump_validity_and_get_size(&total_coredump_size));
+
+  prv_check_cached_rle_size(s_storage_buf, total_coredump_size);
+}
+
+TEST(MfltCoredumpTestGroup, Test_MfltCoredumpRleSizeCacheSequencesSpanningHeader) {
+  // registers which continue runs and literals started by the header and by the footer in
+  // different ways, so the size cached while saving has to be completed across both
+  const uint8_t fills[] = { 0x00, 0x01, 0x44, 0xff };
+  for (size_t i = 0; i < MEMFAULT_ARRAY_SIZE(fills); i++) {
+    for (size_t regs_len = 1; regs_len <= 24; regs_len++) {
+      uint8_t regs[24];
+      memset(regs, fills[i], sizeof(regs));
+      // a non-repeating byte at a varying offset
+      regs[regs_len / 2] = (uint8_t)(regs_len + 0x80);
+
+      memfault_platform_coredump_storage_clear();
+      CHECK(prv_collect_regions_and_save(regs, regs_len, 0xdead));
+      size_t total_coredump_size = 0;
+      CHECK(prv_check_coredump_validity_and_get_size(&total_coredump_size));
+      prv_check_cached_rle_size(s_storage_buf, total_coredump_size);
+    }
+  }
+}
+#endif /* MEMFAULT_COREDUMP_CACHE_RLE_SIZE */
+
+#if MEMFAULT_COREDUMP_STORAGE_INCREMENTAL_ERASE
+TEST(MfltCoredumpTestGroup, Test_MfltCoredumpIncrementalErase) {
+  // storage holding stale data, 4 sectors of 1kB
+  memset(s_storage_buf, 0xAB, sizeof(s_storage_buf));
+  fake_memfault_platform_coredump_storage_setup(s_storage_buf, sizeof(s_storage_buf), 1024);
+
+  const uint32_t regs[] = { 0x1, 0x2, 0x3, 0x4, 0x5 };
+  CHECK(prv_collect_regions_and_save((void *)&regs, sizeof(regs), 0xdead));
+
+  size_t total_coredump_size = 0;
+  CHECK(prv_check_coredump_validity_and_get_size(&total_coredump_size));
+  CHECK(total_coredump_size < 1024);
+
+  // only the sector the coredump was written to has been erased
+  LONGS_EQUAL(1, fake_memfault_platform_coredump_storage_get_erase_count());
+  for (size_t i = total_coredump_size; i < 1024; i++) {
+    LONGS_EQUAL(0xff, s_storage_buf[i]);
+  }
+  for (size_t i = 1024; i < sizeof(s_storage_buf); i++) {
+    LONGS_EQUAL(0xAB, s_storage_buf[i]);
+  }
+}
+
+TEST(MfltCoredumpTestGroup, Test_MfltCoredumpIncrementalEraseAcrossSectors) {
+  // a region spanning several sectors
+  static uint8_t s_large_region[2500];
+  for (size_t i = 0; i < sizeof(s_large_region); i++) {
+    s_large_region[i] = (uint8_t)(i * 7);
+  }
+  s_fake_memory_region[0].region_start = s_large_region;
+  s_fake_memory_region[0].region_size = sizeof(s_large_region);
+  s_num_fake_regions = 1;
+
+  memset(s_storage_buf, 0xAB, sizeof(s_storage_buf));
+  fake_memfault_platform_coredump_storage_setup(s_storage_buf, sizeof(s_storage_buf), 1024);
+
+  const uint32_t regs[] = { 0x1, 0x2, 0x3, 0x4, 0x5 };
+  CHECK(prv_collect_regions_and_save((void *)&regs, sizeof(regs), 0xdead));
+
+  size_t total_coredump_size = 0;
+  CHECK(prv_check_coredump_validity_and_get_size(&total_coredump_size));
+  CHECK(total_coredump_size > 2048);
+  CHECK(total_coredump_size < 3072);
+  LONGS_EQUAL(3, fake_memfault_platform_coredump_storage_get_erase_count());
+  LONGS_EQUAL(0xAB, s_storage_buf[sizeof(s_storage_buf) - 1]);
+
+  // the region was written intact across the sector boundaries
+  bool found = false;
+  for (size_t offset = 0; offset + sizeof(s_large_region) <= total_coredump_size; offset++) {
+    if (memcmp(&s_storage_buf[offset], s_large_region, sizeof(s_large_region)) == 0) {
+      found = true;
+      break;
+    }
+  }
+  CHECK(found);
+}
+
+TEST(MfltCoredumpTestGroup, Test_MfltCoredumpIncrementalEraseUnknownSectorSize) {
+  // without a sector size, the entire region is erased up front
+  memset(s_storage_buf, 0xAB, sizeof(s_storage_buf));
+  fake_memfault_platform_coredump_storage_setup(s_storage_buf, sizeof(s_storage_buf),
+                                                sizeof(s_storage_buf));
+  const uint32_t regs[] = { 0x1, 0x2, 0x3, 0x4, 0x5 };
+  CHECK(prv_collect_regions_and_save((void *)&regs, sizeof(regs), 0xdead));
+  LONGS_EQUAL(1, fake_memfault_platform_coredump_storage_get_erase_count());
+  LONGS_EQUAL(0xff, s_storage_buf[sizeof(s_storage_buf) - 1]);
+}
+#endif /* MEMFAULT_COREDUMP_STORAGE_INCREMENTAL_ERASE */
+
+#if MEMFAULT_COREDUMP_STORAGE_PRE_ERASE_ENABLED
+TEST(MfltCoredumpTestGroup, Test_MfltCoredumpPreErase) {
+  memset(s_storage_buf, 0xAB, sizeof(s_storage_buf));
+  fake_memfault_platform_coredump_storage_setup(s_storage_buf, sizeof(s_storage_buf), 1024);
+  mock().ignoreOtherCalls();
+
+  CHECK(memfault_coredump_storage_pre_erase());
+  LONGS_EQUAL(4, fake_memfault_platform_coredump_storage_get_erase_count());
+  // sectors which are still erased are skipped
+  CHECK(memfault_coredump_storage_pre_erase());
+  LONGS_EQUAL(4, fake_memfault_platform_coredump_storage_get_erase_count());
+
+  // saving a coredump to pre-erased storage doesn't erase anything
+  const uint32_t regs[] = { 0x1, 0x2, 0x3, 0x4, 0x5 };
+  CHECK(prv_collect_regions_and_save((void *)&regs, sizeof(regs), 0xdead));
+  LONGS_EQUAL(4, fake_memfault_platform_coredump_storage_get_erase_count());
+  size_t total_coredump_size = 0;
+  CHECK(memfault_coredump_has_valid_coredump(&total_coredump_size));
+
+  // a stored coredump is never erased
+  CHECK_FALSE(memfault_coredump_storage_pre_erase());
+  CHECK(memfault_coredump_has_valid_coredump(&total_coredump_size));
+
+  // once cleared, only the sector holding the coredump needs to be erased
+  memfault_platform_coredump_storage_clear();
+  CHECK(memfault_coredump_storage_pre_erase());
+  LONGS_EQUAL(5, fake_memfault_platform_coredump_storage_get_erase_count());
+}
+
+TEST(MfltCoredumpTestGroup, Test_MfltCoredumpPartiallyPreErased) {
+  // the background erase was interrupted, only the first sector was erased
+  memset(s_storage_buf, 0xAB, sizeof(s_storage_buf));
+  memset(s_storage_buf, 0xff, 1024);
+  fake_memfault_platform_coredump_storage_setup(s_storage_buf, sizeof(s_storage_buf), 1024);
+
+  static uint8_t s_large_region[1500];
+  memset(s_large_region, 0x5A, sizeof(s_large_region));
+  s_fake_memory_region[0].region_start = s_large_region;
+  s_fake_memory_region[0].region_size = sizeof(s_large_region);
+  s_num_fake_regions = 1;
+
+  const uint32_t regs[] = { 0x1, 0x2, 0x3, 0x4, 0x5 };
+  CHECK(prv_collect_regions_and_save((void *)&regs, sizeof(regs), 0xdead));
+  // the second sector is erased by the fault handler
+  LONGS_EQUAL(1, fake_memfault_platform_coredump_storage_get_erase_count());
+  size_t total_coredump_size = 0;
+  CHECK(prv_check_coredump_validity_and_get_size(&total_coredump_size));
 }
+#endif /* MEMFAULT_COREDUMP_STORAGE_PRE_ERASE_ENABLED */
@@ -4,13 +4,47 @@
 
 extern "C" {
 #include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 
+#include "memfault/config.h"
 #include "memfault/util/crc16.h"
+
+#if MEMFAULT_CRC16_PLATFORM_HOOK_ENABLE
+static bool s_platform_crc16_available;
+static size_t s_platform_crc16_call_count;
+
+bool memfault_platform_crc16_compute(uint16_t crc_initial_value, const void *data,
+                                     size_t data_len_bytes, uint16_t *crc_out) {
+  s_platform_crc16_call_count++;
+  if (!s_platform_crc16_available) {
+    return false;
+  }
+  // a recognizable value so the tests can tell the hook result was used
+  *crc_out = (uint16_t)(crc_initial_value ^ data_len_bytes ^ *(const uint8_t *)data ^ 0xbeef);
+  return true;
+}
+#endif
+}
+
+//! Bit-by-bit reference implementation every configuration is checked against
+static uint16_t prv_crc16_reference(uint16_t crc, const uint8_t *data, size_t data_len) {
+  for (size_t i = 0; i < data_len; i++) {
+    crc ^= (uint16_t)(data[i] << 8);
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+  }
+  return crc;
 }
 
 TEST_GROUP(MfltCrc16CcittGroup) {
-  void setup() { }
+  void setup() {
+#if MEMFAULT_CRC16_PLATFORM_HOOK_ENABLE
+    s_platform_crc16_available = false;
+    s_platform_crc16_call_count = 0;
+#endif
+  }
   void teardown() { }
 };
 
@@ -48,3 +82,45 @@ TEST(MfltCrc16CcittGroup, Test_MfltCrc16CcittGroupComputeTestPatternIncremental)
   }
   LONGS_EQUAL(0x31C3, crc);
 }
+
+TEST(MfltCrc16CcittGroup, Test_MfltCrc16CcittGroupMatchesReference) {
+  uint8_t data[256];
+  srand(0);
+  for (size_t i = 0; i < sizeof(data); i++) {
+    data[i] = (uint8_t)rand();
+  }
+
+  // exercise every start alignment and every length around the slice sizes, starting from a
+  // non-zero CRC as is the case when computing incrementally
+  for (size_t offset = 0; offset < 8; offset++) {
+    for (size_t len = 0; len <= sizeof(data) - offset; len++) {
+      const uint16_t expected = prv_crc16_reference(0x1234, &data[offset], len);
+      LONGS_EQUAL(expected, memfault_crc16_compute(0x1234, &data[offset], len));
+    }
+  }
+
+  // splitting the computation at any point yields the same result
+  const uint16_t expected = prv_crc16_reference(MEMFAULT_CRC16_INITIAL_VALUE, data, sizeof(data));
+  for (size_t split = 0; split <= sizeof(data); split++) {
+    uint16_t crc = memfault_crc16_compute(MEMFAULT_CRC16_INITIAL_VALUE, data, split);
+    crc = memfault_crc16_compute(crc, &data[split], sizeof(data) - split);
+    LONGS_EQUAL(expected, crc);
+  }
+}
+
+#if MEMFAULT_CRC16_PLATFORM_HOOK_ENABLE
+TEST(MfltCrc16CcittGroup, Test_MfltCrc16CcittGroupPlatformHook) {
+  const char *test_pattern = "123456789";
+
+  s_platform_crc16_available = true;
+  uint16_t crc = memfault_crc16_compute(0x1, test_pattern, strlen(test_pattern));
+  LONGS_EQUAL(0x1 ^ 9 ^ '1' ^ 0xbeef, crc);
+  LONGS_EQUAL(1, s_platform_crc16_call_count);
+
+  // falls back to the software implementation when the hook declines
+  s_platform_crc16_available = false;
+  crc = memfault_crc16_compute(MEMFAULT_CRC16_INITIAL_VALUE, test_pattern, strlen(test_pattern));
+  LONGS_EQUAL(0x31C3, crc);
+  LONGS_EQUAL(2, s_platform_crc16_call_count);
+}
+#endif
@@ -0,0 +1,98 @@
+//! @file
+//!
+//! @brief
+//! Benchmark the throughput of the CRC16 implementation selected by the build configuration over
+//! a range of buffer sizes. Set CRC16_BENCHMARK_VARIANT when running
+//! Makefile_memfault_crc16_ccitt_benchmark.mk to build a different variant so the numbers
+//! reported can be compared.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+
+#include "CppUTest/MemoryLeakDetectorMallocMacros.h"
+#include "CppUTest/MemoryLeakDetectorNewMacros.h"
+#include "CppUTest/TestHarness.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+  #include <x86intrin.h>
+  #define BENCHMARK_HAS_CYCLE_COUNTER 1
+#else
+  #define BENCHMARK_HAS_CYCLE_COUNTER 0
+#endif
+
+extern "C" {
+#include "memfault/config.h"
+#include "memfault/core/math.h"
+#include "memfault/util/crc16.h"
+}
+
+#if !MEMFAULT_CRC16_LOOKUP_TABLE_ENABLE
+  #if MEMFAULT_CRC16_NIBBLE_TABLE_ENABLE
+    #define CRC16_VARIANT "nibble table"
+  #else
+    #define CRC16_VARIANT "bitwise"
+  #endif
+#elif MEMFAULT_CRC16_SLICE_BY == 8
+  #define CRC16_VARIANT "slice-by-8"
+#elif MEMFAULT_CRC16_SLICE_BY == 4
+  #define CRC16_VARIANT "slice-by-4"
+#else
+  #define CRC16_VARIANT "byte table"
+#endif
+
+// Total number of bytes to run through the CRC for each buffer size
+#define BYTES_PER_RUN (4 * 1024 * 1024)
+
+static uint8_t s_data[4096];
+
+TEST_GROUP(MfltCrc16CcittBenchmark) {
+  void setup() {
+    srand(0);
+    for (size_t i = 0; i < sizeof(s_data); i++) {
+      s_data[i] = (uint8_t)rand();
+    }
+  }
+  void teardown() { }
+};
+
+TEST(MfltCrc16CcittBenchmark, Test_Throughput) {
+  const size_t buf_sizes[] = { 16, 244, sizeof(s_data) };
+
+  for (size_t i = 0; i < MEMFAULT_ARRAY_SIZE(buf_sizes); i++) {
+    const size_t iterations = BYTES_PER_RUN / buf_sizes[i];
+    // accumulate the CRCs so the computations can't be optimized out
+    volatile uint16_t crc = MEMFAULT_CRC16_INITIAL_VALUE;
+
+    const auto start = std::chrono::steady_clock::now();
+#if BENCHMARK_HAS_CYCLE_COUNTER
+    const uint64_t start_cycles = __rdtsc();
+#endif
+    for (size_t iter = 0; iter < iterations; iter++) {
+      crc = memfault_crc16_compute(crc, s_data, buf_sizes[i]);
+    }
+#if BENCHMARK_HAS_CYCLE_COUNTER
+    const uint64_t cycles = __rdtsc() - start_cycles;
+#endif
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    const double total_bytes = (double)(iterations * buf_sizes[i]);
+    const double elapsed_us =
+      (double)std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    printf("crc16 %s: %d byte buffers: %.1f MB/s", CRC16_VARIANT, (int)buf_sizes[i],
+           (elapsed_us > 0) ? total_bytes / elapsed_us : 0.0);
+#if BENCHMARK_HAS_CYCLE_COUNTER
+    printf(", %.3f bytes/cycle", (cycles > 0) ? total_bytes / (double)cycles : 0.0);
+#endif
+    printf("\n");
+
+    // the result must be independent of the variant being benchmarked
+    if (i == 0) {
+      const char *test_pattern = "123456789";
+      LONGS_EQUAL(0x31C3, memfault_crc16_compute(MEMFAULT_CRC16_INITIAL_VALUE, test_pattern, 9));
+    }
+  }
+}
@@ -420,6 +420,117 @@ TEST(MemfaultDataPacketizer, Test_SimpleGetChunkApi) {
   CHECK(!got_data);
 }
 
+static void prv_setup_expect_event_call_expectations(void) {
+  prv_setup_expect_coredump_call_expectations(false);
+  mock().expectOneCall("prv_heartbeat_metric_has_event");
+  mock().expectOneCall("prv_heartbeat_metric_read_event");
+  mock().expectOneCall("prv_heartbeat_metric_mark_read");
+  mock().expectOneCall("memfault_data_source_rle_encoder_set_active");
+}
+
+static void prv_setup_expect_no_more_data_call_expectations(void) {
+  prv_setup_expect_coredump_call_expectations(false);
+  mock().expectOneCall("prv_heartbeat_metric_has_event").andReturnValue(false);
+}
+
+TEST(MemfaultDataPacketizer, Test_GetChunksBulk) {
+  uint8_t buf[64 + 2 * MEMFAULT_PROJECT_KEY_LEN];
+  size_t chunk_lens[4];
+
+  prv_setup_expect_coredump_call_expectations(true);
+  mock().expectOneCall("prv_coredump_read_core");
+  mock().expectOneCall("prv_mark_core_read");
+  mock().expectOneCall("memfault_data_source_rle_encoder_set_active");
+  prv_setup_expect_event_call_expectations();
+  prv_setup_expect_no_more_data_call_expectations();
+
+  size_t buf_len = sizeof(buf);
+  size_t num_chunks = MEMFAULT_ARRAY_SIZE(chunk_lens);
+  CHECK(memfault_packetizer_get_chunks_bulk(buf, &buf_len, chunk_lens, &num_chunks));
+  mock().checkExpectations();
+
+  // the fake chunker has 0 overhead so each message is packed as a single chunk
+  const size_t coredump_chunk_len = sizeof(s_fake_coredump) + PACKETIZER_HEADER_SIZE_BYTES;
+  const size_t event_chunk_len = sizeof(s_fake_event) + PACKETIZER_HEADER_SIZE_BYTES;
+  LONGS_EQUAL(2, num_chunks);
+  LONGS_EQUAL(coredump_chunk_len, chunk_lens[0]);
+  LONGS_EQUAL(event_chunk_len, chunk_lens[1]);
+  LONGS_EQUAL(coredump_chunk_len + event_chunk_len, buf_len);
+
+  LONGS_EQUAL(1, buf[0] & PACKETIZER_HEADER_TYPE_MASK);
+  MEMCMP_EQUAL(s_fake_coredump, &buf[PACKETIZER_HEADER_SIZE_BYTES], sizeof(s_fake_coredump));
+  const uint8_t *event_chunk = &buf[coredump_chunk_len];
+  LONGS_EQUAL(2, event_chunk[0] & PACKETIZER_HEADER_TYPE_MASK);
+  MEMCMP_EQUAL(s_fake_event, &event_chunk[PACKETIZER_HEADER_SIZE_BYTES], sizeof(s_fake_event));
+
+  // nothing left to send
+  prv_setup_expect_no_more_data_call_expectations();
+  buf_len = sizeof(buf);
+  num_chunks = MEMFAULT_ARRAY_SIZE(chunk_lens);
+  CHECK(!memfault_packetizer_get_chunks_bulk(buf, &buf_len, chunk_lens, &num_chunks));
+  LONGS_EQUAL(0, num_chunks);
+  LONGS_EQUAL(0, buf_len);
+}
+
+TEST(MemfaultDataPacketizer, Test_GetChunksBulkPartialMessageAndChunkLimit) {
+  uint8_t buf[64 + 2 * MEMFAULT_PROJECT_KEY_LEN];
+  size_t chunk_lens[4];
+
+  // only all but the last byte of the coredump fits, the rest is returned on the next call
+  prv_setup_expect_coredump_call_expectations(true);
+  mock().expectOneCall("prv_coredump_read_core");
+
+  const size_t partial_len = sizeof(s_fake_coredump) - 1 + PACKETIZER_HEADER_SIZE_BYTES;
+  size_t buf_len = partial_len;
+  size_t num_chunks = MEMFAULT_ARRAY_SIZE(chunk_lens);
+  CHECK(memfault_packetizer_get_chunks_bulk(buf, &buf_len, chunk_lens, &num_chunks));
+  mock().checkExpectations();
+  LONGS_EQUAL(1, num_chunks);
+  LONGS_EQUAL(partial_len, chunk_lens[0]);
+  LONGS_EQUAL(partial_len, buf_len);
+
+  // finish the coredump but only request a single chunk so the event is left queued
+  mock().expectOneCall("prv_coredump_read_core");
+  mock().expectOneCall("prv_mark_core_read");
+  mock().expectOneCall("memfault_data_source_rle_encoder_set_active");
+
+  buf_len = sizeof(buf);
+  num_chunks = 1;
+  CHECK(memfault_packetizer_get_chunks_bulk(buf, &buf_len, chunk_lens, &num_chunks));
+  mock().checkExpectations();
+  LONGS_EQUAL(1, num_chunks);
+  LONGS_EQUAL(1, chunk_lens[0]);
+  LONGS_EQUAL(1, buf_len);
+  BYTES_EQUAL(s_fake_coredump[sizeof(s_fake_coredump) - 1], buf[0]);
+
+  prv_setup_expect_event_call_expectations();
+  prv_setup_expect_no_more_data_call_expectations();
+
+  buf_len = sizeof(buf);
+  num_chunks = MEMFAULT_ARRAY_SIZE(chunk_lens);
+  CHECK(memfault_packetizer_get_chunks_bulk(buf, &buf_len, chunk_lens, &num_chunks));
+  LONGS_EQUAL(1, num_chunks);
+  LONGS_EQUAL(sizeof(s_fake_event) + PACKETIZER_HEADER_SIZE_BYTES, buf_len);
+}
+
+TEST(MemfaultDataPacketizer, Test_GetChunksBulkBadArguments) {
+  uint8_t buf[16];
+  size_t chunk_lens[1];
+  size_t buf_len = sizeof(buf);
+  size_t num_chunks = MEMFAULT_ARRAY_SIZE(chunk_lens);
+
+  CHECK(!memfault_packetizer_get_chunks_bulk(NULL, &buf_len, chunk_lens, &num_chunks));
+  CHECK(!memfault_packetizer_get_chunks_bulk(buf, NULL, chunk_lens, &num_chunks));
+  CHECK(!memfault_packetizer_get_chunks_bulk(buf, &buf_len, NULL, &num_chunks));
+  CHECK(!memfault_packetizer_get_chunks_bulk(buf, &buf_len, chunk_lens, NULL));
+
+  // a buffer too small to hold any data or no room for chunk lengths packs nothing
+  buf_len = MEMFAULT_PACKETIZER_MIN_BUF_LEN - 1;
+  CHECK(!memfault_packetizer_get_chunks_bulk(buf, &buf_len, chunk_lens, &num_chunks));
+  LONGS_EQUAL(0, buf_len);
+  LONGS_EQUAL(0, num_chunks);
+}
+
 TEST(MemfaultDataPacketizer, Test_MessageSendAbort) {
   // set the destination buffer size sufficient to hold the header and all but
   // 1 byte of the payload
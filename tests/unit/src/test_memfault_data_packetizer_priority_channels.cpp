@@ -0,0 +1,318 @@
+//! @file
+//!
+//! @brief
+//! Exercises the packetizer with MEMFAULT_PACKETIZER_PRIORITY_CHANNELS_ENABLED. The real chunk
+//! transport is used so the chunks emitted can be reassembled like the Memfault cloud would.
+
+#include <vector>
+
+#include "CppUTest/MemoryLeakDetectorMallocMacros.h"
+#include "CppUTest/MemoryLeakDetectorNewMacros.h"
+#include "CppUTest/TestHarness.h"
+#include "CppUTestExt/MockSupport.h"
+
+extern "C" {
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "memfault/core/data_packetizer.h"
+#include "memfault/core/data_packetizer_source.h"
+#include "memfault/core/math.h"
+#include "memfault/util/chunk_transport.h"
+#include "memfault/util/crc16.h"
+}
+
+#define MSG_TYPE_COREDUMP 1
+#define MSG_TYPE_EVENT 2
+
+//! Bits 0-2 of the chunk header are reserved and must always be 0
+#define CHUNK_HDR_RESERVED_MASK 0x7
+
+//
+// Fake data sources
+//
+
+static uint8_t s_fake_coredump[200];
+static bool s_has_coredump;
+static size_t s_coredump_mark_read_count;
+
+static bool prv_coredump_has_core(size_t *total_size_out) {
+  *total_size_out = s_has_coredump ? sizeof(s_fake_coredump) : 0;
+  return s_has_coredump;
+}
+
+static bool prv_coredump_read_core(uint32_t offset, void *buf, size_t buf_len) {
+  CHECK(s_has_coredump);
+  CHECK((offset + buf_len) <= sizeof(s_fake_coredump));
+  memcpy(buf, &s_fake_coredump[offset], buf_len);
+  return true;
+}
+
+static void prv_coredump_mark_read(void) {
+  s_has_coredump = false;
+  s_coredump_mark_read_count++;
+}
+
+const sMemfaultDataSourceImpl g_memfault_coredump_data_source = {
+  .has_more_msgs_cb = prv_coredump_has_core,
+  .read_msg_cb = prv_coredump_read_core,
+  .mark_msg_read_cb = prv_coredump_mark_read,
+};
+
+static const uint8_t s_fake_event[] = { 0xa, 0xb, 0xc, 0xd };
+static size_t s_num_events_queued;
+static size_t s_event_mark_read_count;
+
+static bool prv_event_has_event(size_t *total_size_out) {
+  *total_size_out = (s_num_events_queued != 0) ? sizeof(s_fake_event) : 0;
+  return s_num_events_queued != 0;
+}
+
+static bool prv_event_read(uint32_t offset, void *buf, size_t buf_len) {
+  CHECK(s_num_events_queued != 0);
+  CHECK((offset + buf_len) <= sizeof(s_fake_event));
+  memcpy(buf, &s_fake_event[offset], buf_len);
+  return true;
+}
+
+static void prv_event_mark_read(void) {
+  s_num_events_queued--;
+  s_event_mark_read_count++;
+}
+
+const sMemfaultDataSourceImpl g_memfault_event_data_source = {
+  .has_more_msgs_cb = prv_event_has_event,
+  .read_msg_cb = prv_event_read,
+  .mark_msg_read_cb = prv_event_mark_read,
+};
+
+//
+// Chunk reassembly, mirroring what the Memfault cloud does with the chunks received
+//
+
+typedef struct {
+  bool in_progress;
+  size_t total_len;
+  std::vector<uint8_t> data;
+} sReassembly;
+
+static sReassembly s_reassembly;
+static std::vector<std::vector<uint8_t>> s_completed_msgs;
+
+static size_t prv_decode_varint(const uint8_t *buf, size_t *value) {
+  size_t len = 0;
+  *value = 0;
+  do {
+    *value |= (size_t)(buf[len] & 0x7f) << (7 * len);
+  } while ((buf[len++] & 0x80) != 0);
+  return len;
+}
+
+static void prv_process_chunk(const uint8_t *chunk, size_t chunk_len) {
+  const uint8_t hdr = chunk[0];
+  LONGS_EQUAL(0, hdr & CHUNK_HDR_RESERVED_MASK);
+  const bool continuation = (hdr & 0x80) != 0;
+  const bool more_data = (hdr & 0x40) != 0;
+
+  size_t offset = 1;
+  if (continuation) {
+    CHECK(s_reassembly.in_progress);
+    size_t msg_offset;
+    offset += prv_decode_varint(&chunk[offset], &msg_offset);
+    // chunks must arrive in order
+    LONGS_EQUAL(s_reassembly.data.size(), msg_offset);
+  } else {
+    // the chunks of different messages are never interleaved
+    CHECK(!s_reassembly.in_progress);
+    s_reassembly.data.clear();
+    s_reassembly.total_len = 0;
+    if (more_data) {
+      offset += prv_decode_varint(&chunk[offset], &s_reassembly.total_len);
+    }
+  }
+
+  const size_t crc_len = more_data ? 0 : 2;
+  CHECK(chunk_len >= offset + crc_len);
+  s_reassembly.data.insert(s_reassembly.data.end(), &chunk[offset], &chunk[chunk_len - crc_len]);
+  s_reassembly.in_progress = more_data;
+
+  if (!more_data) {
+    if (s_reassembly.total_len != 0) {
+      LONGS_EQUAL(s_reassembly.total_len, s_reassembly.data.size());
+    }
+    const uint16_t crc = memfault_crc16_compute(
+      MEMFAULT_CRC16_INITIAL_VALUE, s_reassembly.data.data(), s_reassembly.data.size());
+    LONGS_EQUAL(crc, chunk[chunk_len - 2] | (chunk[chunk_len - 1] << 8));
+    s_completed_msgs.push_back(s_reassembly.data);
+  }
+}
+
+//! Fetches the next chunk with memfault_packetizer_get_chunk() and reassembles it
+static void prv_get_and_process_chunk(size_t buf_len) {
+  uint8_t buf[256];
+  CHECK(buf_len <= sizeof(buf));
+  CHECK(memfault_packetizer_get_chunk(buf, &buf_len));
+  prv_process_chunk(buf, buf_len);
+}
+
+//! Sends chunks until no message is in progress
+static void prv_drain_message(size_t buf_len) {
+  while (s_reassembly.in_progress) {
+    prv_get_and_process_chunk(buf_len);
+  }
+}
+
+static void prv_check_coredump_msg(const std::vector<uint8_t> &msg) {
+  LONGS_EQUAL(1 + sizeof(s_fake_coredump), msg.size());
+  LONGS_EQUAL(MSG_TYPE_COREDUMP, msg[0]);
+  MEMCMP_EQUAL(s_fake_coredump, &msg[1], sizeof(s_fake_coredump));
+}
+
+static void prv_check_event_msg(const std::vector<uint8_t> &msg) {
+  LONGS_EQUAL(1 + sizeof(s_fake_event), msg.size());
+  LONGS_EQUAL(MSG_TYPE_EVENT, msg[0]);
+  MEMCMP_EQUAL(s_fake_event, &msg[1], sizeof(s_fake_event));
+}
+
+TEST_GROUP(MemfaultDataPacketizerPriorityChannels) {
+  void setup() {
+    memfault_packetizer_abort();
+    for (size_t i = 0; i < sizeof(s_fake_coredump); i++) {
+      s_fake_coredump[i] = (uint8_t)i;
+    }
+    s_has_coredump = false;
+    s_coredump_mark_read_count = 0;
+    s_num_events_queued = 0;
+    s_event_mark_read_count = 0;
+    s_reassembly = sReassembly();
+    s_completed_msgs.clear();
+  }
+  void teardown() {
+    // every message should have been sent in full
+    CHECK(!s_reassembly.in_progress);
+    mock().checkExpectations();
+    mock().clear();
+  }
+};
+
+TEST(MemfaultDataPacketizerPriorityChannels, Test_EventsSentAheadOfQueuedCoredump) {
+  const size_t chunk_len = 32;
+  s_has_coredump = true;
+  s_num_events_queued = 2;
+
+  // events are sent first, even though the coredump data source is checked first by default
+  prv_get_and_process_chunk(chunk_len);
+  prv_get_and_process_chunk(chunk_len);
+  LONGS_EQUAL(2, s_event_mark_read_count);
+  LONGS_EQUAL(0, s_coredump_mark_read_count);
+
+  prv_get_and_process_chunk(chunk_len);
+  prv_drain_message(chunk_len);
+  LONGS_EQUAL(1, s_coredump_mark_read_count);
+
+  LONGS_EQUAL(3, s_completed_msgs.size());
+  prv_check_event_msg(s_completed_msgs[0]);
+  prv_check_event_msg(s_completed_msgs[1]);
+  prv_check_coredump_msg(s_completed_msgs[2]);
+}
+
+TEST(MemfaultDataPacketizerPriorityChannels, Test_InFlightCoredumpNotPreempted) {
+  const size_t chunk_len = 32;
+  s_has_coredump = true;
+
+  prv_get_and_process_chunk(chunk_len);
+  CHECK(s_reassembly.in_progress);
+
+  // an event recorded mid-message is only sent once the coredump has been sent in full, so the
+  // chunks of different messages are never interleaved
+  s_num_events_queued = 1;
+  prv_drain_message(chunk_len);
+  LONGS_EQUAL(0, s_event_mark_read_count);
+  LONGS_EQUAL(1, s_coredump_mark_read_count);
+
+  prv_get_and_process_chunk(chunk_len);
+  LONGS_EQUAL(1, s_event_mark_read_count);
+
+  LONGS_EQUAL(2, s_completed_msgs.size());
+  prv_check_coredump_msg(s_completed_msgs[0]);
+  prv_check_event_msg(s_completed_msgs[1]);
+}
+
+TEST(MemfaultDataPacketizerPriorityChannels, Test_DataAvailableWhileMessageInFlight) {
+  CHECK(!memfault_packetizer_data_available());
+
+  s_has_coredump = true;
+  CHECK(memfault_packetizer_data_available());
+  prv_get_and_process_chunk(MEMFAULT_PACKETIZER_MIN_BUF_LEN);
+
+  // The coredump remains queued in its data source until it has been sent in full
+  CHECK(s_has_coredump);
+  CHECK(memfault_packetizer_data_available());
+
+  while (memfault_packetizer_data_available()) {
+    prv_get_and_process_chunk(64);
+  }
+  LONGS_EQUAL(1, s_completed_msgs.size());
+  prv_check_coredump_msg(s_completed_msgs[0]);
+}
+
+TEST(MemfaultDataPacketizerPriorityChannels, Test_AbortRestartsInFlightMessages) {
+  uint8_t buf[32];
+  size_t buf_len = sizeof(buf);
+  s_has_coredump = true;
+  CHECK(memfault_packetizer_get_chunk(buf, &buf_len));
+  // the first chunk of a message is an INIT chunk with more data to follow
+  LONGS_EQUAL(0x40, buf[0] & ~0x38);
+
+  memfault_packetizer_abort();
+
+  // the coredump is re-sent from the beginning
+  prv_get_and_process_chunk(sizeof(buf));
+  prv_drain_message(sizeof(buf));
+  LONGS_EQUAL(1, s_completed_msgs.size());
+  prv_check_coredump_msg(s_completed_msgs[0]);
+}
+
+TEST(MemfaultDataPacketizerPriorityChannels, Test_MultiPacketChunkNotPreempted) {
+  const sMemfaultPacketizerConfig cfg = {
+    .enable_multi_packet_chunk = true,
+  };
+  sMemfaultPacketizerMetadata metadata;
+  s_has_coredump = true;
+
+  CHECK(memfault_packetizer_begin(&cfg, &metadata));
+  CHECK(!metadata.send_in_progress);
+  LONGS_EQUAL(1 /* chunk hdr */ + 1 /* msg hdr */ + sizeof(s_fake_coredump) + 2 /* crc */,
+              metadata.single_chunk_message_length);
+
+  std::vector<uint8_t> chunk(metadata.single_chunk_message_length);
+  size_t bytes_received = 0;
+  eMemfaultPacketizerStatus status;
+  do {
+    size_t buf_len = MEMFAULT_MIN(64, chunk.size() - bytes_received);
+    status = memfault_packetizer_get_next(&chunk[bytes_received], &buf_len);
+    bytes_received += buf_len;
+
+    // an event recorded mid-chunk has to wait for the chunk to complete
+    s_num_events_queued = 1;
+    CHECK(memfault_packetizer_begin(&cfg, &metadata));
+    CHECK((status != kMemfaultPacketizerStatus_MoreDataForChunk) || metadata.send_in_progress);
+  } while (status == kMemfaultPacketizerStatus_MoreDataForChunk);
+
+  LONGS_EQUAL(kMemfaultPacketizerStatus_EndOfChunk, status);
+  LONGS_EQUAL(chunk.size(), bytes_received);
+  LONGS_EQUAL(0, s_event_mark_read_count);
+  prv_process_chunk(chunk.data(), chunk.size());
+  prv_check_coredump_msg(s_completed_msgs[0]);
+
+  // with the coredump sent, the event is up next
+  LONGS_EQUAL(sizeof(s_fake_event) + 1 /* msg hdr */ + 3 /* chunk overhead */,
+              metadata.single_chunk_message_length);
+  size_t buf_len = chunk.size();
+  LONGS_EQUAL(kMemfaultPacketizerStatus_EndOfChunk,
+              memfault_packetizer_get_next(chunk.data(), &buf_len));
+  prv_process_chunk(chunk.data(), buf_len);
+  prv_check_event_msg(s_completed_msgs[1]);
+  LONGS_EQUAL(1, s_event_mark_read_count);
+}
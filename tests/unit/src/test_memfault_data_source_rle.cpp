@@ -14,10 +14,13 @@ extern "C" {
 #include <stdio.h>
 #include <string.h>
 
+#include "memfault/config.h"
 #include "memfault/core/data_source_rle.h"
 
 static const uint8_t *s_active_data = NULL;
 static size_t s_active_data_size = 0;
+static size_t s_backing_bytes_read = 0;
+static size_t s_cached_rle_size = 0;
 }
 
 static bool prv_has_msgs(size_t *total_size_out) {
@@ -27,9 +30,15 @@ static bool prv_has_msgs(size_t *total_size_out) {
 
 static bool prv_read_msg_data(uint32_t offset, void *buf, size_t buf_len) {
   memcpy(buf, &s_active_data[offset], buf_len);
+  s_backing_bytes_read += buf_len;
   return true;
 }
 
+static bool prv_get_rle_size(size_t *rle_size) {
+  *rle_size = s_cached_rle_size;
+  return (s_cached_rle_size != 0);
+}
+
 static void prv_mark_msg_read(void) {
   s_active_data = NULL;
   s_active_data_size = 0;
@@ -41,10 +50,19 @@ static const sMemfaultDataSourceImpl s_test_data_source = {
   .mark_msg_read_cb = prv_mark_msg_read,
 };
 
+static const sMemfaultDataSourceImpl s_test_data_source_with_rle_size = {
+  .has_more_msgs_cb = prv_has_msgs,
+  .read_msg_cb = prv_read_msg_data,
+  .mark_msg_read_cb = prv_mark_msg_read,
+  .get_rle_size_cb = prv_get_rle_size,
+};
+
 TEST_GROUP(MemfaultDataSourceRle) {
   void setup() {
     s_active_data = NULL;
     s_active_data_size = 0;
+    s_backing_bytes_read = 0;
+    s_cached_rle_size = 0;
     memfault_data_source_rle_encoder_set_active(&s_test_data_source);
   }
   void teardown() {
@@ -120,3 +138,54 @@ TEST(MemfaultDataSourceRle, Test_DataSourceMultiByteVarintAndEndsWithNonRepeat)
 
   prv_check_pattern(fake_core, sizeof(fake_core), expected_core_rle, sizeof(expected_core_rle));
 }
+
+TEST(MemfaultDataSourceRle, Test_DataSourceSingleReadPass) {
+  // a pattern with many short sequences that fits within one read window
+  uint8_t fake_core[MEMFAULT_DATA_SOURCE_RLE_READ_BUF_SIZE];
+  for (size_t i = 0; i < sizeof(fake_core); i++) {
+    fake_core[i] = (uint8_t)((i / 3) % 2);
+  }
+  s_active_data = fake_core;
+  s_active_data_size = sizeof(fake_core);
+
+  size_t total_size = 0;
+  CHECK(memfault_data_source_rle_has_more_msgs(&total_size));
+  LONGS_EQUAL(sizeof(fake_core), s_backing_bytes_read);
+
+  // the backing data should only be read once while encoding, regardless of how many sequences
+  // are found
+  s_backing_bytes_read = 0;
+  uint8_t rle_buf[total_size];
+  prv_get_coredump_data(rle_buf, sizeof(rle_buf), 7);
+  LONGS_EQUAL(sizeof(fake_core), s_backing_bytes_read);
+}
+
+TEST(MemfaultDataSourceRle, Test_DataSourceCachedRleSize) {
+  const uint8_t fake_core[] = { 1, 1, 2, 3, 4, 5, 5, 5, 5, 5, 6, 9, 9, 9, 9 };
+  const uint8_t expected_core_rle[] = { 4, 1, 5, 2, 3, 4, 10, 5, 1, 6, 8, 9 };
+
+  memfault_data_source_rle_encoder_set_active(&s_test_data_source_with_rle_size);
+  s_active_data = fake_core;
+  s_active_data_size = sizeof(fake_core);
+  s_cached_rle_size = sizeof(expected_core_rle);
+
+  // the size is known up front so no backing reads are needed to compute it
+  size_t total_size = 0;
+  CHECK(memfault_data_source_rle_has_more_msgs(&total_size));
+  LONGS_EQUAL(sizeof(expected_core_rle), total_size);
+  LONGS_EQUAL(0, s_backing_bytes_read);
+
+  uint8_t rle_buf[sizeof(expected_core_rle)];
+  prv_get_coredump_data(rle_buf, sizeof(rle_buf), 5);
+  MEMCMP_EQUAL(expected_core_rle, rle_buf, sizeof(expected_core_rle));
+  LONGS_EQUAL(sizeof(fake_core), s_backing_bytes_read);
+  memfault_data_source_rle_mark_msg_read();
+
+  // fall back to computing the size if the data source doesn't know it
+  s_active_data = fake_core;
+  s_active_data_size = sizeof(fake_core);
+  s_cached_rle_size = 0;
+  CHECK(memfault_data_source_rle_has_more_msgs(&total_size));
+  LONGS_EQUAL(sizeof(expected_core_rle), total_size);
+  LONGS_EQUAL(2 * sizeof(fake_core), s_backing_bytes_read);
+}
@@ -133,6 +133,170 @@ TEST(MemfaultEventStorage, Test_ApiMisuse) {
   CHECK(!success);
 }
 
+  #if MEMFAULT_EVENT_STORAGE_RESERVED_WRITES_ENABLED
+
+static void prv_reserve_and_write(sMemfaultEventStorageReservation *reservation,
+                                  const void *data, size_t data_len) {
+  CHECK(s_storage_impl->reserve_cb(data_len, reservation));
+  CHECK(s_storage_impl->write_reserved_cb(reservation, data, data_len));
+}
+
+TEST(MemfaultEventStorage, Test_ReservedWritesCommitOutOfOrder) {
+  // two 1-byte events, overhead is the same as for regular writes
+  const uint8_t evt1 = 0x1;
+  const uint8_t evt2 = 0x2;
+  sMemfaultEventStorageReservation res1;
+  sMemfaultEventStorageReservation res2;
+  prv_reserve_and_write(&res1, &evt1, sizeof(evt1));
+  prv_reserve_and_write(&res2, &evt2, sizeof(evt2));
+  LONGS_EQUAL(2 * (1 + MEMFAULT_STORAGE_OVERHEAD), memfault_event_storage_bytes_used());
+
+  // can't write past the reserved size
+  CHECK(!s_storage_impl->write_reserved_cb(&res2, &evt2, sizeof(evt2)));
+
+  // regular writes are blocked while reservations are outstanding
+  LONGS_EQUAL(0, s_storage_impl->begin_write_cb());
+  s_storage_impl->finish_write_cb(true);
+
+  // the second event isn't readable until the first is committed
+  CHECK(s_storage_impl->commit_reserved_cb(&res2, false));
+  prv_assert_no_more_events();
+  CHECK(s_storage_impl->commit_reserved_cb(&res1, false));
+
+  uint8_t expected = evt1;
+  prv_assert_read(&expected, sizeof(expected));
+  expected = evt2;
+  prv_assert_read(&expected, sizeof(expected));
+  prv_assert_no_more_events();
+
+  // and regular writes work again
+  CHECK(s_storage_impl->begin_write_cb() != 0);
+  s_storage_impl->finish_write_cb(true);
+}
+
+TEST(MemfaultEventStorage, Test_ReservedWritesRollback) {
+  const uint8_t evt1 = 0x1;
+  const uint8_t evt2 = 0x2;
+  const uint8_t evt3 = 0x3;
+  sMemfaultEventStorageReservation res1;
+  sMemfaultEventStorageReservation res2;
+  sMemfaultEventStorageReservation res3;
+  prv_reserve_and_write(&res1, &evt1, sizeof(evt1));
+  prv_reserve_and_write(&res2, &evt2, sizeof(evt2));
+
+  // rolling back the most recent reservation frees its space immediately
+  s_storage_impl->commit_reserved_cb(&res2, true);
+  LONGS_EQUAL(1 + MEMFAULT_STORAGE_OVERHEAD, memfault_event_storage_bytes_used());
+
+  // rolling back an earlier one leaves a discarded event in place, as does committing one that
+  // was never written to
+  CHECK(s_storage_impl->reserve_cb(sizeof(evt2), &res2));
+  prv_reserve_and_write(&res3, &evt3, sizeof(evt3));
+  CHECK(!s_storage_impl->commit_reserved_cb(&res1, true));
+  CHECK(!s_storage_impl->commit_reserved_cb(&res2, false));
+  CHECK(s_storage_impl->commit_reserved_cb(&res3, false));
+  LONGS_EQUAL(3 * (1 + MEMFAULT_STORAGE_OVERHEAD), memfault_event_storage_bytes_used());
+
+  // which the reader skips over
+  uint8_t expected = evt3;
+  prv_assert_read(&expected, sizeof(expected));
+  prv_assert_no_more_events();
+  LONGS_EQUAL(0, memfault_event_storage_bytes_used());
+}
+
+TEST(MemfaultEventStorage, Test_ReservedWritesTrimmed) {
+  // the space not written to is released when the most recent reservation is committed
+  const uint8_t evt1[] = { 0x1, 0x2 };
+  sMemfaultEventStorageReservation res1;
+  CHECK(s_storage_impl->reserve_cb(5, &res1));
+  LONGS_EQUAL(5, res1.size);
+  CHECK(s_storage_impl->write_reserved_cb(&res1, evt1, sizeof(evt1)));
+  CHECK(s_storage_impl->commit_reserved_cb(&res1, false));
+  LONGS_EQUAL(sizeof(evt1) + MEMFAULT_STORAGE_OVERHEAD, memfault_event_storage_bytes_used());
+
+  uint8_t expected[sizeof(evt1)];
+  memcpy(expected, evt1, sizeof(evt1));
+  prv_assert_read(expected, sizeof(expected));
+  prv_assert_no_more_events();
+}
+
+TEST(MemfaultEventStorage, Test_ReservedWritesTrimmedBeforeLaterReservation) {
+  // otherwise the unused space is left in place as a discarded event
+  const uint8_t evt1[] = { 0x1, 0x2 };
+  const uint8_t evt2 = 0x3;
+  sMemfaultEventStorageReservation res1;
+  sMemfaultEventStorageReservation res2;
+  CHECK(s_storage_impl->reserve_cb(5, &res1));
+  CHECK(s_storage_impl->write_reserved_cb(&res1, evt1, sizeof(evt1)));
+  prv_reserve_and_write(&res2, &evt2, sizeof(evt2));
+  CHECK(s_storage_impl->commit_reserved_cb(&res1, false));
+  CHECK(s_storage_impl->commit_reserved_cb(&res2, false));
+  LONGS_EQUAL(5 + 1 + 2 * MEMFAULT_STORAGE_OVERHEAD, memfault_event_storage_bytes_used());
+
+  uint8_t expected[sizeof(evt1)];
+  memcpy(expected, evt1, sizeof(evt1));
+  prv_assert_read(expected, sizeof(expected));
+  expected[0] = evt2;
+  prv_assert_read(expected, sizeof(evt2));
+  prv_assert_no_more_events();
+  LONGS_EQUAL(0, memfault_event_storage_bytes_used());
+}
+
+TEST(MemfaultEventStorage, Test_ReservedWritesSingleByteTailMoved) {
+  // a single unused byte can't hold a discarded event header, so the event is moved to the end
+  // of storage instead
+  const uint8_t evt1 = 0x1;
+  const uint8_t evt2 = 0x2;
+  sMemfaultEventStorageReservation res1;
+  sMemfaultEventStorageReservation res2;
+  CHECK(s_storage_impl->reserve_cb(2, &res1));
+  CHECK(s_storage_impl->write_reserved_cb(&res1, &evt1, sizeof(evt1)));
+  prv_reserve_and_write(&res2, &evt2, sizeof(evt2));
+  CHECK(s_storage_impl->commit_reserved_cb(&res1, false));
+  LONGS_EQUAL(2 + 1 + 1 + 3 * MEMFAULT_STORAGE_OVERHEAD, memfault_event_storage_bytes_used());
+  prv_assert_no_more_events();
+  CHECK(s_storage_impl->commit_reserved_cb(&res2, false));
+
+  uint8_t expected = evt2;
+  prv_assert_read(&expected, sizeof(expected));
+  expected = evt1;
+  prv_assert_read(&expected, sizeof(expected));
+  prv_assert_no_more_events();
+  LONGS_EQUAL(0, memfault_event_storage_bytes_used());
+
+  // and is dropped if there's no space to move it to
+  CHECK(s_storage_impl->reserve_cb(3, &res1));
+  CHECK(s_storage_impl->write_reserved_cb(&res1, &evt1, sizeof(evt1)));
+  CHECK(s_storage_impl->write_reserved_cb(&res1, &evt1, sizeof(evt1)));
+  CHECK(s_storage_impl->reserve_cb(4, &res2));
+  LONGS_EQUAL(4, res2.size);
+  CHECK(s_storage_impl->write_reserved_cb(&res2, &evt2, sizeof(evt2)));
+  CHECK(!s_storage_impl->commit_reserved_cb(&res1, false));
+  CHECK(s_storage_impl->commit_reserved_cb(&res2, false));
+  expected = evt2;
+  prv_assert_read(&expected, sizeof(expected));
+  prv_assert_no_more_events();
+}
+
+TEST(MemfaultEventStorage, Test_ReservedWritesFull) {
+  // when less space is free than requested, all of it is reserved
+  sMemfaultEventStorageReservation res;
+  CHECK(!s_storage_impl->reserve_cb(0, &res));
+  CHECK(s_storage_impl->reserve_cb(s_ram_store_size, &res));
+  LONGS_EQUAL(s_ram_store_size - MEMFAULT_STORAGE_OVERHEAD, res.size);
+  sMemfaultEventStorageReservation res2;
+  CHECK(!s_storage_impl->reserve_cb(1, &res2));
+  CHECK(!s_storage_impl->commit_reserved_cb(&res, true));
+  LONGS_EQUAL(0, memfault_event_storage_bytes_used());
+
+  // reservations are blocked while a regular write is in progress
+  CHECK(s_storage_impl->begin_write_cb() != 0);
+  CHECK(!s_storage_impl->reserve_cb(1, &res));
+  s_storage_impl->finish_write_cb(true);
+}
+
+  #endif /* MEMFAULT_EVENT_STORAGE_RESERVED_WRITES_ENABLED */
+
   #if MEMFAULT_EVENT_STORAGE_READ_BATCHING_ENABLED == 0
 
 TEST(MemfaultEventStorage, Test_MemfaultMultiEvent) {
@@ -306,6 +470,38 @@ TEST(MemfaultEventStorage, Test_MemfaultMultiEventLimited) {
   LONGS_EQUAL(0, event_size);
 }
 
+// Reads of a batch may rewind, for example when a transport retries a chunk
+TEST(MemfaultEventStorage, Test_MemfaultMultiEventNonSequentialReads) {
+  const uint8_t event1[] = { 0x1, 0x2 };
+  const uint8_t event2[] = { 0x3 };
+  bool rollback = false;
+  prv_write_payload(&event1, sizeof(event1), rollback);
+  prv_write_payload(&event2, sizeof(event2), rollback);
+
+  size_t event_size;
+  CHECK(prv_fake_event_impl_has_event(&event_size));
+  const uint8_t expected_data[] = { 0xAB, 0x02, 0x1, 0x2, 0x3 };
+  LONGS_EQUAL(sizeof(expected_data), event_size);
+
+  // read backwards, one byte at a time
+  uint8_t actual_data[sizeof(expected_data)];
+  memset(actual_data, 0x0, sizeof(actual_data));
+  for (size_t i = sizeof(actual_data); i > 0; i--) {
+    CHECK(prv_fake_event_impl_read(i - 1, &actual_data[i - 1], 1));
+  }
+  MEMCMP_EQUAL(expected_data, actual_data, sizeof(actual_data));
+
+  // read the last event, then the span across both events again
+  memset(actual_data, 0x0, sizeof(actual_data));
+  CHECK(prv_fake_event_impl_read(4, &actual_data[4], 1));
+  CHECK(prv_fake_event_impl_read(2, &actual_data[2], 3));
+  CHECK(prv_fake_event_impl_read(0, &actual_data[0], 2));
+  MEMCMP_EQUAL(expected_data, actual_data, sizeof(actual_data));
+
+  prv_fake_event_impl_mark_event_read();
+  prv_assert_no_more_events();
+}
+
   #endif /* MEMFAULT_EVENT_STORAGE_MAX_READ_BATCH_LEN */
 //
 // We use a compilation flag and run the test suite twice so we can test the default stub
@@ -0,0 +1,96 @@
+//! @file
+//!
+//! @brief
+//! Benchmark draining a full RAM event storage buffer as a single batch at a range of transport
+//! MTU sizes.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+
+#include "CppUTest/MemoryLeakDetectorMallocMacros.h"
+#include "CppUTest/MemoryLeakDetectorNewMacros.h"
+#include "CppUTest/TestHarness.h"
+#include "CppUTestExt/MockSupport.h"
+#include "fakes/fake_memfault_platform_metrics_locking.h"
+#include "memfault/core/data_packetizer_source.h"
+#include "memfault/core/event_storage.h"
+#include "memfault/core/event_storage_implementation.h"
+#include "memfault/core/math.h"
+
+extern "C" {
+// Declaration for test function used to reset event storage
+extern void memfault_event_storage_reset(void);
+}
+
+#define EVENT_PAYLOAD_SIZE (40)
+
+static uint8_t s_ram_store[16 * 1024];
+static uint8_t s_drained[sizeof(s_ram_store)];
+static const sMemfaultEventStorageImpl *s_storage_impl;
+
+TEST_GROUP(MemfaultEventStorageBenchmark) {
+  void setup() {
+    fake_memfault_metrics_platform_locking_reboot();
+    memfault_event_storage_reset();
+    s_storage_impl = memfault_events_storage_boot(s_ram_store, sizeof(s_ram_store));
+  }
+  void teardown() {
+    CHECK(fake_memfault_platform_metrics_lock_calls_balanced());
+    mock().checkExpectations();
+    mock().clear();
+  }
+};
+
+//! Fill the storage with events, returning the number written
+static size_t prv_fill_storage(void) {
+  size_t num_events = 0;
+  while (s_storage_impl->begin_write_cb() >= EVENT_PAYLOAD_SIZE) {
+    uint8_t payload[EVENT_PAYLOAD_SIZE];
+    memset(payload, (int)(num_events & 0xff), sizeof(payload));
+    CHECK(s_storage_impl->append_data_cb(payload, sizeof(payload)));
+    s_storage_impl->finish_write_cb(false);
+    num_events++;
+  }
+  // roll back the final, partial transaction
+  s_storage_impl->finish_write_cb(true);
+  return num_events;
+}
+
+TEST(MemfaultEventStorageBenchmark, Test_DrainFullStorage) {
+  const size_t mtu_sizes[] = { 20, 64, 244, 512, 1024 };
+
+  for (size_t i = 0; i < MEMFAULT_ARRAY_SIZE(mtu_sizes); i++) {
+    const size_t num_events = prv_fill_storage();
+    CHECK(num_events > 1);
+
+    size_t total_size;
+    CHECK(g_memfault_event_data_source.has_more_msgs_cb(&total_size));
+    CHECK(total_size <= sizeof(s_drained));
+
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t offset = 0; offset < total_size; offset += mtu_sizes[i]) {
+      const size_t read_len = MEMFAULT_MIN(mtu_sizes[i], total_size - offset);
+      CHECK(g_memfault_event_data_source.read_msg_cb(offset, &s_drained[offset], read_len));
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    printf("event storage drain: %d events, %d bytes, mtu %d: %lld us\n", (int)num_events,
+           (int)total_size, (int)mtu_sizes[i],
+           (long long)std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+
+    // the batch is the batch header followed by every event's payload, in order
+    const size_t events_offset = total_size - num_events * EVENT_PAYLOAD_SIZE;
+    for (size_t evt = 0; evt < num_events; evt++) {
+      const uint8_t *payload = &s_drained[events_offset + evt * EVENT_PAYLOAD_SIZE];
+      for (size_t b = 0; b < EVENT_PAYLOAD_SIZE; b++) {
+        LONGS_EQUAL(evt & 0xff, payload[b]);
+      }
+    }
+
+    g_memfault_event_data_source.mark_msg_read_cb();
+    CHECK(!g_memfault_event_data_source.has_more_msgs_cb(&total_size));
+  }
+}
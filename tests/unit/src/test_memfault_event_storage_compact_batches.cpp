@@ -0,0 +1,179 @@
+//! @file
+//!
+//! @brief
+//! Tests for the metadata of compact event batches read out of event storage
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "CppUTest/MemoryLeakDetectorMallocMacros.h"
+#include "CppUTest/MemoryLeakDetectorNewMacros.h"
+#include "CppUTest/TestHarness.h"
+#include "CppUTestExt/MockSupport.h"
+#include "fakes/fake_memfault_platform_get_device_info.h"
+#include "fakes/fake_memfault_platform_metrics_locking.h"
+#include "memfault/core/batched_events.h"
+#include "memfault/core/data_packetizer_source.h"
+#include "memfault/core/event_storage.h"
+#include "memfault/core/event_storage_implementation.h"
+#include "memfault/core/math.h"
+#include "memfault/core/platform/device_info.h"
+
+extern "C" {
+// Declaration for test function used to reset event storage
+extern void memfault_event_storage_reset(void);
+}
+
+static uint8_t s_ram_store[64];
+static const sMemfaultEventStorageImpl *s_storage_impl;
+static const char *s_original_software_version;
+
+static const uint8_t s_evt_a[] = { 0xa, 0xa, 0xa };
+static const uint8_t s_evt_b[] = { 0xb, 0xb };
+static const uint8_t s_evt_c[] = { 0xc };
+
+TEST_GROUP(MemfaultEventStorageCompactBatches) {
+  void setup() {
+    fake_memfault_metrics_platform_locking_reboot();
+    memfault_event_storage_reset();
+    s_storage_impl = memfault_events_storage_boot(s_ram_store, sizeof(s_ram_store));
+    s_original_software_version = g_fake_device_info.software_version;
+    memfault_event_storage_read_metadata_drop_count();
+  }
+  void teardown() {
+    g_fake_device_info.software_version = s_original_software_version;
+    CHECK(fake_memfault_platform_metrics_lock_calls_balanced());
+    mock().checkExpectations();
+    mock().clear();
+  }
+};
+
+static bool prv_write_event(const void *data, size_t data_len, bool rollback) {
+  const size_t space_available = s_storage_impl->begin_write_cb();
+  if (space_available == 0) {
+    return false;
+  }
+  CHECK(s_storage_impl->append_data_cb(data, data_len));
+  s_storage_impl->finish_write_cb(rollback);
+  return true;
+}
+
+static void prv_set_software_version(const char *software_version) {
+  g_fake_device_info.software_version = software_version;
+  memfault_device_info_changed();
+}
+
+//! Reads out the next batch, checking it holds the events that were written with the
+//! metadata of the given software version
+static void prv_assert_read_batch(const char *software_version, const uint8_t *events,
+                                  size_t events_len, size_t num_events) {
+  const char *current_software_version = g_fake_device_info.software_version;
+  g_fake_device_info.software_version = software_version;
+  sMemfaultBatchedEventsMetadata metadata;
+  CHECK(memfault_batched_events_capture_metadata(&metadata));
+  g_fake_device_info.software_version = current_software_version;
+
+  sMemfaultBatchedEventsHeader header;
+  memfault_batched_events_build_compact_header(num_events, &metadata, &header);
+
+  size_t total_size = 0;
+  CHECK(g_memfault_event_data_source.has_more_msgs_cb(&total_size));
+  LONGS_EQUAL(header.length + events_len, total_size);
+
+  uint8_t result[total_size];
+  CHECK(g_memfault_event_data_source.read_msg_cb(0, result, sizeof(result)));
+  MEMCMP_EQUAL(header.data, result, header.length);
+  MEMCMP_EQUAL(events, &result[header.length], events_len);
+
+  g_memfault_event_data_source.mark_msg_read_cb();
+}
+
+static void prv_assert_no_more_events(void) {
+  size_t total_size = 0;
+  CHECK_FALSE(g_memfault_event_data_source.has_more_msgs_cb(&total_size));
+}
+
+TEST(MemfaultEventStorageCompactBatches, Test_BatchEndsWhenMetadataChanges) {
+  CHECK(prv_write_event(s_evt_a, sizeof(s_evt_a), false));
+  prv_set_software_version("1.2.4");
+  CHECK(prv_write_event(s_evt_b, sizeof(s_evt_b), false));
+  CHECK(prv_write_event(s_evt_c, sizeof(s_evt_c), false));
+
+  // the first event is sent with the metadata from when it was written
+  prv_assert_read_batch("1.2.3", s_evt_a, sizeof(s_evt_a), 1);
+
+  const uint8_t expected_bc[] = { 0xb, 0xb, 0xc };
+  prv_assert_read_batch("1.2.4", expected_bc, sizeof(expected_bc), 2);
+  prv_assert_no_more_events();
+}
+
+TEST(MemfaultEventStorageCompactBatches, Test_MetadataChangedTwice) {
+  CHECK(prv_write_event(s_evt_a, sizeof(s_evt_a), false));
+  prv_set_software_version("1.2.4");
+  CHECK(prv_write_event(s_evt_b, sizeof(s_evt_b), false));
+  prv_set_software_version("1.2.5");
+  CHECK(prv_write_event(s_evt_c, sizeof(s_evt_c), false));
+
+  prv_assert_read_batch("1.2.3", s_evt_a, sizeof(s_evt_a), 1);
+  prv_assert_read_batch("1.2.4", s_evt_b, sizeof(s_evt_b), 1);
+  prv_assert_read_batch("1.2.5", s_evt_c, sizeof(s_evt_c), 1);
+  prv_assert_no_more_events();
+  LONGS_EQUAL(0, memfault_event_storage_read_metadata_drop_count());
+}
+
+TEST(MemfaultEventStorageCompactBatches, Test_TooManyMetadataChanges) {
+  const char *versions[] = { "1.2.3", "1.2.4", "1.2.5", "1.2.6", "1.2.7" };
+  CHECK(MEMFAULT_ARRAY_SIZE(versions) > MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_MAX_GENERATIONS);
+  for (size_t i = 0; i < MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_MAX_GENERATIONS; i++) {
+    prv_set_software_version(versions[i]);
+    CHECK(prv_write_event(s_evt_c, sizeof(s_evt_c), false));
+  }
+
+  // once every generation is in use, events with new metadata are dropped and counted
+  const size_t next_version = MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_MAX_GENERATIONS;
+  prv_set_software_version(versions[next_version]);
+  CHECK_FALSE(prv_write_event(s_evt_a, sizeof(s_evt_a), false));
+  CHECK_FALSE(prv_write_event(s_evt_b, sizeof(s_evt_b), false));
+  LONGS_EQUAL(2, memfault_event_storage_read_metadata_drop_count());
+  LONGS_EQUAL(0, memfault_event_storage_read_metadata_drop_count());
+
+  // reading out the oldest events frees up a generation
+  prv_assert_read_batch(versions[0], s_evt_c, sizeof(s_evt_c), 1);
+  CHECK(prv_write_event(s_evt_a, sizeof(s_evt_a), false));
+
+  for (size_t i = 1; i < MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_MAX_GENERATIONS; i++) {
+    prv_assert_read_batch(versions[i], s_evt_c, sizeof(s_evt_c), 1);
+  }
+  prv_assert_read_batch(versions[next_version], s_evt_a, sizeof(s_evt_a), 1);
+  prv_assert_no_more_events();
+}
+
+TEST(MemfaultEventStorageCompactBatches, Test_RolledBackWriteWithNewMetadata) {
+  CHECK(prv_write_event(s_evt_a, sizeof(s_evt_a), false));
+  prv_set_software_version("1.2.4");
+  CHECK(prv_write_event(s_evt_b, sizeof(s_evt_b), true));
+  prv_set_software_version("1.2.3");
+  CHECK(prv_write_event(s_evt_c, sizeof(s_evt_c), false));
+
+  // nothing was stored with the other metadata, so the events are sent together
+  const uint8_t expected_ac[] = { 0xa, 0xa, 0xa, 0xc };
+  prv_assert_read_batch("1.2.3", expected_ac, sizeof(expected_ac), 2);
+  prv_assert_no_more_events();
+}
+
+TEST(MemfaultEventStorageCompactBatches, Test_MetadataTooLarge) {
+  char software_version[MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_METADATA_MAX_LEN + 1];
+  memset(software_version, 'a', sizeof(software_version) - 1);
+  software_version[sizeof(software_version) - 1] = '\0';
+
+  // the event is not stored, instead of failing when the batch is read
+  prv_set_software_version(software_version);
+  CHECK_FALSE(prv_write_event(s_evt_a, sizeof(s_evt_a), false));
+  prv_assert_no_more_events();
+  LONGS_EQUAL(1, memfault_event_storage_read_metadata_drop_count());
+
+  prv_set_software_version(s_original_software_version);
+  CHECK(prv_write_event(s_evt_b, sizeof(s_evt_b), false));
+  prv_assert_read_batch(s_original_software_version, s_evt_b, sizeof(s_evt_b), 1);
+}
@@ -0,0 +1,180 @@
+//! @file
+//!
+//! @brief
+//! Stress test for reserved event storage writes: several POSIX threads serialize events into
+//! the RAM event storage concurrently while another thread drains it.
+
+#include <pthread.h>
+#include <sched.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "CppUTest/MemoryLeakDetectorMallocMacros.h"
+#include "CppUTest/MemoryLeakDetectorNewMacros.h"
+#include "CppUTest/TestHarness.h"
+#include "CppUTestExt/MockSupport.h"
+#include "memfault/core/data_packetizer_source.h"
+#include "memfault/core/event_storage.h"
+#include "memfault/core/event_storage_implementation.h"
+#include "memfault/core/platform/overrides.h"
+#include "memfault/core/serializer_helper.h"
+#include "memfault/util/cbor.h"
+
+extern "C" {
+// Declaration for test function used to reset event storage
+extern void memfault_event_storage_reset(void);
+}
+
+#define NUM_PRODUCERS (4)
+#define EVENTS_PER_PRODUCER (2000)
+#define MAX_EVENT_PAYLOAD_LEN (48)
+
+static pthread_mutex_t s_memfault_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void memfault_lock(void) {
+  pthread_mutex_lock(&s_memfault_lock);
+}
+
+void memfault_unlock(void) {
+  pthread_mutex_unlock(&s_memfault_lock);
+}
+
+static uint8_t s_ram_store[4096];
+static const sMemfaultEventStorageImpl *s_storage_impl;
+
+typedef struct {
+  uint8_t producer_id;
+  uint32_t seq;
+} sStressEvent;
+
+//! Payload length varies per event so reservations of different sizes interleave
+static size_t prv_payload_len(uint32_t seq) {
+  return 5 + (seq % (MAX_EVENT_PAYLOAD_LEN - 5));
+}
+
+static void prv_build_payload(const sStressEvent *evt, uint8_t *payload, size_t payload_len) {
+  payload[0] = evt->producer_id;
+  memcpy(&payload[1], &evt->seq, sizeof(evt->seq));
+  for (size_t i = 5; i < payload_len; i++) {
+    payload[i] = (uint8_t)(evt->producer_id + evt->seq + i);
+  }
+}
+
+static bool prv_encode_cb(sMemfaultCborEncoder *encoder, void *ctx) {
+  const sStressEvent *evt = (const sStressEvent *)ctx;
+  uint8_t payload[MAX_EVENT_PAYLOAD_LEN];
+  const size_t payload_len = prv_payload_len(evt->seq);
+  prv_build_payload(evt, payload, payload_len);
+  return memfault_cbor_encode_byte_string(encoder, payload, payload_len);
+}
+
+static void *prv_producer_thread(void *arg) {
+  sStressEvent evt = { .producer_id = (uint8_t)(uintptr_t)arg, .seq = 0 };
+
+  while (evt.seq < EVENTS_PER_PRODUCER) {
+    sMemfaultCborEncoder encoder;
+    if (memfault_serializer_helper_encode_to_storage(&encoder, s_storage_impl, prv_encode_cb,
+                                                     &evt)) {
+      evt.seq++;
+    } else {
+      // storage full, wait for the consumer to catch up
+      sched_yield();
+    }
+  }
+  return NULL;
+}
+
+typedef struct {
+  uint32_t next_seq[NUM_PRODUCERS];
+  size_t events_received;
+  size_t errors;
+} sConsumerState;
+
+static bool prv_check_event(sConsumerState *state, const uint8_t *event, size_t event_len) {
+  // a CBOR byte string header (major type 2) followed by the payload
+  const size_t hdr_len = (event_len - 1) < 24 ? 1 : 2;
+  if ((event_len <= hdr_len) || ((event[0] >> 5) != 2)) {
+    return false;
+  }
+
+  const uint8_t *payload = &event[hdr_len];
+  const size_t payload_len = event_len - hdr_len;
+  sStressEvent evt = { .producer_id = payload[0], .seq = 0 };
+  if (evt.producer_id >= NUM_PRODUCERS) {
+    return false;
+  }
+  memcpy(&evt.seq, &payload[1], sizeof(evt.seq));
+
+  // events from a single producer must arrive in order, with none missing
+  if ((evt.seq != state->next_seq[evt.producer_id]) ||
+      (payload_len != prv_payload_len(evt.seq))) {
+    return false;
+  }
+  state->next_seq[evt.producer_id]++;
+
+  uint8_t expected[MAX_EVENT_PAYLOAD_LEN];
+  prv_build_payload(&evt, expected, payload_len);
+  return memcmp(expected, payload, payload_len) == 0;
+}
+
+static void *prv_consumer_thread(void *arg) {
+  sConsumerState *state = (sConsumerState *)arg;
+
+  while (state->events_received < (NUM_PRODUCERS * EVENTS_PER_PRODUCER)) {
+    size_t event_len;
+    if (!g_memfault_event_data_source.has_more_msgs_cb(&event_len)) {
+      sched_yield();
+      continue;
+    }
+
+    uint8_t event[MAX_EVENT_PAYLOAD_LEN + 2];
+    if ((event_len > sizeof(event)) ||
+        !g_memfault_event_data_source.read_msg_cb(0, event, event_len) ||
+        !prv_check_event(state, event, event_len)) {
+      state->errors++;
+      break;
+    }
+    g_memfault_event_data_source.mark_msg_read_cb();
+    state->events_received++;
+  }
+  return NULL;
+}
+
+TEST_GROUP(MemfaultEventStorageMultiProducer) {
+  void setup() {
+    memfault_event_storage_reset();
+    s_storage_impl = memfault_events_storage_boot(s_ram_store, sizeof(s_ram_store));
+    CHECK(s_storage_impl->reserve_cb != NULL);
+  }
+  void teardown() {
+    mock().checkExpectations();
+    mock().clear();
+  }
+};
+
+TEST(MemfaultEventStorageMultiProducer, Test_ConcurrentProducers) {
+  sConsumerState consumer_state = { 0 };
+  pthread_t consumer;
+  pthread_t producers[NUM_PRODUCERS];
+
+  LONGS_EQUAL(0, pthread_create(&consumer, NULL, prv_consumer_thread, &consumer_state));
+  for (uintptr_t i = 0; i < NUM_PRODUCERS; i++) {
+    LONGS_EQUAL(0, pthread_create(&producers[i], NULL, prv_producer_thread, (void *)i));
+  }
+
+  for (size_t i = 0; i < NUM_PRODUCERS; i++) {
+    LONGS_EQUAL(0, pthread_join(producers[i], NULL));
+  }
+  LONGS_EQUAL(0, pthread_join(consumer, NULL));
+
+  LONGS_EQUAL(0, consumer_state.errors);
+  LONGS_EQUAL(NUM_PRODUCERS * EVENTS_PER_PRODUCER, consumer_state.events_received);
+  for (size_t i = 0; i < NUM_PRODUCERS; i++) {
+    LONGS_EQUAL(EVENTS_PER_PRODUCER, consumer_state.next_seq[i]);
+  }
+
+  size_t event_len;
+  CHECK(!g_memfault_event_data_source.has_more_msgs_cb(&event_len));
+  LONGS_EQUAL(0, memfault_event_storage_bytes_used());
+}
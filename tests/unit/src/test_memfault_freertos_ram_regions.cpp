@@ -0,0 +1,104 @@
+//! @file
+//!
+//! @brief
+//! Tests for the FreeRTOS task region collection used when capturing a coredump
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "FreeRTOS.h"
+#include "memfault/config.h"
+#include "memfault/core/math.h"
+#include "memfault/ports/freertos_coredump.h"
+#include "task.h"
+
+#define TEST_NUM_TASKS 3
+#define TEST_TCB_WORDS (MEMFAULT_PLATFORM_FREERTOS_TCB_SIZE / sizeof(uintptr_t))
+#define TEST_STACK_WORDS (MEMFAULT_PLATFORM_TASK_STACK_SIZE_TO_COLLECT / sizeof(uintptr_t))
+
+// Stand-in for the RAM of the device, only addresses in here are valid
+static struct {
+  uintptr_t tcbs[TEST_NUM_TASKS][TEST_TCB_WORDS];
+  uintptr_t stacks[TEST_NUM_TASKS][TEST_STACK_WORDS];
+} s_fake_ram;
+
+// A "TCB" outside of RAM, which points at a stack that must never be collected
+static uintptr_t s_corrupt_tcb[TEST_TCB_WORDS];
+static uintptr_t s_poison_stack[TEST_STACK_WORDS];
+
+static size_t s_watermark_call_count;
+
+extern "C" {
+size_t memfault_platform_sanitize_address_range(void *start_addr, size_t desired_size) {
+  const uintptr_t ram_start = (uintptr_t)&s_fake_ram;
+  const uintptr_t ram_end = ram_start + sizeof(s_fake_ram);
+  const uintptr_t addr = (uintptr_t)start_addr;
+  if ((addr >= ram_start) && (addr < ram_end)) {
+    return MEMFAULT_MIN(desired_size, ram_end - addr);
+  }
+  return 0;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t xTask) {
+  CHECK(xTask != (TaskHandle_t)s_corrupt_tcb);
+  s_watermark_call_count++;
+  return 10;
+}
+}
+
+TEST_GROUP(MemfaultFreeRTOSRamRegions) {
+  void setup() {
+    s_watermark_call_count = 0;
+    for (size_t i = 0; i < TEST_NUM_TASKS; i++) {
+      // pxTopOfStack is the first entry of the TCB
+      s_fake_ram.tcbs[i][0] = (uintptr_t)&s_fake_ram.stacks[i][0];
+      memfault_freertos_trace_task_create(&s_fake_ram.tcbs[i][0]);
+    }
+    s_corrupt_tcb[0] = (uintptr_t)&s_poison_stack[0];
+  }
+
+  void teardown() {
+    for (size_t i = 0; i < TEST_NUM_TASKS; i++) {
+      memfault_freertos_trace_task_delete(&s_fake_ram.tcbs[i][0]);
+    }
+  }
+};
+
+TEST(MemfaultFreeRTOSRamRegions, Test_CorruptedTcbEntryIsScrubbed) {
+  sMfltCoredumpRegion regions[MEMFAULT_PLATFORM_MAX_TASK_REGIONS + 2];
+
+  // every task has a TCB and stack region, followed by the TCB array and the watermarks
+  size_t num_regions = memfault_freertos_get_task_regions(regions, MEMFAULT_ARRAY_SIZE(regions));
+  LONGS_EQUAL(2 * TEST_NUM_TASKS + 2, num_regions);
+  LONGS_EQUAL(TEST_NUM_TASKS, s_watermark_call_count);
+
+  const sMfltCoredumpRegion *tcbs_region = &regions[num_regions - 2];
+  LONGS_EQUAL(sizeof(void *) * MEMFAULT_PLATFORM_MAX_TRACKED_TASKS, tcbs_region->region_size);
+  void **task_tcbs = (void **)(uintptr_t)tcbs_region->region_start;
+  POINTERS_EQUAL(&s_fake_ram.tcbs[1][0], task_tcbs[1]);
+
+  // corrupt an entry of the TCB array, like a memory error in the firmware would
+  task_tcbs[1] = s_corrupt_tcb;
+  s_watermark_call_count = 0;
+
+  num_regions = memfault_freertos_get_task_regions(regions, MEMFAULT_ARRAY_SIZE(regions));
+  LONGS_EQUAL(2 * (TEST_NUM_TASKS - 1) + 2, num_regions);
+  LONGS_EQUAL(TEST_NUM_TASKS - 1, s_watermark_call_count);
+  POINTERS_EQUAL(NULL, task_tcbs[1]);
+
+  for (size_t i = 0; i < num_regions; i++) {
+    CHECK(regions[i].region_start != s_corrupt_tcb);
+    CHECK(regions[i].region_start != s_poison_stack);
+  }
+
+  // the remaining tasks are still collected
+  POINTERS_EQUAL(&s_fake_ram.tcbs[0][0], regions[0].region_start);
+  POINTERS_EQUAL(&s_fake_ram.tcbs[2][0], regions[1].region_start);
+  POINTERS_EQUAL(&s_fake_ram.stacks[0][0], regions[2].region_start);
+  POINTERS_EQUAL(&s_fake_ram.stacks[2][0], regions[3].region_start);
+
+  // put the task back so it can be removed from the registry
+  task_tcbs[1] = &s_fake_ram.tcbs[1][0];
+}
@@ -8,7 +8,9 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <algorithm>
 #include <random>
+#include <vector>
 
 #include "CppUTest/MemoryLeakDetectorMallocMacros.h"
 #include "CppUTest/MemoryLeakDetectorNewMacros.h"
@@ -562,3 +564,71 @@ TEST(MemfaultHeapStats, Test_NoCycle) {
     prv_run_list_checks();
   }
 }
+
+//! Freed entries should be recycled oldest-freed first, once all never-used entries are consumed
+TEST(MemfaultHeapStats, Test_FreedEntriesReusedInFreeOrder) {
+  // Fill up the heap stats pool
+  for (uintptr_t i = 0; i < MEMFAULT_HEAP_STATS_MAX_COUNT; i++) {
+    MEMFAULT_HEAP_STATS_MALLOC((void *)(0x1000 + i * 8), 1 + i);
+  }
+
+  // Free two entries, the later-indexed one first
+  const uint16_t first_freed = MEMFAULT_HEAP_STATS_MAX_COUNT - 2;
+  const uint16_t second_freed = 1;
+  MEMFAULT_HEAP_STATS_FREE((void *)(0x1000 + (uintptr_t)first_freed * 8));
+  MEMFAULT_HEAP_STATS_FREE((void *)(0x1000 + (uintptr_t)second_freed * 8));
+
+  MEMFAULT_HEAP_STATS_MALLOC((void *)0x9000, 1);
+  LONGS_EQUAL(first_freed, g_memfault_heap_stats.stats_pool_head);
+  MEMFAULT_HEAP_STATS_MALLOC((void *)0x9008, 1);
+  LONGS_EQUAL(second_freed, g_memfault_heap_stats.stats_pool_head);
+
+  // No freed entries left, the oldest allocation (index 0) is evicted
+  MEMFAULT_HEAP_STATS_MALLOC((void *)0x9010, 1);
+  LONGS_EQUAL(0, g_memfault_heap_stats.stats_pool_head);
+
+  // The evicted allocation is no longer tracked, so freeing it leaves the list untouched
+  MEMFAULT_HEAP_STATS_FREE((void *)0x1000);
+  LONGS_EQUAL(1, g_memfault_heap_stats_pool[0].info.in_use);
+}
+
+//! Compare the tracked list against a reference model over many random operations, using
+//! addresses that share most of their bits so the pointer lookup sees plenty of collisions
+TEST(MemfaultHeapStats, Test_MatchesReferenceModel) {
+  std::mt19937 gen(1234);
+  std::uniform_int_distribution<uintptr_t> address_generator(1, 4 * MEMFAULT_HEAP_STATS_MAX_COUNT);
+  std::uniform_int_distribution<> malloc_operation_generator(0, 2);
+
+  // tracked allocations, newest first
+  std::vector<uintptr_t> model;
+
+  for (size_t op = 0; op < 200 * MEMFAULT_HEAP_STATS_MAX_COUNT; op++) {
+    const uintptr_t addr = address_generator(gen) << 12;
+    auto it = std::find(model.begin(), model.end(), addr);
+    if (malloc_operation_generator(gen) != 0) {
+      if (it != model.end()) {
+        continue;  // only track an address once
+      }
+      MEMFAULT_HEAP_STATS_MALLOC((void *)addr, 8);
+      if (model.size() == MEMFAULT_HEAP_STATS_MAX_COUNT) {
+        model.pop_back();
+      }
+      model.insert(model.begin(), addr);
+    } else {
+      MEMFAULT_HEAP_STATS_FREE((void *)addr);
+      if (it != model.end()) {
+        model.erase(it);
+      }
+    }
+
+    uint16_t current_index = g_memfault_heap_stats.stats_pool_head;
+    for (size_t i = 0; i < model.size(); i++) {
+      CHECK(current_index != MEMFAULT_HEAP_STATS_LIST_END);
+      const sMfltHeapStatEntry *entry = &g_memfault_heap_stats_pool[current_index];
+      LONGS_EQUAL(model[i], (uintptr_t)entry->ptr);
+      LONGS_EQUAL(1, entry->info.in_use);
+      current_index = entry->info.next_entry_index;
+    }
+    LONGS_EQUAL(MEMFAULT_HEAP_STATS_LIST_END, current_index);
+  }
+}
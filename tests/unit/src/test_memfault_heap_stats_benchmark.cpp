@@ -0,0 +1,96 @@
+//! @file
+//!
+//! @brief
+//! Microbenchmark for the heap stats malloc/free hooks. Set HEAP_STATS_BENCHMARK_MAX_COUNT when
+//! running Makefile_memfault_heap_stats_benchmark.mk to compare the per-call cost against pool
+//! size.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTestExt/MockSupport.h"
+#include "fakes/fake_memfault_platform_metrics_locking.h"
+#include "memfault/core/heap_stats.h"
+#include "memfault/core/heap_stats_impl.h"
+
+#define BENCHMARK_ITERATIONS (200000)
+
+TEST_GROUP(MemfaultHeapStatsBenchmark) {
+  void setup() {
+    fake_memfault_metrics_platform_locking_reboot();
+    mock().disable();
+    memfault_heap_stats_reset();
+  }
+  void teardown() {
+    CHECK(fake_memfault_platform_metrics_lock_calls_balanced());
+    memfault_heap_stats_reset();
+    mock().checkExpectations();
+    mock().clear();
+  }
+};
+
+static void prv_report(const char *name, std::chrono::steady_clock::duration elapsed,
+                       size_t num_calls) {
+  const double ns =
+    (double)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+  printf("heap stats %s: pool size %d, %.1f ns/call\n", name, MEMFAULT_HEAP_STATS_MAX_COUNT,
+         ns / (double)num_calls);
+}
+
+static size_t prv_count_in_use_list(void) {
+  size_t count = 0;
+  uint16_t current_index = g_memfault_heap_stats.stats_pool_head;
+  while (current_index != MEMFAULT_HEAP_STATS_LIST_END) {
+    CHECK(count < MEMFAULT_HEAP_STATS_MAX_COUNT);
+    count++;
+    current_index = g_memfault_heap_stats_pool[current_index].info.next_entry_index;
+  }
+  return count;
+}
+
+//! Full pool of outstanding allocations: every free hits a random tracked entry and every malloc
+//! reuses the freed entry
+TEST(MemfaultHeapStatsBenchmark, Test_FreeMallocChurn) {
+  std::vector<uintptr_t> live;
+  for (uintptr_t i = 0; i < MEMFAULT_HEAP_STATS_MAX_COUNT; i++) {
+    live.push_back(0x20000000 + i * 16);
+    MEMFAULT_HEAP_STATS_MALLOC((void *)live.back(), 16);
+  }
+
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<size_t> victim(0, live.size() - 1);
+  std::vector<size_t> victims(BENCHMARK_ITERATIONS);
+  for (size_t &v : victims) {
+    v = victim(gen);
+  }
+
+  uintptr_t next_addr = 0x20000000 + MEMFAULT_HEAP_STATS_MAX_COUNT * 16;
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < BENCHMARK_ITERATIONS; i++) {
+    uintptr_t *slot = &live[victims[i]];
+    MEMFAULT_HEAP_STATS_FREE((void *)*slot);
+    *slot = next_addr;
+    next_addr += 16;
+    MEMFAULT_HEAP_STATS_MALLOC((void *)*slot, 16);
+  }
+  prv_report("free+malloc", std::chrono::steady_clock::now() - start, 2 * BENCHMARK_ITERATIONS);
+
+  LONGS_EQUAL(MEMFAULT_HEAP_STATS_MAX_COUNT, prv_count_in_use_list());
+}
+
+//! Allocations that are never freed: once the pool is full, every malloc evicts the oldest entry
+TEST(MemfaultHeapStatsBenchmark, Test_MallocEviction) {
+  const auto start = std::chrono::steady_clock::now();
+  for (uintptr_t i = 0; i < BENCHMARK_ITERATIONS; i++) {
+    MEMFAULT_HEAP_STATS_MALLOC((void *)(0x20000000 + i * 16), 16);
+  }
+  prv_report("malloc w/ eviction", std::chrono::steady_clock::now() - start, BENCHMARK_ITERATIONS);
+
+  LONGS_EQUAL(MEMFAULT_HEAP_STATS_MAX_COUNT, prv_count_in_use_list());
+}
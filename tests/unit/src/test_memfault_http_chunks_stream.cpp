@@ -0,0 +1,298 @@
+//! @file
+//!
+//! @brief
+//! End to end tests for streaming the packetizer backlog in a single chunks POST with
+//! "Transfer-Encoding: chunked". The request is decoded by a minimal stand-in for the chunks
+//! endpoint, which checks the reassembled chunks against the messages the packetizer returned.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "CppUTest/MemoryLeakDetectorMallocMacros.h"
+#include "CppUTest/MemoryLeakDetectorNewMacros.h"
+#include "CppUTest/TestHarness.h"
+#include "CppUTestExt/MockSupport.h"
+
+extern "C" {
+#include "memfault/core/data_packetizer.h"
+#include "memfault/core/math.h"
+#include "memfault/core/platform/device_info.h"
+#include "memfault/http/http_client.h"
+#include "memfault/http/utils.h"
+
+void memfault_platform_get_device_info(struct MemfaultDeviceInfo *info) {
+  *info = (struct MemfaultDeviceInfo){
+    .device_serial = "DEMOSERIAL",
+    .software_type = "main",
+    .software_version = "1.0.0",
+    .hardware_version = "main-proto",
+  };
+}
+
+sMfltHttpClientConfig g_mflt_http_client_config = {
+  .api_key = "00112233445566778899aabbccddeeff",  // gitleaks:allow
+};
+}
+
+//
+// A fake packetizer returning the messages in s_messages
+//
+
+static std::vector<std::string> s_messages;
+static size_t s_msg_idx;
+static size_t s_msg_offset;
+
+bool memfault_packetizer_begin(MEMFAULT_UNUSED const sMemfaultPacketizerConfig *cfg,
+                               sMemfaultPacketizerMetadata *metadata_out) {
+  CHECK(cfg->enable_multi_packet_chunk);
+  if (s_msg_idx >= s_messages.size()) {
+    return false;
+  }
+  *metadata_out = (sMemfaultPacketizerMetadata){
+    .send_in_progress = (s_msg_offset != 0),
+    .single_chunk_message_length = (uint32_t)s_messages[s_msg_idx].size(),
+  };
+  return true;
+}
+
+eMemfaultPacketizerStatus memfault_packetizer_get_next(void *buf, size_t *buf_len) {
+  CHECK(*buf_len >= MEMFAULT_PACKETIZER_MIN_BUF_LEN);
+  if (s_msg_idx >= s_messages.size()) {
+    *buf_len = 0;
+    return kMemfaultPacketizerStatus_NoMoreData;
+  }
+
+  const std::string &msg = s_messages[s_msg_idx];
+  const size_t len = MEMFAULT_MIN(*buf_len, msg.size() - s_msg_offset);
+  memcpy(buf, &msg[s_msg_offset], len);
+  *buf_len = len;
+  s_msg_offset += len;
+  if (s_msg_offset < msg.size()) {
+    return kMemfaultPacketizerStatus_MoreDataForChunk;
+  }
+
+  s_msg_idx++;
+  s_msg_offset = 0;
+  return kMemfaultPacketizerStatus_EndOfChunk;
+}
+
+void memfault_packetizer_abort(void) {
+  s_msg_offset = 0;
+}
+
+//
+// Transport collecting the request, which can be made to fail after a number of writes
+//
+
+typedef struct {
+  std::string data;
+  size_t num_writes;
+  size_t fail_after_writes;
+} sTransport;
+
+static bool prv_transport_write(const void *data, size_t data_len, void *ctx) {
+  sTransport *transport = (sTransport *)ctx;
+  if (transport->num_writes == transport->fail_after_writes) {
+    return false;
+  }
+  transport->num_writes++;
+  transport->data.append((const char *)data, data_len);
+  return true;
+}
+
+//
+// Stand-in for the chunks endpoint
+//
+
+static size_t prv_consume_line(const std::string &data, size_t *offset, std::string *line) {
+  const size_t end = data.find("\r\n", *offset);
+  CHECK(end != std::string::npos);
+  *line = data.substr(*offset, end - *offset);
+  *offset = end + 2;
+  return line->size();
+}
+
+//! Decodes a chunks stream POST, returning the chunks in its multipart body
+static std::vector<std::string> prv_server_receive(const std::string &request) {
+  size_t offset = 0;
+  std::string line;
+
+  // request line and headers
+  prv_consume_line(request, &offset, &line);
+  STRCMP_EQUAL("POST /api/v0/chunks/DEMOSERIAL HTTP/1.1", line.c_str());
+  bool chunked = false;
+  while (prv_consume_line(request, &offset, &line) != 0) {
+    CHECK(line.find("Content-Length") == std::string::npos);
+    chunked |= (line == "Transfer-Encoding:chunked");
+  }
+  CHECK(chunked);
+
+  // undo the chunked transfer coding
+  std::string body;
+  while (1) {
+    prv_consume_line(request, &offset, &line);
+    const size_t size = strtoul(line.c_str(), NULL, 16);
+    if (size == 0) {
+      prv_consume_line(request, &offset, &line);
+      LONGS_EQUAL(0, line.size());
+      break;
+    }
+    body.append(request, offset, size);
+    offset += size;
+    prv_consume_line(request, &offset, &line);
+    LONGS_EQUAL(0, line.size());
+  }
+  LONGS_EQUAL(request.size(), offset);
+
+  // split the multipart body
+  std::vector<std::string> chunks;
+  offset = 0;
+  while (1) {
+    prv_consume_line(body, &offset, &line);
+    if (line == "--" MEMFAULT_HTTP_CHUNKS_BATCH_BOUNDARY "--") {
+      break;
+    }
+    STRCMP_EQUAL("--" MEMFAULT_HTTP_CHUNKS_BATCH_BOUNDARY, line.c_str());
+    prv_consume_line(body, &offset, &line);
+    CHECK(line.rfind("Content-Length:", 0) == 0);
+    const size_t chunk_len = strtoul(&line[strlen("Content-Length:")], NULL, 10);
+    prv_consume_line(body, &offset, &line);
+    LONGS_EQUAL(0, line.size());
+
+    chunks.push_back(body.substr(offset, chunk_len));
+    offset += chunk_len;
+    prv_consume_line(body, &offset, &line);
+    LONGS_EQUAL(0, line.size());
+  }
+  LONGS_EQUAL(body.size(), offset);
+  return chunks;
+}
+
+static int prv_post(sTransport *transport, size_t buf_len, size_t max_messages) {
+  std::vector<uint8_t> buf(buf_len);
+  return memfault_http_post_chunks_stream(prv_transport_write, transport, buf.data(), buf.size(),
+                                          max_messages);
+}
+
+TEST_GROUP(MemfaultHttpChunksStream) {
+  void setup() {
+    s_messages.clear();
+    const size_t msg_lens[] = { 5, 100, 1, 300, 26, 27 };
+    for (size_t i = 0; i < MEMFAULT_ARRAY_SIZE(msg_lens); i++) {
+      std::string msg;
+      for (size_t j = 0; j < msg_lens[i]; j++) {
+        msg.push_back((char)(i * 37 + j));
+      }
+      s_messages.push_back(msg);
+    }
+    s_msg_idx = 0;
+    s_msg_offset = 0;
+  }
+  void teardown() {
+    s_messages.clear();
+    mock().checkExpectations();
+    mock().clear();
+  }
+};
+
+TEST(MemfaultHttpChunksStream, Test_StreamsAllMessages) {
+  sTransport transport = { .data = "", .num_writes = 0, .fail_after_writes = SIZE_MAX };
+  LONGS_EQUAL(s_messages.size(), prv_post(&transport, 32, 100));
+
+  const std::vector<std::string> chunks = prv_server_receive(transport.data);
+  LONGS_EQUAL(s_messages.size(), chunks.size());
+  for (size_t i = 0; i < chunks.size(); i++) {
+    CHECK(s_messages[i] == chunks[i]);
+  }
+  LONGS_EQUAL(s_messages.size(), s_msg_idx);
+
+  // a 32 byte buffer carries 26 bytes of data per write, after the transfer chunk framing. Each
+  // message also needs a write to start and end its part, and the request needs 11 for the
+  // header and one to end the body.
+  const size_t expected_writes =
+    11 + (2 + 1) + (2 + 4) + (2 + 1) + (2 + 12) + (2 + 1) + (2 + 2) + 1;
+  LONGS_EQUAL(expected_writes, transport.num_writes);
+
+  // and the server's chunked response is parsed
+  const char *rsp = "HTTP/1.1 202 Accepted\r\n"
+                    "Transfer-Encoding: chunked\r\n"
+                    "\r\n"
+                    "8\r\n"
+                    "Accepted\r\n"
+                    "0\r\n"
+                    "\r\n";
+  sMemfaultHttpResponseContext rsp_ctx = {};
+  CHECK(memfault_http_parse_response(&rsp_ctx, rsp, strlen(rsp)));
+  CHECK(!rsp_ctx.parse_error);
+  LONGS_EQUAL(202, rsp_ctx.http_status_code);
+  STRCMP_EQUAL("Accepted", rsp_ctx.http_body);
+}
+
+TEST(MemfaultHttpChunksStream, Test_MaxMessages) {
+  sTransport transport = { .data = "", .num_writes = 0, .fail_after_writes = SIZE_MAX };
+  LONGS_EQUAL(2, prv_post(&transport, 64, 2));
+  const std::vector<std::string> chunks = prv_server_receive(transport.data);
+  LONGS_EQUAL(2, chunks.size());
+  CHECK(s_messages[1] == chunks[1]);
+
+  // the next POST picks up where this one stopped
+  transport = (sTransport){ .data = "", .num_writes = 0, .fail_after_writes = SIZE_MAX };
+  LONGS_EQUAL(s_messages.size() - 2, prv_post(&transport, 64, 100));
+  const std::vector<std::string> rest = prv_server_receive(transport.data);
+  LONGS_EQUAL(s_messages.size() - 2, rest.size());
+  CHECK(s_messages[2] == rest[0]);
+}
+
+TEST(MemfaultHttpChunksStream, Test_WriteFailureRewindsMessage) {
+  // fail in the middle of the data of the second message, after the 11 writes of the header
+  sTransport transport = { .data = "", .num_writes = 0, .fail_after_writes = 16 };
+  LONGS_EQUAL(-1, prv_post(&transport, 32, 100));
+  LONGS_EQUAL(1, s_msg_idx);
+  LONGS_EQUAL(0, s_msg_offset);
+
+  // the message is sent again, in its entirety, by the next POST
+  transport = (sTransport){ .data = "", .num_writes = 0, .fail_after_writes = SIZE_MAX };
+  LONGS_EQUAL(s_messages.size() - 1, prv_post(&transport, 32, 100));
+  const std::vector<std::string> chunks = prv_server_receive(transport.data);
+  LONGS_EQUAL(s_messages.size() - 1, chunks.size());
+  CHECK(s_messages[1] == chunks[0]);
+}
+
+TEST(MemfaultHttpChunksStream, Test_PartiallySentMessageIsRewound) {
+  // a message left partially sent by a previous upload is sent from its start
+  s_msg_offset = 3;
+  sTransport transport = { .data = "", .num_writes = 0, .fail_after_writes = SIZE_MAX };
+  LONGS_EQUAL(1, prv_post(&transport, 32, 1));
+  const std::vector<std::string> chunks = prv_server_receive(transport.data);
+  LONGS_EQUAL(1, chunks.size());
+  CHECK(s_messages[0] == chunks[0]);
+}
+
+TEST(MemfaultHttpChunksStream, Test_BufferTooSmall) {
+  sTransport transport = { .data = "", .num_writes = 0, .fail_after_writes = SIZE_MAX };
+  uint8_t buf[MEMFAULT_PACKETIZER_MIN_BUF_LEN];
+  LONGS_EQUAL(-1, memfault_http_post_chunks_stream(prv_transport_write, &transport, buf,
+                                                   sizeof(buf), 100));
+  LONGS_EQUAL(0, transport.num_writes);
+  LONGS_EQUAL(0, s_msg_idx);
+}
+
+TEST(MemfaultHttpChunksStream, Test_NothingSentWithoutMessages) {
+  // no POST is sent when there is no message to upload
+  s_messages.clear();
+  sTransport transport = { .data = "", .num_writes = 0, .fail_after_writes = SIZE_MAX };
+  LONGS_EQUAL(0, prv_post(&transport, 32, 100));
+  LONGS_EQUAL(0, transport.num_writes);
+}
+
+TEST(MemfaultHttpChunksStream, Test_HeaderWriteFailureRewindsMessage) {
+  s_msg_offset = 3;
+  sTransport transport = { .data = "", .num_writes = 0, .fail_after_writes = 0 };
+  LONGS_EQUAL(-1, prv_post(&transport, 32, 100));
+  LONGS_EQUAL(0, s_msg_idx);
+  LONGS_EQUAL(0, s_msg_offset);
+}
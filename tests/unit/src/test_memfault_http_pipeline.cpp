@@ -0,0 +1,234 @@
+//! @file
+//!
+//! @brief
+//! Tests for posting chunks with several requests in flight, against a stand-in for the chunks
+//! endpoint listening on a loopback socket
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "CppUTest/MemoryLeakDetectorMallocMacros.h"
+#include "CppUTest/MemoryLeakDetectorNewMacros.h"
+#include "CppUTest/TestHarness.h"
+#include "fakes/fake_memfault_http_loopback_server.h"
+
+extern "C" {
+#include "memfault/core/data_packetizer.h"
+#include "memfault/core/math.h"
+#include "memfault/core/platform/device_info.h"
+#include "memfault/http/http_client.h"
+#include "memfault/http/utils.h"
+
+void memfault_platform_get_device_info(struct MemfaultDeviceInfo *info) {
+  *info = (struct MemfaultDeviceInfo){
+    .device_serial = "DEMOSERIAL",
+    .software_type = "main",
+    .software_version = "1.0.0",
+    .hardware_version = "main-proto",
+  };
+}
+
+sMfltHttpClientConfig g_mflt_http_client_config = {
+  .api_key = "00112233445566778899aabbccddeeff",  // gitleaks:allow
+};
+}
+
+#define TEST_PIPELINE_DEPTH 4
+#define TEST_MAX_CHUNK_LEN 16
+
+//
+// A fake packetizer returning the chunks "chunk-0", "chunk-1", ...
+//
+
+static size_t s_num_chunks;
+static size_t s_next_chunk;
+
+bool memfault_packetizer_get_chunk(void *buf, size_t *buf_len) {
+  if (s_next_chunk == s_num_chunks) {
+    return false;
+  }
+  const int len = snprintf((char *)buf, *buf_len, "chunk-%d", (int)s_next_chunk);
+  CHECK((len > 0) && ((size_t)len < *buf_len));
+  *buf_len = (size_t)len;
+  s_next_chunk++;
+  return true;
+}
+
+MEMFAULT_HTTP_PIPELINE_DEFINE(s_pipeline, TEST_PIPELINE_DEPTH, TEST_MAX_CHUNK_LEN);
+
+static uint16_t s_port;
+static sFakeHttpLoopbackClient s_client;
+
+TEST_GROUP(MemfaultHttpPipeline) {
+  void setup() {
+    g_mflt_http_client_config.chunks_api.host = NULL;
+    s_num_chunks = 0;
+    s_next_chunk = 0;
+    s_pipeline.head = 0;
+    s_pipeline.count = 0;
+    s_pipeline.in_flight = 0;
+  }
+
+  void teardown() {
+    fake_http_loopback_client_close(&s_client);
+    fake_http_loopback_server_stop();
+  }
+};
+
+static void prv_start_server(const sFakeHttpLoopbackServerConfig *config) {
+  s_port = fake_http_loopback_server_start(config);
+  fake_http_loopback_client_connect(&s_client, s_port);
+}
+
+static void prv_reconnect(void) {
+  fake_http_loopback_client_close(&s_client);
+  fake_http_loopback_client_connect(&s_client, s_port);
+}
+
+static bool prv_upload(int *max_messages_to_send) {
+  return memfault_http_pipeline_upload(&s_pipeline, fake_http_loopback_client_send,
+                                       fake_http_loopback_client_wait_for_response, &s_client,
+                                       max_messages_to_send);
+}
+
+static void prv_check_request(size_t idx, size_t chunk, size_t connection) {
+  const sFakeHttpLoopbackServerRequest request = fake_http_loopback_server_get_request(idx);
+  char expected[16];
+  snprintf(expected, sizeof(expected), "chunk-%d", (int)chunk);
+  STRCMP_EQUAL(expected, request.body);
+  LONGS_EQUAL(connection, request.connection);
+}
+
+TEST(MemfaultHttpPipeline, Test_AllChunksPostedInOrder) {
+  const sFakeHttpLoopbackServerConfig config = { .rtt_ms = 2 };
+  prv_start_server(&config);
+  s_num_chunks = 10;
+
+  int max_messages_to_send = 100;
+  CHECK(prv_upload(&max_messages_to_send));
+  LONGS_EQUAL(100 - 10, max_messages_to_send);
+  CHECK_FALSE(memfault_http_pipeline_has_unacked_chunks(&s_pipeline));
+
+  LONGS_EQUAL(10, fake_http_loopback_server_num_requests());
+  for (size_t i = 0; i < 10; i++) {
+    prv_check_request(i, i, 0);
+  }
+}
+
+TEST(MemfaultHttpPipeline, Test_LongHeaderSentPiecewise) {
+  // a request header which doesn't fit in front of the chunk is sent in several writes
+  char host[MEMFAULT_HTTP_REQUEST_HEADER_MAX_LEN / 2];
+  memset(host, 'a', sizeof(host) - 1);
+  host[sizeof(host) - 1] = '\0';
+  g_mflt_http_client_config.chunks_api.host = host;
+
+  const sFakeHttpLoopbackServerConfig config = {};
+  prv_start_server(&config);
+  s_num_chunks = 3;
+
+  char buf[MEMFAULT_HTTP_REQUEST_HEADER_MAX_LEN];
+  LONGS_EQUAL(0, memfault_http_build_chunk_post_header(buf, sizeof(buf), TEST_MAX_CHUNK_LEN));
+
+  int max_messages_to_send = 100;
+  CHECK(prv_upload(&max_messages_to_send));
+  LONGS_EQUAL(3, fake_http_loopback_server_num_requests());
+  for (size_t i = 0; i < 3; i++) {
+    prv_check_request(i, i, 0);
+  }
+}
+
+TEST(MemfaultHttpPipeline, Test_MaxMessagesToSend) {
+  const sFakeHttpLoopbackServerConfig config = {};
+  prv_start_server(&config);
+  s_num_chunks = 10;
+
+  int max_messages_to_send = 3;
+  CHECK(prv_upload(&max_messages_to_send));
+  LONGS_EQUAL(0, max_messages_to_send);
+  LONGS_EQUAL(3, fake_http_loopback_server_num_requests());
+  LONGS_EQUAL(3, s_next_chunk);
+}
+
+TEST(MemfaultHttpPipeline, Test_UnackedChunksResentAfterConnectionError) {
+  // the server shuts the connection down once the first TEST_PIPELINE_DEPTH chunks were received,
+  // with only 2 of them acknowledged
+  sFakeHttpLoopbackServerConfig config = {
+    .close_after_requests = TEST_PIPELINE_DEPTH,
+    .acks_before_close = 2,
+  };
+  prv_start_server(&config);
+  s_num_chunks = 8;
+
+  int max_messages_to_send = 100;
+  CHECK_FALSE(prv_upload(&max_messages_to_send));
+  CHECK(memfault_http_pipeline_has_unacked_chunks(&s_pipeline));
+  for (size_t i = 0; i < TEST_PIPELINE_DEPTH; i++) {
+    prv_check_request(i, i, 0);
+  }
+
+  // Chunks posted after the acknowledged ones may or may not have reached the server before the
+  // connection was closed
+  const size_t num_first_connection_requests = fake_http_loopback_server_num_requests();
+  CHECK(num_first_connection_requests >= TEST_PIPELINE_DEPTH);
+  CHECK(num_first_connection_requests <= TEST_PIPELINE_DEPTH + 2);
+
+  config = (sFakeHttpLoopbackServerConfig){};
+  fake_http_loopback_server_set_config(&config);
+  prv_reconnect();
+  CHECK(prv_upload(&max_messages_to_send));
+  CHECK_FALSE(memfault_http_pipeline_has_unacked_chunks(&s_pipeline));
+  LONGS_EQUAL(100 - 8, max_messages_to_send);
+
+  // every chunk which was not acknowledged is posted again, in order, so the chunks which the
+  // server received on the first connection but did not acknowledge are delivered twice
+  const size_t num_requests = fake_http_loopback_server_num_requests();
+  LONGS_EQUAL(num_first_connection_requests + 8 - 2, num_requests);
+  for (size_t i = 0; i < 8 - 2; i++) {
+    prv_check_request(num_first_connection_requests + i, 2 + i, 1);
+  }
+}
+
+TEST(MemfaultHttpPipeline, Test_RejectedChunkDropped) {
+  // the second chunk is rejected
+  const sFakeHttpLoopbackServerConfig config = { .reject_request = 2 };
+  prv_start_server(&config);
+  s_num_chunks = 8;
+
+  // no new chunks are posted after the rejection, but the chunks in flight are acknowledged
+  int max_messages_to_send = 100;
+  CHECK_FALSE(prv_upload(&max_messages_to_send));
+  CHECK_FALSE(memfault_http_pipeline_has_unacked_chunks(&s_pipeline));
+  const size_t num_first_upload_requests = fake_http_loopback_server_num_requests();
+  CHECK(num_first_upload_requests >= TEST_PIPELINE_DEPTH);
+  LONGS_EQUAL(num_first_upload_requests, s_next_chunk);
+
+  // the rejected chunk is not posted again
+  CHECK(prv_upload(&max_messages_to_send));
+  LONGS_EQUAL(8, fake_http_loopback_server_num_requests());
+  for (size_t i = 0; i < 8; i++) {
+    prv_check_request(i, i, 0);
+  }
+}
+
+TEST(MemfaultHttpPipeline, Test_SendErrorKeepsChunk) {
+  const sFakeHttpLoopbackServerConfig config = {};
+  prv_start_server(&config);
+  s_num_chunks = 3;
+
+  // the first post fails, so the chunk read for it is kept
+  fake_http_loopback_client_close(&s_client);
+  int max_messages_to_send = 100;
+  CHECK_FALSE(prv_upload(&max_messages_to_send));
+  CHECK(memfault_http_pipeline_has_unacked_chunks(&s_pipeline));
+  LONGS_EQUAL(1, s_next_chunk);
+
+  fake_http_loopback_client_connect(&s_client, s_port);
+  CHECK(prv_upload(&max_messages_to_send));
+  LONGS_EQUAL(3, fake_http_loopback_server_num_requests());
+  // the server saw the first connection closing before any request was received
+  for (size_t i = 0; i < 3; i++) {
+    prv_check_request(i, i, 1);
+  }
+}
@@ -0,0 +1,97 @@
+//! @file
+//!
+//! @brief
+//! Benchmark of the chunk upload rate against a loopback stand-in for the chunks endpoint which
+//! delays every response by a round trip time, comparing a single POST in flight (the
+//! non-pipelined upload) against several pipeline depths for a range of round trip times.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+
+#include "CppUTest/TestHarness.h"
+#include "fakes/fake_memfault_http_loopback_server.h"
+
+extern "C" {
+#include "memfault/core/data_packetizer.h"
+#include "memfault/core/math.h"
+#include "memfault/core/platform/device_info.h"
+#include "memfault/http/http_client.h"
+#include "memfault/http/utils.h"
+
+void memfault_platform_get_device_info(struct MemfaultDeviceInfo *info) {
+  *info = (struct MemfaultDeviceInfo){
+    .device_serial = "DEMOSERIAL",
+    .software_type = "main",
+    .software_version = "1.0.0",
+    .hardware_version = "main-proto",
+  };
+}
+
+sMfltHttpClientConfig g_mflt_http_client_config = {
+  .api_key = "00112233445566778899aabbccddeeff",  // gitleaks:allow
+};
+}
+
+#define BENCHMARK_NUM_CHUNKS 40
+#define BENCHMARK_MAX_DEPTH 8
+#define BENCHMARK_CHUNK_LEN 32
+
+static size_t s_chunks_left;
+
+bool memfault_packetizer_get_chunk(void *buf, size_t *buf_len) {
+  if (s_chunks_left == 0) {
+    return false;
+  }
+  *buf_len = MEMFAULT_MIN(*buf_len, BENCHMARK_CHUNK_LEN);
+  memset(buf, 'a', *buf_len);
+  s_chunks_left--;
+  return true;
+}
+
+MEMFAULT_HTTP_PIPELINE_DEFINE(s_pipeline, BENCHMARK_MAX_DEPTH, BENCHMARK_CHUNK_LEN);
+
+TEST_GROUP(MemfaultHttpPipelineBenchmark) {
+  void setup() { }
+};
+
+//! @return the number of chunks uploaded per second with up to depth POSTs in flight
+static double prv_uploads_per_sec(uint16_t port, size_t depth) {
+  s_pipeline.depth = depth;
+  s_pipeline.head = 0;
+  s_pipeline.count = 0;
+  s_chunks_left = BENCHMARK_NUM_CHUNKS;
+
+  sFakeHttpLoopbackClient client;
+  fake_http_loopback_client_connect(&client, port);
+  int max_messages_to_send = BENCHMARK_NUM_CHUNKS;
+
+  const auto start = std::chrono::steady_clock::now();
+  CHECK(memfault_http_pipeline_upload(&s_pipeline, fake_http_loopback_client_send,
+                                      fake_http_loopback_client_wait_for_response, &client,
+                                      &max_messages_to_send));
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  fake_http_loopback_client_close(&client);
+  LONGS_EQUAL(0, s_chunks_left);
+
+  const double secs = std::chrono::duration<double>(elapsed).count();
+  return BENCHMARK_NUM_CHUNKS / secs;
+}
+
+TEST(MemfaultHttpPipelineBenchmark, Test_UploadsPerSecVsRtt) {
+  const uint32_t rtts_ms[] = { 0, 2, 5, 10 };
+  const size_t depths[] = { 1, 4, 8 };
+  for (size_t i = 0; i < MEMFAULT_ARRAY_SIZE(rtts_ms); i++) {
+    const sFakeHttpLoopbackServerConfig config = { .rtt_ms = rtts_ms[i] };
+    const uint16_t port = fake_http_loopback_server_start(&config);
+    for (size_t j = 0; j < MEMFAULT_ARRAY_SIZE(depths); j++) {
+      const double uploads_per_sec = prv_uploads_per_sec(port, depths[j]);
+      printf("http pipeline: rtt %2d ms, depth %d, %.0f uploads/s\n", (int)rtts_ms[i],
+             (int)depths[j], uploads_per_sec);
+    }
+    fake_http_loopback_server_stop();
+  }
+}
@@ -73,7 +73,7 @@ TEST(MfltHttpClientUtils, Test_MfltHttpClientOverrides) {
 }
 
 typedef struct {
-  char buf[256];
+  char buf[512];
   size_t bytes_written;
 } sHttpWriteCtx;
 
@@ -89,24 +89,151 @@ static bool prv_http_write_cb(const void *data, size_t data_len, void *ctx) {
   return true;
 }
 
+static const char *s_expected_chunk_post_hdr =
+  "POST /api/v0/chunks/DEMOSERIAL HTTP/1.1\r\n"
+  "Host:chunks.memfault.com\r\n"
+  "User-Agent:MemfaultSDK/" MEMFAULT_SDK_VERSION_STR "\r\n"
+  "Memfault-Project-Key:00112233445566778899aabbccddeeff\r\n"  // gitleaks:allow
+  "Content-Type:application/octet-stream\r\n"
+  "Content-Length:123\r\n\r\n";
+
 TEST(MfltHttpClientUtils, Test_MfltHttpClientPost) {
   mock().expectNCalls(11, "prv_http_write_cb");
   sHttpWriteCtx ctx = { 0 };
   bool success = memfault_http_start_chunk_post(prv_http_write_cb, &ctx, 123);
   CHECK(success);
+
+  STRCMP_EQUAL(s_expected_chunk_post_hdr, ctx.buf);
+  LONGS_EQUAL(strlen(s_expected_chunk_post_hdr), ctx.bytes_written);
+}
+
+TEST(MfltHttpClientUtils, Test_MfltHttpClientPostSendWriteFailure) {
+  const size_t num_write_calls = 11;
+  for (size_t i = 0; i < num_write_calls; i++) {
+    if (i > 0) {
+      mock().expectNCalls(i, "prv_http_write_cb");
+    }
+    mock().expectOneCall("prv_http_write_cb").andReturnValue(false);
+
+    sHttpWriteCtx ctx = { 0 };
+    bool success = memfault_http_start_chunk_post(prv_http_write_cb, &ctx, 10);
+    CHECK(!success);
+    mock().checkExpectations();
+  }
+}
+
+TEST(MfltHttpClientUtils, Test_MfltHttpClientPostStringsUpdatedInPlace) {
+  // the device serial and project key are stored in buffers which are updated in place, like a
+  // port filling in the device serial lazily or changing the project key at runtime
+  char serial[] = "DEMOSERIAL";
+  char project_key[] = "00112233445566778899aabbccddeeff";  // gitleaks:allow
+  g_device_info.device_serial = serial;
+  g_mflt_http_client_config.api_key = project_key;
+
+  char buf[MEMFAULT_HTTP_REQUEST_HEADER_MAX_LEN + 1];
+  size_t hdr_len = memfault_http_build_chunk_post_header(buf, sizeof(buf) - 1, 123);
+  buf[hdr_len] = '\0';
+  STRCMP_EQUAL(s_expected_chunk_post_hdr, buf);
+
+  memcpy(serial, "NEWSERIAL1", sizeof(serial));
+  memcpy(project_key, "ffeeddccbbaa99887766554433221100", sizeof(project_key));
+  hdr_len = memfault_http_build_chunk_post_header(buf, sizeof(buf) - 1, 123);
+  buf[hdr_len] = '\0';
+  STRCMP_EQUAL("POST /api/v0/chunks/NEWSERIAL1 HTTP/1.1\r\n"
+               "Host:chunks.memfault.com\r\n"
+               "User-Agent:MemfaultSDK/" MEMFAULT_SDK_VERSION_STR "\r\n"
+               "Memfault-Project-Key:ffeeddccbbaa99887766554433221100\r\n"  // gitleaks:allow
+               "Content-Type:application/octet-stream\r\n"
+               "Content-Length:123\r\n\r\n",
+               buf);
+}
+
+TEST(MfltHttpClientUtils, Test_MfltHttpClientBuildChunkPostHeader) {
+  char buf[MEMFAULT_HTTP_REQUEST_HEADER_MAX_LEN + 1];
+  const size_t hdr_len = memfault_http_build_chunk_post_header(buf, sizeof(buf) - 1, 123);
+  LONGS_EQUAL(strlen(s_expected_chunk_post_hdr), hdr_len);
+  buf[hdr_len] = '\0';
+  STRCMP_EQUAL(s_expected_chunk_post_hdr, buf);
+
+  // the buffer must fit the whole header
+  LONGS_EQUAL(0, memfault_http_build_chunk_post_header(buf, hdr_len - 1, 123));
+  LONGS_EQUAL(0, memfault_http_build_chunk_post_header(buf, 10, 123));
+  LONGS_EQUAL(0, memfault_http_build_chunk_post_header(NULL, sizeof(buf), 123));
+  LONGS_EQUAL(hdr_len, memfault_http_build_chunk_post_header(buf, hdr_len, 123));
+}
+
+TEST(MfltHttpClientUtils, Test_MfltHttpClientPostHeaderLongerThanBuffer) {
+  // a header which doesn't fit in a MEMFAULT_HTTP_REQUEST_HEADER_MAX_LEN buffer can't be built,
+  // but can still be sent piecewise
+  char long_host[MEMFAULT_HTTP_REQUEST_HEADER_MAX_LEN / 2];
+  memset(long_host, 'a', sizeof(long_host) - 1);
+  long_host[sizeof(long_host) - 1] = '\0';
+  char expected[512];
+  snprintf(expected, sizeof(expected),
+           "POST /api/v0/chunks/DEMOSERIAL HTTP/1.1\r\n"
+           "Host:%s\r\n"
+           "User-Agent:MemfaultSDK/" MEMFAULT_SDK_VERSION_STR "\r\n"
+           "Memfault-Project-Key:00112233445566778899aabbccddeeff\r\n"  // gitleaks:allow
+           "Content-Type:application/octet-stream\r\n"
+           "Content-Length:10\r\n\r\n",
+           long_host);
+  CHECK(strlen(expected) > MEMFAULT_HTTP_REQUEST_HEADER_MAX_LEN);
+  g_mflt_http_client_config.chunks_api.host = long_host;
+
+  char buf[MEMFAULT_HTTP_REQUEST_HEADER_MAX_LEN];
+  LONGS_EQUAL(0, memfault_http_build_chunk_post_header(buf, sizeof(buf), 10));
+
+  mock().expectNCalls(11, "prv_http_write_cb");
+  sHttpWriteCtx ctx = { 0 };
+  CHECK(memfault_http_start_chunk_post(prv_http_write_cb, &ctx, 10));
+  STRCMP_EQUAL(expected, ctx.buf);
+}
+
+TEST(MfltHttpClientUtils, Test_MfltHttpClientChunksBatchPost) {
+  mock().expectNCalls(11, "prv_http_write_cb");
+  sHttpWriteCtx ctx = { 0 };
+  bool success = memfault_http_start_chunks_batch_post(prv_http_write_cb, &ctx, 123);
+  CHECK(success);
   const char *expected_string =
     "POST /api/v0/chunks/DEMOSERIAL HTTP/1.1\r\n"
     "Host:chunks.memfault.com\r\n"
     "User-Agent:MemfaultSDK/" MEMFAULT_SDK_VERSION_STR "\r\n"
     "Memfault-Project-Key:00112233445566778899aabbccddeeff\r\n"  // gitleaks:allow
-    "Content-Type:application/octet-stream\r\n"
+    "Content-Type:multipart/mixed; boundary=MemfaultChunksBatch\r\n"
     "Content-Length:123\r\n\r\n";
 
   STRCMP_EQUAL(expected_string, ctx.buf);
 }
 
-TEST(MfltHttpClientUtils, Test_MfltHttpClientPostSendWriteFailure) {
-  const size_t num_write_calls = 11;
+TEST(MfltHttpClientUtils, Test_MfltHttpClientChunksBatchBody) {
+  const char chunks[] = "abcdefghijklmnop";
+  const size_t chunk_lens[] = { 3, 13 };
+
+  // 4 writes per part + the closing delimiter
+  mock().expectNCalls(9, "prv_http_write_cb");
+  sHttpWriteCtx ctx = { 0 };
+  bool success = memfault_http_write_chunks_batch_body(prv_http_write_cb, &ctx, chunks,
+                                                       chunk_lens, MEMFAULT_ARRAY_SIZE(chunk_lens));
+  CHECK(success);
+  const char *expected_string =
+    "--MemfaultChunksBatch\r\n"
+    "Content-Length:3\r\n\r\n"
+    "abc\r\n"
+    "--MemfaultChunksBatch\r\n"
+    "Content-Length:13\r\n\r\n"
+    "defghijklmnop\r\n"
+    "--MemfaultChunksBatch--\r\n";
+
+  STRCMP_EQUAL(expected_string, ctx.buf);
+  LONGS_EQUAL(strlen(expected_string),
+              memfault_http_chunks_batch_body_length(chunk_lens, MEMFAULT_ARRAY_SIZE(chunk_lens)));
+}
+
+TEST(MfltHttpClientUtils, Test_MfltHttpClientChunksBatchBodyWriteFailure) {
+  const char chunks[] = "abc";
+  const size_t chunk_lens[] = { 3 };
+
+  const size_t num_write_calls = 5;
   for (size_t i = 0; i < num_write_calls; i++) {
     if (i > 0) {
       mock().expectNCalls(i, "prv_http_write_cb");
@@ -114,10 +241,14 @@ TEST(MfltHttpClientUtils, Test_MfltHttpClientPostSendWriteFailure) {
     mock().expectOneCall("prv_http_write_cb").andReturnValue(false);
 
     sHttpWriteCtx ctx = { 0 };
-    bool success = memfault_http_start_chunk_post(prv_http_write_cb, &ctx, 10);
+    bool success = memfault_http_write_chunks_batch_body(prv_http_write_cb, &ctx, chunks,
+                                                         chunk_lens, 1);
     CHECK(!success);
     mock().checkExpectations();
   }
+
+  LONGS_EQUAL(0, memfault_http_chunks_batch_body_length(chunk_lens, 0));
+  CHECK(!memfault_http_write_chunks_batch_body(prv_http_write_cb, NULL, chunks, chunk_lens, 0));
 }
 
 TEST(MfltHttpClientUtils, Test_MfltHttpClientGetOtaPayloadUrl) {
@@ -314,6 +445,189 @@ TEST(MfltHttpClientUtils, Test_VeryLongBody) {
   prv_expect_parse_success(msg, sizeof(msg), 202);
 }
 
+TEST(MfltHttpClientUtils, Test_MfltResponseParserNoBody) {
+  const char *rsp = "HTTP/1.1 202 Accepted\r\n"
+                    "Content-Length: 0\r\n"
+                    "Connection: keep-alive\r\n"
+                    "\r\n";
+  prv_expect_parse_success(rsp, strlen(rsp), 202);
+}
+
+TEST(MfltHttpClientUtils, Test_MfltResponseParserPipelined) {
+  // responses to pipelined requests arrive back to back, and data_bytes_processed is used to
+  // find where the next one starts
+  const char *rsps = "HTTP/1.1 202 Accepted\r\n"
+                     "Content-Length: 8\r\n"
+                     "\r\n"
+                     "Accepted"
+                     "HTTP/1.1 202 Accepted\r\n"
+                     "Content-Length: 0\r\n"
+                     "\r\n"
+                     "HTTP/1.1 429 Too Many Requests\r\n"
+                     "Content-Length: 2\r\n"
+                     "\r\n"
+                     "{}";
+  const int expected_http_status[] = { 202, 202, 429 };
+
+  const size_t rsps_len = strlen(rsps);
+  size_t offset = 0;
+  for (size_t i = 0; i < MEMFAULT_ARRAY_SIZE(expected_http_status); i++) {
+    sMemfaultHttpResponseContext ctx = {};
+    bool done = memfault_http_parse_response(&ctx, &rsps[offset], rsps_len - offset);
+    CHECK(done);
+    CHECK(!ctx.parse_error);
+    LONGS_EQUAL(expected_http_status[i], ctx.http_status_code);
+    offset += (size_t)ctx.data_bytes_processed;
+  }
+  LONGS_EQUAL(rsps_len, offset);
+}
+
+TEST(MfltHttpClientUtils, Test_MfltResponseParserChunkedBody) {
+  const char *rsp = "HTTP/1.1 202 Accepted\r\n"
+                    "Content-Type: text/plain; charset=utf-8\r\n"
+                    "transfer-encoding: gzip, CHUNKED  \r\n"
+                    "Connection: keep-alive\r\n"
+                    "\r\n"
+                    "3;name=value\r\n"
+                    "Acc\r\n"
+                    "A\r\n"
+                    "epted, yay\r\n"
+                    "0\r\n"
+                    "Trailer-Field: 1\r\n"
+                    "\r\n";
+  const size_t rsp_len = strlen(rsp);
+
+  sMemfaultHttpResponseContext ctx = {};
+  bool done = memfault_http_parse_response(&ctx, rsp, rsp_len);
+  CHECK(done);
+  CHECK(!ctx.parse_error);
+  CHECK(ctx.chunked_body);
+  LONGS_EQUAL(202, ctx.http_status_code);
+  LONGS_EQUAL(rsp_len, ctx.data_bytes_processed);
+  LONGS_EQUAL(0, ctx.content_length);
+  STRCMP_EQUAL("Accepted, yay", ctx.http_body);
+
+  // one byte at a time
+  memset(&ctx, 0x0, sizeof(ctx));
+  for (size_t i = 0; i < rsp_len; i++) {
+    done = memfault_http_parse_response(&ctx, &rsp[i], 1);
+    LONGS_EQUAL(1, ctx.data_bytes_processed);
+    LONGS_EQUAL(i == rsp_len - 1, done);
+    CHECK(!ctx.parse_error);
+  }
+  STRCMP_EQUAL("Accepted, yay", ctx.http_body);
+
+  // the header-only parser stops at the start of the body
+  memset(&ctx, 0x0, sizeof(ctx));
+  done = memfault_http_parse_response_header(&ctx, rsp, rsp_len);
+  CHECK(done);
+  CHECK(!ctx.parse_error);
+  CHECK(ctx.chunked_body);
+  LONGS_EQUAL(strstr(rsp, "3;name") - rsp, ctx.data_bytes_processed);
+}
+
+TEST(MfltHttpClientUtils, Test_MfltResponseParserChunkedBodyTakesPrecedence) {
+  // the Content-Length is ignored when the chunked transfer coding is used
+  const char *rsps = "HTTP/1.1 200 OK\r\n"
+                     "Content-Length: 100\r\n"
+                     "Transfer-Encoding: chunked\r\n"
+                     "\r\n"
+                     "0\r\n"
+                     "\r\n"
+                     "HTTP/1.1 202 Accepted\r\n"
+                     "Content-Length: 0\r\n"
+                     "\r\n";
+
+  sMemfaultHttpResponseContext ctx = {};
+  bool done = memfault_http_parse_response(&ctx, rsps, strlen(rsps));
+  CHECK(done);
+  CHECK(!ctx.parse_error);
+  LONGS_EQUAL(200, ctx.http_status_code);
+  STRCMP_EQUAL("", ctx.http_body);
+
+  const char *next_rsp = &rsps[ctx.data_bytes_processed];
+  memset(&ctx, 0x0, sizeof(ctx));
+  done = memfault_http_parse_response(&ctx, next_rsp, strlen(next_rsp));
+  CHECK(done);
+  CHECK(!ctx.parse_error);
+  LONGS_EQUAL(202, ctx.http_status_code);
+}
+
+TEST(MfltHttpClientUtils, Test_MfltResponseParserNotChunked) {
+  // only a chunked transfer coding applied last makes the body chunked
+  const char *rsp = "HTTP/1.1 202 Accepted\r\n"
+                    "Transfer-Encoding: chunked, gzip\r\n"
+                    "Content-Length: 2\r\n"
+                    "\r\n"
+                    "ok";
+  sMemfaultHttpResponseContext ctx = {};
+  bool done = memfault_http_parse_response(&ctx, rsp, strlen(rsp));
+  CHECK(done);
+  CHECK(!ctx.parse_error);
+  CHECK(!ctx.chunked_body);
+  STRCMP_EQUAL("ok", ctx.http_body);
+}
+
+TEST(MfltHttpClientUtils, Test_MfltResponseParserChunkedBodyErrors) {
+#define CHUNKED_RSP_HDR "HTTP/1.1 202 Accepted\r\nTransfer-Encoding:chunked\r\n\r\n"
+  const char *bad_rsps[] = {
+    CHUNKED_RSP_HDR "\r\n",                   // missing chunk size
+    CHUNKED_RSP_HDR "zz\r\n",                 // chunk size isn't hex
+    CHUNKED_RSP_HDR "4\r\nAcceXX",             // chunk data isn't terminated by CRLF
+    CHUNKED_RSP_HDR "FFFFFFFFFFFFFFFF\r\n",   // chunk size overflows
+  };
+
+  for (size_t i = 0; i < MEMFAULT_ARRAY_SIZE(bad_rsps); i++) {
+    sMemfaultHttpResponseContext ctx = {};
+    bool done = memfault_http_parse_response(&ctx, bad_rsps[i], strlen(bad_rsps[i]));
+    CHECK(done);
+    LONGS_EQUAL(MfltHttpParseStatus_ParseChunkedBodyError, ctx.parse_error);
+  }
+}
+
+TEST(MfltHttpClientUtils, Test_MfltHttpClientChunksStreamPost) {
+  mock().expectNCalls(11, "prv_http_write_cb");
+  sHttpWriteCtx ctx = { 0 };
+  bool success = memfault_http_start_chunks_stream_post(prv_http_write_cb, &ctx);
+  CHECK(success);
+  const char *expected_string =
+    "POST /api/v0/chunks/DEMOSERIAL HTTP/1.1\r\n"
+    "Host:chunks.memfault.com\r\n"
+    "User-Agent:MemfaultSDK/" MEMFAULT_SDK_VERSION_STR "\r\n"
+    "Memfault-Project-Key:00112233445566778899aabbccddeeff\r\n"  // gitleaks:allow
+    "Content-Type:multipart/mixed; boundary=MemfaultChunksBatch\r\n"
+    "Transfer-Encoding:chunked\r\n\r\n";
+
+  STRCMP_EQUAL(expected_string, ctx.buf);
+}
+
+TEST(MfltHttpClientUtils, Test_MfltHttpClientChunksStreamFraming) {
+  mock().expectNCalls(3, "prv_http_write_cb");
+  sHttpWriteCtx ctx = { 0 };
+  CHECK(memfault_http_write_chunks_stream_part_begin(prv_http_write_cb, &ctx, 300));
+  CHECK(memfault_http_write_chunks_stream_part_end(prv_http_write_cb, &ctx));
+  CHECK(memfault_http_end_chunks_stream(prv_http_write_cb, &ctx));
+
+  const char *expected_string = "2d\r\n"
+                                "--MemfaultChunksBatch\r\n"
+                                "Content-Length:300\r\n\r\n"
+                                "\r\n"
+                                "2\r\n"
+                                "\r\n"
+                                "\r\n"
+                                "19\r\n"
+                                "--MemfaultChunksBatch--\r\n"
+                                "\r\n"
+                                "0\r\n"
+                                "\r\n";
+  STRCMP_EQUAL(expected_string, ctx.buf);
+
+  char size_line[8];
+  LONGS_EQUAL(5, memfault_http_chunks_stream_data_header(size_line, 6, 0x123));
+  STRCMP_EQUAL("123\r\n", size_line);
+  LONGS_EQUAL(0, memfault_http_chunks_stream_data_header(size_line, 5, 0x123));
+}
+
 static void prv_expect_parse_failure(const void *response, size_t response_len,
                                      eMfltHttpParseStatus expected_parse_error) {
   sMemfaultHttpResponseContext ctx = {};
@@ -501,6 +501,38 @@ TEST(MemfaultLog, Test_CompactLog) {
   prv_read_log_and_check(level, type, mock_compact_log, sizeof(mock_compact_log));
 }
 
+TEST(MemfaultLog, Test_CompactLogExpiresOnlyWhatItNeeds) {
+  // room for exactly 10 logs of 4 bytes plus their 2 byte header
+  uint8_t s_ram_log_store[60];
+  memfault_log_boot(s_ram_log_store, sizeof(s_ram_log_store));
+
+  eMemfaultPlatformLogLevel level = kMemfaultPlatformLogLevel_Info;
+  eMemfaultLogRecordType type = kMemfaultLogRecordType_Compact;
+  uint8_t mock_compact_log[] = { 0x00, 0x02, 0x03, 0x04 };
+
+  mock().enable();
+  mock().setData("mock_compact_log", mock_compact_log);
+  mock().setData("mock_compact_log_len", (int)sizeof(mock_compact_log));
+  mock().ignoreOtherCalls();
+
+  for (uint8_t i = 0; i < 11; i++) {
+    mock_compact_log[0] = i;
+    memfault_compact_log_save(level, 0, 0);
+  }
+  LONGS_EQUAL(11, memfault_log_get_recorded_count());
+
+  // only the oldest log was expired to make room for the last one
+  const char *expected_string = "... 1 messages dropped ...";
+  prv_read_log_and_check(kMemfaultPlatformLogLevel_Warning, kMemfaultLogRecordType_Preformatted,
+                         expected_string, strlen(expected_string));
+  for (uint8_t i = 1; i < 11; i++) {
+    mock_compact_log[0] = i;
+    prv_read_log_and_check(level, type, mock_compact_log, sizeof(mock_compact_log));
+  }
+  sMemfaultLog log;
+  CHECK_FALSE(memfault_log_read(&log));
+}
+
 TEST(MemfaultLog, Test_CompactLogsExport) {
   uint8_t s_ram_log_store[40] = { 0 };
   memfault_log_boot(s_ram_log_store, sizeof(s_ram_log_store));
@@ -18,6 +18,7 @@ extern "C" {
 #include "memfault/core/data_packetizer_source.h"
 #include "memfault/core/log.h"
 #include "memfault/core/log_impl.h"
+#include "memfault/core/math.h"
 #include "memfault_log_data_source_private.h"
 }
 
@@ -194,6 +195,54 @@ TEST(MemfaultLogDataSource, Test_ReadMsg) {
   MEMCMP_EQUAL(expected_encoded_buffer, cbor_buffer, expected_encoded_size);
 }
 
+TEST(MemfaultLogDataSource, Test_ReadMsgChunked) {
+  prv_add_logs();
+
+  memfault_log_trigger_collection();
+
+  // Drain the message sequentially at every chunk size. Each pass starts back at offset 0, which
+  // exercises the fallback path for reads that go backwards (i.e after memfault_packetizer_abort())
+  for (size_t chunk_size = 1; chunk_size <= expected_encoded_size; ++chunk_size) {
+    uint8_t cbor_buffer[expected_encoded_size] = { 0 };
+    for (size_t offset = 0; offset < expected_encoded_size; offset += chunk_size) {
+      const size_t read_len = MEMFAULT_MIN(chunk_size, expected_encoded_size - offset);
+      CHECK_TRUE(g_memfault_log_data_source.read_msg_cb(offset, &cbor_buffer[offset], read_len));
+    }
+    MEMCMP_EQUAL(expected_encoded_buffer, cbor_buffer, expected_encoded_size);
+  }
+}
+
+TEST(MemfaultLogDataSource, Test_ReadMsgRewind) {
+  prv_add_logs();
+
+  memfault_log_trigger_collection();
+
+  size_t size = 0;
+  CHECK_TRUE(g_memfault_log_data_source.has_more_msgs_cb(&size));
+  LONGS_EQUAL(expected_encoded_size, size);
+
+  // Read part of the message, then re-read an earlier range that overlaps the last read
+  uint8_t cbor_buffer[expected_encoded_size] = { 0 };
+  const size_t first_read_len = expected_encoded_size - 10;
+  CHECK_TRUE(g_memfault_log_data_source.read_msg_cb(0, cbor_buffer, first_read_len));
+  const size_t reread_offset = first_read_len - 7;
+  CHECK_TRUE(g_memfault_log_data_source.read_msg_cb(reread_offset, &cbor_buffer[reread_offset], 7));
+  MEMCMP_EQUAL(expected_encoded_buffer, cbor_buffer, first_read_len);
+
+  // Skip ahead past data that was never read
+  memset(cbor_buffer, 0, sizeof(cbor_buffer));
+  CHECK_TRUE(g_memfault_log_data_source.read_msg_cb(5, &cbor_buffer[5], 3));
+  CHECK_TRUE(g_memfault_log_data_source.read_msg_cb(40, &cbor_buffer[40], 4));
+  MEMCMP_EQUAL(&expected_encoded_buffer[5], &cbor_buffer[5], 3);
+  MEMCMP_EQUAL(&expected_encoded_buffer[40], &cbor_buffer[40], 4);
+
+  // Restarting the message (packetizer abort) drains it again from the beginning
+  CHECK_TRUE(g_memfault_log_data_source.has_more_msgs_cb(&size));
+  memset(cbor_buffer, 0, sizeof(cbor_buffer));
+  CHECK_TRUE(g_memfault_log_data_source.read_msg_cb(0, cbor_buffer, expected_encoded_size));
+  MEMCMP_EQUAL(expected_encoded_buffer, cbor_buffer, expected_encoded_size);
+}
+
 TEST(MemfaultLogDataSource, Test_MarkMsgRead) {
   const size_t num_batch_logs_1 = prv_add_logs();
   const size_t size_batch_logs_1 = MEMFAULT_LOG_TIMESTAMPS_ENABLE ? 41 : 25;
@@ -0,0 +1,272 @@
+//! @file
+//!
+//! @brief
+//! Tests for the staging of logs issued from ISR context (MEMFAULT_LOG_ISR_STAGING_ENABLED). The
+//! stress test uses host signal handlers to stand in for (nested) ISRs preempting the task level
+//! code at arbitrary points.
+
+#include <signal.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "CppUTest/MemoryLeakDetectorMallocMacros.h"
+#include "CppUTest/MemoryLeakDetectorNewMacros.h"
+#include "CppUTest/TestHarness.h"
+#include "CppUTestExt/MockSupport.h"
+#include "memfault/config.h"
+#include "memfault/core/arch.h"
+#include "memfault/core/log.h"
+#include "memfault/core/log_impl.h"
+#include "memfault/core/platform/overrides.h"
+#include "memfault_log_data_source_private.h"
+#include "memfault_log_private.h"
+
+bool memfault_log_data_source_has_been_triggered(void) {
+  return false;
+}
+
+//! Nesting depth of the fake ISRs currently running
+static volatile sig_atomic_t s_isr_depth;
+
+bool memfault_arch_is_inside_isr(void) {
+  return s_isr_depth != 0;
+}
+
+TEST_GROUP(MemfaultLogIsrStaging) {
+  void setup() {
+    s_isr_depth = 0;
+    mock().disable();
+  }
+  void teardown() {
+    memfault_log_reset();
+    mock().enable();
+    mock().checkExpectations();
+    mock().clear();
+  }
+};
+
+static void prv_save_log_from_isr(const char *log) {
+  s_isr_depth++;
+  memfault_log_save_preformatted(kMemfaultPlatformLogLevel_Info, log, strlen(log));
+  s_isr_depth--;
+}
+
+static void prv_read_log_and_check(const char *expected_log) {
+  sMemfaultLog log;
+  CHECK(memfault_log_read(&log));
+  STRCMP_EQUAL(expected_log, log.msg);
+}
+
+static void prv_check_no_more_logs(void) {
+  sMemfaultLog log;
+  CHECK_FALSE(memfault_log_read(&log));
+}
+
+TEST(MemfaultLogIsrStaging, Test_IsrLogSavedByNextTaskLog) {
+  uint8_t s_ram_log_store[128];
+  memfault_log_boot(s_ram_log_store, sizeof(s_ram_log_store));
+
+  prv_save_log_from_isr("isr 1");
+  prv_save_log_from_isr("isr 2");
+  // nothing is written to the log buffer from the ISR
+  LONGS_EQUAL(0, memfault_log_get_recorded_count());
+  prv_check_no_more_logs();
+
+  memfault_log_save_preformatted(kMemfaultPlatformLogLevel_Info, "task", strlen("task"));
+  LONGS_EQUAL(3, memfault_log_get_recorded_count());
+  prv_read_log_and_check("isr 1");
+  prv_read_log_and_check("isr 2");
+  prv_read_log_and_check("task");
+  prv_check_no_more_logs();
+}
+
+TEST(MemfaultLogIsrStaging, Test_IsrLogNotSavedByNolockTaskLog) {
+  uint8_t s_ram_log_store[128];
+  memfault_log_boot(s_ram_log_store, sizeof(s_ram_log_store));
+
+  prv_save_log_from_isr("isr");
+  // the staging ring is only drained with the lock held
+  memfault_log_save_preformatted_nolock(kMemfaultPlatformLogLevel_Info, "nolock",
+                                        strlen("nolock"));
+  LONGS_EQUAL(1, memfault_log_get_recorded_count());
+
+  memfault_log_save_preformatted(kMemfaultPlatformLogLevel_Info, "task", strlen("task"));
+  prv_read_log_and_check("nolock");
+  prv_read_log_and_check("isr");
+  prv_read_log_and_check("task");
+  prv_check_no_more_logs();
+}
+
+TEST(MemfaultLogIsrStaging, Test_IsrLogDrainedBeforeNolockTaskLog) {
+  uint8_t s_ram_log_store[128];
+  memfault_log_boot(s_ram_log_store, sizeof(s_ram_log_store));
+
+  // mirrors the Zephyr log backend, which only saves logs with the nolock API
+  prv_save_log_from_isr("isr 1");
+  s_isr_depth++;
+  memfault_log_save_preformatted_nolock(kMemfaultPlatformLogLevel_Info, "isr 2", strlen("isr 2"));
+  s_isr_depth--;
+  LONGS_EQUAL(0, memfault_log_get_recorded_count());
+
+  memfault_lock();
+  memfault_log_drain_isr_logs_locked();
+  memfault_unlock();
+  memfault_log_save_preformatted_nolock(kMemfaultPlatformLogLevel_Info, "nolock",
+                                        strlen("nolock"));
+  LONGS_EQUAL(3, memfault_log_get_recorded_count());
+
+  prv_read_log_and_check("isr 1");
+  prv_read_log_and_check("isr 2");
+  prv_read_log_and_check("nolock");
+  prv_check_no_more_logs();
+}
+
+TEST(MemfaultLogIsrStaging, Test_IsrLogDrain) {
+  uint8_t s_ram_log_store[128];
+
+  // logs are only staged once the log buffer has been booted
+  prv_save_log_from_isr("dropped");
+  memfault_log_drain_isr_logs_locked();
+  memfault_log_boot(s_ram_log_store, sizeof(s_ram_log_store));
+  memfault_log_drain_isr_logs_locked();
+  prv_check_no_more_logs();
+
+  prv_save_log_from_isr("isr");
+  memfault_log_drain_isr_logs_locked();
+  prv_read_log_and_check("isr");
+  prv_check_no_more_logs();
+}
+
+TEST(MemfaultLogIsrStaging, Test_IsrLogTruncated) {
+  uint8_t s_ram_log_store[256];
+  memfault_log_boot(s_ram_log_store, sizeof(s_ram_log_store));
+
+  char long_log[MEMFAULT_LOG_ISR_STAGING_MAX_LINE_LEN + 10];
+  memset(long_log, 'a', sizeof(long_log) - 1);
+  long_log[sizeof(long_log) - 1] = '\0';
+  prv_save_log_from_isr(long_log);
+  memfault_log_drain_isr_logs_locked();
+
+  long_log[MEMFAULT_LOG_ISR_STAGING_MAX_LINE_LEN] = '\0';
+  prv_read_log_and_check(long_log);
+}
+
+TEST(MemfaultLogIsrStaging, Test_IsrStagingFull) {
+  uint8_t s_ram_log_store[256];
+  memfault_log_boot(s_ram_log_store, sizeof(s_ram_log_store));
+
+  const size_t num_dropped = 3;
+  char log[16];
+  for (size_t i = 0; i < MEMFAULT_LOG_ISR_STAGING_NUM_ENTRIES + num_dropped; i++) {
+    snprintf(log, sizeof(log), "isr %d", (int)i);
+    prv_save_log_from_isr(log);
+  }
+  LONGS_EQUAL(num_dropped, memfault_log_get_isr_dropped_count());
+  // the drops are accounted for in the log buffer once the staged logs are drained
+  LONGS_EQUAL(0, memfault_log_get_dropped_count());
+
+  memfault_log_drain_isr_logs_locked();
+  LONGS_EQUAL(num_dropped, memfault_log_get_dropped_count());
+  LONGS_EQUAL(MEMFAULT_LOG_ISR_STAGING_NUM_ENTRIES, memfault_log_get_recorded_count());
+
+  // the ring can be filled again after being drained
+  prv_save_log_from_isr("isr again");
+  LONGS_EQUAL(num_dropped, memfault_log_get_isr_dropped_count());
+  memfault_log_drain_isr_logs_locked();
+  LONGS_EQUAL(num_dropped, memfault_log_get_dropped_count());
+  LONGS_EQUAL(MEMFAULT_LOG_ISR_STAGING_NUM_ENTRIES + 1, memfault_log_get_recorded_count());
+}
+
+//
+// Stress test: SIGALRM and SIGVTALRM fire periodically and can nest within each other, each
+// saving a log from "ISR" context while the main loop saves logs from task context.
+//
+
+static int s_isr_logs_issued;
+#define MAX_ISR_LOGS 4096
+static bool s_isr_log_seen[MAX_ISR_LOGS];
+
+static void prv_isr_signal_handler(MEMFAULT_UNUSED int signum) {
+  s_isr_depth++;
+  char log[16];
+  const int seq = __atomic_fetch_add(&s_isr_logs_issued, 1, __ATOMIC_RELAXED);
+  const int len = snprintf(log, sizeof(log), "isr %d", seq);
+  memfault_log_save_preformatted(kMemfaultPlatformLogLevel_Info, log, (size_t)len);
+  s_isr_depth--;
+}
+
+static void prv_set_timers(long interval_us) {
+  const struct itimerval timer = {
+    .it_interval = { .tv_sec = 0, .tv_usec = interval_us },
+    .it_value = { .tv_sec = 0, .tv_usec = interval_us },
+  };
+  setitimer(ITIMER_REAL, &timer, NULL);
+  setitimer(ITIMER_VIRTUAL, &timer, NULL);
+}
+
+TEST(MemfaultLogIsrStaging, Test_IsrStagingStress) {
+  static uint8_t s_ram_log_store[256 * 1024];
+  memfault_log_boot(s_ram_log_store, sizeof(s_ram_log_store));
+  s_isr_logs_issued = 0;
+  memset(s_isr_log_seen, 0, sizeof(s_isr_log_seen));
+
+  struct sigaction action = { 0 };
+  action.sa_handler = prv_isr_signal_handler;
+  sigemptyset(&action.sa_mask);
+  struct sigaction prev_alrm_action;
+  struct sigaction prev_vtalrm_action;
+  sigaction(SIGALRM, &action, &prev_alrm_action);
+  sigaction(SIGVTALRM, &action, &prev_vtalrm_action);
+
+  const int min_isr_logs = 2000;
+  int task_logs = 0;
+  prv_set_timers(20);
+  while (__atomic_load_n(&s_isr_logs_issued, __ATOMIC_RELAXED) < min_isr_logs) {
+    char log[16];
+    const int len = snprintf(log, sizeof(log), "task %d", task_logs);
+    memfault_log_save_preformatted(kMemfaultPlatformLogLevel_Info, log, (size_t)len);
+    task_logs++;
+    // give the "ISRs" a chance to fire between task logs without filling up the log buffer
+    for (volatile int i = 0; i < 2000; i++) { }
+  }
+  CHECK(task_logs < (int)(sizeof(s_ram_log_store) / 32));
+  prv_set_timers(0);
+  sigaction(SIGALRM, &prev_alrm_action, NULL);
+  sigaction(SIGVTALRM, &prev_vtalrm_action, NULL);
+
+  // flush anything still staged
+  memfault_log_drain_isr_logs_locked();
+
+  const uint32_t isr_logs_issued = (uint32_t)s_isr_logs_issued;
+  const uint32_t isr_dropped = memfault_log_get_isr_dropped_count();
+  LONGS_EQUAL(isr_dropped, memfault_log_get_dropped_count());
+  LONGS_EQUAL((uint32_t)task_logs + isr_logs_issued - isr_dropped,
+              memfault_log_get_recorded_count());
+
+  // Every log must be intact and saved exactly once. Task logs must be in order, ISR logs can
+  // be reordered by a nested ISR preempting an ISR before it staged its log.
+  CHECK(isr_logs_issued <= MAX_ISR_LOGS);
+  int next_task_log = 0;
+  uint32_t isr_logs_read = 0;
+  sMemfaultLog log;
+  while (memfault_log_read(&log)) {
+    int seq;
+    if (sscanf(log.msg, "task %d", &seq) == 1) {
+      LONGS_EQUAL(next_task_log, seq);
+      next_task_log++;
+    } else if (sscanf(log.msg, "isr %d", &seq) == 1) {
+      CHECK((seq >= 0) && (seq < (int)isr_logs_issued));
+      CHECK_FALSE(s_isr_log_seen[seq]);
+      s_isr_log_seen[seq] = true;
+      isr_logs_read++;
+    } else {
+      // the "... N messages dropped ..." marker logged when ISR logs were dropped
+      CHECK(strstr(log.msg, "messages dropped") != NULL);
+    }
+  }
+  LONGS_EQUAL(task_logs, next_task_log);
+  LONGS_EQUAL(isr_logs_issued - isr_dropped, isr_logs_read);
+}
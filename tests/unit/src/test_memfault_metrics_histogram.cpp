@@ -0,0 +1,195 @@
+//! @file
+//!
+//! @brief
+//! Tests for histogram metrics (MEMFAULT_METRICS_HISTOGRAM_KEY_DEFINE), which are reported as
+//! p50/p90/p99/max/overflow metrics when the heartbeat or session is collected.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTestExt/MockSupport.h"
+#include "fakes/fake_memfault_platform_metrics_locking.h"
+#include "memfault/core/math.h"
+#include "memfault/core/platform/core.h"
+#include "memfault/metrics/metrics.h"
+#include "memfault/metrics/platform/timer.h"
+#include "memfault/metrics/reliability.h"
+#include "memfault/metrics/serializer.h"
+
+#define FAKE_STORAGE_SIZE 1024
+
+extern "C" {
+uint64_t memfault_platform_get_time_since_boot_ms(void) {
+  return 0;
+}
+
+bool memfault_metrics_heartbeat_serialize(
+  MEMFAULT_UNUSED const sMemfaultEventStorageImpl *storage_impl) {
+  return mock().actualCall(__func__).returnBoolValueOrDefault(true);
+}
+
+bool memfault_metrics_session_serialize(
+  MEMFAULT_UNUSED const sMemfaultEventStorageImpl *storage_impl,
+  MEMFAULT_UNUSED eMfltMetricsSessionIndex session_index) {
+  return mock().actualCall(__func__).returnBoolValueOrDefault(true);
+}
+
+size_t memfault_metrics_heartbeat_compute_worst_case_storage_size(void) {
+  return FAKE_STORAGE_SIZE;
+}
+
+// fakes
+void memfault_metrics_reliability_boot(sMemfaultMetricsReliabilityCtx *ctx) {
+  (void)ctx;
+}
+void memfault_metrics_reliability_collect(void) { }
+}
+
+bool memfault_platform_metrics_timer_boot(MEMFAULT_UNUSED uint32_t period_sec,
+                                          MEMFAULT_UNUSED MemfaultPlatformTimerCallback callback) {
+  return true;
+}
+
+// clang-format off
+TEST_GROUP(MemfaultMetricsHistogram){
+  void setup() {
+    // end the previous heartbeat, so every test starts with empty histograms
+    mock().expectOneCall("memfault_metrics_heartbeat_serialize");
+    memfault_metrics_heartbeat_debug_trigger();
+    fake_memfault_metrics_platform_locking_reboot();
+  }
+  void teardown() {
+    CHECK(fake_memfault_platform_metrics_lock_calls_balanced());
+    mock().checkExpectations();
+    mock().clear();
+  }
+};
+// clang-format on
+
+static void prv_check_unsigned(MemfaultMetricId key, uint32_t expected) {
+  uint32_t val = 0;
+  LONGS_EQUAL(0, memfault_metrics_heartbeat_read_unsigned(key, &val));
+  LONGS_EQUAL(expected, val);
+}
+
+static void prv_check_histogram(uint32_t p50, uint32_t p90, uint32_t p99, uint32_t max) {
+  prv_check_unsigned(MEMFAULT_METRICS_KEY(test_histogram_p50), p50);
+  prv_check_unsigned(MEMFAULT_METRICS_KEY(test_histogram_p90), p90);
+  prv_check_unsigned(MEMFAULT_METRICS_KEY(test_histogram_p99), p99);
+  prv_check_unsigned(MEMFAULT_METRICS_KEY(test_histogram_max), max);
+}
+
+TEST(MemfaultMetricsHistogram, Test_SmallValuesAreExact) {
+  const uint32_t values[] = { 1, 3, 1, 2, 1 };
+  for (size_t i = 0; i < MEMFAULT_ARRAY_SIZE(values); i++) {
+    LONGS_EQUAL(0, MEMFAULT_METRIC_HISTOGRAM_RECORD(test_histogram, values[i]));
+  }
+  memfault_metrics_heartbeat_collect();
+
+  prv_check_histogram(1, 3, 3, 3);
+  prv_check_unsigned(MEMFAULT_METRICS_KEY(test_histogram_overflow), 0);
+}
+
+TEST(MemfaultMetricsHistogram, Test_Percentiles) {
+  for (uint32_t i = 100; i > 0; i--) {
+    LONGS_EQUAL(0, MEMFAULT_METRIC_HISTOGRAM_RECORD(test_histogram, i));
+  }
+  // the max is tracked as values are recorded
+  prv_check_unsigned(MEMFAULT_METRICS_KEY(test_histogram_max), 100);
+
+  memfault_metrics_heartbeat_collect();
+
+  // percentiles report the upper bound of their bucket: 50 is in [50, 51], 90 in [88, 91], and
+  // 99 in [96, 99]
+  prv_check_histogram(51, 91, 99, 100);
+}
+
+TEST(MemfaultMetricsHistogram, Test_BucketResolution) {
+  const uint32_t values[] = { 4,     5,     7,       8,       13,      100,     1000,
+                              4097,  65535, 99999,   1048575, 1048576, 8388609, 16777215 };
+  for (size_t i = 0; i < MEMFAULT_ARRAY_SIZE(values); i++) {
+    // a larger value makes the median the top of the bucket the value is in
+    LONGS_EQUAL(0, MEMFAULT_METRIC_HISTOGRAM_RECORD(test_histogram, values[i]));
+    LONGS_EQUAL(0, MEMFAULT_METRIC_HISTOGRAM_RECORD(test_histogram, values[i]));
+    LONGS_EQUAL(0, MEMFAULT_METRIC_HISTOGRAM_RECORD(test_histogram, UINT32_MAX));
+    memfault_metrics_heartbeat_collect();
+
+    uint32_t p50 = 0;
+    LONGS_EQUAL(0,
+                memfault_metrics_heartbeat_read_unsigned(MEMFAULT_METRICS_KEY(test_histogram_p50),
+                                                         &p50));
+    // within 1 / 2^MEMFAULT_METRICS_HISTOGRAM_SUB_BUCKET_BITS of the value
+    CHECK(p50 >= values[i]);
+    CHECK(((uint64_t)p50 << MEMFAULT_METRICS_HISTOGRAM_SUB_BUCKET_BITS) <
+          (uint64_t)values[i] * ((1u << MEMFAULT_METRICS_HISTOGRAM_SUB_BUCKET_BITS) + 1));
+
+    mock().expectOneCall("memfault_metrics_heartbeat_serialize");
+    memfault_metrics_heartbeat_debug_trigger();
+  }
+}
+
+TEST(MemfaultMetricsHistogram, Test_ValuesAboveRange) {
+  const uint32_t above_range = (1u << MEMFAULT_METRICS_HISTOGRAM_MAX_BITS) + 3;
+  LONGS_EQUAL(0, MEMFAULT_METRIC_HISTOGRAM_RECORD(test_histogram, 5));
+  LONGS_EQUAL(0, MEMFAULT_METRIC_HISTOGRAM_RECORD(test_histogram, 5));
+  LONGS_EQUAL(0, MEMFAULT_METRIC_HISTOGRAM_RECORD(test_histogram, above_range));
+  LONGS_EQUAL(0, MEMFAULT_METRIC_HISTOGRAM_RECORD(test_histogram, above_range - 1));
+  memfault_metrics_heartbeat_collect();
+
+  // values of 2^MEMFAULT_METRICS_HISTOGRAM_MAX_BITS or more are counted as overflows, and a
+  // percentile in the overflow bucket is reported as the max rather than clamped to the range
+  prv_check_histogram(5, above_range, above_range, above_range);
+  prv_check_unsigned(MEMFAULT_METRICS_KEY(test_histogram_overflow), 2);
+}
+
+TEST(MemfaultMetricsHistogram, Test_NotSetWhenEmpty) {
+  memfault_metrics_heartbeat_collect();
+
+  uint32_t val;
+  LONGS_EQUAL(
+    -7, memfault_metrics_heartbeat_read_unsigned(MEMFAULT_METRICS_KEY(test_histogram_p50), &val));
+  LONGS_EQUAL(
+    -7, memfault_metrics_heartbeat_read_unsigned(MEMFAULT_METRICS_KEY(test_histogram_max), &val));
+}
+
+TEST(MemfaultMetricsHistogram, Test_ResetEachHeartbeat) {
+  LONGS_EQUAL(0, MEMFAULT_METRIC_HISTOGRAM_RECORD(test_histogram, 1000));
+  mock().expectOneCall("memfault_metrics_heartbeat_serialize");
+  memfault_metrics_heartbeat_debug_trigger();
+
+  LONGS_EQUAL(0, MEMFAULT_METRIC_HISTOGRAM_RECORD(test_histogram, 2));
+  memfault_metrics_heartbeat_collect();
+  prv_check_histogram(2, 2, 2, 2);
+}
+
+TEST(MemfaultMetricsHistogram, Test_SessionHistogram) {
+  LONGS_EQUAL(0, MEMFAULT_METRICS_SESSION_START(test_key_session));
+  for (uint32_t i = 0; i < 10; i++) {
+    LONGS_EQUAL(0,
+                MEMFAULT_METRIC_SESSION_HISTOGRAM_RECORD(test_histogram, test_key_session, i % 4));
+  }
+  mock().expectOneCall("memfault_metrics_session_serialize");
+  LONGS_EQUAL(0, MEMFAULT_METRICS_SESSION_END(test_key_session));
+
+  prv_check_unsigned(MEMFAULT_METRICS_KEY_WITH_SESSION(test_histogram_p50, test_key_session), 1);
+  prv_check_unsigned(MEMFAULT_METRICS_KEY_WITH_SESSION(test_histogram_p90, test_key_session), 3);
+  prv_check_unsigned(MEMFAULT_METRICS_KEY_WITH_SESSION(test_histogram_p99, test_key_session), 3);
+  prv_check_unsigned(MEMFAULT_METRICS_KEY_WITH_SESSION(test_histogram_max, test_key_session), 3);
+
+  // the heartbeat histogram is separate
+  uint32_t val;
+  LONGS_EQUAL(
+    -7, memfault_metrics_heartbeat_read_unsigned(MEMFAULT_METRICS_KEY(test_histogram_max), &val));
+
+  // and the session histogram is cleared when the session is restarted
+  LONGS_EQUAL(0, MEMFAULT_METRICS_SESSION_START(test_key_session));
+  LONGS_EQUAL(0, MEMFAULT_METRIC_SESSION_HISTOGRAM_RECORD(test_histogram, test_key_session, 9));
+  mock().expectOneCall("memfault_metrics_session_serialize");
+  LONGS_EQUAL(0, MEMFAULT_METRICS_SESSION_END(test_key_session));
+  prv_check_unsigned(MEMFAULT_METRICS_KEY_WITH_SESSION(test_histogram_p50, test_key_session), 9);
+}
+
+TEST(MemfaultMetricsHistogram, Test_InvalidHistogram) {
+  LONGS_EQUAL(-1, memfault_metrics_histogram_record(kMfltMetricsHistogramIndex_COUNT, 1));
+}
@@ -0,0 +1,122 @@
+//! @file
+//!
+//! @brief
+//! Benchmark several POSIX threads incrementing the same counter metric, comparing
+//! memfault_metrics_heartbeat_add(), which takes memfault_lock() for every update, against
+//! memfault_metrics_heartbeat_add_lockless().
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <chrono>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTestExt/MockSupport.h"
+#include "memfault/core/math.h"
+#include "memfault/core/platform/core.h"
+#include "memfault/core/platform/overrides.h"
+#include "memfault/metrics/metrics.h"
+#include "memfault/metrics/platform/timer.h"
+#include "memfault/metrics/reliability.h"
+#include "memfault/metrics/serializer.h"
+
+#define BENCHMARK_ADDS_PER_THREAD 200000
+#define BENCHMARK_MAX_THREADS 8
+
+static pthread_mutex_t s_memfault_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void memfault_lock(void) {
+  pthread_mutex_lock(&s_memfault_lock);
+}
+
+void memfault_unlock(void) {
+  pthread_mutex_unlock(&s_memfault_lock);
+}
+
+extern "C" {
+uint64_t memfault_platform_get_time_since_boot_ms(void) {
+  return 0;
+}
+
+bool memfault_metrics_heartbeat_serialize(
+  MEMFAULT_UNUSED const sMemfaultEventStorageImpl *storage_impl) {
+  return true;
+}
+
+bool memfault_metrics_session_serialize(
+  MEMFAULT_UNUSED const sMemfaultEventStorageImpl *storage_impl,
+  MEMFAULT_UNUSED eMfltMetricsSessionIndex session_index) {
+  return true;
+}
+
+size_t memfault_metrics_heartbeat_compute_worst_case_storage_size(void) {
+  return 0;
+}
+
+// fakes
+void memfault_metrics_reliability_boot(sMemfaultMetricsReliabilityCtx *ctx) {
+  (void)ctx;
+}
+void memfault_metrics_reliability_collect(void) { }
+}
+
+bool memfault_platform_metrics_timer_boot(MEMFAULT_UNUSED uint32_t period_sec,
+                                          MEMFAULT_UNUSED MemfaultPlatformTimerCallback callback) {
+  return true;
+}
+
+typedef int (*MetricAddFn)(MemfaultMetricId key, int32_t amount);
+
+static void *prv_add_thread(void *arg) {
+  const MetricAddFn add_fn = (MetricAddFn)arg;
+  for (size_t i = 0; i < BENCHMARK_ADDS_PER_THREAD; i++) {
+    add_fn(MEMFAULT_METRICS_KEY(test_key_unsigned), 1);
+  }
+  return NULL;
+}
+
+//! @return the throughput, in millions of adds per second
+static double prv_run(MetricAddFn add_fn, size_t num_threads) {
+  // start from an empty heartbeat
+  memfault_metrics_heartbeat_debug_trigger();
+
+  pthread_t threads[BENCHMARK_MAX_THREADS];
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < num_threads; i++) {
+    LONGS_EQUAL(0, pthread_create(&threads[i], NULL, prv_add_thread, (void *)add_fn));
+  }
+  for (size_t i = 0; i < num_threads; i++) {
+    LONGS_EQUAL(0, pthread_join(threads[i], NULL));
+  }
+  const auto end = std::chrono::steady_clock::now();
+
+  // no update may be lost, whichever API was used
+  memfault_metrics_heartbeat_collect();
+  uint32_t val = 0;
+  LONGS_EQUAL(0, memfault_metrics_heartbeat_read_unsigned(MEMFAULT_METRICS_KEY(test_key_unsigned),
+                                                          &val));
+  LONGS_EQUAL(num_threads * BENCHMARK_ADDS_PER_THREAD, val);
+
+  const double elapsed_s = std::chrono::duration<double>(end - start).count();
+  return (double)(num_threads * BENCHMARK_ADDS_PER_THREAD) / elapsed_s / 1e6;
+}
+
+TEST_GROUP(MemfaultMetricsLocklessCounterBenchmark) {
+  void teardown() {
+    mock().checkExpectations();
+    mock().clear();
+  }
+};
+
+TEST(MemfaultMetricsLocklessCounterBenchmark, Test_ContendedCounterThroughput) {
+  const size_t thread_counts[] = { 1, 2, 4, BENCHMARK_MAX_THREADS };
+
+  printf("\n%8s %16s %16s %8s\n", "threads", "locked (M/s)", "lockless (M/s)", "speedup");
+  for (size_t i = 0; i < MEMFAULT_ARRAY_SIZE(thread_counts); i++) {
+    const double locked = prv_run(memfault_metrics_heartbeat_add, thread_counts[i]);
+    const double lockless = prv_run(memfault_metrics_heartbeat_add_lockless, thread_counts[i]);
+    printf("%8zu %16.2f %16.2f %7.1fx\n", thread_counts[i], locked, lockless, lockless / locked);
+  }
+}
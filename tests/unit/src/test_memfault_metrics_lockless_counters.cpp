@@ -0,0 +1,223 @@
+//! @file
+//!
+//! @brief
+//! Tests for lock-free metric counters (MEMFAULT_METRICS_LOCKLESS_COUNTERS_ENABLED). Amounts
+//! added with memfault_metrics_heartbeat_add_lockless() must end up in the metric exactly as if
+//! they had been added with memfault_metrics_heartbeat_add(), once the metric is collected.
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTestExt/MockSupport.h"
+#include "fakes/fake_memfault_platform_metrics_locking.h"
+#include "memfault/core/platform/core.h"
+#include "memfault/metrics/metrics.h"
+#include "memfault/metrics/platform/timer.h"
+#include "memfault/metrics/reliability.h"
+#include "memfault/metrics/serializer.h"
+
+#define FAKE_STORAGE_SIZE 1024
+
+#define TEST_NUM_ADD_THREADS 4
+#define TEST_ADDS_PER_THREAD 20000
+
+extern "C" {
+uint64_t memfault_platform_get_time_since_boot_ms(void) {
+  return 0;
+}
+
+bool memfault_metrics_heartbeat_serialize(
+  MEMFAULT_UNUSED const sMemfaultEventStorageImpl *storage_impl) {
+  return mock().actualCall(__func__).returnBoolValueOrDefault(true);
+}
+
+bool memfault_metrics_session_serialize(
+  MEMFAULT_UNUSED const sMemfaultEventStorageImpl *storage_impl,
+  MEMFAULT_UNUSED eMfltMetricsSessionIndex session_index) {
+  return mock().actualCall(__func__).returnBoolValueOrDefault(true);
+}
+
+size_t memfault_metrics_heartbeat_compute_worst_case_storage_size(void) {
+  return FAKE_STORAGE_SIZE;
+}
+
+// fakes
+void memfault_metrics_reliability_boot(sMemfaultMetricsReliabilityCtx *ctx) {
+  (void)ctx;
+}
+void memfault_metrics_reliability_collect(void) { }
+}
+
+bool memfault_platform_metrics_timer_boot(MEMFAULT_UNUSED uint32_t period_sec,
+                                          MEMFAULT_UNUSED MemfaultPlatformTimerCallback callback) {
+  return true;
+}
+
+// clang-format off
+TEST_GROUP(MemfaultMetricsLocklessCounters){
+  void setup() {
+    // end the previous heartbeat, so every test starts with no values set or pending
+    mock().expectOneCall("memfault_metrics_heartbeat_serialize");
+    memfault_metrics_heartbeat_debug_trigger();
+    fake_memfault_metrics_platform_locking_reboot();
+  }
+  void teardown() {
+    CHECK(fake_memfault_platform_metrics_lock_calls_balanced());
+    mock().checkExpectations();
+    mock().clear();
+  }
+};
+// clang-format on
+
+TEST(MemfaultMetricsLocklessCounters, Test_AddedWhenCollected) {
+  const MemfaultMetricId key = MEMFAULT_METRICS_KEY(test_key_unsigned);
+
+  LONGS_EQUAL(0, MEMFAULT_METRIC_ADD_LOCKLESS(test_key_unsigned, 1));
+  LONGS_EQUAL(0, MEMFAULT_METRIC_ADD_LOCKLESS(test_key_unsigned, 2));
+  LONGS_EQUAL(0, memfault_metrics_heartbeat_add_lockless(key, 3));
+  // adding doesn't take the lock
+  LONGS_EQUAL(0, fake_memfault_platform_metrics_lock_get_lock_count());
+
+  // not visible until the metrics are collected
+  uint32_t val = 0;
+  LONGS_EQUAL(-7, memfault_metrics_heartbeat_read_unsigned(key, &val));
+
+  memfault_metrics_heartbeat_collect();
+  LONGS_EQUAL(0, memfault_metrics_heartbeat_read_unsigned(key, &val));
+  LONGS_EQUAL(6, val);
+
+  // the pending amount was consumed by the first collection
+  memfault_metrics_heartbeat_collect();
+  LONGS_EQUAL(0, memfault_metrics_heartbeat_read_unsigned(key, &val));
+  LONGS_EQUAL(6, val);
+}
+
+TEST(MemfaultMetricsLocklessCounters, Test_CombinedWithLockedAdds) {
+  const MemfaultMetricId key = MEMFAULT_METRICS_KEY(test_key_signed);
+
+  LONGS_EQUAL(0, MEMFAULT_METRIC_ADD(test_key_signed, 10));
+  LONGS_EQUAL(0, MEMFAULT_METRIC_ADD_LOCKLESS(test_key_signed, -25));
+  LONGS_EQUAL(0, MEMFAULT_METRIC_ADD(test_key_signed, 3));
+  memfault_metrics_heartbeat_collect();
+
+  int32_t val = 0;
+  LONGS_EQUAL(0, memfault_metrics_heartbeat_read_signed(key, &val));
+  LONGS_EQUAL(-12, val);
+}
+
+TEST(MemfaultMetricsLocklessCounters, Test_Clipping) {
+  const MemfaultMetricId unsigned_key = MEMFAULT_METRICS_KEY(test_key_unsigned);
+  const MemfaultMetricId signed_key = MEMFAULT_METRICS_KEY(test_key_signed);
+
+  LONGS_EQUAL(0, memfault_metrics_heartbeat_set_unsigned(unsigned_key, 5));
+  LONGS_EQUAL(0, MEMFAULT_METRIC_ADD_LOCKLESS(test_key_unsigned, -10));
+  LONGS_EQUAL(0, memfault_metrics_heartbeat_set_signed(signed_key, INT32_MAX - 1));
+  LONGS_EQUAL(0, MEMFAULT_METRIC_ADD_LOCKLESS(test_key_signed, 10));
+  memfault_metrics_heartbeat_collect();
+
+  uint32_t unsigned_val = 1;
+  LONGS_EQUAL(0, memfault_metrics_heartbeat_read_unsigned(unsigned_key, &unsigned_val));
+  LONGS_EQUAL(0, unsigned_val);
+  int32_t signed_val = 0;
+  LONGS_EQUAL(0, memfault_metrics_heartbeat_read_signed(signed_key, &signed_val));
+  LONGS_EQUAL(INT32_MAX, signed_val);
+}
+
+TEST(MemfaultMetricsLocklessCounters, Test_NetZeroAddSetsValue) {
+  // like memfault_metrics_heartbeat_add(), adding marks the metric as set even if the total is 0
+  LONGS_EQUAL(0, MEMFAULT_METRIC_ADD_LOCKLESS(test_key_unsigned, 5));
+  LONGS_EQUAL(0, MEMFAULT_METRIC_ADD_LOCKLESS(test_key_unsigned, -5));
+  memfault_metrics_heartbeat_collect();
+
+  uint32_t val = 1;
+  LONGS_EQUAL(0, memfault_metrics_heartbeat_read_unsigned(MEMFAULT_METRICS_KEY(test_key_unsigned),
+                                                          &val));
+  LONGS_EQUAL(0, val);
+}
+
+TEST(MemfaultMetricsLocklessCounters, Test_InvalidKeys) {
+  LONGS_EQUAL(-2, MEMFAULT_METRIC_ADD_LOCKLESS(test_key_timer, 1));
+  LONGS_EQUAL(-2, MEMFAULT_METRIC_ADD_LOCKLESS(test_key_string, 1));
+  const MemfaultMetricId bad_key = { ._impl = 0xffff };
+  LONGS_EQUAL(-1, memfault_metrics_heartbeat_add_lockless(bad_key, 1));
+}
+
+TEST(MemfaultMetricsLocklessCounters, Test_HeartbeatEndFoldsBeforeReset) {
+  const MemfaultMetricId key = MEMFAULT_METRICS_KEY(test_key_unsigned);
+  LONGS_EQUAL(0, MEMFAULT_METRIC_ADD_LOCKLESS(test_key_unsigned, 7));
+
+  // the amount is reported in the heartbeat it was added in, and not carried over to the next
+  mock().expectOneCall("memfault_metrics_heartbeat_serialize");
+  memfault_metrics_heartbeat_debug_trigger();
+  memfault_metrics_heartbeat_collect();
+
+  uint32_t val = 0;
+  LONGS_EQUAL(-7, memfault_metrics_heartbeat_read_unsigned(key, &val));
+}
+
+TEST(MemfaultMetricsLocklessCounters, Test_FoldedAtSessionEnd) {
+  const MemfaultMetricId key = MEMFAULT_METRICS_KEY_WITH_SESSION(test_unsigned, test_key_session);
+
+  LONGS_EQUAL(0, MEMFAULT_METRICS_SESSION_START(test_key_session));
+  LONGS_EQUAL(0, MEMFAULT_METRIC_SESSION_ADD_LOCKLESS(test_unsigned, test_key_session, 3));
+  LONGS_EQUAL(0, MEMFAULT_METRIC_SESSION_ADD_LOCKLESS(test_unsigned, test_key_session, 4));
+
+  mock().expectOneCall("memfault_metrics_session_serialize");
+  LONGS_EQUAL(0, MEMFAULT_METRICS_SESSION_END(test_key_session));
+
+  uint32_t val = 0;
+  LONGS_EQUAL(0, memfault_metrics_heartbeat_read_unsigned(key, &val));
+  LONGS_EQUAL(7, val);
+}
+
+TEST(MemfaultMetricsLocklessCounters, Test_DiscardedAtSessionStart) {
+  const MemfaultMetricId key = MEMFAULT_METRICS_KEY_WITH_SESSION(test_unsigned, test_key_session);
+
+  // amounts added outside of the session are discarded when it starts, like locked adds are
+  LONGS_EQUAL(0, MEMFAULT_METRIC_SESSION_ADD_LOCKLESS(test_unsigned, test_key_session, 5));
+  LONGS_EQUAL(0, MEMFAULT_METRIC_ADD_LOCKLESS(test_key_unsigned, 2));
+  LONGS_EQUAL(0, MEMFAULT_METRICS_SESSION_START(test_key_session));
+  LONGS_EQUAL(0, MEMFAULT_METRIC_SESSION_ADD_LOCKLESS(test_unsigned, test_key_session, 3));
+
+  mock().expectOneCall("memfault_metrics_session_serialize");
+  LONGS_EQUAL(0, MEMFAULT_METRICS_SESSION_END(test_key_session));
+
+  uint32_t val = 0;
+  LONGS_EQUAL(0, memfault_metrics_heartbeat_read_unsigned(key, &val));
+  LONGS_EQUAL(3, val);
+
+  // the pending amounts of other sessions are kept
+  memfault_metrics_heartbeat_collect();
+  LONGS_EQUAL(0, memfault_metrics_heartbeat_read_unsigned(MEMFAULT_METRICS_KEY(test_key_unsigned),
+                                                          &val));
+  LONGS_EQUAL(2, val);
+}
+
+static void *prv_add_lockless_thread(MEMFAULT_UNUSED void *arg) {
+  for (size_t i = 0; i < TEST_ADDS_PER_THREAD; i++) {
+    MEMFAULT_METRIC_ADD_LOCKLESS(test_key_unsigned, 1);
+  }
+  return NULL;
+}
+
+TEST(MemfaultMetricsLocklessCounters, Test_ConcurrentAddsNotLost) {
+  // amounts added from several threads while the metrics are being collected are all counted
+  pthread_t threads[TEST_NUM_ADD_THREADS];
+  for (size_t i = 0; i < TEST_NUM_ADD_THREADS; i++) {
+    LONGS_EQUAL(0, pthread_create(&threads[i], NULL, prv_add_lockless_thread, NULL));
+  }
+  for (size_t i = 0; i < 100; i++) {
+    memfault_metrics_heartbeat_collect();
+  }
+  for (size_t i = 0; i < TEST_NUM_ADD_THREADS; i++) {
+    LONGS_EQUAL(0, pthread_join(threads[i], NULL));
+  }
+  memfault_metrics_heartbeat_collect();
+
+  uint32_t val = 0;
+  LONGS_EQUAL(0, memfault_metrics_heartbeat_read_unsigned(MEMFAULT_METRICS_KEY(test_key_unsigned),
+                                                          &val));
+  LONGS_EQUAL(TEST_NUM_ADD_THREADS * TEST_ADDS_PER_THREAD, val);
+}
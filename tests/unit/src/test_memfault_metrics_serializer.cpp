@@ -83,6 +83,26 @@ void memfault_metrics_heartbeat_iterate(MemfaultMetricIteratorCallback cb, void
   cb(ctx, &info);
 }
 
+typedef struct {
+  eMfltMetricsSessionIndex session_key;
+  MemfaultMetricIteratorCallback cb;
+  void *ctx;
+} sSessionIterateCtx;
+
+static bool prv_session_filter_cb(void *ctx, const sMemfaultMetricInfo *metric_info) {
+  sSessionIterateCtx *session_ctx = (sSessionIterateCtx *)ctx;
+  if (metric_info->session_key != session_ctx->session_key) {
+    return true;
+  }
+  return session_ctx->cb(session_ctx->ctx, metric_info);
+}
+
+void memfault_metrics_session_iterate(eMfltMetricsSessionIndex session_key,
+                                      MemfaultMetricIteratorCallback cb, void *ctx) {
+  sSessionIterateCtx session_ctx = { .session_key = session_key, .cb = cb, .ctx = ctx };
+  memfault_metrics_heartbeat_iterate(prv_session_filter_cb, &session_ctx);
+}
+
 size_t memfault_metrics_session_get_num_metrics(eMfltMetricsSessionIndex session_key) {
   // if this fails, it means we need to add add a report for the new type
   // to the fake "memfault_metrics_heartbeat_iterate"
@@ -0,0 +1,305 @@
+//! @file
+//!
+//! @brief
+//! Tests for the log-structured non-volatile event store, run against a simulated NOR flash.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "CppUTest/MemoryLeakDetectorMallocMacros.h"
+#include "CppUTest/MemoryLeakDetectorNewMacros.h"
+#include "CppUTest/TestHarness.h"
+#include "CppUTestExt/MockSupport.h"
+#include "fakes/fake_memfault_nv_event_log_flash.h"
+#include "memfault/core/math.h"
+#include "memfault/core/nv_event_log.h"
+#include "memfault/core/platform/nonvolatile_event_storage.h"
+
+#define TEST_SECTOR_SIZE 256
+#define TEST_NUM_SECTORS 4
+
+static uint8_t s_flash[TEST_SECTOR_SIZE * TEST_NUM_SECTORS];
+
+static const sMemfaultNonVolatileEventStorageImpl *s_impl =
+  &g_memfault_platform_nv_event_storage_impl;
+
+//! The event handed to the write callback
+static const uint8_t *s_event;
+
+static bool prv_read_event(uint32_t offset, void *buf, size_t buf_len) {
+  memcpy(buf, &s_event[offset], buf_len);
+  return true;
+}
+
+static bool prv_write_event(const uint8_t *event, size_t len) {
+  s_event = event;
+  return s_impl->write(prv_read_event, len);
+}
+
+//! Builds an event of len bytes whose contents are derived from seed
+static void prv_make_event(uint8_t *event, size_t len, uint32_t seed) {
+  for (size_t i = 0; i < len; i++) {
+    event[i] = (uint8_t)(seed * 31 + i);
+  }
+}
+
+static void prv_write_test_event(size_t len, uint32_t seed) {
+  uint8_t event[TEST_SECTOR_SIZE];
+  prv_make_event(event, len, seed);
+  CHECK(prv_write_event(event, len));
+}
+
+//! Checks the oldest event matches the one written with seed and consumes it
+static void prv_check_and_consume_event(size_t len, uint32_t seed) {
+  size_t event_len = 0;
+  CHECK(s_impl->has_event(&event_len));
+  LONGS_EQUAL(len, event_len);
+
+  uint8_t expected[TEST_SECTOR_SIZE];
+  prv_make_event(expected, len, seed);
+  uint8_t actual[TEST_SECTOR_SIZE];
+  // read in two chunks, the way the packetizer does
+  const size_t first_len = len / 2;
+  CHECK(s_impl->read(0, actual, first_len));
+  CHECK(s_impl->read((uint32_t)first_len, &actual[first_len], len - first_len));
+  MEMCMP_EQUAL(expected, actual, len);
+
+  s_impl->consume();
+}
+
+static size_t prv_num_events(void) {
+  sMfltNvEventLogStats stats;
+  memfault_nv_event_log_get_stats(&stats);
+  return stats.num_events;
+}
+
+TEST_GROUP(MemfaultNvEventLog) {
+  void setup() {
+    fake_memfault_nv_event_log_flash_setup(s_flash, sizeof(s_flash), TEST_SECTOR_SIZE);
+    fake_memfault_nv_event_log_flash_erase_all();
+    CHECK(memfault_nv_event_log_boot());
+  }
+  void teardown() {
+    mock().checkExpectations();
+    mock().clear();
+  }
+};
+
+TEST(MemfaultNvEventLog, Test_EmptyLog) {
+  CHECK(s_impl->enabled());
+  size_t event_len;
+  CHECK_FALSE(s_impl->has_event(&event_len));
+  uint8_t buf[4];
+  CHECK_FALSE(s_impl->read(0, buf, sizeof(buf)));
+  // consuming with nothing stored is a no-op
+  s_impl->consume();
+  LONGS_EQUAL(0, prv_num_events());
+}
+
+TEST(MemfaultNvEventLog, Test_WriteReadConsume) {
+  prv_write_test_event(10, 1);
+  prv_write_test_event(33, 2);
+  prv_write_test_event(1, 3);
+  LONGS_EQUAL(3, prv_num_events());
+
+  // reads past the end of the event fail
+  uint8_t buf[16];
+  CHECK_FALSE(s_impl->read(0, buf, 11));
+  CHECK_FALSE(s_impl->read(5, buf, 6));
+
+  prv_check_and_consume_event(10, 1);
+  prv_check_and_consume_event(33, 2);
+  prv_check_and_consume_event(1, 3);
+  size_t event_len;
+  CHECK_FALSE(s_impl->has_event(&event_len));
+  LONGS_EQUAL(0, prv_num_events());
+
+  // the log keeps working after being drained
+  prv_write_test_event(20, 4);
+  prv_check_and_consume_event(20, 4);
+}
+
+TEST(MemfaultNvEventLog, Test_InvalidEventSizes) {
+  uint8_t event[TEST_SECTOR_SIZE] = { 0 };
+  CHECK_FALSE(prv_write_event(event, 0));
+  // an event has to fit in a sector along with the sector and record headers
+  CHECK_FALSE(prv_write_event(event, TEST_SECTOR_SIZE - 8));
+  CHECK(prv_write_event(event, TEST_SECTOR_SIZE - 16));
+  LONGS_EQUAL(1, prv_num_events());
+}
+
+TEST(MemfaultNvEventLog, Test_HeaderAndDataBatchedIntoOneWrite) {
+  // the sector header and the record are written separately for the first event...
+  prv_write_test_event(20, 1);
+  LONGS_EQUAL(2, fake_memfault_nv_event_log_flash_get_write_count());
+  // ... then the record header and a small event are staged in a single write
+  prv_write_test_event(20, 2);
+  LONGS_EQUAL(3, fake_memfault_nv_event_log_flash_get_write_count());
+}
+
+TEST(MemfaultNvEventLog, Test_SectorRotationLevelsWear) {
+  const size_t event_len = 50;
+  uint32_t next_write = 0;
+  uint32_t next_read = 0;
+
+  // keep a few events in flight while going around the region many times
+  for (int i = 0; i < 400; i++) {
+    prv_write_test_event(event_len, next_write++);
+    if (prv_num_events() > 6) {
+      prv_check_and_consume_event(event_len, next_read++);
+    }
+  }
+  while (next_read != next_write) {
+    prv_check_and_consume_event(event_len, next_read++);
+  }
+
+  // every sector has been erased about as many times as the others
+  uint32_t min_erases = UINT32_MAX;
+  uint32_t max_erases = 0;
+  for (size_t sector = 0; sector < TEST_NUM_SECTORS; sector++) {
+    const uint32_t erases = fake_memfault_nv_event_log_flash_get_erase_count(sector);
+    min_erases = MEMFAULT_MIN(min_erases, erases);
+    max_erases = MEMFAULT_MAX(max_erases, erases);
+  }
+  CHECK(min_erases > 10);
+  CHECK((max_erases - min_erases) <= 1);
+
+  sMfltNvEventLogStats stats;
+  memfault_nv_event_log_get_stats(&stats);
+  // 4 events of 60 bytes fit in each sector
+  LONGS_EQUAL(400 / 4, stats.sector_erase_count);
+}
+
+TEST(MemfaultNvEventLog, Test_FullLogRejectsWrites) {
+  const size_t event_len = 100;
+  // 2 events fit in a sector
+  uint32_t num_written = 0;
+  while (num_written < 100) {
+    uint8_t event[event_len];
+    prv_make_event(event, event_len, num_written);
+    if (!prv_write_event(event, event_len)) {
+      break;
+    }
+    num_written++;
+  }
+  LONGS_EQUAL(2 * TEST_NUM_SECTORS, num_written);
+  LONGS_EQUAL(num_written, prv_num_events());
+
+  // consuming one event doesn't free the oldest sector yet
+  prv_check_and_consume_event(event_len, 0);
+  CHECK_FALSE(prv_write_event(s_flash, event_len));
+  // once the sector has been fully consumed it is reclaimed
+  prv_check_and_consume_event(event_len, 1);
+  prv_write_test_event(event_len, num_written);
+
+  for (uint32_t i = 2; i <= num_written; i++) {
+    prv_check_and_consume_event(event_len, i);
+  }
+  LONGS_EQUAL(0, prv_num_events());
+}
+
+TEST(MemfaultNvEventLog, Test_RecoveryAfterReboot) {
+  for (uint32_t i = 0; i < 10; i++) {
+    prv_write_test_event(40 + i, i);
+  }
+  prv_check_and_consume_event(40, 0);
+  prv_check_and_consume_event(41, 1);
+  prv_check_and_consume_event(42, 2);
+
+  // events and their consumed state survive a reboot
+  CHECK(memfault_nv_event_log_boot());
+  LONGS_EQUAL(7, prv_num_events());
+  prv_check_and_consume_event(43, 3);
+
+  CHECK(memfault_nv_event_log_boot());
+  LONGS_EQUAL(6, prv_num_events());
+  for (uint32_t i = 4; i < 10; i++) {
+    prv_check_and_consume_event(40 + i, i);
+  }
+
+  // new events are appended after the recovered ones
+  CHECK(memfault_nv_event_log_boot());
+  prv_write_test_event(12, 100);
+  CHECK(memfault_nv_event_log_boot());
+  prv_check_and_consume_event(12, 100);
+  LONGS_EQUAL(0, prv_num_events());
+}
+
+TEST(MemfaultNvEventLog, Test_RecoveryAfterWrapAround) {
+  const size_t event_len = 100;
+  uint32_t next_read = 0;
+  for (uint32_t i = 0; i < 30; i++) {
+    prv_write_test_event(event_len, i);
+    if (prv_num_events() > 4) {
+      prv_check_and_consume_event(event_len, next_read++);
+    }
+  }
+
+  CHECK(memfault_nv_event_log_boot());
+  LONGS_EQUAL(4, prv_num_events());
+  for (uint32_t i = next_read; i < 30; i++) {
+    prv_check_and_consume_event(event_len, i);
+  }
+}
+
+TEST(MemfaultNvEventLog, Test_TornWriteDiscarded) {
+  prv_write_test_event(30, 1);
+  prv_write_test_event(30, 2);
+
+  // lose power at every possible point while writing the third event
+  for (int bytes_written = 0; bytes_written < 38; bytes_written++) {
+    fake_memfault_nv_event_log_flash_set_power_loss_after(bytes_written);
+    uint8_t event[30];
+    prv_make_event(event, sizeof(event), 3);
+    CHECK_FALSE(prv_write_event(event, sizeof(event)));
+
+    fake_memfault_nv_event_log_flash_set_power_loss_after(-1);
+    CHECK(memfault_nv_event_log_boot());
+    LONGS_EQUAL(2, prv_num_events());
+  }
+
+  // the events written before are intact. The remainder of a sector holding a torn write isn't
+  // reused, so the log fills up but new events can be written once they have been consumed.
+  prv_check_and_consume_event(30, 1);
+  prv_check_and_consume_event(30, 2);
+  prv_write_test_event(30, 4);
+  CHECK(memfault_nv_event_log_boot());
+  prv_check_and_consume_event(30, 4);
+  LONGS_EQUAL(0, prv_num_events());
+}
+
+TEST(MemfaultNvEventLog, Test_TornSectorOpenRecovered) {
+  // fill the first sector
+  prv_write_test_event(100, 1);
+  prv_write_test_event(100, 2);
+
+  // lose power while the header of the next sector is written
+  for (int bytes_written = 0; bytes_written < 8; bytes_written++) {
+    fake_memfault_nv_event_log_flash_set_power_loss_after(bytes_written);
+    CHECK_FALSE(prv_write_event(s_flash, 100));
+    fake_memfault_nv_event_log_flash_set_power_loss_after(-1);
+
+    CHECK(memfault_nv_event_log_boot());
+    LONGS_EQUAL(2, prv_num_events());
+  }
+  prv_write_test_event(100, 3);
+  prv_check_and_consume_event(100, 1);
+  prv_check_and_consume_event(100, 2);
+  prv_check_and_consume_event(100, 3);
+}
+
+TEST(MemfaultNvEventLog, Test_InvalidStorageConfig) {
+  // region smaller than 2 sectors
+  fake_memfault_nv_event_log_flash_setup(s_flash, TEST_SECTOR_SIZE, TEST_SECTOR_SIZE);
+  CHECK_FALSE(memfault_nv_event_log_boot());
+  CHECK_FALSE(s_impl->enabled());
+  CHECK_FALSE(prv_write_event(s_flash, 10));
+
+  // region not a multiple of the sector size
+  fake_memfault_nv_event_log_flash_setup(s_flash, TEST_SECTOR_SIZE * 2 + 1, TEST_SECTOR_SIZE);
+  CHECK_FALSE(memfault_nv_event_log_boot());
+
+  fake_memfault_nv_event_log_flash_setup(s_flash, sizeof(s_flash), 0);
+  CHECK_FALSE(memfault_nv_event_log_boot());
+}
@@ -0,0 +1,91 @@
+//! @file
+//!
+//! @brief
+//! Benchmark persisting and draining events through the non-volatile event log at a range of
+//! event sizes, reporting the throughput along with the number of flash operations used.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+
+#include "CppUTest/MemoryLeakDetectorMallocMacros.h"
+#include "CppUTest/MemoryLeakDetectorNewMacros.h"
+#include "CppUTest/TestHarness.h"
+#include "CppUTestExt/MockSupport.h"
+#include "fakes/fake_memfault_nv_event_log_flash.h"
+#include "memfault/core/math.h"
+#include "memfault/core/nv_event_log.h"
+#include "memfault/core/platform/nonvolatile_event_storage.h"
+
+#define BENCHMARK_SECTOR_SIZE 4096
+#define BENCHMARK_NUM_SECTORS 16
+#define BENCHMARK_NUM_EVENTS 20000
+//! Events kept in flight, as if the device was offline for a while
+#define BENCHMARK_EVENTS_IN_FLIGHT 32
+
+static uint8_t s_flash[BENCHMARK_SECTOR_SIZE * BENCHMARK_NUM_SECTORS];
+static uint8_t s_event[1024];
+
+static bool prv_read_event(uint32_t offset, void *buf, size_t buf_len) {
+  memcpy(buf, &s_event[offset], buf_len);
+  return true;
+}
+
+TEST_GROUP(MemfaultNvEventLogBenchmark) {
+  void setup() {
+    fake_memfault_nv_event_log_flash_setup(s_flash, sizeof(s_flash), BENCHMARK_SECTOR_SIZE);
+    fake_memfault_nv_event_log_flash_erase_all();
+    CHECK(memfault_nv_event_log_boot());
+  }
+  void teardown() {
+    mock().checkExpectations();
+    mock().clear();
+  }
+};
+
+static void prv_drain_event(const sMemfaultNonVolatileEventStorageImpl *impl, uint8_t *buf) {
+  size_t event_len;
+  CHECK(impl->has_event(&event_len));
+  CHECK(impl->read(0, buf, event_len));
+  impl->consume();
+}
+
+TEST(MemfaultNvEventLogBenchmark, Test_WriteAndDrainThroughput) {
+  const sMemfaultNonVolatileEventStorageImpl *impl = &g_memfault_platform_nv_event_storage_impl;
+  const size_t event_sizes[] = { 16, 64, 256, 1024 };
+
+  for (size_t i = 0; i < MEMFAULT_ARRAY_SIZE(event_sizes); i++) {
+    const size_t event_size = event_sizes[i];
+    memset(s_event, (int)i, event_size);
+
+    const uint32_t writes_before = fake_memfault_nv_event_log_flash_get_write_count();
+    sMfltNvEventLogStats stats_before;
+    memfault_nv_event_log_get_stats(&stats_before);
+
+    uint8_t buf[sizeof(s_event)];
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t evt = 0; evt < BENCHMARK_NUM_EVENTS; evt++) {
+      CHECK(impl->write(prv_read_event, event_size));
+      if (evt >= BENCHMARK_EVENTS_IN_FLIGHT) {
+        prv_drain_event(impl, buf);
+      }
+    }
+    for (size_t evt = 0; evt < BENCHMARK_EVENTS_IN_FLIGHT; evt++) {
+      prv_drain_event(impl, buf);
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    sMfltNvEventLogStats stats;
+    memfault_nv_event_log_get_stats(&stats);
+    LONGS_EQUAL(0, stats.num_events);
+    const long long elapsed_us =
+      (long long)std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    printf("nv event log: %d events of %d bytes: %lld us, %d flash writes, %d sector erases\n",
+           BENCHMARK_NUM_EVENTS, (int)event_size, elapsed_us,
+           (int)(fake_memfault_nv_event_log_flash_get_write_count() - writes_before),
+           (int)(stats.sector_erase_count - stats_before.sector_erase_count));
+  }
+}
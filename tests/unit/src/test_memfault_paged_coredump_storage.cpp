@@ -0,0 +1,146 @@
+//! @file
+//!
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "CppUTest/MemoryLeakDetectorMallocMacros.h"
+#include "CppUTest/MemoryLeakDetectorNewMacros.h"
+#include "CppUTest/TestHarness.h"
+#include "fakes/fake_memfault_paged_coredump_storage.h"
+#include "memfault/core/math.h"
+#include "memfault/panics/platform/coredump.h"
+
+#define TEST_PAGE_SIZE MEMFAULT_COREDUMP_STORAGE_PAGE_SIZE
+#define TEST_STORAGE_SIZE (8 * TEST_PAGE_SIZE)
+#define TEST_HEADER_SIZE 12
+
+TEST_GROUP(MemfaultPagedCoredumpStorage) {
+  void setup() {
+    fake_paged_coredump_storage_reset(TEST_STORAGE_SIZE);
+    fake_paged_coredump_storage_set_blocking(false);
+  }
+  void teardown() { }
+};
+
+static uint8_t prv_pattern(size_t offset) {
+  return (uint8_t)((offset * 7) + 3);
+}
+
+//! Writes the bytes after the header in chunks of chunk_size, then the header
+static void prv_write_coredump(size_t coredump_size, size_t chunk_size) {
+  uint8_t data[TEST_STORAGE_SIZE];
+  for (size_t i = 0; i < sizeof(data); i++) {
+    data[i] = prv_pattern(i);
+  }
+
+  for (size_t offset = TEST_HEADER_SIZE; offset < coredump_size; offset += chunk_size) {
+    const size_t len = MEMFAULT_MIN(chunk_size, coredump_size - offset);
+    CHECK(memfault_platform_coredump_storage_write(offset, &data[offset], len));
+  }
+  CHECK(memfault_platform_coredump_storage_write(0, data, TEST_HEADER_SIZE));
+  // everything has been programmed once the header has been written
+  CHECK_FALSE(fake_paged_coredump_storage_write_in_flight());
+}
+
+static void prv_validate_pattern_written(size_t coredump_size) {
+  for (size_t i = 0; i < coredump_size; i++) {
+    LONGS_EQUAL(prv_pattern(i), g_paged_storage[i]);
+  }
+  // the remainder of the last page is zero'd and the rest of storage is untouched
+  const size_t pages_used = (coredump_size + TEST_PAGE_SIZE - 1) / TEST_PAGE_SIZE;
+  for (size_t i = coredump_size; i < pages_used * TEST_PAGE_SIZE; i++) {
+    LONGS_EQUAL(0, g_paged_storage[i]);
+  }
+  for (size_t i = pages_used * TEST_PAGE_SIZE; i < TEST_STORAGE_SIZE; i++) {
+    LONGS_EQUAL(0xff, g_paged_storage[i]);
+  }
+  LONGS_EQUAL(pages_used, fake_paged_coredump_storage_get_num_programs());
+}
+
+TEST(MemfaultPagedCoredumpStorage, Test_ByteWrites) {
+  const size_t coredump_size = 3 * TEST_PAGE_SIZE + 5;
+  prv_write_coredump(coredump_size, 1);
+  prv_validate_pattern_written(coredump_size);
+}
+
+TEST(MemfaultPagedCoredumpStorage, Test_WordWrites) {
+  const size_t coredump_size = TEST_STORAGE_SIZE;
+  prv_write_coredump(coredump_size, 4);
+  prv_validate_pattern_written(coredump_size);
+}
+
+TEST(MemfaultPagedCoredumpStorage, Test_WritesSpanningPages) {
+  const size_t coredump_size = 5 * TEST_PAGE_SIZE + 17;
+  prv_write_coredump(coredump_size, TEST_PAGE_SIZE + 3);
+  prv_validate_pattern_written(coredump_size);
+}
+
+TEST(MemfaultPagedCoredumpStorage, Test_SmallCoredump) {
+  // nothing is programmed until the header is written
+  const size_t coredump_size = TEST_PAGE_SIZE / 2;
+  uint8_t data[TEST_PAGE_SIZE];
+  for (size_t i = 0; i < sizeof(data); i++) {
+    data[i] = prv_pattern(i);
+  }
+  CHECK(memfault_platform_coredump_storage_write(TEST_HEADER_SIZE, &data[TEST_HEADER_SIZE],
+                                                 coredump_size - TEST_HEADER_SIZE));
+  LONGS_EQUAL(0, fake_paged_coredump_storage_get_num_programs());
+
+  CHECK(memfault_platform_coredump_storage_write(0, data, TEST_HEADER_SIZE));
+  prv_validate_pattern_written(coredump_size);
+}
+
+TEST(MemfaultPagedCoredumpStorage, Test_PagesProgrammedWhileNextFills) {
+  uint8_t data[TEST_PAGE_SIZE];
+  memset(data, 0xa5, sizeof(data));
+
+  // fill the rest of the first page (held until the end) and the second page
+  CHECK(memfault_platform_coredump_storage_write(TEST_HEADER_SIZE, data,
+                                                 TEST_PAGE_SIZE - TEST_HEADER_SIZE));
+  CHECK(memfault_platform_coredump_storage_write(TEST_PAGE_SIZE, data, TEST_PAGE_SIZE));
+  LONGS_EQUAL(1, fake_paged_coredump_storage_get_num_programs());
+  CHECK(fake_paged_coredump_storage_write_in_flight());
+
+  // the third page is filled while the second one is still being programmed
+  CHECK(memfault_platform_coredump_storage_write(2 * TEST_PAGE_SIZE, data, TEST_PAGE_SIZE / 2));
+  CHECK(fake_paged_coredump_storage_write_in_flight());
+  LONGS_EQUAL(1, fake_paged_coredump_storage_get_num_programs());
+
+  // once it's full, the writer waits for the second page before programming the third
+  CHECK(memfault_platform_coredump_storage_write(2 * TEST_PAGE_SIZE + TEST_PAGE_SIZE / 2, data,
+                                                 TEST_PAGE_SIZE / 2));
+  LONGS_EQUAL(2, fake_paged_coredump_storage_get_num_programs());
+
+  CHECK(memfault_platform_coredump_storage_write(0, data, TEST_HEADER_SIZE));
+  LONGS_EQUAL(3, fake_paged_coredump_storage_get_num_programs());
+  CHECK_FALSE(fake_paged_coredump_storage_write_in_flight());
+}
+
+TEST(MemfaultPagedCoredumpStorage, Test_BlockingWrites) {
+  fake_paged_coredump_storage_set_blocking(true);
+  const size_t coredump_size = 4 * TEST_PAGE_SIZE + 1;
+  prv_write_coredump(coredump_size, 9);
+  prv_validate_pattern_written(coredump_size);
+}
+
+TEST(MemfaultPagedCoredumpStorage, Test_OutOfBounds) {
+  uint8_t data[16] = { 0 };
+  CHECK_FALSE(memfault_platform_coredump_storage_write(TEST_STORAGE_SIZE - 8, data, sizeof(data)));
+
+  // storage which isn't a multiple of the page size
+  fake_paged_coredump_storage_reset(TEST_STORAGE_SIZE - 4);
+  CHECK_FALSE(memfault_platform_coredump_storage_write(0, data, sizeof(data)));
+}
+
+TEST(MemfaultPagedCoredumpStorage, Test_BadPageWrite) {
+  uint8_t data[TEST_PAGE_SIZE] = { 0 };
+
+  fake_paged_coredump_storage_inject_write_failure();
+  CHECK_FALSE(memfault_platform_coredump_storage_write(TEST_PAGE_SIZE, data, sizeof(data)));
+
+  fake_paged_coredump_storage_reset(TEST_STORAGE_SIZE);
+  fake_paged_coredump_storage_inject_write_failure();
+  CHECK_FALSE(memfault_platform_coredump_storage_write(0, data, TEST_HEADER_SIZE));
+}
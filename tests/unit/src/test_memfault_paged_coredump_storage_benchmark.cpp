@@ -0,0 +1,119 @@
+//! @file
+//!
+//! @brief
+//! Benchmark saving a coredump through the paged coredump storage writer
+//! (memfault/ports/paged_coredump_storage.h) to a simulated NOR flash. Set
+//! PAGED_COREDUMP_BENCHMARK_PAGE_SIZE when running
+//! Makefile_memfault_paged_coredump_storage_benchmark.mk to build a different page size so the
+//! save times reported can be compared.
+//!
+//! The time reported is the host time spent saving plus the time spent waiting on the simulated
+//! flash (see test_memfault_paged_coredump_storage_impl.c). Erasing storage is not included.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "CppUTest/MemoryLeakDetectorMallocMacros.h"
+#include "CppUTest/MemoryLeakDetectorNewMacros.h"
+#include "CppUTest/TestHarness.h"
+
+extern "C" {
+#include "fakes/fake_memfault_paged_coredump_storage.h"
+#include "memfault/core/build_info.h"
+#include "memfault/core/math.h"
+#include "memfault/core/platform/device_info.h"
+#include "memfault/panics/coredump.h"
+#include "memfault/panics/coredump_impl.h"
+#include "memfault/panics/platform/coredump.h"
+
+void memfault_platform_get_device_info(struct MemfaultDeviceInfo *info) {
+  *info = (struct MemfaultDeviceInfo){
+    .device_serial = "1",
+    .software_type = "main",
+    .software_version = "22",
+    .hardware_version = "333",
+  };
+}
+
+bool memfault_build_info_read(MEMFAULT_UNUSED sMemfaultBuildInfo *info) {
+  return false;
+}
+
+const sMfltCoredumpRegion *memfault_coredump_get_arch_regions(size_t *num_regions) {
+  *num_regions = 0;
+  return NULL;
+}
+
+const sMfltCoredumpRegion *memfault_coredump_get_sdk_regions(size_t *num_regions) {
+  *num_regions = 0;
+  return NULL;
+}
+}
+
+#define BENCHMARK_STORAGE_SIZE (128 * 1024)
+#define BENCHMARK_NUM_TASKS 16
+
+// a large RAM region, a bank of peripheral registers which must be read a word at a time and a
+// number of small regions (i.e task control blocks), each of which adds a block header
+static uint8_t s_ram[64 * 1024];
+static uint32_t s_peripheral_regs[64];
+static uint8_t s_tcbs[BENCHMARK_NUM_TASKS][96];
+
+static sMfltCoredumpRegion s_regions[2 + BENCHMARK_NUM_TASKS];
+
+TEST_GROUP(MemfaultPagedCoredumpStorageBenchmark) {
+  void setup() {
+    for (size_t i = 0; i < sizeof(s_ram); i++) {
+      s_ram[i] = (uint8_t)(i * 13);
+    }
+    s_regions[0] = MEMFAULT_COREDUMP_MEMORY_REGION_INIT(s_ram, sizeof(s_ram));
+    s_regions[1] = (sMfltCoredumpRegion){
+      .type = kMfltCoredumpRegionType_MemoryWordAccessOnly,
+      .region_start = s_peripheral_regs,
+      .region_size = sizeof(s_peripheral_regs),
+    };
+    for (size_t i = 0; i < BENCHMARK_NUM_TASKS; i++) {
+      s_regions[2 + i] = MEMFAULT_COREDUMP_MEMORY_REGION_INIT(s_tcbs[i], sizeof(s_tcbs[i]));
+    }
+  }
+  void teardown() { }
+};
+
+static uint64_t prv_save_coredump(bool blocking, uint32_t *num_programs) {
+  fake_paged_coredump_storage_reset(BENCHMARK_STORAGE_SIZE);
+  fake_paged_coredump_storage_set_blocking(blocking);
+
+  const uint32_t regs[17] = { 0 };
+  const sMemfaultCoredumpSaveInfo save_info = {
+    .regs = regs,
+    .regs_size = sizeof(regs),
+    .trace_reason = kMfltRebootReason_HardFault,
+    .regions = s_regions,
+    .num_regions = MEMFAULT_ARRAY_SIZE(s_regions),
+  };
+
+  const uint64_t start = fake_paged_coredump_storage_get_time_ns();
+  CHECK(memfault_coredump_save(&save_info));
+  const uint64_t elapsed = fake_paged_coredump_storage_get_time_ns() - start;
+
+  size_t total_size = 0;
+  CHECK(memfault_coredump_has_valid_coredump(&total_size));
+  CHECK(total_size > sizeof(s_ram));
+  *num_programs = fake_paged_coredump_storage_get_num_programs();
+  return elapsed;
+}
+
+TEST(MemfaultPagedCoredumpStorageBenchmark, Test_SaveTime) {
+  uint32_t blocking_programs;
+  const uint64_t blocking_ns = prv_save_coredump(true, &blocking_programs);
+  uint32_t programs;
+  const uint64_t double_buffered_ns = prv_save_coredump(false, &programs);
+  LONGS_EQUAL(blocking_programs, programs);
+
+  printf("paged coredump storage, page size %d: %d programs, blocking %lld us, "
+         "double buffered %lld us\n",
+         MEMFAULT_COREDUMP_STORAGE_PAGE_SIZE, (int)programs, (long long)(blocking_ns / 1000),
+         (long long)(double_buffered_ns / 1000));
+}
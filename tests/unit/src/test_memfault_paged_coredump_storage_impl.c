@@ -0,0 +1,142 @@
+//! @file
+//!
+//! Copyright (c) Memfault, Inc.
+//! See LICENSE for details
+//!
+//! A fake implementation of coredump storage which makes use of the
+//! implementation in memfault/ports/paged_coredump_storage.h
+//!
+//! Simulates a NOR flash programmed a page at a time in the background: each program takes a
+//! fixed command overhead plus a per-byte time, and the simulated clock only advances past the
+//! host clock when the writer has to wait for a program to complete.
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "fakes/fake_memfault_paged_coredump_storage.h"
+#include "memfault/ports/paged_coredump_storage.h"
+
+// Typical figures for a QSPI NOR flash: ~0.7ms to program a 256 byte page plus the overhead of
+// issuing the write enable / program commands and polling for completion
+#define FAKE_FLASH_PROGRAM_OVERHEAD_NS 20000
+#define FAKE_FLASH_PROGRAM_NS_PER_BYTE 2700
+
+uint8_t g_paged_storage[MEMFAULT_PAGED_STORAGE_MAX_SIZE];
+
+static struct {
+  size_t size;
+  bool blocking;
+  bool inject_write_failure;
+  bool write_in_flight;
+  uint32_t num_programs;
+  // time the simulated clock has been advanced by, on top of the host clock
+  uint64_t stall_ns;
+  uint64_t flash_busy_until_ns;
+} s_fake_storage;
+
+static uint64_t prv_host_time_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+uint64_t fake_paged_coredump_storage_get_time_ns(void) {
+  return prv_host_time_ns() + s_fake_storage.stall_ns;
+}
+
+static void prv_wait_until(uint64_t time_ns) {
+  const uint64_t now = fake_paged_coredump_storage_get_time_ns();
+  if (time_ns > now) {
+    s_fake_storage.stall_ns += time_ns - now;
+  }
+}
+
+void memfault_platform_coredump_storage_get_info(sMfltCoredumpStorageInfo *info) {
+  *info = (sMfltCoredumpStorageInfo){
+    .size = s_fake_storage.size,
+    .sector_size = MEMFAULT_COREDUMP_STORAGE_PAGE_SIZE,
+  };
+}
+
+bool memfault_platform_coredump_storage_read(uint32_t offset, void *data, size_t read_len) {
+  if ((offset + read_len) > s_fake_storage.size) {
+    return false;
+  }
+  memcpy(data, &g_paged_storage[offset], read_len);
+  return true;
+}
+
+bool memfault_platform_coredump_storage_erase(uint32_t offset, size_t erase_size) {
+  if ((offset + erase_size) > s_fake_storage.size) {
+    return false;
+  }
+  memset(&g_paged_storage[offset], 0xff, erase_size);
+  return true;
+}
+
+void memfault_platform_coredump_storage_clear(void) {
+  memset(g_paged_storage, 0xff, MEMFAULT_COREDUMP_STORAGE_PAGE_SIZE);
+}
+
+bool memfault_platform_coredump_storage_page_write_start(const sCoredumpStoragePage *page) {
+  // the writer must wait for a program to complete before starting the next one
+  assert(!s_fake_storage.write_in_flight);
+  assert((page->write_offset % MEMFAULT_COREDUMP_STORAGE_PAGE_SIZE) == 0);
+  assert((page->write_offset + sizeof(page->data)) <= s_fake_storage.size);
+
+  if (s_fake_storage.inject_write_failure) {
+    s_fake_storage.inject_write_failure = false;
+    return false;
+  }
+
+  // like NOR flash, a page can only be programmed once between erases
+  for (size_t i = 0; i < sizeof(page->data); i++) {
+    assert(g_paged_storage[page->write_offset + i] == 0xff);
+  }
+  memcpy(&g_paged_storage[page->write_offset], page->data, sizeof(page->data));
+
+  s_fake_storage.num_programs++;
+  s_fake_storage.flash_busy_until_ns = fake_paged_coredump_storage_get_time_ns() +
+                                       FAKE_FLASH_PROGRAM_OVERHEAD_NS +
+                                       FAKE_FLASH_PROGRAM_NS_PER_BYTE * sizeof(page->data);
+  if (s_fake_storage.blocking) {
+    prv_wait_until(s_fake_storage.flash_busy_until_ns);
+  } else {
+    s_fake_storage.write_in_flight = true;
+  }
+  return true;
+}
+
+bool memfault_platform_coredump_storage_page_write_wait(void) {
+  prv_wait_until(s_fake_storage.flash_busy_until_ns);
+  s_fake_storage.write_in_flight = false;
+  return true;
+}
+
+void fake_paged_coredump_storage_reset(size_t size) {
+  assert(size <= sizeof(g_paged_storage));
+  memset(g_paged_storage, 0xff, sizeof(g_paged_storage));
+  s_coredump_paged_writer = (sCoredumpPagedWriter){ 0 };
+  s_fake_storage.size = size;
+  s_fake_storage.inject_write_failure = false;
+  s_fake_storage.write_in_flight = false;
+  s_fake_storage.num_programs = 0;
+}
+
+void fake_paged_coredump_storage_set_blocking(bool blocking) {
+  s_fake_storage.blocking = blocking;
+}
+
+void fake_paged_coredump_storage_inject_write_failure(void) {
+  s_fake_storage.inject_write_failure = true;
+}
+
+bool fake_paged_coredump_storage_write_in_flight(void) {
+  return s_fake_storage.write_in_flight;
+}
+
+uint32_t fake_paged_coredump_storage_get_num_programs(void) {
+  return s_fake_storage.num_programs;
+}
@@ -12,9 +12,12 @@
 #include "CppUTest/TestHarness.h"
 #include "CppUTestExt/MockSupport.h"
 #include "fakes/fake_memfault_build_id.h"
+#include "fakes/fake_memfault_platform_get_device_info.h"
+#include "fakes/fake_memfault_platform_metrics_locking.h"
 #include "fakes/fake_memfault_platform_time.h"
 #include "memfault/config.h"
 #include "memfault/core/math.h"
+#include "memfault/core/platform/device_info.h"
 #include "memfault/core/serializer_helper.h"
 #include "memfault/util/cbor.h"
 
@@ -22,6 +25,7 @@ TEST_GROUP(MemfaultMetricsSerializerHelper) {
   void setup() {
     fake_memfault_platform_time_enable(false);
     fake_memfault_build_id_reset();
+    memfault_device_info_changed();
   }
   void teardown() {
     mock().checkExpectations();
@@ -171,3 +175,97 @@ TEST(MemfaultMetricsSerializerHelper, Test_MemfaultMetricSerializeEventMetadata)
     MEMCMP_EQUAL(vec->expected_encoding, result, sizeof(result));
   }
 }
+
+#if MEMFAULT_EVENT_METADATA_CACHE_ENABLED
+TEST(MemfaultMetricsSerializerHelper, Test_MemfaultMetadataCacheInvalidation) {
+  const char *original_software_version = g_fake_device_info.software_version;
+  uint8_t result[sizeof(test_vector)];
+  sMemfaultCborEncoder encoder;
+
+  uint8_t expected_updated[sizeof(test_vector)];
+  memcpy(expected_updated, test_vector, sizeof(expected_updated));
+  uint8_t *version = (uint8_t *)memmem(expected_updated, sizeof(expected_updated), "1.2.3", 5);
+  CHECK(version != NULL);
+  version[4] = '4';
+
+  prv_encode_metadata_and_check(&encoder, result, sizeof(result));
+  MEMCMP_EQUAL(test_vector, result, sizeof(result));
+
+  // The cached metadata keeps being used until the cache is invalidated. When the metadata does
+  // not fit in the cache, it is encoded from scratch for every event instead.
+  g_fake_device_info.software_version = "1.2.4";
+  prv_encode_metadata_and_check(&encoder, result, sizeof(result));
+  const bool cache_fits = MEMFAULT_EVENT_METADATA_CACHE_SIZE >= sizeof(test_vector);
+  MEMCMP_EQUAL(cache_fits ? test_vector : expected_updated, result, sizeof(result));
+
+  memfault_device_info_changed();
+  prv_encode_metadata_and_check(&encoder, result, sizeof(result));
+  g_fake_device_info.software_version = original_software_version;
+  MEMCMP_EQUAL(expected_updated, result, sizeof(result));
+
+  // the cache is shared between tasks, so it's only accessed with the lock held
+  CHECK(fake_memfault_platform_metrics_lock_get_lock_count() > 0);
+  CHECK(fake_memfault_platform_metrics_lock_calls_balanced());
+}
+
+static void prv_unlocked_write_cb(void *ctx, uint32_t offset, const void *buf, size_t buf_len) {
+  // the encoder may be writing to storage, which must not happen with the lock held
+  CHECK(fake_memfault_platform_metrics_lock_calls_balanced());
+  prv_write_cb(ctx, offset, buf, buf_len);
+}
+
+TEST(MemfaultMetricsSerializerHelper, Test_MemfaultMetadataCacheWrittenWithoutLock) {
+  uint8_t result[sizeof(test_vector)];
+  sMemfaultCborEncoder encoder;
+  for (int i = 0; i < 2; i++) {
+    // first from a freshly built cache, then from the cache as is
+    memfault_cbor_encoder_init(&encoder, prv_unlocked_write_cb, result, sizeof(result));
+    CHECK(memfault_serializer_helper_encode_metadata(&encoder, kMemfaultEventType_Heartbeat));
+    LONGS_EQUAL(sizeof(result), memfault_cbor_encoder_deinit(&encoder));
+    MEMCMP_EQUAL(test_vector, result, sizeof(result));
+  }
+}
+#endif
+
+#if MEMFAULT_EVENT_STORAGE_COMPACT_BATCHES_ENABLED
+TEST(MemfaultMetricsSerializerHelper, Test_MemfaultStoredEventMetadataCompact) {
+  // only the type (and timestamp when available) are stored with each event
+  const uint8_t expected[] = { 0xa2, 0x02, 0x01 };
+  const uint8_t expected_with_timestamp[] = {
+    0xa3, 0x02, 0x01, 0x01, 0x1a, 0x5e, 0x8d, 0xd6, 0xf4,
+  };
+  uint8_t result[sizeof(expected_with_timestamp)];
+  sMemfaultCborEncoder encoder;
+
+  memfault_cbor_encoder_init(&encoder, prv_write_cb, result, sizeof(result));
+  CHECK(memfault_serializer_helper_encode_stored_event_metadata(&encoder,
+                                                                 kMemfaultEventType_Heartbeat));
+  LONGS_EQUAL(sizeof(expected), memfault_cbor_encoder_deinit(&encoder));
+  MEMCMP_EQUAL(expected, result, sizeof(expected));
+
+  prv_enable_captured_date();
+  memfault_cbor_encoder_init(&encoder, prv_write_cb, result, sizeof(result));
+  CHECK(memfault_serializer_helper_encode_stored_event_metadata(&encoder,
+                                                                 kMemfaultEventType_Heartbeat));
+  LONGS_EQUAL(sizeof(expected_with_timestamp), memfault_cbor_encoder_deinit(&encoder));
+  MEMCMP_EQUAL(expected_with_timestamp, result, sizeof(expected_with_timestamp));
+}
+
+TEST(MemfaultMetricsSerializerHelper, Test_MemfaultBatchMetadata) {
+  // The batch metadata is the full event metadata without the type and event info pairs
+  const size_t type_pair_len = 2;
+  uint8_t expected[sizeof(test_vector) - type_pair_len];
+  expected[0] = (uint8_t)(test_vector[0] - 2);
+  memcpy(&expected[1], &test_vector[1 + type_pair_len], sizeof(expected) - 1);
+
+  uint8_t result[sizeof(expected)];
+  sMemfaultCborEncoder encoder;
+  for (size_t i = 1; i <= sizeof(result); i++) {
+    memfault_cbor_encoder_init(&encoder, prv_write_cb, result, i);
+    const bool success = memfault_serializer_helper_encode_batch_metadata(&encoder);
+    LONGS_EQUAL(i == sizeof(result), success);
+    memfault_cbor_encoder_deinit(&encoder);
+  }
+  MEMCMP_EQUAL(expected, result, sizeof(expected));
+}
+#endif
@@ -4,11 +4,13 @@
 
 #include "CppUTest/TestHarness.h"
 #include "CppUTestExt/MockSupport.h"
+#include "memfault/core/math.h"
 #include "memfault/core/platform/core.h"
 #include "memfault/metrics/metrics.h"
 #include "memfault/metrics/platform/timer.h"
 #include "memfault/metrics/reliability.h"
 #include "memfault/metrics/serializer.h"
+#include "memfault/metrics/utils.h"
 
 #define FAKE_STORAGE_SIZE 1024
 
@@ -260,3 +262,55 @@ TEST(MemfaultSessionMetrics, Test_ResetSession) {
   LONGS_EQUAL(0, rv);
   LONGS_EQUAL(expected, val);
 }
+
+typedef struct {
+  eMfltMetricsSessionIndex session_key;
+  MemfaultMetricId keys[16];
+  size_t num_keys;
+} sSessionKeysCtx;
+
+static bool prv_collect_session_keys(void *ctx, const sMemfaultMetricInfo *metric_info) {
+  sSessionKeysCtx *keys_ctx = (sSessionKeysCtx *)ctx;
+  CHECK(keys_ctx->num_keys < MEMFAULT_ARRAY_SIZE(keys_ctx->keys));
+  keys_ctx->keys[keys_ctx->num_keys++] = metric_info->key;
+  return true;
+}
+
+static bool prv_collect_filtered_session_keys(void *ctx, const sMemfaultMetricInfo *metric_info) {
+  sSessionKeysCtx *keys_ctx = (sSessionKeysCtx *)ctx;
+  if (metric_info->session_key != keys_ctx->session_key) {
+    return true;
+  }
+  return prv_collect_session_keys(ctx, metric_info);
+}
+
+TEST(MemfaultSessionMetrics, Test_SessionIterate) {
+  const struct {
+    eMfltMetricsSessionIndex session_key;
+    size_t num_metrics;
+  } expected[] = {
+    // 2 built-in session metrics + the ones defined in the .def file
+    { MEMFAULT_METRICS_SESSION_KEY(test_key_session), 5 },
+    { MEMFAULT_METRICS_SESSION_KEY(test_key_session_two), 6 },
+  };
+
+  for (size_t i = 0; i < MEMFAULT_ARRAY_SIZE(expected); i++) {
+    const eMfltMetricsSessionIndex session_key = expected[i].session_key;
+    LONGS_EQUAL(expected[i].num_metrics, memfault_metrics_session_get_num_metrics(session_key));
+
+    // the session iterator should visit exactly the session's metrics, in definition order
+    sSessionKeysCtx all_keys = { .session_key = session_key };
+    memfault_metrics_heartbeat_iterate(prv_collect_filtered_session_keys, &all_keys);
+    sSessionKeysCtx session_keys = { .session_key = session_key };
+    memfault_metrics_session_iterate(session_key, prv_collect_session_keys, &session_keys);
+
+    LONGS_EQUAL(expected[i].num_metrics, session_keys.num_keys);
+    LONGS_EQUAL(all_keys.num_keys, session_keys.num_keys);
+    for (size_t j = 0; j < session_keys.num_keys; j++) {
+      LONGS_EQUAL(all_keys.keys[j]._impl, session_keys.keys[j]._impl);
+    }
+  }
+
+  // an out of range session has no metrics
+  LONGS_EQUAL(0, memfault_metrics_session_get_num_metrics(kMfltMetricsSessionKey_COUNT));
+}
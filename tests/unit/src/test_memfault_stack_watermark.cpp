@@ -0,0 +1,146 @@
+//! @file
+//!
+//! @brief
+//! Tests for memfault_stack_watermark_bytes_unused()
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "memfault/panics/stack_watermark.h"
+
+#define TEST_STACK_WORDS 64
+#define ZEPHYR_PAINT 0xAAAAAAAAu
+#define THREADX_RANDOM_PAINT 0x1EC0FFEEu
+
+static uint32_t s_stack[TEST_STACK_WORDS];
+
+static void prv_paint(uint32_t paint) {
+  for (size_t i = 0; i < TEST_STACK_WORDS; i++) {
+    s_stack[i] = paint;
+  }
+}
+
+//! Mark the stack as used from offset to the top, like a descending stack that grew down to it
+static void prv_use_down_to(size_t offset) {
+  uint8_t *bytes = (uint8_t *)s_stack;
+  for (size_t i = offset; i < sizeof(s_stack); i++) {
+    bytes[i] = (uint8_t)(i | 0x1);
+  }
+}
+
+//! The byte-by-byte scan the ports used to do
+static size_t prv_reference_bytes_unused(const uint8_t *start, size_t size, uint32_t paint) {
+  uint8_t paint_bytes[sizeof(paint)];
+  memcpy(paint_bytes, &paint, sizeof(paint));
+
+  size_t i = 0;
+  for (; (i < size) && (start[i] == paint_bytes[(uintptr_t)&start[i] % sizeof(paint)]); i++) { }
+  return i;
+}
+
+TEST_GROUP(MemfaultStackWatermark) {
+  void setup() {
+    prv_paint(ZEPHYR_PAINT);
+  }
+};
+
+TEST(MemfaultStackWatermark, Test_Unused) {
+  LONGS_EQUAL(sizeof(s_stack),
+              memfault_stack_watermark_bytes_unused(s_stack, sizeof(s_stack), ZEPHYR_PAINT, 0));
+}
+
+TEST(MemfaultStackWatermark, Test_Exhausted) {
+  prv_use_down_to(0);
+  LONGS_EQUAL(0, memfault_stack_watermark_bytes_unused(s_stack, sizeof(s_stack), ZEPHYR_PAINT, 0));
+}
+
+TEST(MemfaultStackWatermark, Test_EmptyStack) {
+  LONGS_EQUAL(0, memfault_stack_watermark_bytes_unused(s_stack, 0, ZEPHYR_PAINT, 0));
+}
+
+TEST(MemfaultStackWatermark, Test_EveryWatermarkMatchesByteScan) {
+  const uint32_t paints[] = { ZEPHYR_PAINT, THREADX_RANDOM_PAINT };
+  const uint8_t *bytes = (const uint8_t *)s_stack;
+
+  for (size_t p = 0; p < sizeof(paints) / sizeof(paints[0]); p++) {
+    // cover stacks that don't start or end on a word boundary
+    for (size_t head = 0; head < 4; head++) {
+      for (size_t tail = 0; tail < 4; tail++) {
+        const uint8_t *start = &bytes[head];
+        const size_t size = sizeof(s_stack) - head - tail;
+        for (size_t watermark = 0; watermark <= sizeof(s_stack); watermark++) {
+          prv_paint(paints[p]);
+          prv_use_down_to(watermark);
+          LONGS_EQUAL(prv_reference_bytes_unused(start, size, paints[p]),
+                      memfault_stack_watermark_bytes_unused(start, size, paints[p], 0));
+        }
+      }
+    }
+  }
+}
+
+TEST(MemfaultStackWatermark, Test_UsedByteMatchingPaint) {
+  // a used byte that happens to match the pattern is counted as unused, like the byte scan does
+  prv_use_down_to(101);
+  ((uint8_t *)s_stack)[101] = 0xAA;
+  LONGS_EQUAL(102,
+              memfault_stack_watermark_bytes_unused(s_stack, sizeof(s_stack), ZEPHYR_PAINT, 0));
+}
+
+TEST(MemfaultStackWatermark, Test_CachedWatermark) {
+  for (size_t cached = 1; cached <= sizeof(s_stack); cached++) {
+    for (size_t watermark = 0; watermark <= cached; watermark++) {
+      prv_paint(ZEPHYR_PAINT);
+      prv_use_down_to(cached);
+      // the cached watermark is only used if it's still valid for the stack
+      LONGS_EQUAL(cached, memfault_stack_watermark_bytes_unused(s_stack, sizeof(s_stack),
+                                                                ZEPHYR_PAINT, cached));
+
+      // the stack grew since the watermark was cached
+      prv_use_down_to(watermark);
+      LONGS_EQUAL(watermark, memfault_stack_watermark_bytes_unused(s_stack, sizeof(s_stack),
+                                                                   ZEPHYR_PAINT, cached));
+    }
+  }
+}
+
+TEST(MemfaultStackWatermark, Test_CachedWatermarkUnalignedStack) {
+  const uint8_t *start = (const uint8_t *)s_stack + 3;
+  const size_t size = sizeof(s_stack) - 3;
+
+  for (size_t cached = 1; cached <= size; cached++) {
+    prv_paint(THREADX_RANDOM_PAINT);
+    prv_use_down_to(3 + cached);
+    const size_t expected = prv_reference_bytes_unused(start, size, THREADX_RANDOM_PAINT);
+    LONGS_EQUAL(expected,
+                memfault_stack_watermark_bytes_unused(start, size, THREADX_RANDOM_PAINT, cached));
+
+    prv_use_down_to(3);
+    LONGS_EQUAL(0,
+                memfault_stack_watermark_bytes_unused(start, size, THREADX_RANDOM_PAINT, cached));
+  }
+}
+
+TEST(MemfaultStackWatermark, Test_StaleCachedWatermark) {
+  // the stack was painted again, for a new thread, after the watermark was cached
+  prv_use_down_to(200);
+  LONGS_EQUAL(200, memfault_stack_watermark_bytes_unused(s_stack, sizeof(s_stack), ZEPHYR_PAINT,
+                                                         100));
+
+  // out of range values are ignored
+  LONGS_EQUAL(200, memfault_stack_watermark_bytes_unused(s_stack, sizeof(s_stack), ZEPHYR_PAINT,
+                                                         sizeof(s_stack) + 1));
+}
+
+TEST(MemfaultStackWatermark, Test_CachedWatermarkSkipsPaintedHole) {
+  // a large local buffer that was never written, below the cached watermark
+  prv_use_down_to(16);
+  memset(&s_stack[8], 0xAA, 64);
+
+  // found by a full scan, but not when starting from the cached watermark
+  LONGS_EQUAL(16, memfault_stack_watermark_bytes_unused(s_stack, sizeof(s_stack), ZEPHYR_PAINT, 0));
+  LONGS_EQUAL(96, memfault_stack_watermark_bytes_unused(s_stack, sizeof(s_stack), ZEPHYR_PAINT,
+                                                        200));
+}
@@ -0,0 +1,149 @@
+//! @file
+//!
+//! @brief
+//! Tests for the task registry used by the RTOS ports to track TCBs for coredumps. Built with
+//! MEMFAULT_TASK_REGISTRY_CONSTANT_TIME both disabled and enabled.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <map>
+#include <random>
+#include <vector>
+
+#include "CppUTest/TestHarness.h"
+#include "memfault/core/math.h"
+#include "memfault/panics/task_registry.h"
+
+#define TEST_NUM_SLOTS 8
+
+// A stand-in for a port's TCB pointer array, which is what ends up in the coredump
+static void *s_task_tcbs[TEST_NUM_SLOTS];
+#if MEMFAULT_TASK_REGISTRY_CONSTANT_TIME
+static uint16_t s_free_slots[TEST_NUM_SLOTS];
+static uint16_t s_index[MEMFAULT_TASK_REGISTRY_INDEX_SIZE(TEST_NUM_SLOTS)];
+#endif
+static sMfltTaskRegistry s_registry;
+
+static uint8_t s_fake_tcbs[64][16];
+
+TEST_GROUP(MemfaultTaskRegistry) {
+  void setup() {
+    memset(s_task_tcbs, 0, sizeof(s_task_tcbs));
+#if MEMFAULT_TASK_REGISTRY_CONSTANT_TIME
+    memset(s_free_slots, 0, sizeof(s_free_slots));
+    memset(s_index, 0, sizeof(s_index));
+    s_registry = sMfltTaskRegistry{ s_task_tcbs, s_free_slots, s_index, TEST_NUM_SLOTS,
+                                    MEMFAULT_ARRAY_SIZE(s_index) - 1, 0, 0 };
+#else
+    s_registry = sMfltTaskRegistry{ s_task_tcbs, TEST_NUM_SLOTS };
+#endif
+  }
+};
+
+#if MEMFAULT_TASK_REGISTRY_CONSTANT_TIME
+TEST(MemfaultTaskRegistry, Test_IndexSize) {
+  LONGS_EQUAL(16, MEMFAULT_ARRAY_SIZE(s_index));
+  LONGS_EQUAL(2, MEMFAULT_TASK_REGISTRY_INDEX_SIZE(1));
+  LONGS_EQUAL(64, MEMFAULT_TASK_REGISTRY_INDEX_SIZE(17));
+  LONGS_EQUAL(64, MEMFAULT_TASK_REGISTRY_INDEX_SIZE(32));
+}
+#endif
+
+TEST(MemfaultTaskRegistry, Test_AddUntilFull) {
+  for (size_t i = 0; i < TEST_NUM_SLOTS; i++) {
+    size_t slot = SIZE_MAX;
+    CHECK(memfault_task_registry_add(&s_registry, s_fake_tcbs[i], &slot));
+    LONGS_EQUAL(i, slot);
+    POINTERS_EQUAL(s_fake_tcbs[i], s_task_tcbs[i]);
+  }
+
+  CHECK_FALSE(memfault_task_registry_add(&s_registry, s_fake_tcbs[TEST_NUM_SLOTS], NULL));
+
+  // the registry is still intact
+  for (size_t i = 0; i < TEST_NUM_SLOTS; i++) {
+    POINTERS_EQUAL(s_fake_tcbs[i], s_task_tcbs[i]);
+  }
+}
+
+TEST(MemfaultTaskRegistry, Test_AddTwice) {
+  size_t slot = SIZE_MAX;
+  CHECK(memfault_task_registry_add(&s_registry, s_fake_tcbs[0], NULL));
+  CHECK(memfault_task_registry_add(&s_registry, s_fake_tcbs[1], NULL));
+  CHECK(memfault_task_registry_add(&s_registry, s_fake_tcbs[0], &slot));
+  LONGS_EQUAL(0, slot);
+  POINTERS_EQUAL(NULL, s_task_tcbs[2]);
+}
+
+TEST(MemfaultTaskRegistry, Test_RemoveAndReuse) {
+  for (size_t i = 0; i < TEST_NUM_SLOTS; i++) {
+    CHECK(memfault_task_registry_add(&s_registry, s_fake_tcbs[i], NULL));
+  }
+
+  size_t slot = SIZE_MAX;
+  CHECK(memfault_task_registry_remove(&s_registry, s_fake_tcbs[5], &slot));
+  LONGS_EQUAL(5, slot);
+  POINTERS_EQUAL(NULL, s_task_tcbs[5]);
+  CHECK(memfault_task_registry_remove(&s_registry, s_fake_tcbs[2], &slot));
+  LONGS_EQUAL(2, slot);
+
+  // not in the registry anymore
+  CHECK_FALSE(memfault_task_registry_remove(&s_registry, s_fake_tcbs[2], NULL));
+
+  // the freed slots are used again. In a constant time registry the most recently freed slot is
+  // used first, otherwise the lowest free slot is, which is the same slot here
+  CHECK(memfault_task_registry_add(&s_registry, s_fake_tcbs[20], &slot));
+  LONGS_EQUAL(2, slot);
+  CHECK(memfault_task_registry_add(&s_registry, s_fake_tcbs[21], &slot));
+  LONGS_EQUAL(5, slot);
+  CHECK_FALSE(memfault_task_registry_add(&s_registry, s_fake_tcbs[22], NULL));
+
+  POINTERS_EQUAL(s_fake_tcbs[20], s_task_tcbs[2]);
+  POINTERS_EQUAL(s_fake_tcbs[21], s_task_tcbs[5]);
+}
+
+TEST(MemfaultTaskRegistry, Test_InvalidTcb) {
+  CHECK_FALSE(memfault_task_registry_add(&s_registry, NULL, NULL));
+  CHECK_FALSE(memfault_task_registry_remove(&s_registry, NULL, NULL));
+  CHECK_FALSE(memfault_task_registry_remove(&s_registry, s_fake_tcbs[0], NULL));
+}
+
+TEST(MemfaultTaskRegistry, Test_RandomChurn) {
+  // addresses that only differ in their upper bits, to exercise hash collisions too
+  std::vector<void *> tcbs;
+  for (uintptr_t i = 0; i < 32; i++) {
+    tcbs.push_back((void *)(0x20000000u + i * 0x100u));
+    tcbs.push_back((void *)(0x20000000u + i * 0x10000u + 0x8u));
+  }
+
+  std::map<void *, size_t> expected;
+  std::mt19937 gen(1234);
+  std::uniform_int_distribution<size_t> pick(0, tcbs.size() - 1);
+
+  for (size_t i = 0; i < 20000; i++) {
+    void *tcb = tcbs[pick(gen)];
+    size_t slot = SIZE_MAX;
+    if (expected.count(tcb) != 0) {
+      CHECK(memfault_task_registry_remove(&s_registry, tcb, &slot));
+      LONGS_EQUAL(expected[tcb], slot);
+      expected.erase(tcb);
+    } else if (expected.size() < TEST_NUM_SLOTS) {
+      CHECK(memfault_task_registry_add(&s_registry, tcb, &slot));
+      CHECK(slot < TEST_NUM_SLOTS);
+      expected[tcb] = slot;
+    } else {
+      CHECK_FALSE(memfault_task_registry_add(&s_registry, tcb, NULL));
+    }
+
+    // the TCB pointer array always matches the set of tasks
+    size_t num_tracked = 0;
+    for (size_t j = 0; j < TEST_NUM_SLOTS; j++) {
+      if (s_task_tcbs[j] != NULL) {
+        LONGS_EQUAL(j, expected.at(s_task_tcbs[j]));
+        num_tracked++;
+      }
+    }
+    LONGS_EQUAL(expected.size(), num_tracked);
+  }
+}
@@ -0,0 +1,131 @@
+//! @file
+//!
+//! @brief
+//! Microbenchmark for task create/delete churn in the task registry, compared against the linear
+//! scan of the TCB pointer array the RTOS ports used before, for a range of task counts to compare
+//! the per-call cost against the number of tracked tasks.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "CppUTest/TestHarness.h"
+#include "memfault/core/math.h"
+#include "memfault/panics/task_registry.h"
+
+#define BENCHMARK_ITERATIONS (200000)
+
+#define BENCHMARK_MAX_NUM_SLOTS 128
+
+static void *s_task_tcbs[BENCHMARK_MAX_NUM_SLOTS];
+static uint16_t s_free_slots[BENCHMARK_MAX_NUM_SLOTS];
+static uint16_t s_index[MEMFAULT_TASK_REGISTRY_INDEX_SIZE(BENCHMARK_MAX_NUM_SLOTS)];
+static sMfltTaskRegistry s_registry;
+static size_t s_num_slots;
+
+//! The slot lookup the ports did before the registry was added
+static bool prv_linear_find_slot(size_t *idx, void *desired_tcb) {
+  for (size_t i = 0; i < s_num_slots; i++) {
+    if (s_task_tcbs[i] == desired_tcb) {
+      *idx = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+static void prv_linear_create(void *tcb) {
+  size_t idx = 0;
+  if (prv_linear_find_slot(&idx, NULL)) {
+    s_task_tcbs[idx] = tcb;
+  }
+}
+
+static void prv_linear_delete(void *tcb) {
+  size_t idx = 0;
+  if (prv_linear_find_slot(&idx, tcb)) {
+    s_task_tcbs[idx] = NULL;
+  }
+}
+
+static void prv_registry_create(void *tcb) {
+  memfault_task_registry_add(&s_registry, tcb, NULL);
+}
+
+static void prv_registry_delete(void *tcb) {
+  memfault_task_registry_remove(&s_registry, tcb, NULL);
+}
+
+//! Sets up an empty registry (and TCB pointer array) tracking up to num_slots tasks
+static void prv_reset(size_t num_slots) {
+  memset(s_task_tcbs, 0, sizeof(s_task_tcbs));
+  memset(s_free_slots, 0, sizeof(s_free_slots));
+  memset(s_index, 0, sizeof(s_index));
+  s_num_slots = num_slots;
+  // the index of a registry is sized for its number of slots, see MEMFAULT_TASK_REGISTRY_DEFINE
+  const size_t index_size = MEMFAULT_TASK_REGISTRY_INDEX_SIZE(num_slots);
+  s_registry =
+    sMfltTaskRegistry{ s_task_tcbs, s_free_slots, s_index, (uint16_t)num_slots,
+                       (uint16_t)(index_size - 1), 0, 0 };
+}
+
+TEST_GROUP(MemfaultTaskRegistryBenchmark) {
+  void setup() { }
+};
+
+//! All slots hold a task; every iteration deletes a random task and creates a new one, like a
+//! system with short-lived worker tasks
+static double prv_churn(void (*create)(void *), void (*remove)(void *)) {
+  std::vector<uintptr_t> live;
+  for (uintptr_t i = 0; i < s_num_slots; i++) {
+    live.push_back(0x20000000 + i * 0x200);
+    create((void *)live.back());
+  }
+
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<size_t> victim(0, live.size() - 1);
+  std::vector<size_t> victims(BENCHMARK_ITERATIONS);
+  for (size_t &v : victims) {
+    v = victim(gen);
+  }
+
+  uintptr_t next_tcb = 0x20000000 + s_num_slots * 0x200;
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < BENCHMARK_ITERATIONS; i++) {
+    uintptr_t *tcb = &live[victims[i]];
+    remove((void *)*tcb);
+    *tcb = next_tcb;
+    next_tcb += 0x200;
+    create((void *)*tcb);
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+
+  // every live task is tracked
+  for (size_t i = 0; i < live.size(); i++) {
+    size_t idx = 0;
+    CHECK(prv_linear_find_slot(&idx, (void *)live[i]));
+  }
+
+  const double ns =
+    (double)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+  return ns / (double)(2 * BENCHMARK_ITERATIONS);
+}
+
+TEST(MemfaultTaskRegistryBenchmark, Test_CreateDeleteChurn) {
+  const size_t num_slots[] = { 8, 32, 128 };
+  for (size_t i = 0; i < MEMFAULT_ARRAY_SIZE(num_slots); i++) {
+    prv_reset(num_slots[i]);
+    const double linear_ns = prv_churn(prv_linear_create, prv_linear_delete);
+    prv_reset(num_slots[i]);
+    const double registry_ns = prv_churn(prv_registry_create, prv_registry_delete);
+
+    printf("task registry create+delete: %d tasks, linear scan %.1f ns/call, registry %.1f "
+           "ns/call\n",
+           (int)num_slots[i], linear_ns, registry_ns);
+  }
+}
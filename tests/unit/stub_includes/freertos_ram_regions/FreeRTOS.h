@@ -0,0 +1,13 @@
+//! @file
+//!
+//! Copyright (c) Memfault, Inc.
+//! See LICENSE for details
+//!
+//! Stubs for FreeRTOS.h, used when testing memfault_freertos_ram_regions.c
+#pragma once
+
+#define configRECORD_STACK_HIGH_ADDRESS 1
+#define INCLUDE_uxTaskGetStackHighWaterMark 1
+
+// Normally included from FreeRTOSConfig.h
+#include "memfault/ports/freertos_trace.h"
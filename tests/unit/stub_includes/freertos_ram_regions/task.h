@@ -0,0 +1,27 @@
+//! @file
+//!
+//! Copyright (c) Memfault, Inc.
+//! See LICENSE for details
+//!
+//! Stubs for FreeRTOS task.h, used when testing memfault_freertos_ram_regions.c
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define tskKERNEL_VERSION_MAJOR 10
+#define tskKERNEL_VERSION_MINOR 4
+#define tskKERNEL_VERSION_BUILD 3
+
+typedef void *TaskHandle_t;
+typedef uint32_t StackType_t;
+typedef uint32_t UBaseType_t;
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t xTask);
+
+#ifdef __cplusplus
+}
+#endif